@@ -1,11 +1,19 @@
 #include "./MiniVstEffect.hpp"
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
-#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
 #include <vector>
+#if !defined(HWM_MINIVSTEFFECT_NO_EDITOR)
 #include "./MiniVstEffecteditor.h"
+#endif
+#include "./dsp/Denormals.hpp"
+#include "./dsp/ParamMapping.hpp"
+#include "./dsp/Silence.hpp"
 
 namespace hwm {
 
@@ -13,10 +21,25 @@ struct defines{
 
 	//! parameter index
 	enum {
-		kNumPrograms	= 8,
+		kNumPrograms	= dsp::kNumPresets,
 		kVendorVersion	= 1
 	};
 
+	//! パラメータの変化を滑らかにする時間[sec]
+	static double const	kSmoothingTime;
+	//! 滑らかに変化させる間、係数を計算し直す間隔[sample]
+	enum {
+		kControlInterval = 32
+	};
+
+	//! 入力と出力を無音とみなす振幅(-120dBFS)
+	static double const	kSilenceThreshold;
+	//! 尾の長さを決める、インパルス応答の減衰量
+	//! ゲインの上限(+20dB)で鳴らした後でも、kSilenceThresholdを下回るまで
+	static double const	kTailDecay;
+	//! 極が単位円上にあるなど、減衰しないときの尾の長さ[sec]
+	static double const	kMaxTailTime;
+
 	static int const	kID;
 	static char const *kVendor;
 	static char const *kProduct;
@@ -26,15 +49,66 @@ struct defines{
 
 	//! フィルタタイプの定義
 	enum {
-		LPF,
-		HPF,
-		BPF,
-		notch,
-		APF,
-		PeakingEQ,
-		LowShelf,
-		HighShelf,
-		kNumFilterType
+		LPF			= dsp::FilterType::LPF,
+		HPF			= dsp::FilterType::HPF,
+		BPF			= dsp::FilterType::BPF,
+		notch		= dsp::FilterType::notch,
+		APF			= dsp::FilterType::APF,
+		PeakingEQ	= dsp::FilterType::PeakingEQ,
+		LowShelf	= dsp::FilterType::LowShelf,
+		HighShelf	= dsp::FilterType::HighShelf,
+		kNumFilterType	= dsp::FilterType::kNumFilterType
+	};
+
+	//! パラメータを変更するMIDIのコントロールチェンジ
+	//! 用途の定められていない番号だけを使う。パラメータIDの小さい方から20 ~ 31、102 ~ 119、85 ~ 90、14 ~ 15
+	//! 32 ~ 63は0 ~ 31のLSB(32はバンクセレクト、38はデータエントリー)なので使わない
+	enum {
+		kFirstParamCC		= 20,
+		kNumFirstParamCCs	= 12,
+		kSecondParamCC		= 102,
+		kNumSecondParamCCs	= 18,
+		kThirdParamCC		= 85,
+		kNumThirdParamCCs	= 6,
+		kFourthParamCC		= 14,
+		kNumFourthParamCCs	= 2
+	};
+
+	//! コントロールチェンジの番号に対応するパラメータID
+	//! 対応するパラメータがなければ-1
+	static
+	int		cc_to_param(int cc)
+	{
+		int param = -1;
+		if(cc >= kFirstParamCC && cc < kFirstParamCC + kNumFirstParamCCs) {
+			param = cc - kFirstParamCC;
+		} else if(cc >= kSecondParamCC && cc < kSecondParamCC + kNumSecondParamCCs) {
+			param = kNumFirstParamCCs + (cc - kSecondParamCC);
+		} else if(cc >= kThirdParamCC && cc < kThirdParamCC + kNumThirdParamCCs) {
+			param = kNumFirstParamCCs + kNumSecondParamCCs + (cc - kThirdParamCC);
+		} else if(cc >= kFourthParamCC && cc < kFourthParamCC + kNumFourthParamCCs) {
+			param = kNumFirstParamCCs + kNumSecondParamCCs + kNumThirdParamCCs + (cc - kFourthParamCC);
+		}
+		return (param < MiniVstEffect::kNumParams) ? param : -1;
+	}
+
+	//! フィルタエンジンの定義
+	enum {
+		kBiquad,
+		kSvf,
+		kNumEngine
+	};
+
+	//! 位相の定義
+	enum {
+		kMinimumPhase,
+		kLinearPhase,
+		kNumPhase
+	};
+
+	//! オーバーサンプリングの倍率の選択肢の数(1x, 2x, 4x)
+	enum {
+		kNumOversampling = 3
 	};
 
 	static VstProgram const presets[defines::kNumPrograms];
@@ -61,11 +135,156 @@ struct defines{
 			static_cast<vst_param_t>((filter + 0.5) / kNumFilterType);
 	}
 	
+	//! vstのパラメータ値をエンジンのインデックスに
+	static
+	size_t	param_to_engine(vst_param_t value)
+	{
+		return (value < 0.5) ? kBiquad : kSvf;
+	}
+
+	//! エンジンのインデックスをvstのパラメータ値に
+	static
+	vst_param_t
+			engine_to_param(size_t engine)
+	{
+		return (engine == kSvf) ? 1.0f : 0.0f;
+	}
+
+	//! vstのパラメータ値をバンド数に
+	//! 1 ~ kMaxBands
+	static
+	size_t	param_to_num_bands(vst_param_t value)
+	{
+		return
+			1 + static_cast<size_t>(value * (kMaxBands - 1) + 0.5);
+	}
+
+	//! バンド数をvstのパラメータ値に
+	static
+	vst_param_t
+			num_bands_to_param(size_t num_bands)
+	{
+		return
+			static_cast<vst_param_t>(num_bands - 1) / (kMaxBands - 1);
+	}
+
+	//! vstのパラメータ値を傾きに
+	//! 12dB/oct単位のセクション数(1 ~ kMaxSlopeSections)
+	static
+	size_t	param_to_slope_sections(vst_param_t value)
+	{
+		return
+			1 + static_cast<size_t>(value * (dsp::kMaxSlopeSections - 1) + 0.5);
+	}
+
+	//! 傾きをvstのパラメータ値に
+	static
+	vst_param_t
+			slope_sections_to_param(size_t num_sections)
+	{
+		return
+			static_cast<vst_param_t>(num_sections - 1) / (dsp::kMaxSlopeSections - 1);
+	}
+
+	//! vstのパラメータ値を高次のLPF, HPFの特性に
+	static
+	size_t	param_to_alignment(vst_param_t value)
+	{
+		return (value < 0.5) ? dsp::Alignment::Butterworth : dsp::Alignment::LinkwitzRiley;
+	}
+
+	//! 高次のLPF, HPFの特性をvstのパラメータ値に
+	static
+	vst_param_t
+			alignment_to_param(size_t alignment)
+	{
+		return (alignment == dsp::Alignment::LinkwitzRiley) ? 1.0f : 0.0f;
+	}
+
+	//! vstのパラメータ値を位相に
+	static
+	size_t	param_to_phase(vst_param_t value)
+	{
+		return (value < 0.5) ? kMinimumPhase : kLinearPhase;
+	}
+
+	//! 位相をvstのパラメータ値に
+	static
+	vst_param_t
+			phase_to_param(size_t phase)
+	{
+		return (phase == kLinearPhase) ? 1.0f : 0.0f;
+	}
+
+	//! vstのパラメータ値をオーバーサンプリングの倍率に
+	//! 1, 2, 4
+	static
+	size_t	param_to_oversampling(vst_param_t value)
+	{
+		return
+			static_cast<size_t>(1) << static_cast<size_t>(value * (kNumOversampling - 1) + 0.5);
+	}
+
+	//! オーバーサンプリングの倍率をvstのパラメータ値に
+	static
+	vst_param_t
+			oversampling_to_param(size_t factor)
+	{
+		size_t const index = (factor >= 4) ? 2 : (factor >= 2) ? 1 : 0;
+		return
+			static_cast<vst_param_t>(index) / (kNumOversampling - 1);
+	}
+
+	//! dsp::get_preset_paramsのindex番目のプリセットを作る
+	//! 2番目以降のバンドは、帯域に散らばらせた0dBのPeaking EQにしておく
+	static
+	VstProgram
+			make_preset(size_t index)
+	{
+		dsp::PresetParams const &preset = dsp::get_preset_params(index);
+
+		VstProgram prog;
+		prog.cutoff_		= static_cast<vst_param_t>(preset.cutoff_);
+		prog.db_gain_		= static_cast<vst_param_t>(preset.db_gain_);
+		prog.Q_				= static_cast<vst_param_t>(preset.Q_);
+		prog.filter_type_	= filter_to_param(preset.filter_type_);
+		prog.engine_		= engine_to_param(kBiquad);
+		prog.num_bands_		= num_bands_to_param(1);
+		prog.slope_			= slope_sections_to_param(1);
+		prog.alignment_		= alignment_to_param(dsp::Alignment::Butterworth);
+		prog.phase_			= phase_to_param(kMinimumPhase);
+		prog.oversampling_	= oversampling_to_param(1);
+		for(size_t i = 0; i < kMaxBands - 1; ++i) {
+			BandParams &band = prog.bands_[i];
+			band.cutoff_		= static_cast<vst_param_t>(i + 1) / kMaxBands;
+			band.db_gain_		= db_to_param(0.0);
+			band.Q_				= 0.0;
+			band.filter_type_	= filter_to_param(PeakingEQ);
+		}
+		vst_strncpy(prog.name_, preset.name_, kVstMaxProgNameLen);
+		return prog;
+	}
+
+	//! パラメータと正規化周波数
+	//! 写像はベンチマークなどと共有するため、dsp/ParamMapping.hppに置いている
+	static
+	double	param_to_cutoff(double value, double sampling_rate)
+	{
+		return dsp::param_to_cutoff(value, sampling_rate);
+	}
+
+	//! パラメータとQ
+	static
+	double	param_to_Q(double value)
+	{
+		return dsp::param_to_Q(value);
+	}
+
 	//! パラメータとdB
 	static
 	double	param_to_db(vst_param_t value)
 	{
-		return 20.0 * log10(static_cast<double>(value * 4.0));
+		return dsp::param_to_db(value);
 	}
 
 	//! パラメータとdB
@@ -74,7 +293,7 @@ struct defines{
 			db_to_param(double dB)
 	{
 		return
-			static_cast<vst_param_t>(pow(10.0, (dB)/20.0) / 4.0);
+			static_cast<vst_param_t>(dsp::db_to_param(dB));
 	}
 
 	//! フィルタタイプから、そのフィルタを表す文字列を取得
@@ -102,6 +321,69 @@ struct defines{
 		}
 		return "Unknown";
 	}
+
+	//! エンジンから、そのエンジンを表す文字列を取得
+	static
+	char const *
+			get_engine_string(size_t engine)
+	{
+		switch(engine) {
+			case defines::kBiquad:
+				return "Biquad";
+			case defines::kSvf:
+				return "SVF";
+		}
+		return "Unknown";
+	}
+
+	//! 高次のLPF, HPFの特性から、それを表す文字列を取得
+	static
+	char const *
+			get_alignment_string(size_t alignment)
+	{
+		switch(alignment) {
+			case dsp::Alignment::Butterworth:
+				return "Butter";
+			case dsp::Alignment::LinkwitzRiley:
+				return "L-R";
+		}
+		return "Unknown";
+	}
+
+	//! 位相から、それを表す文字列を取得
+	static
+	char const *
+			get_phase_string(size_t phase)
+	{
+		switch(phase) {
+			case defines::kMinimumPhase:
+				return "Min";
+			case defines::kLinearPhase:
+				return "Linear";
+		}
+		return "Unknown";
+	}
+
+	//! 表示用の文字列を、確保せずにlabelに書く
+	//! ホストはオーディオスレッドからも表示を取得することがあるので、文字列ストリームは使わない
+	//! 数値はstd::ostreamの既定と同じ、有効数字6桁の%gで書く
+	static
+	void	format_display(char *label, double value)
+	{
+		std::snprintf(label, kVstMaxParamStrLen + 1, "%g", value);
+	}
+
+	static
+	void	format_display(char *label, size_t value)
+	{
+		std::snprintf(label, kVstMaxParamStrLen + 1, "%u", static_cast<unsigned>(value));
+	}
+
+	static
+	void	format_display(char *label, char const *text)
+	{
+		vst_strncpy(label, text, kVstMaxParamStrLen);
+	}
 };
 
 int	const defines::kID					= 'MVFx';
@@ -112,19 +394,167 @@ char const *	defines::kEffect		= defines::kProduct;
 //! プラグインのプリセット
 VstProgram	const 
 				defines::presets[defines::kNumPrograms] = {
-	{ 0.5, 0.0, 0.0, defines::filter_to_param(defines::LPF), "Low Pass Filter"},
-	{ 0.5, 0.0, 0.0, defines::filter_to_param(defines::HPF), "High Pass Filter"},
-	{ 0.5, 0.0, 0.0, defines::filter_to_param(defines::BPF), "Band Pass Filter"},
-	{ 0.5, 0.0, 0.0, defines::filter_to_param(defines::notch), "notch Filter"},
-	{ 0.5, 0.0, 0.0, defines::filter_to_param(defines::APF), "All-Pass Filter"},
-	{ 0.5, defines::db_to_param(0.0), 0.0, defines::filter_to_param(defines::PeakingEQ), "peaking EQ" },
-	{ 0.5, defines::db_to_param(0.0), 0.0, defines::filter_to_param(defines::LowShelf), "Low Shelving Filter" },
-	{ 0.5, defines::db_to_param(0.0), 0.0, defines::filter_to_param(defines::HighShelf), "High Shelving Filter" }
+	defines::make_preset(0),
+	defines::make_preset(1),
+	defines::make_preset(2),
+	defines::make_preset(3),
+	defines::make_preset(4),
+	defines::make_preset(5),
+	defines::make_preset(6),
+	defines::make_preset(7)
 };
 
 double const	defines::kdBMin			= -100.0;
 double const	defines::kdBMax			= 20.0;
 double const	defines::kdBRange		= defines::kdBMax - defines::kdBMin;
+double const	defines::kSmoothingTime	= 0.02;
+double const	defines::kSilenceThreshold	= 1e-6;
+double const	defines::kTailDecay			= 1e-7;
+double const	defines::kMaxTailTime		= 10.0;
+
+//! スナップショットの値が前回から変わっていれば、書き込み側の変更として反映する
+static
+void	merge_param	(vst_param_t &applied, vst_param_t published, vst_param_t value)
+{
+	if(value != published) {
+		applied = value;
+	}
+}
+
+//! パラメータIDが2番目以降のバンドのパラメータかどうか
+static
+bool	is_band_param	(VstInt32 index)
+{
+	return index >= MiniVstEffect::kBandParams && index < MiniVstEffect::kNumParams;
+}
+
+//! 2番目以降のバンドのパラメータIDから、値の格納場所を取得
+static
+vst_param_t &
+		get_band_param	(BandParams *bands, VstInt32 index)
+{
+	BandParams &band = bands[(index - MiniVstEffect::kBandParams) / MiniVstEffect::kNumBandParams];
+
+	switch((index - MiniVstEffect::kBandParams) % MiniVstEffect::kNumBandParams) {
+		case MiniVstEffect::kBandCutOff:
+			return band.cutoff_;
+		case MiniVstEffect::kBanddBGain:
+			return band.db_gain_;
+		case MiniVstEffect::kBandQ:
+			return band.Q_;
+	}
+	return band.filter_type_;
+}
+
+//! パラメータIDから、値の格納場所を取得
+//! VstProgramとFilterParamsは同じ名前のメンバを持つので、どちらにも使う
+//! @return 範囲外のIDなら0
+template<class Params>
+vst_param_t *
+		find_param	(Params &params, VstInt32 index)
+{
+	switch(index) {
+		case MiniVstEffect::kCutOff:
+			return &params.cutoff_;
+		case MiniVstEffect::kdBGain:
+			return &params.db_gain_;
+		case MiniVstEffect::kQ:
+			return &params.Q_;
+		case MiniVstEffect::kFilterType:
+			return &params.filter_type_;
+		case MiniVstEffect::kEngine:
+			return &params.engine_;
+		case MiniVstEffect::kNumBands:
+			return &params.num_bands_;
+		case MiniVstEffect::kSlope:
+			return &params.slope_;
+		case MiniVstEffect::kAlignment:
+			return &params.alignment_;
+		case MiniVstEffect::kPhase:
+			return &params.phase_;
+		case MiniVstEffect::kOversampling:
+			return &params.oversampling_;
+	}
+
+	if(!is_band_param(index)) {
+		return 0;
+	}
+	return &get_band_param(params.bands_, index);
+}
+
+template<class Params>
+vst_param_t
+		get_param	(Params const &params, VstInt32 index)
+{
+	vst_param_t const *param = find_param(const_cast<Params &>(params), index);
+	return param ? *param : 0;
+}
+
+//! パラメータがold_valueからnew_valueに変わったとき、遅延子のクリアが必要かどうか
+static
+bool	needs_clear_on_change	(VstInt32 index, vst_param_t old_value, vst_param_t new_value)
+{
+	switch(index) {
+		case MiniVstEffect::kFilterType:
+			return defines::param_to_filter(old_value) != defines::param_to_filter(new_value);
+
+		case MiniVstEffect::kEngine:
+			//! エンジン間で状態は引き継げないので、切り替えたらクリアする
+			return defines::param_to_engine(old_value) != defines::param_to_engine(new_value);
+
+		case MiniVstEffect::kNumBands:
+			//! 処理するフィルタが変わるので、バンド数を変えたらクリアする
+			return defines::param_to_num_bands(old_value) != defines::param_to_num_bands(new_value);
+
+		case MiniVstEffect::kSlope:
+			//! セクション数と各セクションのQが変わるので、クリアする
+			return
+				defines::param_to_slope_sections(old_value) !=
+				defines::param_to_slope_sections(new_value);
+
+		case MiniVstEffect::kAlignment:
+			return defines::param_to_alignment(old_value) != defines::param_to_alignment(new_value);
+
+		case MiniVstEffect::kPhase:
+			//! 処理するフィルタと遅延が変わるので、クリアする
+			return defines::param_to_phase(old_value) != defines::param_to_phase(new_value);
+
+		case MiniVstEffect::kOversampling:
+			//! 処理するレートと遅延が変わるので、クリアする
+			return
+				defines::param_to_oversampling(old_value) !=
+				defines::param_to_oversampling(new_value);
+	}
+
+	return
+		is_band_param(index) &&
+		(index - MiniVstEffect::kBandParams) % MiniVstEffect::kNumBandParams ==
+			MiniVstEffect::kBandFilterType &&
+		defines::param_to_filter(old_value) != defines::param_to_filter(new_value);
+}
+
+//! 変えると処理の遅延が変わるパラメータかどうか
+//! 遅延の通知と線形位相の準備が要るので、オーディオスレッドからは切り替えない
+static
+bool	changes_latency	(VstInt32 index)
+{
+	return index == MiniVstEffect::kPhase || index == MiniVstEffect::kOversampling;
+}
+
+//! パラメータを1つ変更する
+//! @return 遅延子のクリアが必要な変更かどうか
+template<class Params>
+bool	set_param	(Params &params, VstInt32 index, vst_param_t value)
+{
+	vst_param_t *param = find_param(params, index);
+	if(!param) {
+		return false;
+	}
+
+	bool const needs_clear = needs_clear_on_change(index, *param, value);
+	*param = value;
+	return needs_clear;
+}
 
 //! MiniVstEffectの実装
 MiniVstEffect::MiniVstEffect(audioMasterCallback audioMaster)
@@ -132,16 +562,44 @@ MiniVstEffect::MiniVstEffect(audioMasterCallback audioMaster)
 			audioMaster,
 			defines::kNumPrograms,
 			kNumParams )
-	,	b0_(0.0)
-	,	b1_(0.0)
-	,	b2_(0.0)
-	,	a0_(0.0)
-	,	a1_(0.0)
-	,	a2_(0.0)
+	,	filter_(kNumChannels)
+	,	svf_(kNumChannels)
+	,	eq_(kNumChannels)
+	,	slope_filter_(kNumChannels)
+	,	linear_(kNumChannels)
+	,	crossover_(kNumChannels)
+	,	oversampler_(kNumChannels)
+	,	clear_count_(0)
+	,	latency_(0)
+	,	requested_program_(-1)
+	,	audio_thread_(std::thread::id())
+	,	automation_pending_(false)
+	,	automation_clear_(false)
+	,	params_(FilterParams())
+	,	published_params_(FilterParams())
+	,	applied_params_(FilterParams())
+	,	num_param_events_(0)
+	,	num_parameter_writes_(0)
+	,	num_coeff_updates_(0)
+	,	use_crossover_(false)
+	,	use_coeff_table_(false)
+	,	silent_samples_(0)
+	,	tail_samples_(0)
+	,	bypassed_(false)
 {	
+	for(VstInt32 i = 0; i < kNumParams; ++i) {
+		values_[i].store(0, std::memory_order_relaxed);
+	}
+
+	//! クロスオーバーのビルド
+	//! Bandsのバンド数に分け、1番目からBands - 1番目のバンドのCutoffを分割周波数にする
+#if defined(HWM_MINIVSTEFFECT_CROSSOVER)
+	use_crossover_ = true;
+#endif
+
 	//! 出入力チャンネルの設定
 	setNumInputs(kNumChannels);
-	setNumOutputs(kNumChannels);
+	setNumOutputs(kNumChannels * static_cast<VstInt32>(get_num_output_busses()));
 
 	//! processReplacingが使用できることを表明
 	canProcessReplacing();
@@ -152,8 +610,31 @@ MiniVstEffect::MiniVstEffect(audioMasterCallback audioMaster)
 	//! uniqueIDの設定
 	setUniqueID(defines::kID);
 	
+	//! 単精度で処理するビルドでは、遅延子と演算も単精度にする
+	//! 低いカットオフで誤差が大きくなるので、mve_bench precisionの結果を見て選ぶこと
+#if defined(HWM_MINIVSTEFFECT_FLOAT_STATE)
+	filter_.get_filter().set_state_precision(dsp::StatePrecision::Float);
+#endif
+
+	//! 係数をテーブル引きで計算するビルド
+	//! 誤差はmve_bench coeff_tableで確認できる
+#if defined(HWM_MINIVSTEFFECT_COEFF_TABLE)
+	use_coeff_table_ = true;
+#endif
+	build_coeff_table();
+
+	filter_.set_control_interval(defines::kControlInterval);
+	svf_.set_control_interval(defines::kControlInterval);
+	eq_.set_control_interval(defines::kControlInterval);
+	slope_filter_.set_control_interval(defines::kControlInterval);
+
+	allocate_oversampled(kNumChannels);
+
 	//! Editorの設定
+	//! HWM_MINIVSTEFFECT_NO_EDITORを定義したビルド(mve_rtcheckなど)では、VSTGUIを使わない
+#if !defined(HWM_MINIVSTEFFECT_NO_EDITOR)
 	editor = new MiniVstEffectEditor(this);
+#endif
 
 	//! 先頭のプログラムを設定しておく
 	setProgram(0);
@@ -164,83 +645,98 @@ MiniVstEffect::~MiniVstEffect()
 
 void	MiniVstEffect::setProgram		(VstInt32 program)
 {
-	cur_program_ = defines::presets[program];
-	reset_coeffs();
-	clear_buffer();
+	VstProgram const &preset = defines::presets[program];
+	for(VstInt32 i = 0; i < kNumParams; ++i) {
+		values_[i].store(get_param(preset, i), std::memory_order_relaxed);
+	}
+
+	if(is_audio_thread()) {
+		//! 名前は次にロックを取ったときにcur_program_へ取り込む
+		requested_program_.store(program, std::memory_order_relaxed);
+		for(VstInt32 i = 0; i < kNumParams; ++i) {
+			automate_param(i, get_param(preset, i));
+		}
+		automation_clear_ = true;
+		return;
+	}
+
+	size_t latency = 0;
+	bool latency_changed = false;
+	{
+		std::lock_guard<std::mutex> lock(param_lock_);
+
+		requested_program_.store(-1, std::memory_order_relaxed);
+		cur_program_ = preset;
+		latency_changed = commit_program(true, latency);
+	}
+
+	if(latency_changed) {
+		report_latency(latency);
+	}
 }
 
 void	MiniVstEffect::setProgramName	(char *name)
 {
-	get_current_program().name_ = name;
+	vst_strncpy(get_current_program().name_, name, kVstMaxProgNameLen);
 }
 
 void	MiniVstEffect::getProgramName	(char *name)
 {
-	vst_strncpy(name, cur_program_.name_.c_str(), kVstMaxProgNameLen);
+	vst_strncpy(name, cur_program_.name_, kVstMaxProgNameLen);
 }
 
 bool	MiniVstEffect::getProgramNameIndexed (VstInt32 /*unused*/, VstInt32 index, char* text)
 {
-	vst_strncpy(text, defines::presets[index].name_.c_str(), kVstMaxProgNameLen);
+	vst_strncpy(text, defines::presets[index].name_, kVstMaxProgNameLen);
 	return true;
 }
 
 void	MiniVstEffect::setParameter		(VstInt32 index, vst_param_t value)
 {
+	if(index < 0 || index >= kNumParams) {
+		return;
+	}
+
 	AudioEffectX::setParameter(index, value);
-	bool filter_changed = false;
-	
-	switch(index) {
-	case kCutOff:
-		get_current_program().cutoff_ = value;
-		break;
+	++num_parameter_writes_;
+	values_[index].store(value, std::memory_order_relaxed);
+
+	if(is_audio_thread()) {
+		//! ホストがオーディオスレッドから呼び出す自動化では、ロックを取らない
+		//! ロックを持った書き込み側のスレッドが止められると、オーディオスレッドも待たされる
+		automate_param(index, value);
+	} else {
+		size_t latency = 0;
+		bool latency_changed = false;
+		{
+			std::lock_guard<std::mutex> lock(param_lock_);
 
-	case kdBGain:
-		get_current_program().db_gain_ = value;
-		break;
+			bool const needs_clear = set_param(get_current_program(), index, value);
 
-	case kQ:
-		get_current_program().Q_ = value;
-		break;
+			//! 反映は次のprocessReplacingの先頭で行う
+			latency_changed = commit_program(needs_clear, latency);
+		}
 
-	case kFilterType:
-		if( defines::param_to_filter(get_current_program().filter_type_) !=
-			defines::param_to_filter(value) )
-		{
-			filter_changed = true;
+		//! Editorからの変更はここに戻ってくるので、ロックの外で通知する
+		if(latency_changed) {
+			report_latency(latency);
 		}
-		get_current_program().filter_type_ = value;
-		break;
 	}
 
-	this->reset_coeffs();
-	
-	if(filter_changed) {
-		clear_buffer();
-	}
+#if !defined(HWM_MINIVSTEFFECT_NO_EDITOR)
 	if (editor) {
 		((AEffGUIEditor*)editor)->setParameter (index, value);
 	}
+#endif
 }
 
 vst_param_t
 		MiniVstEffect::getParameter		(VstInt32 index)
 {
-	switch(index) {
-	case kCutOff:
-		return get_current_program().cutoff_;
-
-	case kdBGain:
-		return get_current_program().db_gain_;
-
-	case kQ:
-		return get_current_program().Q_;
-
-	case kFilterType:
-		return get_current_program().filter_type_;
+	if(index < 0 || index >= kNumParams) {
+		return 0;
 	}
-	
-	return 0;
+	return values_[index].load(std::memory_order_relaxed);
 }
 
 void	MiniVstEffect::getParameterName(VstInt32 index, char *label)
@@ -261,32 +757,113 @@ void	MiniVstEffect::getParameterName(VstInt32 index, char *label)
 		case kFilterType:
 			vst_strncpy(label, "Filter Type", kVstMaxParamStrLen);
 			break;
+
+		case kEngine:
+			vst_strncpy(label, "Engine", kVstMaxParamStrLen);
+			break;
+
+		case kNumBands:
+			vst_strncpy(label, "Bands", kVstMaxParamStrLen);
+			break;
+
+		case kSlope:
+			vst_strncpy(label, "Slope", kVstMaxParamStrLen);
+			break;
+
+		case kAlignment:
+			vst_strncpy(label, "Response", kVstMaxParamStrLen);
+			break;
+
+		case kPhase:
+			vst_strncpy(label, "Phase", kVstMaxParamStrLen);
+			break;
+
+		case kOversampling:
+			vst_strncpy(label, "Oversmp", kVstMaxParamStrLen);
+			break;
+
+		default:
+			if(is_band_param(index)) {
+				//! "Cutoff2", "Gain2", "Q2", "Type2" ...
+				static char const * const names[kNumBandParams] = { "Cutoff", "Gain", "Q", "Type" };
+				std::snprintf(label, kVstMaxParamStrLen + 1, "%s%d",
+					names[(index - kBandParams) % kNumBandParams],
+					static_cast<int>((index - kBandParams) / kNumBandParams + 2));
+			}
+			break;
 	}
 }
 
 void	MiniVstEffect::getParameterDisplay(VstInt32 index, char *label)
 {
-	std::stringstream ss;
+	FilterParams const params = load_filter_params();
+
+	label[0] = '\0';
 
 	switch(index) {
 		case kCutOff:
-			ss << (getSampleRate() * get_cutoff());
+			defines::format_display(label, params.sampling_rate_ * get_cutoff(params));
 			break;
 
 		case kdBGain:
-			ss << get_db_gain();
+			defines::format_display(label, get_db_gain(params));
 			break;
 
 		case kQ:
-			ss << get_Q();
+			defines::format_display(label, get_Q(params));
 			break;
 
 		case kFilterType:
-			ss << defines::get_filter_string(get_filter_type());
+			defines::format_display(label, defines::get_filter_string(get_filter_type(params)));
+			break;
+
+		case kEngine:
+			defines::format_display(label, defines::get_engine_string(get_engine(params)));
+			break;
+
+		case kNumBands:
+			defines::format_display(label, get_num_bands(params));
+			break;
+
+		case kSlope:
+			defines::format_display(label, get_slope_sections(params) * 12);
+			break;
+
+		case kAlignment:
+			defines::format_display(label, defines::get_alignment_string(get_alignment(params)));
+			break;
+
+		case kPhase:
+			defines::format_display(label, defines::get_phase_string(defines::param_to_phase(params.phase_)));
+			break;
+
+		case kOversampling:
+			defines::format_display(label, defines::param_to_oversampling(params.oversampling_));
 			break;
-	}
 
-	vst_strncpy(label, ss.str().c_str(), kVstMaxParamStrLen);
+		default:
+			if(is_band_param(index)) {
+				size_t const band = (index - kBandParams) / kNumBandParams + 1;
+				BandParams const b = get_band(params, band);
+
+				switch((index - kBandParams) % kNumBandParams) {
+					case kBandCutOff:
+						defines::format_display(label,
+							params.sampling_rate_ * defines::param_to_cutoff(b.cutoff_, params.sampling_rate_));
+						break;
+					case kBanddBGain:
+						defines::format_display(label, defines::param_to_db(b.db_gain_));
+						break;
+					case kBandQ:
+						defines::format_display(label, defines::param_to_Q(b.Q_));
+						break;
+					case kBandFilterType:
+						defines::format_display(label, defines::get_filter_string(defines::param_to_filter(b.filter_type_)));
+						break;
+				}
+			}
+			break;
+	}
 }
 
 void	MiniVstEffect::getParameterLabel(VstInt32 index, char *label)
@@ -306,6 +883,38 @@ void	MiniVstEffect::getParameterLabel(VstInt32 index, char *label)
 
 		case kFilterType:
 			vst_strncpy(label, "", kVstMaxParamStrLen);
+			break;
+
+		case kEngine:
+			vst_strncpy(label, "", kVstMaxParamStrLen);
+			break;
+
+		case kNumBands:
+			vst_strncpy(label, "", kVstMaxParamStrLen);
+			break;
+
+		case kSlope:
+			vst_strncpy(label, "dB/oct", kVstMaxParamStrLen);
+			break;
+
+		case kAlignment:
+			vst_strncpy(label, "", kVstMaxParamStrLen);
+			break;
+
+		case kPhase:
+			vst_strncpy(label, "", kVstMaxParamStrLen);
+			break;
+
+		case kOversampling:
+			vst_strncpy(label, "x", kVstMaxParamStrLen);
+			break;
+
+		default:
+			if(is_band_param(index)) {
+				static char const * const labels[kNumBandParams] = { "Hz", "dB", "", "" };
+				vst_strncpy(label, labels[(index - kBandParams) % kNumBandParams], kVstMaxParamStrLen);
+			}
+			break;
 	}
 }
 
@@ -333,49 +942,190 @@ VstInt32
 	return defines::kVendorVersion;
 }
 
-//! reset_coeffsで設定した係数を元に、IIRフィルタをかける
-double	MiniVstEffect::process	(size_t channel, double input) const
+void	MiniVstEffect::processReplacing	(float ** input, float ** output, VstInt32 sampleFrames)
 {
-	double const ret =
-		(b0_/a0_) * input + (b1_/a0_) * x_[channel][0] + (b2_/a0_) * x_[channel][1]
-						 - (a1_/a0_) * y_[channel][0] - (a2_/a0_) * y_[channel][1];
+	dsp::ScopedFlushDenormals const flush;
+
+	audio_thread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+	update_filter();
 
-		x_[channel][1] = x_[channel][0];
-		x_[channel][0] = input;
-		y_[channel][1] = y_[channel][0];
-		y_[channel][0] = ret;
-		
-	return ret;
+	//! L/Rをまとめて処理する
+	process_block(input, output, static_cast<size_t>(sampleFrames));
 }
 
-void	MiniVstEffect::processReplacing	(float ** input, float ** output, VstInt32 sampleFrames)
+void	MiniVstEffect::processDoubleReplacing(double ** input, double ** output, VstInt32 sampleFrames)
 {
-	for(size_t ch = 0; ch < kNumChannels; ++ch) {
+	dsp::ScopedFlushDenormals const flush;
 
-		float const * const x = input[ch];
-		float * const y = output[ch];
+	audio_thread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+	update_filter();
 
-		for(size_t i = 0; i < sampleFrames; ++i) {
-			y[i] = static_cast<float>(process(ch, x[i]));
-		}
-	}
+	process_block(input, output, static_cast<size_t>(sampleFrames));
 }
 
-void	MiniVstEffect::processDoubleReplacing(double ** input, double ** output, VstInt32 sampleFrames)
+void	MiniVstEffect::setSampleRate	(float sampleRate)
 {
-	for(size_t ch = 0; ch < kNumChannels; ++ch) {
+	AudioEffectX::setSampleRate(sampleRate);
 
-		double const * const x = input[ch];
-		double * const y = output[ch];
+	//! カットオフの正規化周波数はサンプリング周波数に依存する
+	//! ホストは処理を止めている間にしか呼び出さないので、テーブルはここで作り直す
+	build_coeff_table();
 
-		for(size_t i = 0; i < sampleFrames; ++i) {
-			y[i] = process(ch, x[i]);
-		}
+	size_t latency = 0;
+	bool latency_changed = false;
+	{
+		std::lock_guard<std::mutex> lock(param_lock_);
+		latency_changed = commit_program(false, latency);
+	}
+
+	if(latency_changed) {
+		report_latency(latency);
 	}
 }
 
-VstProgram &
-		MiniVstEffect::get_current_program()
+VstInt32
+		MiniVstEffect::getGetTailSize	()
+{
+	size_t const tail = get_tail_samples(load_filter_params());
+
+	//! 0は尾の長さが不明という意味になるので、尾がないときは1を返す
+	return (tail == 0) ? 1 : static_cast<VstInt32>(tail);
+}
+
+void	MiniVstEffect::suspend	()
+{
+	//! 止まっている間のブロックは処理されないので、次のブロック向けのイベントは捨てる
+	num_param_events_ = 0;
+
+	AudioEffectX::suspend();
+}
+
+void	MiniVstEffect::resume	()
+{
+	//! ホストは処理を止めている間にしか呼び出さないので、オーディオスレッドの状態をここで戻す
+	//! 止める前の信号の続きは出さない。遅延子は0なので、バイパスから始める
+	clear_buffer();
+	silent_samples_ = 0;
+	bypassed_ = true;
+
+	//! オーディオスレッドからの位相とオーバーサンプリングの変更は、まだ切り替えていなければここで切り替える
+	size_t latency = 0;
+	bool latency_changed = false;
+	{
+		std::lock_guard<std::mutex> lock(param_lock_);
+		latency_changed = commit_program(false, latency);
+	}
+
+	if(latency_changed) {
+		report_latency(latency);
+	}
+
+	AudioEffectX::resume();
+}
+
+bool	MiniVstEffect::setSpeakerArrangement	(VstSpeakerArrangement *pluginInput,
+												 VstSpeakerArrangement *pluginOutput)
+{
+	if(!pluginInput || !pluginOutput) {
+		return false;
+	}
+
+	VstInt32 const num_channels = pluginInput->numChannels;
+	VstInt32 const num_busses = static_cast<VstInt32>(get_num_output_busses());
+	if(	num_channels < 1 || num_channels > kMaxChannels ||
+		pluginOutput->numChannels != num_channels * num_busses)
+	{
+		return false;
+	}
+
+	setNumInputs(num_channels);
+	setNumOutputs(num_channels * num_busses);
+
+	//! 全チャンネルを1つのフィルタで処理する
+	//! チャンネルはSIMDのレーンに並べて計算されるので、インスタンスを並べるより軽い
+	filter_.get_filter().set_num_channels(static_cast<size_t>(num_channels));
+	svf_.get_filter().set_num_channels(static_cast<size_t>(num_channels));
+	eq_.get_filter().set_num_channels(static_cast<size_t>(num_channels));
+	slope_filter_.get_filter().set_num_channels(static_cast<size_t>(num_channels));
+	linear_.set_num_channels(static_cast<size_t>(num_channels));
+	crossover_.set_num_channels(static_cast<size_t>(num_channels));
+	oversampler_.set_num_channels(static_cast<size_t>(num_channels));
+	allocate_oversampled(static_cast<size_t>(num_channels));
+
+	return true;
+}
+
+VstInt32
+		MiniVstEffect::processEvents	(VstEvents *events)
+{
+	for(VstInt32 i = 0; i < events->numEvents; ++i) {
+		VstEvent const *event = events->events[i];
+		if(event->type != kVstMidiType) {
+			continue;
+		}
+
+		VstMidiEvent const *midi = reinterpret_cast<VstMidiEvent const *>(event);
+		int const status = midi->midiData[0] & 0xF0;
+		int const cc = midi->midiData[1] & 0x7F;
+		int const value = midi->midiData[2] & 0x7F;
+
+		//! パラメータに対応するコントロールチェンジ以外は使わない
+		int const param = defines::cc_to_param(cc);
+		if(status != 0xB0 || param < 0) {
+			continue;
+		}
+
+		size_t const offset =
+			(midi->deltaFrames > 0) ? static_cast<size_t>(midi->deltaFrames) : 0;
+		add_param_event(param, value / 127.0f, offset);
+	}
+
+	return 1;
+}
+
+VstInt32
+		MiniVstEffect::canDo	(char *text)
+{
+	if(	std::strcmp(text, "receiveVstEvents") == 0 ||
+		std::strcmp(text, "receiveVstMidiEvent") == 0)
+	{
+		return 1;
+	}
+
+	return AudioEffectX::canDo(text);
+}
+
+void	MiniVstEffect::add_param_event	(VstInt32 index, vst_param_t value, size_t offset)
+{
+	if(num_param_events_ == kMaxParamEvents) {
+		return;
+	}
+
+	//! ホストはふつうoffsetの順に渡してくるので、後ろから挿入位置を探す
+	//! 同じ位置のイベントは渡された順に反映する
+	size_t pos = num_param_events_;
+	while(pos > 0 && param_events_[pos - 1].offset_ > offset) {
+		param_events_[pos] = param_events_[pos - 1];
+		--pos;
+	}
+
+	ParamEvent const event = { offset, index, value };
+	param_events_[pos] = event;
+	++num_param_events_;
+}
+
+size_t	MiniVstEffect::get_num_parameter_writes	() const
+{
+	return num_parameter_writes_;
+}
+
+size_t	MiniVstEffect::get_num_coeff_updates	() const
+{
+	return num_coeff_updates_;
+}
+
+VstProgram &
+		MiniVstEffect::get_current_program()
 {
 	return cur_program_;
 }
@@ -388,121 +1138,678 @@ VstProgram const &
 
 void	MiniVstEffect::clear_buffer()
 {
-	for(size_t ch = 0; ch < kNumChannels; ++ch) {
-		for(size_t i = 0; i < 2; ++i) {
-			x_[ch][i] = y_[ch][i] = 0.0;
+	filter_.get_filter().clear_buffer();
+	svf_.get_filter().clear_buffer();
+	eq_.get_filter().clear_buffer();
+	slope_filter_.get_filter().clear_buffer();
+	linear_.clear_buffer();
+	crossover_.clear_buffer();
+	oversampler_.clear_buffer();
+}
+
+void	MiniVstEffect::flush_denormals	()
+{
+	//! FIRで処理するlinear_とoversampler_は、入力が0なら状態もすぐに0になる
+	filter_.get_filter().flush_denormals();
+	svf_.get_filter().flush_denormals();
+	eq_.get_filter().flush_denormals();
+	slope_filter_.get_filter().flush_denormals();
+	crossover_.flush_denormals();
+}
+
+void	MiniVstEffect::allocate_oversampled	(size_t num_channels)
+{
+	size_t const size = dsp::Oversampler::kMaxBlockSize * dsp::Oversampler::kMaxFactor;
+	oversampled_.assign(num_channels * size, 0.0);
+	oversampled_channels_.resize(num_channels);
+	for(size_t ch = 0; ch < num_channels; ++ch) {
+		oversampled_channels_[ch] = &oversampled_[ch * size];
+	}
+}
+
+void	MiniVstEffect::report_latency	(size_t latency)
+{
+	setInitialDelay(static_cast<VstInt32>(latency));
+	ioChanged();
+}
+
+bool	MiniVstEffect::is_audio_thread	()
+{
+	VstInt32 const level = getCurrentProcessLevel();
+	if(level == kVstProcessLevelRealtime) {
+		return true;
+	}
+	if(level == kVstProcessLevelUser) {
+		return false;
+	}
+	return std::this_thread::get_id() == audio_thread_.load(std::memory_order_relaxed);
+}
+
+void	MiniVstEffect::automate_param	(VstInt32 index, vst_param_t value)
+{
+	//! 遅延が変わるパラメータは、次にオーディオスレッド以外から呼び出されたときにcommit_programで切り替える
+	if(changes_latency(index)) {
+		return;
+	}
+
+	automation_clear_ = set_param(applied_params_, index, value) || automation_clear_;
+	automation_pending_ = true;
+}
+
+size_t	MiniVstEffect::get_latency	(FilterParams const &params) const
+{
+	if(use_crossover_) {
+		return 0;
+	}
+	if(is_linear_phase(params)) {
+		return linear_.get_latency();
+	}
+	return dsp::Oversampler::get_latency(get_oversampling(params));
+}
+
+size_t	MiniVstEffect::get_tail_samples	(FilterParams const &params) const
+{
+	//! 線形位相のFIRの応答は、遅延の2倍で終わる
+	size_t const latency = get_latency(params);
+	if(!use_crossover_ && is_linear_phase(params)) {
+		return 2 * latency;
+	}
+
+	//! 係数は処理するレートで求める
+	size_t const factor = get_oversampling(params);
+	double const rate = params.sampling_rate_;
+	size_t const num_bands = get_num_bands(params);
+	double radius = 0;
+
+	if(use_crossover_) {
+		if(num_bands > 1) {
+			size_t const num_sections = (get_slope_sections(params) <= 2) ? 1 : 2;
+			double Q[dsp::kMaxCrossoverSections];
+			dsp::get_slope_Qs(num_sections, dsp::Alignment::Butterworth, Q);
+			for(size_t band = 0; band + 1 < num_bands; ++band) {
+				double const split = defines::param_to_cutoff(get_band(params, band).cutoff_, rate);
+				for(size_t i = 0; i < num_sections; ++i) {
+					radius = std::max(radius, dsp::get_pole_radius(
+						dsp::design_biquad(dsp::FilterType::LPF, split, 0.0, Q[i])));
+				}
+			}
+		}
+	} else if(num_bands > 1) {
+		for(size_t band = 0; band < num_bands; ++band) {
+			BandParams const b = get_band(params, band);
+			radius = std::max(radius, dsp::get_pole_radius(
+				dsp::design_biquad(
+					defines::param_to_filter(b.filter_type_),
+					defines::param_to_cutoff(b.cutoff_, rate) / factor,
+					defines::param_to_db(b.db_gain_),
+					defines::param_to_Q(b.Q_))));
 		}
+	} else if(uses_slope_filter(params)) {
+		dsp::SlopeCoeffs const c =
+			dsp::design_slope(
+				get_filter_type(params), get_cutoff(params) / factor,
+				get_slope_sections(params), get_alignment(params));
+		for(size_t i = 0; i < c.num_sections_; ++i) {
+			radius = std::max(radius, dsp::get_pole_radius(c.sections_[i]));
+		}
+	} else {
+		//! SVFの極はbi-quadと同じ
+		radius = dsp::get_pole_radius(
+			dsp::design_biquad(
+				get_filter_type(params), get_cutoff(params) / factor,
+				get_db_gain(params), get_Q(params)));
 	}
+
+	size_t const max_length = static_cast<size_t>(defines::kMaxTailTime * rate) * factor;
+	size_t const decay = dsp::get_decay_length(radius, defines::kTailDecay, max_length);
+	return (decay + factor - 1) / factor + 2 * latency;
 }
 
-void	MiniVstEffect::reset_coeffs	()
+template<class T>
+void	MiniVstEffect::process_block	(T **input, T **output, size_t n)
 {
-	double const Q = get_Q();
-	double const A = pow(10.0, get_db_gain() / 40);
-	double const w0 = 2.0 * M_PI * get_cutoff();
-	double const cos_w0 = cos(w0);
-	double const sin_w0 = sin(w0);
-	double const alpha = sin_w0 / (2.0 * Q);
-	double const K = 2.0 * sqrt(A) * alpha;
+	size_t const num_channels = filter_.get_filter().get_num_channels();
+	size_t const num_outputs = num_channels * get_num_output_busses();
+	bool const silent =
+		dsp::is_silent(input, num_channels, 0, n, defines::kSilenceThreshold);
+
+	if(!silent) {
+		silent_samples_ = 0;
+		if(bypassed_) {
+			//! バイパス中に変わったパラメータは平滑化せず、目標値から始める
+			//! 遅延子は0なので、切り替えても不連続にならない
+			bypassed_ = false;
+			apply_params(true);
+		}
+	} else if(silent_samples_ < tail_samples_) {
+		silent_samples_ += n;
+	}
 
-	switch(get_filter_type()) {
-		case defines::LPF:
-			b0_ = (1.0 - cos_w0) / 2.0;
-			b1_ = 1.0 - cos_w0;
-			b2_ = (1.0 - cos_w0) / 2.0;
-			a0_ = 1.0 + alpha;
-			a1_ = -2.0 * cos_w0;
-			a2_ = 1.0 - alpha;
-			break;
+	if(bypassed_) {
+		//! イベントはパラメータにだけ反映する
+		bool changed = false;
+		for(size_t i = 0; i < num_param_events_; ++i) {
+			changed = apply_param_event(param_events_[i]) || changed;
+		}
+		num_param_events_ = 0;
+		if(changed) {
+			update_response();
+		}
 
-		case defines::HPF:
-			b0_ = (1.0 + cos_w0) / 2.0;
-			b1_ = -(1.0 + cos_w0);
-			b2_ = (1.0 + cos_w0) / 2.0;
-			a0_ = 1.0 + alpha;
-			a1_ = -2.0 * cos_w0;
-			a2_ = 1.0 - alpha;
-			break;
+		for(size_t ch = 0; ch < num_outputs; ++ch) {
+			std::fill(output[ch], output[ch] + n, static_cast<T>(0));
+		}
+		return;
+	}
 
-		case defines::BPF:
-			//(constant skirt gain, peak gain = Q)
-			b0_ = sin_w0 / 2.0;
-			b1_ = 0;
-			b2_ = -sin_w0 / 2.0;
-			a0_ = 1 + alpha;
-			a1_ = -2 * cos_w0;
-			a2_ = 1 - alpha;
-			break;
+	process_events(input, output, n);
 
-		case defines::notch:
-			b0_ = 1;
-			b1_ = -2 * cos_w0;
-			b2_ = 1;
-			a0_ = 1 + alpha;
-			a1_ = -2 * cos_w0;
-			a2_ = 1 - alpha;
-			break;
+	if(!dsp::ScopedFlushDenormals::is_supported()) {
+		flush_denormals();
+	}
 
-		case defines::APF:
-			b0_ = 1.0 - alpha;
-			b1_ = -2.0 * cos_w0;
-			b2_ = 1.0 + alpha;
-			a0_ = 1.0 + alpha;
-			a1_ = -2.0 * cos_w0;
-			a2_ = 1.0 - alpha;
-			break;
+	//! 入力が無音になってから尾の長さが経ち、出力も無音なら、遅延子は減衰しきっている
+	//! 残っている値はクリアして、次のブロックからバイパスする
+	if(	silent && silent_samples_ >= tail_samples_ &&
+		dsp::is_silent(output, num_outputs, 0, n, defines::kSilenceThreshold))
+	{
+		bypassed_ = true;
+		clear_buffer();
+	}
+}
 
-		case defines::PeakingEQ:
-			b0_ = 1 + alpha * A;
-			b1_ = -2 * cos_w0;
-			b2_ = 1 - alpha * A;
-			a0_ = 1 + alpha / A;
-			a1_ = -2.0 * cos_w0;
-			a2_ = 1 - alpha / A;
-			break;
+template<class T>
+void	MiniVstEffect::process_events	(T **input, T **output, size_t n)
+{
+	size_t pos = 0;
+	bool changed = false;
+
+	//! イベントのない区間はブロックのまま処理する
+	//! 同じ位置のイベントはまとめて反映するので、係数の計算は位置ごとに1回になる
+	for(size_t i = 0; i < num_param_events_; ++i) {
+		ParamEvent const &event = param_events_[i];
+		size_t const offset = (event.offset_ < n) ? event.offset_ : n;
+
+		if(offset > pos) {
+			process_filter(input, output, pos, offset - pos);
+			pos = offset;
+		}
+		changed = apply_param_event(event) || changed;
+	}
+	num_param_events_ = 0;
 
-		case defines::LowShelf:
-			b0_ = A * ( (A+1) - (A-1) * cos_w0 + K );
-			b1_ = 2 * A * ( (A-1) - (A+1) * cos_w0 );
-			b2_ = A * ( (A+1) - (A-1) * cos_w0 - K );
-			a0_ = (A+1) + (A-1) * cos_w0 + K;
-			a1_ = -2 * ( (A-1) + (A+1) * cos_w0 );
-			a2_ = (A+1) + (A-1) * cos_w0 - K;
-			break;
+	if(pos < n) {
+		process_filter(input, output, pos, n - pos);
+	}
 
-		case defines::HighShelf:
-			b0_ = A * ( (A+1) + (A-1) * cos_w0 + K );
-			b1_ = -2 * A * ( (A-1) + (A+1) * cos_w0 );
-			b2_ = A * ( (A+1) + (A-1) * cos_w0 - K );
-			a0_ = (A+1) - (A-1) * cos_w0 + K;
-			a1_ = 2 * ( (A-1) - (A+1) * cos_w0 );
-			a2_ = (A+1) - (A-1) * cos_w0 - K;
-			break;
+	//! 尾の長さと線形位相のFIRの要求は、最後のイベントの後で1回だけ更新する
+	if(changed) {
+		update_response();
+	}
+}
+
+template<class T>
+void	MiniVstEffect::process_filter	(T **input, T **output, size_t offset, size_t n)
+{
+	if(use_crossover_) {
+		process_crossover(input, output, offset, n);
+		return;
+	}
+	if(is_linear_phase(applied_params_)) {
+		linear_.process_block(input, output, offset, n);
+		return;
+	}
+
+	size_t const factor = oversampler_.get_factor();
+	if(factor == 1) {
+		process_engine(input, output, offset, n);
+		return;
+	}
+
+	//! 高いレートではチャンネルごとのバッファに置いて、その場で処理する
+	size_t const num_channels = oversampler_.get_num_channels();
+	double **fast = &oversampled_channels_[0];
+	for(size_t pos = 0; pos < n; pos += dsp::Oversampler::kMaxBlockSize) {
+		size_t const len = std::min<size_t>(dsp::Oversampler::kMaxBlockSize, n - pos);
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			oversampler_.upsample(ch, input[ch] + offset + pos, fast[ch], len);
+		}
+		process_engine(fast, fast, 0, len * factor);
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			oversampler_.downsample(ch, fast[ch], output[ch] + offset + pos, len);
+		}
+	}
+}
+
+template<class T>
+void	MiniVstEffect::process_engine	(T **input, T **output, size_t offset, size_t n)
+{
+	if(get_num_bands(applied_params_) > 1) {
+		BiquadDesigner const design = { this };
+		eq_.process_block(design, input, output, offset, n);
+	} else if(uses_slope_filter(applied_params_)) {
+		SlopeDesigner const design = { this };
+		slope_filter_.process_block(design, input, output, offset, n);
+	} else if(get_engine(applied_params_) == defines::kSvf) {
+		SvfDesigner const design = { this };
+		svf_.process_block(design, input, output, offset, n);
+	} else {
+		BiquadDesigner const design = { this };
+		filter_.process_block(design, input, output, offset, n);
+	}
+}
+
+template<class T>
+void	MiniVstEffect::process_crossover	(T **input, T **output, size_t offset, size_t n)
+{
+	size_t const num_channels = crossover_.get_num_channels();
+	size_t const num_bands = get_num_bands(applied_params_);
+	size_t first_silent = num_bands;
+
+	if(num_bands > 1) {
+		crossover_.process_block(input, output, offset, n);
+	} else {
+		//! 1バンドなら分けずに最初の組に出力する
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			if(output[ch] != input[ch]) {
+				std::copy(input[ch] + offset, input[ch] + offset + n, output[ch] + offset);
+			}
+		}
+		first_silent = 1;
+	}
+
+	for(size_t b = first_silent; b < dsp::kMaxCrossoverBands; ++b) {
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			T *dst = output[b * num_channels + ch] + offset;
+			std::fill(dst, dst + n, static_cast<T>(0));
+		}
+	}
+}
+
+size_t	MiniVstEffect::get_num_output_busses	() const
+{
+	return use_crossover_ ? dsp::kMaxCrossoverBands : 1;
+}
+
+dsp::BiquadCoeffs
+		MiniVstEffect::BiquadDesigner::operator()	(size_t filter_type, double cutoff,
+													 double db_gain, double Q) const
+{
+	++owner_->num_coeff_updates_;
+
+	if(owner_->uses_coeff_table()) {
+		return
+			owner_->coeff_table_.design(filter_type, cutoff, db_gain, defines::param_to_Q(Q));
+	}
+
+	return
+		dsp::design_biquad(
+			filter_type,
+			owner_->get_processing_cutoff(cutoff),
+			defines::param_to_db(static_cast<vst_param_t>(db_gain)),
+			defines::param_to_Q(Q)
+			);
+}
+
+dsp::SlopeCoeffs
+		MiniVstEffect::SlopeDesigner::operator()	(size_t filter_type, double cutoff,
+													 double /*db_gain*/, double /*Q*/) const
+{
+	++owner_->num_coeff_updates_;
+
+	FilterParams const &params = owner_->applied_params_;
+
+	if(owner_->uses_coeff_table()) {
+		return
+			owner_->coeff_table_.design_slope(
+				filter_type, cutoff, get_slope_sections(params), get_alignment(params));
+	}
+
+	return
+		dsp::design_slope(
+			filter_type,
+			owner_->get_processing_cutoff(cutoff),
+			get_slope_sections(params),
+			get_alignment(params)
+			);
+}
+
+dsp::SvfCoeffs
+		MiniVstEffect::SvfDesigner::operator()	(size_t filter_type, double cutoff,
+												 double db_gain, double Q) const
+{
+	++owner_->num_coeff_updates_;
+
+	if(owner_->uses_coeff_table()) {
+		return
+			owner_->coeff_table_.design_svf(filter_type, cutoff, db_gain, defines::param_to_Q(Q));
+	}
+
+	return
+		dsp::design_svf(
+			filter_type,
+			owner_->get_processing_cutoff(cutoff),
+			defines::param_to_db(static_cast<vst_param_t>(db_gain)),
+			defines::param_to_Q(Q)
+			);
+}
+
+void	MiniVstEffect::build_coeff_table	()
+{
+	if(!use_coeff_table_) {
+		return;
 	}
+
+	dsp::ParamMapping const mapping = { get_sampling_rate() };
+	coeff_table_.build(mapping);
+}
+
+bool	MiniVstEffect::uses_coeff_table	() const
+{
+	return use_coeff_table_ && oversampler_.get_factor() == 1;
 }
 
-double	MiniVstEffect::get_db_gain		() const
+double	MiniVstEffect::get_processing_cutoff	(double cutoff) const
 {
+	//! パラメータから周波数への写像はもとのサンプリング周波数で決まる
 	return
-		defines::param_to_db(get_current_program().db_gain_);
+		defines::param_to_cutoff(cutoff, applied_params_.sampling_rate_) / oversampler_.get_factor();
+}
+
+void	MiniVstEffect::update_filter	()
+{
+	//! オーディオスレッドからの変更は、スナップショットより先にapplied_params_に書いてある
+	bool needs_clear = automation_clear_;
+	bool reset = automation_clear_;
+	bool const automated = automation_pending_;
+	automation_pending_ = false;
+	automation_clear_ = false;
+
+	//! 書き込み側とはロックを共有しない
+	//! 取り込んだスナップショットは書き込みの途中で変わることがない
+	if(!params_.update()) {
+		if(automated) {
+			apply_params(reset);
+			if(needs_clear) {
+				clear_buffer();
+			}
+		}
+		return;
+	}
+
+	FilterParams const &params = params_.get();
+	needs_clear = needs_clear || (params.clear_count_ != applied_params_.clear_count_);
+	reset = reset || needs_clear || (params.sampling_rate_ != applied_params_.sampling_rate_);
+
+	//! イベントやオーディオスレッドから変更した値は、書き込み側で同じパラメータが変更されるまで残す
+	merge_param(applied_params_.cutoff_, published_params_.cutoff_, params.cutoff_);
+	merge_param(applied_params_.db_gain_, published_params_.db_gain_, params.db_gain_);
+	merge_param(applied_params_.Q_, published_params_.Q_, params.Q_);
+	merge_param(applied_params_.filter_type_, published_params_.filter_type_, params.filter_type_);
+	merge_param(applied_params_.engine_, published_params_.engine_, params.engine_);
+	merge_param(applied_params_.num_bands_, published_params_.num_bands_, params.num_bands_);
+	merge_param(applied_params_.slope_, published_params_.slope_, params.slope_);
+	merge_param(applied_params_.alignment_, published_params_.alignment_, params.alignment_);
+	merge_param(applied_params_.phase_, published_params_.phase_, params.phase_);
+	merge_param(applied_params_.oversampling_, published_params_.oversampling_, params.oversampling_);
+	for(size_t i = 0; i < kMaxBands - 1; ++i) {
+		BandParams &applied = applied_params_.bands_[i];
+		BandParams const &published = published_params_.bands_[i];
+		BandParams const &value = params.bands_[i];
+		merge_param(applied.cutoff_, published.cutoff_, value.cutoff_);
+		merge_param(applied.db_gain_, published.db_gain_, value.db_gain_);
+		merge_param(applied.Q_, published.Q_, value.Q_);
+		merge_param(applied.filter_type_, published.filter_type_, value.filter_type_);
+	}
+	applied_params_.sampling_rate_ = params.sampling_rate_;
+	applied_params_.clear_count_ = params.clear_count_;
+	published_params_ = params;
+
+	//! 倍率が変わるのは遅延子をクリアするときだけ
+	//! 係数の計算が倍率を使うので、apply_paramsより先に切り替える
+	size_t const factor = get_oversampling(applied_params_);
+	if(oversampler_.get_factor() != factor) {
+		oversampler_.set_factor(factor);
+	}
+
+	//! 平滑化の長さは処理するレートのサンプル数
+	size_t const smoothing_length =
+		static_cast<size_t>(defines::kSmoothingTime * params.sampling_rate_ * factor);
+	filter_.set_smoothing_length(smoothing_length);
+	svf_.set_smoothing_length(smoothing_length);
+	eq_.set_smoothing_length(smoothing_length);
+	slope_filter_.set_smoothing_length(smoothing_length);
+
+	//! フィルタタイプやサンプリング周波数が変わったときは、滑らかにせずに切り替える
+	apply_params(reset);
+
+	if(needs_clear) {
+		clear_buffer();
+	}
+}
+
+dsp::ResponseSections
+		MiniVstEffect::make_response_sections	() const
+{
+	FilterParams const &params = applied_params_;
+	dsp::ResponseSections r;
+
+	if(get_num_bands(params) > 1) {
+		BiquadDesigner const design = { this };
+		r.num_sections_ = get_num_bands(params);
+		for(size_t band = 0; band < r.num_sections_; ++band) {
+			BandParams const b = get_band(params, band);
+			r.sections_[band] = design(defines::param_to_filter(b.filter_type_), b.cutoff_, b.db_gain_, b.Q_);
+		}
+	} else if(uses_slope_filter(params)) {
+		SlopeDesigner const design = { this };
+		dsp::SlopeCoeffs const c =
+			design(get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+		r.num_sections_ = c.num_sections_;
+		for(size_t i = 0; i < c.num_sections_; ++i) {
+			r.sections_[i] = c.sections_[i];
+		}
+	} else {
+		//! SVFはbi-quadと同じ振幅特性なので、エンジンによらずbi-quadの係数を使う
+		BiquadDesigner const design = { this };
+		r.num_sections_ = 1;
+		r.sections_[0] = design(get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+	}
+
+	return r;
+}
+
+void	MiniVstEffect::apply_params		(bool reset)
+{
+	set_filter_params(reset);
+	update_response();
+}
+
+void	MiniVstEffect::set_filter_params	(bool reset)
+{
+	FilterParams const &params = applied_params_;
+
+	//! 係数の計算は各フィルタが処理の中で行う
+	//! 使っていない方のフィルタも目標値だけは追従させておく
+	if(reset) {
+		filter_.reset_params(
+			get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+		svf_.reset_params(
+			get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+		slope_filter_.reset_params(
+			get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+	} else {
+		filter_.set_params(
+			get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+		svf_.set_params(
+			get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+		slope_filter_.set_params(
+			get_filter_type(params), params.cutoff_, params.db_gain_, params.Q_);
+	}
+
+	//! バンド数が変わるのは遅延子をクリアするときだけなので、resetと同時になる
+	size_t const num_bands = get_num_bands(params);
+	if(eq_.get_num_bands() != num_bands) {
+		eq_.set_num_bands(num_bands);
+	}
+
+	for(size_t band = 0; band < num_bands; ++band) {
+		BandParams const b = get_band(params, band);
+		size_t const filter_type = defines::param_to_filter(b.filter_type_);
+		if(reset) {
+			eq_.reset_band_params(band, filter_type, b.cutoff_, b.db_gain_, b.Q_);
+		} else {
+			eq_.set_band_params(band, filter_type, b.cutoff_, b.db_gain_, b.Q_);
+		}
+	}
+
+	//! クロスオーバーの分割周波数は、1番目からnum_bands - 1番目のバンドのカットオフを低い順に並べたもの
+	//! 傾きは24dB/oct以下ならLR24、それより急ならLR48
+	if(use_crossover_ && num_bands > 1) {
+		if(crossover_.get_num_bands() != num_bands) {
+			crossover_.set_num_bands(num_bands);
+		}
+		size_t const slope =
+			(get_slope_sections(params) <= 2) ? dsp::CrossoverSlope::LR24 : dsp::CrossoverSlope::LR48;
+		if(crossover_.get_slope() != slope) {
+			crossover_.set_slope(slope);
+		}
+
+		double splits[dsp::kMaxCrossoverBands - 1];
+		for(size_t band = 0; band + 1 < num_bands; ++band) {
+			splits[band] = defines::param_to_cutoff(get_band(params, band).cutoff_, params.sampling_rate_);
+		}
+		std::sort(splits, splits + num_bands - 1);
+
+		size_t const smoothing_length =
+			reset ? 0 : static_cast<size_t>(defines::kSmoothingTime * params.sampling_rate_);
+		for(size_t i = 0; i + 1 < num_bands; ++i) {
+			crossover_.set_split(i, splits[i], smoothing_length);
+		}
+	}
+}
+
+void	MiniVstEffect::update_response	()
+{
+	FilterParams const &params = applied_params_;
+
+	//! FIRの設計は設計スレッドに任せるので、ここでは要求を置くだけ
+	//! 設計中に来た要求は最新のものだけが設計される
+	if(is_linear_phase(params)) {
+		linear_.set_response(make_response_sections());
+	}
+
+	tail_samples_ = get_tail_samples(params);
+}
+
+bool	MiniVstEffect::apply_param_event	(ParamEvent const &event)
+{
+	//! 遅延が変わるので、オーディオスレッドからは切り替えない
+	if(changes_latency(event.index_)) {
+		return false;
+	}
+
+	//! setParameterと同じく、フィルタタイプ、エンジン、バンド数、傾きの変更では遅延子をクリアする
+	bool const needs_clear = set_param(applied_params_, event.index_, event.value_);
+
+	//! イベントの値は、その位置から平滑化せずに使う
+	//! 係数の計算は、次に処理する区間の先頭での1回だけになる
+	set_filter_params(true);
+
+	if(needs_clear) {
+		clear_buffer();
+	}
+	return true;
+}
+
+FilterParams
+		MiniVstEffect::make_filter_params	() const
+{
+	VstProgram const &prog = get_current_program();
+
+	FilterParams params;
+	params.cutoff_			= prog.cutoff_;
+	params.db_gain_			= prog.db_gain_;
+	params.Q_				= prog.Q_;
+	params.filter_type_		= prog.filter_type_;
+	params.engine_			= prog.engine_;
+	params.num_bands_		= prog.num_bands_;
+	params.slope_			= prog.slope_;
+	params.alignment_		= prog.alignment_;
+	params.phase_			= prog.phase_;
+	params.oversampling_	= prog.oversampling_;
+	for(size_t i = 0; i < kMaxBands - 1; ++i) {
+		params.bands_[i] = prog.bands_[i];
+	}
+	params.sampling_rate_	= get_sampling_rate();
+	params.clear_count_		= clear_count_;
+	return params;
+}
+
+FilterParams
+		MiniVstEffect::load_filter_params	() const
+{
+	FilterParams params = FilterParams();
+	for(VstInt32 i = 0; i < kNumParams; ++i) {
+		*find_param(params, i) = values_[i].load(std::memory_order_relaxed);
+	}
+	params.sampling_rate_	= get_sampling_rate();
+	return params;
+}
+
+bool	MiniVstEffect::commit_program	(bool needs_clear, size_t &latency)
+{
+	VstInt32 const program = requested_program_.exchange(-1, std::memory_order_relaxed);
+	if(program >= 0) {
+		vst_strncpy(cur_program_.name_, defines::presets[program].name_, kVstMaxProgNameLen);
+	}
+
+	//! オーディオスレッドからの変更はvalues_にだけ入っている
+	//! 遅延の変わらない変更はオーディオスレッドで反映してあるので、クリアするのは遅延が変わったときだけ
+	for(VstInt32 i = 0; i < kNumParams; ++i) {
+		bool const cleared = set_param(cur_program_, i, values_[i].load(std::memory_order_relaxed));
+		needs_clear = needs_clear || (cleared && changes_latency(i));
+	}
+
+	FilterParams const params = make_filter_params();
+
+	//! 線形位相のFIRのバッファと設計スレッドは、線形位相に切り替えるときに用意する
+	//! 線形位相を使わないインスタンスは、どちらも持たない
+	//! オーディオスレッドが線形位相で処理するのは、ここで用意した後に公開したスナップショットから
+	if(!use_crossover_ && is_linear_phase(params)) {
+		linear_.activate();
+	} else {
+		linear_.deactivate();
+	}
+
+	latency = get_latency(params);
+	bool const latency_changed = (latency != latency_);
+	latency_ = latency;
+
+	publish_params(needs_clear);
+	return latency_changed;
+}
+
+void	MiniVstEffect::publish_params	(bool needs_clear)
+{
+	if(needs_clear) {
+		++clear_count_;
+	}
+	params_.write(make_filter_params());
+}
+
+double	MiniVstEffect::get_db_gain		(FilterParams const &params)
+{
+	return
+		defines::param_to_db(params.db_gain_);
 }
 
 //! @return normalized cutoff frequency
 //! 0.x(30Hz) <= value <= 0.5
-double	MiniVstEffect::get_cutoff		() const
+double	MiniVstEffect::get_cutoff		(FilterParams const &params)
 {
-	double const E = 10.0;
-	double const e_range = E - 1.0;
-
-	double const f_E = pow(E, (double)get_current_program().cutoff_);
-	double const norm_f_E = (f_E - 1) / e_range;
-	
-	double const freq_range_reduce	= 75.0 / (get_sampling_rate() / 2.0);
-	double const min_freq			= 30.0 / (get_sampling_rate() / 2.0);
-	return 
-		(norm_f_E / 2.0)	//0.0~0.5
-		* (1-freq_range_reduce)		//0.0~0.4X(-75Hz)
-		+ min_freq / 2.0;			//0.X(30Hz)~0.4X
+	return
+		defines::param_to_cutoff(params.cutoff_, params.sampling_rate_);
 }
 
 double	MiniVstEffect::get_sampling_rate() const
@@ -510,22 +1817,84 @@ double	MiniVstEffect::get_sampling_rate() const
 	return const_cast<MiniVstEffect *>(this)->getSampleRate();
 }
 
-double	MiniVstEffect::get_Q			() const
+double	MiniVstEffect::get_Q			(FilterParams const &params)
 {
-	//! 0.3 - 18.0
-	static double const q_range = 18.0 - 0.3;
-	return 
-		(get_current_program().Q_ * q_range) + 0.3;
+	return
+		defines::param_to_Q(params.Q_);
 }
 
-size_t	MiniVstEffect::get_filter_type	() const
+size_t	MiniVstEffect::get_filter_type	(FilterParams const &params)
 {
 	return
 		static_cast<size_t>(
-			defines::param_to_filter(get_current_program().filter_type_)
+			defines::param_to_filter(params.filter_type_)
 			);
 }
 
+size_t	MiniVstEffect::get_engine		(FilterParams const &params)
+{
+	return
+		defines::param_to_engine(params.engine_);
+}
+
+size_t	MiniVstEffect::get_num_bands	(FilterParams const &params) const
+{
+	size_t const num_bands = defines::param_to_num_bands(params.num_bands_);
+	if(use_crossover_) {
+		return std::min<size_t>(num_bands, dsp::kMaxCrossoverBands);
+	}
+	return num_bands;
+}
+
+size_t	MiniVstEffect::get_slope_sections	(FilterParams const &params)
+{
+	return
+		defines::param_to_slope_sections(params.slope_);
+}
+
+size_t	MiniVstEffect::get_alignment	(FilterParams const &params)
+{
+	return
+		defines::param_to_alignment(params.alignment_);
+}
+
+bool	MiniVstEffect::uses_slope_filter	(FilterParams const &params)
+{
+	size_t const filter_type = get_filter_type(params);
+	if(filter_type != defines::LPF && filter_type != defines::HPF) {
+		return false;
+	}
+
+	return
+		get_slope_sections(params) > 1 ||
+		get_alignment(params) == dsp::Alignment::LinkwitzRiley;
+}
+
+bool	MiniVstEffect::is_linear_phase	(FilterParams const &params)
+{
+	return
+		defines::param_to_phase(params.phase_) == defines::kLinearPhase;
+}
+
+size_t	MiniVstEffect::get_oversampling	(FilterParams const &params) const
+{
+	if(use_crossover_ || is_linear_phase(params)) {
+		return 1;
+	}
+	return
+		defines::param_to_oversampling(params.oversampling_);
+}
+
+BandParams
+		MiniVstEffect::get_band		(FilterParams const &params, size_t band)
+{
+	if(band == 0) {
+		BandParams const b = { params.cutoff_, params.db_gain_, params.Q_, params.filter_type_ };
+		return b;
+	}
+	return params.bands_[band - 1];
+}
+
 }	//namespace hwm
 
 AudioEffect *
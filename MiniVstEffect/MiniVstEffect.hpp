@@ -2,22 +2,88 @@
 #define	HWM_MINIVSTEFFECT_MINIVSTEFFECT_HPP
 
 #include "./vst_header_include.hpp"
-#include <string>
+#include "./dsp/Biquad.hpp"
+#include "./dsp/CoeffTable.hpp"
+#include "./dsp/Crossover.hpp"
+#include "./dsp/LinearPhase.hpp"
+#include "./dsp/Oversampler.hpp"
+#include "./dsp/SmoothedCascade.hpp"
+#include "./dsp/SmoothedFilter.hpp"
+#include "./dsp/TripleBuffer.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace hwm {
 
 //! 0.0 ~ 1.0
 typedef float	vst_param_t;
+
+//! イコライザのバンド数の上限
+//! 1番目のバンドはCutoff, dB Gain, Q, Filter Typeのパラメータを使う
+//! クロスオーバーのビルドでは、dsp::kMaxCrossoverBandsまでしか分けない
+enum {
+	kMaxBands = 8
+};
+
+//! 2番目以降のバンドのパラメータ
+struct BandParams
+{
+	vst_param_t		cutoff_;
+	vst_param_t		db_gain_;
+	vst_param_t		Q_;
+	vst_param_t		filter_type_;
+};
 	
 //! プログラム
+//! オーディオスレッドから呼び出されるsetProgramでも読むので、確保の要らないPODにしておく
 struct VstProgram
 {
 	vst_param_t		cutoff_;
 	vst_param_t		db_gain_;
 	vst_param_t		Q_;	
 	vst_param_t		filter_type_;
+	vst_param_t		engine_;
+	vst_param_t		num_bands_;
+	vst_param_t		slope_;
+	vst_param_t		alignment_;
+	vst_param_t		phase_;
+	vst_param_t		oversampling_;
+	BandParams		bands_[kMaxBands - 1];
 
-	std::string		name_;
+	char			name_[kVstMaxProgNameLen + 1];
+};
+
+//! オーディオスレッドに渡すパラメータのスナップショット
+//! 係数はオーディオスレッドでこの値から計算する
+struct FilterParams
+{
+	vst_param_t		cutoff_;
+	vst_param_t		db_gain_;
+	vst_param_t		Q_;
+	vst_param_t		filter_type_;
+	vst_param_t		engine_;
+	vst_param_t		num_bands_;
+	vst_param_t		slope_;
+	vst_param_t		alignment_;
+	vst_param_t		phase_;
+	vst_param_t		oversampling_;
+	BandParams		bands_[kMaxBands - 1];
+	double			sampling_rate_;
+
+	//! 遅延子のクリアが必要な変更(プログラム、フィルタタイプ、エンジン、バンド数、傾き、位相、
+	//! オーバーサンプリング)のたびに増える
+	size_t			clear_count_;
+};
+
+//! ブロック内の位置を指定したパラメータの変更
+struct ParamEvent
+{
+	//! ブロックの先頭からのサンプル数
+	size_t			offset_;
+	VstInt32		index_;
+	vst_param_t		value_;
 };
 
 //! プラグイン本体
@@ -25,19 +91,39 @@ struct MiniVstEffect
 	//! AudioEffectXクラスを継承する
 	:	AudioEffectX
 {
+	//! 2番目以降のバンドの、バンドごとのパラメータの並び
+	enum {
+		kBandCutOff,
+		kBanddBGain,
+		kBandQ,
+		kBandFilterType,
+		kNumBandParams
+	};
+
 	//! パラメータIDの定義
+	//! n番目(2 ~ kMaxBands)のバンドのパラメータは kBandParams + (n - 2) * kNumBandParams + kBandXXX
 	enum {
 		kCutOff,
 		kdBGain,
 		kQ,
 		kFilterType,
-		kNumParams
+		kEngine,
+		kNumBands,
+		kSlope,
+		kAlignment,
+		kPhase,
+		kOversampling,
+		kBandParams,
+		kNumParams = kBandParams + (kMaxBands - 1) * kNumBandParams
 	};
 	
 	//! 入出力数の定義
 	//! シンセなどでは入力0／出力2などにしたりする
+	//! kNumChannelsは既定値で、setSpeakerArrangementでkMaxChannelsまで変更できる
+	//! クロスオーバーのビルドでは、出力は入力のチャンネル数 * dsp::kMaxCrossoverBands
 	enum {
-		kNumChannels = 2
+		kNumChannels = 2,
+		kMaxChannels = 64
 	};
 	
 	//============================================================================//
@@ -87,40 +173,300 @@ public:
 	//	process
 	//============================================================================//
 public:
+	//! 処理の間はFTZ, DAZを立て、無音で減衰した状態が非正規化数になっても遅くならないようにする
+	//! 立てられない環境では、ブロックごとに各フィルタの状態をフラッシュする
 	virtual	void		processReplacing		(float **inputs, float **outputs, VstInt32 sampleFrames);
 	virtual	void		processDoubleReplacing	(double **inputs, double **outputs, VstInt32 sampleFrames);
+	virtual	void		setSampleRate			(float sampleRate);
+
+	//! 入力が途切れた後も出力が続くサンプル数
+	//! 現在のパラメータの極の絶対値から計算する。尾がなければ1を返す
+	virtual	VstInt32	getGetTailSize			();
+
+	//! ホストが処理を止めるときと再開するときに呼び出す
+	//! 再開時は遅延子をクリアし、無音の入力ならすぐにバイパスする
+	virtual	void		suspend					();
+	virtual	void		resume					();
+
+	//! 入出力が同じチャンネル数の配置だけを受け入れる
+	//! クロスオーバーのビルドでは、出力が入力のdsp::kMaxCrossoverBands倍の配置だけを受け入れる
+	//! ホストは処理を止めている間にしか呼び出さないので、遅延子はここで確保し直す
+	virtual	bool		setSpeakerArrangement	(VstSpeakerArrangement *pluginInput,
+												 VstSpeakerArrangement *pluginOutput);
+
+	//! MIDIのコントロールチェンジを、サンプル位置つきのパラメータの変更として受け取る
+	//! CC 20 ~ 31, 102 ~ 119, 85 ~ 90, 14 ~ 15が、順にパラメータID 0 ~ 37に対応する(defines::cc_to_param)
+	virtual	VstInt32	processEvents			(VstEvents *events);
+	virtual	VstInt32	canDo					(char *text);
+
+	//! 次のprocessReplacing/processDoubleReplacingのoffsetサンプル目で、パラメータを変更する
+	//! オーディオスレッドから、処理の前に呼び出す
+	//! ブロックはこの位置で分けて処理され、係数はこの位置から計算し直される
+	//! ブロックあたりkMaxParamEventsを超えた分は捨てる
+	void	add_param_event		(VstInt32 index, vst_param_t value, size_t offset);
+
+	//! パラメータの書き込み回数と、係数を計算した回数
+	//! 係数の計算はBiquadDesigner, SlopeDesigner, SvfDesignerの呼び出しを数える
+	//! 平滑化の間の制御間隔ごとの計算、イベントでの分割ごとの計算、線形位相の応答の計算を含む
+	size_t	get_num_parameter_writes	() const;
+	size_t	get_num_coeff_updates		() const;
 
 private:
-	double	process(size_t channel, double input) const;
-	
-	//! bi-quadフィルタの係数
-	double	b0_;
-	double	b1_;
-	double	b2_;
-	double	a0_;
-	double	a1_;
-	double	a2_;
-	//! 遅延子
-	double	mutable x_[kNumChannels][2];
-	double	mutable y_[kNumChannels][2];
+	//! bi-quadフィルタ
+	//! パラメータの変化はkSmoothingTimeかけて滑らかに反映する
+	dsp::SmoothedBiquad	filter_;
+	//! ステートバリアブルフィルタ
+	//! カットオフを速く動かしても安定している
+	dsp::SmoothedSvf	svf_;
+	//! バンド数が2以上のときに使うマルチバンドのイコライザ
+	//! 全バンドを1パスで処理する。エンジンの選択は使わない
+	dsp::SmoothedCascade	eq_;
+	//! 12dB/octより急な傾きのLPF, HPF
+	//! 全セクションを1パスで処理する。エンジンの選択は使わない
+	dsp::SmoothedSlopeFilter	slope_filter_;
+	//! 線形位相のイコライザ
+	//! 上のいずれかのフィルタと同じ振幅特性のFIRを、バックグラウンドのスレッドで設計して畳み込む
+	//! 係数の平滑化の代わりに、FIRを切り替えるときにクロスフェードする
+	//! バッファと設計スレッドは、最初に線形位相に切り替えるときにcommit_programで用意する
+	dsp::LinearPhaseFilter		linear_;
+	//! クロスオーバーのビルドで使う、バンドごとに出力するクロスオーバー
+	dsp::Crossover				crossover_;
+	//! 最小位相のフィルタを高いレートで処理するためのオーバーサンプリング
+	//! 線形位相とクロスオーバーでは使わない
+	dsp::Oversampler			oversampler_;
+	//! 高いレートの信号を置くバッファ
+	//! チャンネルごとに Oversampler::kMaxBlockSize * kMaxFactor サンプル
+	std::vector<double>			oversampled_;
+	std::vector<double *>		oversampled_channels_;
+
+	//! パラメータを書き込む側(ホスト、GUI)の排他
+	//! cur_program_、clear_count_、latency_を保護する。オーディオスレッドからは取らない
+	std::mutex		param_lock_;
+	size_t			clear_count_;
+	//! 最後にホストへ通知した遅延
+	size_t			latency_;
+
+	//! ホストに見せるパラメータの値。どのスレッドからもロックを取らずに読み書きする
+	//! オーディオスレッドからの変更はここにだけ書き、次にロックを取ったときにcur_program_へ取り込む
+	std::atomic<vst_param_t>	values_[kNumParams];
+	//! オーディオスレッドから切り替えたプログラム。名前をcur_program_へ取り込むまで置いておく
+	std::atomic<VstInt32>		requested_program_;
+
+	//! 最後に処理を呼び出したスレッド
+	std::atomic<std::thread::id>	audio_thread_;
+	//! オーディオスレッドからの変更をapplied_params_に書いてあり、次のブロックで反映する
+	bool			automation_pending_;
+	//! そのうちに遅延子のクリアが必要な変更がある
+	bool			automation_clear_;
+
+	//! 書き込み側からオーディオスレッドへのパラメータの受け渡し
+	dsp::TripleBuffer<FilterParams>	params_;
+
+	//! オーディオスレッドが最後に取り込んだスナップショット
+	FilterParams	published_params_;
+	//! オーディオスレッドで使っているパラメータ
+	//! スナップショットにイベントによる変更を加えたもの
+	FilterParams	applied_params_;
+
+	//! 次のブロックで反映するイベント。offset_の順に並べておく
+	enum {
+		kMaxParamEvents = 512
+	};
+	ParamEvent		param_events_[kMaxParamEvents];
+	size_t			num_param_events_;
+
+	std::atomic<size_t>	num_parameter_writes_;
+	//! 各Designerがconstの呼び出しの中で数える
+	mutable std::atomic<size_t>	num_coeff_updates_;
+
+	//! クロスオーバーとして、入力をバンドに分けてバンドごとの出力に書くかどうか
+	//! 出力の数が変わるので、ビルド時に決める
+	bool				use_crossover_;
+
+	//! 係数をcoeff_table_から計算するかどうか
+	bool				use_coeff_table_;
+	dsp::CoeffTable		coeff_table_;
+
+	//! 入力が続けて無音だったサンプル数
+	size_t				silent_samples_;
+	//! 現在のパラメータでの尾の長さ。apply_paramsで計算し直す
+	size_t				tail_samples_;
+	//! 入力が無音で遅延子も減衰しきったので、フィルタを通さずに無音を出力している
+	//! このとき遅延子はクリアしてある
+	bool				bypassed_;
 
 private:
-	//! bi-quadフィルタの遅延子をクリア
+	//! すべてのフィルタの遅延子をクリア
 	void	clear_buffer		();
+
+	//! FTZ, DAZを設定できない環境で、フィルタの状態のうち非正規化数になりそうな値を0にする
+	void	flush_denormals		();
+
+	//! オーバーサンプリングのバッファをnum_channels分確保する
+	void	allocate_oversampled	(size_t num_channels);
+
+	//! 位相やオーバーサンプリングの切り替えに合わせて、ホストに処理の遅延を通知する
+	//! ホストがioChangedを処理するので、param_lock_の外で呼び出すこと
+	void	report_latency		(size_t latency);
+
+	//! オーディオスレッドから呼び出されているかどうか
+	//! ホストが処理のレベルを返せばそれに従い、返さなければ最後に処理を呼び出したスレッドと比べる
+	bool	is_audio_thread		();
+
+	//! オーディオスレッドからのパラメータの変更
+	//! ロックを取らずにapplied_params_を書き換え、次のブロックの先頭で平滑化して反映する
+	void	automate_param		(VstInt32 index, vst_param_t value);
+
+	//! paramsで処理したときの遅延(サンプル数)
+	size_t	get_latency			(FilterParams const &params) const;
+
+	//! paramsで処理したときの尾の長さ(サンプル数)
+	//! 最小位相のフィルタは極の絶対値から応答がdefines::kTailDecayまで減衰する長さを求め、
+	//! オーバーサンプリングや線形位相のFIRの分を足す
+	size_t	get_tail_samples	(FilterParams const &params) const;
 	
-	//! フィルタの係数を再計算
-	void	reset_coeffs		();
+	//! filter_とeq_に渡す、パラメータから係数への変換
+	//! パラメータはVSTのパラメータの値(0.0 ~ 1.0)
+	struct BiquadDesigner
+	{
+		MiniVstEffect const *	owner_;
+
+		dsp::BiquadCoeffs
+				operator()	(size_t filter_type, double cutoff, double db_gain, double Q) const;
+	};
+
+	//! slope_filter_に渡す、パラメータから係数への変換
+	//! 傾きと特性はowner_->applied_params_から取る
+	struct SlopeDesigner
+	{
+		MiniVstEffect const *	owner_;
+
+		dsp::SlopeCoeffs
+				operator()	(size_t filter_type, double cutoff, double db_gain, double Q) const;
+	};
+
+	//! svf_に渡す、パラメータから係数への変換
+	struct SvfDesigner
+	{
+		MiniVstEffect const *	owner_;
+
+		dsp::SvfCoeffs
+				operator()	(size_t filter_type, double cutoff, double db_gain, double Q) const;
+	};
+
+	//! 入力が無音で遅延子も減衰していれば、フィルタを通さずに無音を書く
+	//! それ以外はprocess_eventsで処理する
+	template<class T>
+	void	process_block		(T **input, T **output, size_t n);
+
+	//! ブロックをイベントの位置で分けて処理する
+	template<class T>
+	void	process_events		(T **input, T **output, size_t n);
+
+	//! 選択されているエンジン(線形位相ならlinear_、それ以外はprocess_engine)で、
+	//! offsetサンプル目からnサンプル分を処理する
+	//! オーバーサンプリングするときは、kMaxBlockSizeずつ高いレートにしてprocess_engineで処理する
+	template<class T>
+	void	process_filter		(T **input, T **output, size_t offset, size_t n);
+
+	//! 最小位相のフィルタ(バンド数が2以上ならeq_、急な傾きのLPF, HPFならslope_filter_、
+	//! それ以外はエンジンの選択に従ってfilter_かsvf_)で処理する
+	template<class T>
+	void	process_engine		(T **input, T **output, size_t offset, size_t n);
+
+	//! クロスオーバーのビルドで、offsetサンプル目からnサンプル分をバンドに分ける
+	//! バンドbのチャンネルchは output[b * チャンネル数 + ch]。使っていないバンドの出力は無音にする
+	template<class T>
+	void	process_crossover	(T **input, T **output, size_t offset, size_t n);
+
+	//! 入力1チャンネルあたりの出力のチャンネル数
+	size_t	get_num_output_busses	() const;
+
+	//! 現在のサンプリング周波数で係数テーブルを作る
+	void	build_coeff_table	();
+
+	//! 係数をcoeff_table_から計算するかどうか
+	//! テーブルはもとのサンプリング周波数で作るので、オーバーサンプリング中は使わない
+	bool	uses_coeff_table	() const;
+
+	//! CutOffのパラメータを、フィルタを処理するレートでの正規化周波数にする
+	double	get_processing_cutoff	(double cutoff) const;
+
+	//! 書き込み側から公開されたパラメータを、処理ブロックの先頭でまとめて反映する
+	//! 取り込みは1ブロックにつき高々1回になる
+	void	update_filter		();
+
+	//! applied_params_の振幅特性を、linear_に渡すbi-quadのセクションの並びにする
+	dsp::ResponseSections
+			make_response_sections	() const;
+
+	//! applied_params_をフィルタに設定し、尾の長さと線形位相のFIRを更新する
+	//! @param reset 滑らかにせずに切り替える
+	void	apply_params		(bool reset);
+
+	//! applied_params_を各フィルタの目標値に設定する。係数は各フィルタが処理の中で計算する
+	void	set_filter_params	(bool reset);
+
+	//! applied_params_から、尾の長さを計算し直し、線形位相ならFIRの設計を要求する
+	//! 極の計算を含むので、イベントの後ではブロックにつき1回だけ呼び出す
+	void	update_response		();
+
+	//! イベントをapplied_params_に反映し、その位置から平滑化せずにフィルタに設定する
+	//! 尾の長さとFIRは更新しないので、最後のイベントの後でupdate_responseを呼び出す
+	//! @return パラメータを変えたかどうか
+	bool	apply_param_event	(ParamEvent const &event);
+
+	//! 現在のパラメータのスナップショットを作る
+	//! param_lock_を取った状態で呼び出す
+	FilterParams
+			make_filter_params	() const;
+
+	//! values_からスナップショットを作る。表示の取得など、ロックを取れない呼び出し用
+	FilterParams
+			load_filter_params	() const;
+
+	//! オーディオスレッドからの変更をcur_program_に取り込み、オーディオスレッドに公開する
+	//! param_lock_を取った状態で呼び出す
+	//! @param latency 公開したパラメータでの遅延
+	//! @return 遅延が変わったかどうか。変わったらロックの外でreport_latencyを呼び出す
+	bool	commit_program		(bool needs_clear, size_t &latency);
+
+	//! 現在のパラメータをオーディオスレッドに公開する
+	//! param_lock_を取った状態で呼び出す
+	void	publish_params		(bool needs_clear);
 
-	//! 現在のパラメータの状態から、dBGainを取得
+	//! パラメータの状態から、dBGainを取得
 	//! dBGainは、Peaking EQ, Low Shelving, High Shelving以外のフィルタでは
 	//! 使用されない
-	double	get_db_gain			() const;
-	//! 現在のパラメータの状態から、CutOffを正規化周波数で取得
-	double	get_cutoff			() const;
-	//! 現在のパラメータの状態から、Qを取得
-	double	get_Q				() const;
-	//! 現在のパラメータの状態から、フィルタのタイプを取得
-	size_t	get_filter_type		() const;
+	static double	get_db_gain		(FilterParams const &params);
+	//! パラメータの状態から、CutOffを正規化周波数で取得
+	static double	get_cutoff		(FilterParams const &params);
+	//! パラメータの状態から、Qを取得
+	static double	get_Q			(FilterParams const &params);
+	//! パラメータの状態から、フィルタのタイプを取得
+	static size_t	get_filter_type	(FilterParams const &params);
+	//! パラメータの状態から、フィルタエンジンを取得
+	static size_t	get_engine		(FilterParams const &params);
+	//! パラメータの状態から、バンド数を取得
+	//! クロスオーバーではdsp::kMaxCrossoverBandsで頭打ちになる
+	size_t			get_num_bands	(FilterParams const &params) const;
+	//! パラメータの状態から、傾きを12dB/oct単位のセクション数で取得
+	static size_t	get_slope_sections	(FilterParams const &params);
+	//! パラメータの状態から、高次のLPF, HPFの特性を取得
+	static size_t	get_alignment	(FilterParams const &params);
+	//! パラメータの状態から、slope_filter_で処理するかどうかを取得
+	//! LPF, HPFで、傾きが12dB/octより急かLinkwitz-Rileyのとき
+	//! 12dB/octのButterworthはこれまで通りQのパラメータを使うbi-quadで処理する
+	static bool		uses_slope_filter	(FilterParams const &params);
+	//! パラメータの状態から、線形位相で処理するかどうかを取得
+	static bool		is_linear_phase		(FilterParams const &params);
+	//! パラメータの状態から、オーバーサンプリングの倍率を取得
+	//! 線形位相とクロスオーバーではオーバーサンプリングしないので1になる
+	size_t			get_oversampling	(FilterParams const &params) const;
+	//! パラメータの状態から、バンドのパラメータを取得
+	//! バンド0は1番目のバンドのパラメータ
+	static BandParams
+					get_band		(FilterParams const &params, size_t band);
 	//! AudioEffectXからサンプリング周波数を取得
 	double	get_sampling_rate	() const;
 			
@@ -7,7 +7,7 @@
  *
  */
 
-#include <string>
+#include <cstdio>
 #include "MiniVstEffectEditor.h"
 #include "MiniVstEffect.hpp"
 
@@ -42,6 +42,11 @@ MiniVstEffectEditor::MiniVstEffectEditor(AudioEffect *eff)
 {
 	background_ = new CBitmap(defines::kBackgroundId);
 	
+	for(size_t i = 0; i < kNumControls; ++i) {
+		values_[i].store(0.0f);
+		dirty_[i].store(false);
+	}
+
 	rect.left = 0;
 	rect.top = 0;
 	rect.right = static_cast<short>(background_->getWidth());
@@ -193,6 +198,12 @@ bool MiniVstEffectEditor::open(void *ptr)
 	bm_slider_back->forget();
 	bm_slider_handle->forget();
 	
+	//! 開いたときの値は、最初のidleで表示する
+	for(size_t i = 0; i < kNumControls; ++i) {
+		values_[i].store(effect->getParameter(static_cast<VstInt32>(i)));
+		dirty_[i].store(true);
+	}
+
 	frame = frm;
 	return true;
 }
@@ -201,62 +212,39 @@ void MiniVstEffectEditor::close()
 {
 	delete frame;
 	frame = 0;
+
+	//! ビューはframeと一緒に削除されるので、idleから触らないようにする
+	freq_ = gain_ = Q_ = filter_type_ = 0;
+	disp_freq_ = disp_gain_ = disp_Q_ = disp_filter_type_ = 0;
 }
 
 void MiniVstEffectEditor::setParameter(VstInt32 index, float value)
 {
-	std::string const sp = " ";
-	
-	char disp_buf[kVstMaxParamStrLen+1] = {};
-	char label_buf[kVstMaxParamStrLen+1] = {};
-				
-	switch (index) {
-		case MiniVstEffect::kCutOff:
-			if(freq_) {
-				freq_->setValue(effect->getParameter(index));
-			}
-			if(disp_freq_) {
-				effect->getParameterDisplay(index, disp_buf);
-				effect->getParameterLabel(index, label_buf);
-				disp_freq_->setText((disp_buf + sp + label_buf).c_str());
-			}
-			break;
-		
-		case MiniVstEffect::kdBGain:
-			if(gain_) {
-				gain_->setValue(effect->getParameter(index));
-			}
-			if(disp_gain_) {
-				effect->getParameterDisplay(index, disp_buf);
-				effect->getParameterLabel(index, label_buf);
-				disp_gain_->setText((disp_buf + sp + label_buf).c_str());
-			}
-			break;
-			
-		case MiniVstEffect::kQ:
-			if(Q_) {
-				Q_->setValue(effect->getParameter(index));
-			}
-			if(disp_Q_) {
-				effect->getParameterDisplay(index, disp_buf);
-				effect->getParameterLabel(index, label_buf);
-				disp_Q_->setText((disp_buf + sp + label_buf).c_str());
-			}
-			break;
-			
-		case MiniVstEffect::kFilterType:
-			if(filter_type_) {
-				filter_type_->setValue(effect->getParameter(index));
-			}
-			if(disp_filter_type_) {
-				effect->getParameterDisplay(index, disp_buf);
-				effect->getParameterLabel(index, label_buf);
-				disp_filter_type_->setText((disp_buf + sp + label_buf).c_str());
-			}
-			break;
-			
-		default:
-			break;
+	if(index < 0 || index >= kNumControls) {
+		return;
+	}
+
+	values_[index].store(value, std::memory_order_relaxed);
+	dirty_[index].store(true, std::memory_order_release);
+}
+
+void MiniVstEffectEditor::update_control(VstInt32 index, CSlider *slider, CTextLabel *disp)
+{
+	if(!dirty_[index].exchange(false, std::memory_order_acquire)) {
+		return;
+	}
+
+	if(slider) {
+		slider->setValue(values_[index].load(std::memory_order_relaxed));
+	}
+	if(disp) {
+		char disp_buf[kVstMaxParamStrLen+1] = {};
+		char label_buf[kVstMaxParamStrLen+1] = {};
+		char text[kVstMaxParamStrLen*2+2] = {};
+		effect->getParameterDisplay(index, disp_buf);
+		effect->getParameterLabel(index, label_buf);
+		std::snprintf(text, sizeof(text), "%s %s", disp_buf, label_buf);
+		disp->setText(text);
 	}
 }
 
@@ -278,6 +266,15 @@ void MiniVstEffectEditor::valueChanged(CDrawContext *context, CControl *control)
 
 void MiniVstEffectEditor::idle()
 {
+	if(!frame) {
+		return;
+	}
+
+	update_control(MiniVstEffect::kCutOff, freq_, disp_freq_);
+	update_control(MiniVstEffect::kdBGain, gain_, disp_gain_);
+	update_control(MiniVstEffect::kQ, Q_, disp_Q_);
+	update_control(MiniVstEffect::kFilterType, filter_type_, disp_filter_type_);
+
 	frame->redraw();
 }
 
@@ -8,6 +8,7 @@
  */
  
 #include "vstgui.sf/vstgui/vstgui.h"
+#include <atomic>
 
 namespace hwm {
 
@@ -20,11 +21,24 @@ struct MiniVstEffectEditor
 	
 	virtual	bool	open(void *ptr);
 	virtual void	close();
+	//! ホストはオーディオスレッドから自動化することもあるので、値を置くだけにする
+	//! コントロールの更新はidleでGUIのスレッドから行う
 	virtual void	setParameter(VstInt32 index, float value);
 	virtual void	valueChanged(CDrawContext *context, CControl *control);	
 	virtual void	idle();
 	
 private:
+	//! 画面に出すパラメータの数(Cutoff, dB Gain, Q, Filter Type)
+	enum {
+		kNumControls = 4
+	};
+
+	//! setParameterで置かれた値を、スライダーと表示に反映する
+	void	update_control(VstInt32 index, CSlider *slider, CTextLabel *disp);
+
+	std::atomic<float>	values_[kNumControls];
+	std::atomic<bool>	dirty_[kNumControls];
+
 	CSlider	*freq_;
 	CSlider *gain_;
 	CSlider *Q_;
@@ -0,0 +1,61 @@
+#include "./BatchEngine.hpp"
+#include "./Denormals.hpp"
+#include <algorithm>
+
+namespace hwm { namespace dsp {
+
+BatchEngine::BatchEngine	(size_t num_filters, size_t num_threads)
+	:	bank_(num_filters)
+	,	pool_(num_threads)
+{}
+
+BiquadBank &
+		BatchEngine::get_bank	()
+{
+	return bank_;
+}
+
+BiquadBank const &
+		BatchEngine::get_bank	() const
+{
+	return bank_;
+}
+
+size_t	BatchEngine::get_num_threads	() const
+{
+	return pool_.get_num_threads();
+}
+
+void	BatchEngine::process	(float const * const *in, float * const *out, size_t n)
+{
+	process_impl(in, out, n);
+}
+
+void	BatchEngine::process	(double const * const *in, double * const *out, size_t n)
+{
+	process_impl(in, out, n);
+}
+
+template<class T>
+void	BatchEngine::process_impl	(T const * const *in, T * const *out, size_t n)
+{
+	size_t const num_filters = bank_.size();
+	if(num_filters < kMinParallelFilters || pool_.get_num_threads() == 1) {
+		ScopedFlushDenormals flush_denormals;
+		bank_.process(in, out, 0, num_filters, n);
+	} else {
+		size_t const num_groups = (num_filters + kGroupFilters - 1) / kGroupFilters;
+		pool_.run(num_groups, 1, [&](size_t begin, size_t end, size_t /*thread_index*/) {
+			//! ワーカースレッドのMXCSRは呼び出し側と別なので、ここで設定する
+			ScopedFlushDenormals flush_denormals;
+			bank_.process(in, out,
+				begin * kGroupFilters, std::min<size_t>(end * kGroupFilters, num_filters), n);
+		});
+	}
+
+	if(!ScopedFlushDenormals::is_supported()) {
+		bank_.flush_denormals();
+	}
+}
+
+}}	//namespace hwm::dsp
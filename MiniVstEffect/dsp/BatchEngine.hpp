@@ -0,0 +1,54 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_BATCHENGINE_HPP
+#define	HWM_MINIVSTEFFECT_DSP_BATCHENGINE_HPP
+
+#include "./BiquadBank.hpp"
+#include "./WorkStealingPool.hpp"
+#include <cstddef>
+
+namespace hwm { namespace dsp {
+
+//! 1つのプロセスで多数(~10万)の独立したフィルタを処理するエンジン
+//!
+//! ボイスやストリームごとにプラグインのインスタンスを作る代わりに、
+//! すべてのフィルタをBiquadBankの連続した配列に持ち、
+//! kGroupFilters本ずつの組をWorkStealingPoolのスレッドで分け合って処理する。
+//! フィルタが少ないときは、スレッドを起こさずに呼び出したスレッドで処理する
+struct BatchEngine
+{
+	enum {
+		//! 1回にスレッドに渡すフィルタの数。SIMDの1組(最大16本)の倍数にする
+		kGroupFilters		= 64,
+		//! これより少ないフィルタは呼び出したスレッドだけで処理する
+		kMinParallelFilters	= 256
+	};
+
+	//! num_threadsが0なら、ハードウェアのスレッド数だけ作る
+	explicit
+	BatchEngine		(size_t num_filters = 0, size_t num_threads = 0);
+
+	//! フィルタのパラメータ、係数、遅延子
+	//! processの実行中に変更してはならない
+	BiquadBank &		get_bank	();
+	BiquadBank const &	get_bank	() const;
+
+	size_t	get_num_threads		() const;
+
+	//! すべてのフィルタについて、in[i]のnサンプルを処理してout[i]に書く(i = 0 ~ get_bank().size() - 1)
+	//! in と out は同じバッファでもよい
+	void	process				(float const * const *in, float * const *out, size_t n);
+	void	process				(double const * const *in, double * const *out, size_t n);
+
+private:
+	BatchEngine		(BatchEngine const &);
+	BatchEngine &	operator=	(BatchEngine const &);
+
+	template<class T>
+	void	process_impl		(T const * const *in, T * const *out, size_t n);
+
+	BiquadBank			bank_;
+	WorkStealingPool	pool_;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_BATCHENGINE_HPP
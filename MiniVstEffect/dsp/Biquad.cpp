@@ -0,0 +1,269 @@
+#include "./Biquad.hpp"
+#include "./Denormals.hpp"
+#include "./InterleavedBiquad.hpp"
+#include "./MultiBiquad.hpp"
+#include "./StereoBiquad.hpp"
+
+namespace hwm { namespace dsp {
+
+Biquad::Biquad	(size_t num_channels)
+	:	filter_type_(kGenericKernel)
+	,	precision_(StatePrecision::Double)
+	,	states_(num_channels)
+	,	mode_(ProcessMode::Direct)
+	,	ramp_remaining_(0)
+{
+	BiquadCoeffs const through = { 1.0, 0.0, 0.0, 0.0, 0.0 };
+	coeffs_ = through;
+	clear_buffer();
+}
+
+void	Biquad::set_coeffs	(BiquadCoeffs const &coeffs, size_t filter_type)
+{
+	ramp_remaining_ = 0;
+	coeffs_ = coeffs;
+	filter_type_ = filter_type;
+	if(mode_ == ProcessMode::StateSpace) {
+		ss_coeffs_ = make_state_space(coeffs_);
+	}
+}
+
+BiquadCoeffs const &
+		Biquad::get_coeffs	() const
+{
+	return coeffs_;
+}
+
+size_t	Biquad::get_filter_type	() const
+{
+	return filter_type_;
+}
+
+void	Biquad::ramp_coeffs	(BiquadCoeffs const &coeffs, size_t filter_type,
+							 size_t num_samples)
+{
+	if(num_samples == 0 || filter_type != filter_type_) {
+		set_coeffs(coeffs, filter_type);
+		return;
+	}
+
+	double const r = 1.0 / num_samples;
+	BiquadCoeffs const delta = {
+		(coeffs.b0_ - coeffs_.b0_) * r,
+		(coeffs.b1_ - coeffs_.b1_) * r,
+		(coeffs.b2_ - coeffs_.b2_) * r,
+		(coeffs.a1_ - coeffs_.a1_) * r,
+		(coeffs.a2_ - coeffs_.a2_) * r
+	};
+
+	ramp_target_ = coeffs;
+	ramp_delta_ = delta;
+	ramp_remaining_ = num_samples;
+}
+
+size_t	Biquad::get_ramp_remaining	() const
+{
+	return ramp_remaining_;
+}
+
+void	Biquad::clear_buffer	()
+{
+	for(size_t ch = 0; ch < states_.size(); ++ch) {
+		for(size_t i = 0; i < 2; ++i) {
+			states_[ch].s_[i] = 0.0;
+		}
+	}
+}
+
+void	Biquad::flush_denormals	()
+{
+	if(!states_.empty()) {
+		dsp::flush_denormals(states_[0].s_, states_.size() * 2);
+	}
+}
+
+BiquadState const &
+		Biquad::get_state			(size_t channel) const
+{
+	return states_[channel];
+}
+
+void	Biquad::set_state			(size_t channel, BiquadState const &state)
+{
+	states_[channel] = state;
+}
+
+size_t	Biquad::get_num_channels	() const
+{
+	return states_.size();
+}
+
+void	Biquad::set_num_channels	(size_t num_channels)
+{
+	states_.resize(num_channels);
+	clear_buffer();
+}
+
+void	Biquad::set_state_precision	(size_t precision)
+{
+	precision_ = precision;
+}
+
+size_t	Biquad::get_state_precision	() const
+{
+	return precision_;
+}
+
+void	Biquad::set_process_mode	(size_t mode)
+{
+	mode_ = mode;
+	if(mode_ == ProcessMode::StateSpace) {
+		ss_coeffs_ = make_state_space(coeffs_);
+	}
+}
+
+size_t	Biquad::get_process_mode	() const
+{
+	return mode_;
+}
+
+namespace {
+
+//! 係数をdeltaのn倍だけ進める
+BiquadCoeffs
+		advance_coeffs	(BiquadCoeffs const &c, BiquadCoeffs const &delta, size_t n)
+{
+	double const k = static_cast<double>(n);
+	BiquadCoeffs const ret = {
+		c.b0_ + delta.b0_ * k,
+		c.b1_ + delta.b1_ * k,
+		c.b2_ + delta.b2_ * k,
+		c.a1_ + delta.a1_ * k,
+		c.a2_ + delta.a2_ * k
+	};
+	return ret;
+}
+
+}	//unnamed namespace
+
+void	Biquad::advance_ramp	(size_t n)
+{
+	ramp_remaining_ -= n;
+	if(ramp_remaining_ == 0) {
+		//! 足し込みの丸め誤差を残さないように、最後は目標の係数に合わせる
+		set_coeffs(ramp_target_, filter_type_);
+	} else {
+		coeffs_ = advance_coeffs(coeffs_, ramp_delta_, n);
+	}
+}
+
+template<class T>
+void	Biquad::process_direct	(BiquadCoeffs const *delta,
+								 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	if(states_.empty()) {
+		return;
+	}
+
+	//! SIMDのレーン幅の倍数のチャンネルをまとめて処理し、
+	//! 残りを2チャンネルずつ、さらに余ったチャンネルを1チャンネルずつ処理する
+	size_t ch = process_multi(coeffs_, delta, filter_type_, precision_,
+		&states_[0], states_.size(), in, out, offset, n);
+	for( ; ch + 1 < states_.size(); ch += 2) {
+		process_stereo(coeffs_, delta, filter_type_, precision_, &states_[ch],
+			in[ch] + offset, in[ch+1] + offset, out[ch] + offset, out[ch+1] + offset, n);
+	}
+	if(ch < states_.size()) {
+		process_mono(ch, delta, in[ch] + offset, out[ch] + offset, n);
+	}
+}
+
+template<class T>
+void	Biquad::process_channels	(T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	if(ramp_remaining_ > 0) {
+		size_t const m = (n < ramp_remaining_) ? n : ramp_remaining_;
+		process_direct(&ramp_delta_, in, out, offset, m);
+		advance_ramp(m);
+
+		offset += m;
+		n -= m;
+	}
+
+	if(n == 0) {
+		return;
+	}
+
+	if(mode_ == ProcessMode::StateSpace) {
+		for(size_t ch = 0; ch < states_.size(); ++ch) {
+			process_state_space(coeffs_, ss_coeffs_, states_[ch], in[ch] + offset, out[ch] + offset, n);
+		}
+		return;
+	}
+
+	process_direct<T>(0, in, out, offset, n);
+}
+
+template<class T>
+void	Biquad::process_frames	(T *data, size_t stride, size_t n)
+{
+	if(states_.empty()) {
+		return;
+	}
+
+	if(ramp_remaining_ > 0) {
+		size_t const m = (n < ramp_remaining_) ? n : ramp_remaining_;
+		dsp::process_interleaved(coeffs_, &ramp_delta_, filter_type_, precision_,
+			&states_[0], states_.size(), data, stride, m);
+		advance_ramp(m);
+
+		data += m * stride;
+		n -= m;
+	}
+
+	if(n == 0) {
+		return;
+	}
+
+	if(mode_ == ProcessMode::StateSpace && states_.size() == 1 && stride == 1) {
+		process_state_space(coeffs_, ss_coeffs_, states_[0], data, data, n);
+		return;
+	}
+
+	dsp::process_interleaved(coeffs_, 0, filter_type_, precision_,
+		&states_[0], states_.size(), data, stride, n);
+}
+
+void	Biquad::process_block	(float const * const *in, float * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	Biquad::process_block	(double const * const *in, double * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	Biquad::process_block	(float const * const *in, float * const *out,
+								 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+void	Biquad::process_block	(double const * const *in, double * const *out,
+								 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+void	Biquad::process_interleaved	(float *data, size_t stride, size_t n)
+{
+	process_frames(data, stride, n);
+}
+
+void	Biquad::process_interleaved	(double *data, size_t stride, size_t n)
+{
+	process_frames(data, stride, n);
+}
+
+}}	//namespace hwm::dsp
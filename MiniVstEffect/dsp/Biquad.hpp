@@ -0,0 +1,163 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_BIQUAD_HPP
+#define	HWM_MINIVSTEFFECT_DSP_BIQUAD_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include "./BiquadKernels.hpp"
+#include "./StateSpaceBiquad.hpp"
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! 全チャンネルをまとめて処理するときの処理方式
+struct ProcessMode
+{
+	enum {
+		//! 転置直接形II。チャンネルをSIMDのレーンに並べて処理する
+		Direct,
+		//! 状態空間表現で複数サンプルをまとめて計算する
+		//! 4096サンプル以上のような大きなブロックを処理するとき向け
+		StateSpace,
+		kNumProcessMode
+	};
+};
+
+//! bi-quadフィルタ
+//! 係数は全チャンネルで共有し、遅延子はチャンネルごとに持つ
+struct Biquad
+{
+	explicit
+	Biquad	(size_t num_channels);
+
+	//! filter_typeを指定すると、そのフィルタタイプに特殊化したカーネルで処理する
+	//! 係数がdesign_biquadで計算したものでない場合はkGenericKernelを指定する
+	void	set_coeffs			(BiquadCoeffs const &coeffs,
+								 size_t filter_type = kGenericKernel);
+	BiquadCoeffs const &
+			get_coeffs			() const;
+	size_t	get_filter_type		() const;
+
+	//! 係数を、全チャンネルをまとめて処理するprocess_blockのnum_samplesサンプルをかけて
+	//! 現在の値からcoeffsまで線形に変化させる
+	//! 直線上の係数はdesign_biquadが作る構造上の定数を保つので、特殊化されたカーネルのまま処理できる
+	//! 変化の途中はStateSpaceモードでも直接形で処理する
+	void	ramp_coeffs			(BiquadCoeffs const &coeffs, size_t filter_type,
+								 size_t num_samples);
+	//! 係数の変化が終わるまでの残りサンプル数
+	size_t	get_ramp_remaining	() const;
+
+	//! 遅延子をクリア
+	void	clear_buffer		();
+	//! 絶対値がkDenormalFlushLimit未満の遅延子を0にする
+	//! FTZ, DAZを設定できない環境で、非正規化数での演算を避けるためにブロックの境界で呼び出す
+	void	flush_denormals		();
+
+	//! チャンネルchの遅延子
+	//! 長い信号を区間に分けて処理するときに、区間の境界の状態を受け渡すのに使う
+	BiquadState const &
+			get_state			(size_t channel) const;
+	void	set_state			(size_t channel, BiquadState const &state);
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。遅延子はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! StatePrecisionのいずれか
+	//! StateSpaceモードは常に倍精度で処理する
+	void	set_state_precision	(size_t precision);
+	size_t	get_state_precision	() const;
+
+	//! ProcessModeのいずれか
+	void	set_process_mode	(size_t mode);
+	size_t	get_process_mode	() const;
+
+	//! 設定された係数を元に、IIRフィルタをかける
+	double	process				(size_t channel, double input)
+	{
+		BiquadCoeffs const &c = coeffs_;
+		BiquadState &s = states_[channel];
+
+		double const ret = c.b0_ * input + s.s_[0];
+		s.s_[0] = c.b1_ * input - c.a1_ * ret + s.s_[1];
+		s.s_[1] = c.b2_ * input - c.a2_ * ret;
+
+		return ret;
+	}
+
+	//! n サンプル分まとめてIIRフィルタをかける
+	//! 係数と遅延子はブロックの間ローカル変数に保持する
+	//! カーネルはブロックの先頭でフィルタタイプから選択する
+	//! in と out は同じバッファでもよい
+	template<class T>
+	void	process_block		(size_t channel, T const *in, T *out, size_t n)
+	{
+		process_mono(channel, 0, in, out, n);
+	}
+
+	//! 全チャンネルをまとめて処理する
+	//! Directではprocess_multiでレーン幅の倍数のチャンネルをまとめて処理し、
+	//! 残りを2チャンネルずつprocess_stereoで、余ったチャンネルをprocess_blockで処理する
+	//! StateSpaceではチャンネルごとにprocess_state_spaceで処理する
+	//! ramp_coeffsで係数を変化させている間は、係数を1サンプルずつ進めながら処理する
+	void	process_block		(float const * const *in, float * const *out, size_t n);
+	void	process_block		(double const * const *in, double * const *out, size_t n);
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	//! ブロックを分割して処理するときに使う
+	void	process_block		(float const * const *in, float * const *out,
+								 size_t offset, size_t n);
+	void	process_block		(double const * const *in, double * const *out,
+								 size_t offset, size_t n);
+
+	//! インターリーブされたバッファをその場で処理する
+	//! チャンネルchのiフレーム目はdata[i * stride + ch]。strideはサンプル数で、get_num_channels()以上
+	//! チャンネルごとのバッファに並べ替えず、隣り合うチャンネルをまとめてSIMDのレーンに読み込む
+	//! ramp_coeffsの変化は反映する
+	//! StateSpaceモードは、1チャンネルでstrideが1(連続したモノラルのバッファ)のときだけ使い、
+	//! それ以外は直接形で処理する
+	void	process_interleaved	(float *data, size_t stride, size_t n);
+	void	process_interleaved	(double *data, size_t stride, size_t n);
+
+private:
+	template<class T>
+	void	process_mono		(size_t channel, BiquadCoeffs const *delta,
+								 T const *in, T *out, size_t n)
+	{
+		if(precision_ == StatePrecision::Float) {
+			MonoBlockKernel<T, ScalarFloatOps> kernel = { coeffs_, delta, states_[channel], in, out, n };
+			dispatch_filter_type(filter_type_, kernel);
+		} else {
+			MonoBlockKernel<T, ScalarOps> kernel = { coeffs_, delta, states_[channel], in, out, n };
+			dispatch_filter_type(filter_type_, kernel);
+		}
+	}
+
+	template<class T>
+	void	process_channels	(T const * const *in, T * const *out, size_t offset, size_t n);
+
+	template<class T>
+	void	process_direct		(BiquadCoeffs const *delta,
+								 T const * const *in, T * const *out, size_t offset, size_t n);
+
+	template<class T>
+	void	process_frames		(T *data, size_t stride, size_t n);
+
+	//! 係数の変化をnサンプル分進める
+	void	advance_ramp		(size_t n);
+
+
+	BiquadCoeffs				coeffs_;
+	size_t						filter_type_;
+	size_t						precision_;
+	StateSpaceCoeffs			ss_coeffs_;
+	std::vector<BiquadState>	states_;
+	size_t						mode_;
+
+	BiquadCoeffs				ramp_target_;
+	BiquadCoeffs				ramp_delta_;
+	size_t						ramp_remaining_;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_BIQUAD_HPP
@@ -0,0 +1,312 @@
+#include "./BiquadBank.hpp"
+#include "./BiquadKernels.hpp"
+#include "./CpuFeatures.hpp"
+#include "./Denormals.hpp"
+#include "./SimdOps.hpp"
+#include <algorithm>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! カーネルに渡す、SoAの配列の先頭
+struct BankArrays
+{
+	double *	b0_;
+	double *	b1_;
+	double *	b2_;
+	double *	a1_;
+	double *	a2_;
+	double *	s0_;
+	double *	s1_;
+};
+
+//! p[0] ~ p[W - 1]をレジスタのレーンに読み込む
+template<class Ops>
+typename Ops::value_type
+		load_lanes	(double const *p)
+{
+	typedef typename Ops::scalar_type S;
+	S tmp[Ops::kWidth];
+	for(size_t j = 0; j < Ops::kWidth; ++j) {
+		tmp[j] = static_cast<S>(p[j]);
+	}
+	return Ops::loadu(tmp);
+}
+
+template<class Ops>
+void	store_lanes	(double *p, typename Ops::value_type v)
+{
+	typedef typename Ops::scalar_type S;
+	S tmp[Ops::kWidth];
+	Ops::storeu(tmp, v);
+	for(size_t j = 0; j < Ops::kWidth; ++j) {
+		p[j] = tmp[j];
+	}
+}
+
+//! Lanes組のレジスタで、フィルタfirst ~ first + Ops::kWidth * Lanes - 1をまとめて処理する
+//! 係数と遅延子はレーンごとに違う値をブロックの間レジスタに保持する
+template<class Ops, size_t Lanes, class T>
+void	process_bank_lanes	(BankArrays const &a, size_t first,
+							 T const * const *in, T * const *out, size_t n)
+{
+	typedef typename Ops::value_type	V;
+	typedef typename Ops::scalar_type	S;
+
+	enum {
+		W = Ops::kWidth,
+		kNumFilters = W * Lanes
+	};
+
+	T const * const *src = in + first;
+	T * const *dst = out + first;
+
+	KernelCoeffs<Ops> c[Lanes];
+	V s0[Lanes];
+	V s1[Lanes];
+	for(size_t l = 0; l < Lanes; ++l) {
+		size_t const f = first + l * W;
+		c[l].b0_ = load_lanes<Ops>(a.b0_ + f);
+		c[l].b1_ = load_lanes<Ops>(a.b1_ + f);
+		c[l].b2_ = load_lanes<Ops>(a.b2_ + f);
+		c[l].a1_ = load_lanes<Ops>(a.a1_ + f);
+		c[l].a2_ = load_lanes<Ops>(a.a2_ + f);
+		s0[l] = load_lanes<Ops>(a.s0_ + f);
+		s1[l] = load_lanes<Ops>(a.s1_ + f);
+	}
+
+	size_t i = 0;
+	for( ; i + W <= n; i += W) {
+		V x[Lanes][W];
+		for(size_t l = 0; l < Lanes; ++l) {
+			load_tile(x[l], src + l * W, i);
+		}
+
+		for(size_t k = 0; k < W; ++k) {
+			for(size_t l = 0; l < Lanes; ++l) {
+				x[l][k] = BiquadKernel<kGenericKernel>::template tick<Ops>(c[l], x[l][k], s0[l], s1[l]);
+			}
+		}
+
+		for(size_t l = 0; l < Lanes; ++l) {
+			store_tile(x[l], dst + l * W, i);
+		}
+	}
+
+	//! 端数のサンプルは1サンプルずつ並べ替える
+	S sbuf[kNumFilters];
+	for( ; i < n; ++i) {
+		for(size_t f = 0; f < kNumFilters; ++f) {
+			sbuf[f] = static_cast<S>(src[f][i]);
+		}
+		for(size_t l = 0; l < Lanes; ++l) {
+			V const x = Ops::loadu(sbuf + l * W);
+			Ops::storeu(sbuf + l * W, BiquadKernel<kGenericKernel>::template tick<Ops>(c[l], x, s0[l], s1[l]));
+		}
+		for(size_t f = 0; f < kNumFilters; ++f) {
+			dst[f][i] = static_cast<T>(sbuf[f]);
+		}
+	}
+
+	for(size_t l = 0; l < Lanes; ++l) {
+		store_lanes<Ops>(a.s0_ + first + l * W, s0[l]);
+		store_lanes<Ops>(a.s1_ + first + l * W, s1[l]);
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+template<class Ops, size_t Lanes, class T>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	process_bank_lanes_avx	(BankArrays const &a, size_t first,
+								 T const * const *in, T * const *out, size_t n)
+{
+	process_bank_lanes<Ops, Lanes, T>(a, first, in, out, n);
+}
+
+#endif
+
+}	//unnamed namespace
+
+BiquadBank::BiquadBank	(size_t num_filters)
+	:	precision_(StatePrecision::Double)
+{
+	resize(num_filters);
+}
+
+void	BiquadBank::resize	(size_t num_filters)
+{
+	size_t const old_size = size();
+
+	Params const through = { kGenericKernel, 0.0, 0.0, 0.0 };
+	filter_type_.resize(num_filters, through.filter_type_);
+	cutoff_.resize(num_filters, through.cutoff_);
+	db_gain_.resize(num_filters, through.db_gain_);
+	Q_.resize(num_filters, through.Q_);
+
+	b0_.resize(num_filters, 1.0);
+	b1_.resize(num_filters, 0.0);
+	b2_.resize(num_filters, 0.0);
+	a1_.resize(num_filters, 0.0);
+	a2_.resize(num_filters, 0.0);
+
+	s0_.resize(num_filters, 0.0);
+	s1_.resize(num_filters, 0.0);
+
+	for(size_t i = old_size; i < num_filters; ++i) {
+		clear_buffer(i);
+	}
+}
+
+size_t	BiquadBank::size	() const
+{
+	return b0_.size();
+}
+
+void	BiquadBank::set_params	(size_t index, Params const &params)
+{
+	filter_type_[index]	= params.filter_type_;
+	cutoff_[index]		= params.cutoff_;
+	db_gain_[index]		= params.db_gain_;
+	Q_[index]			= params.Q_;
+	set_coeffs(index, design_biquad(params.filter_type_, params.cutoff_, params.db_gain_, params.Q_));
+}
+
+BiquadBank::Params
+		BiquadBank::get_params	(size_t index) const
+{
+	Params params;
+	params.filter_type_	= filter_type_[index];
+	params.cutoff_		= cutoff_[index];
+	params.db_gain_		= db_gain_[index];
+	params.Q_			= Q_[index];
+	return params;
+}
+
+void	BiquadBank::set_coeffs	(size_t index, BiquadCoeffs const &coeffs)
+{
+	b0_[index] = coeffs.b0_;
+	b1_[index] = coeffs.b1_;
+	b2_[index] = coeffs.b2_;
+	a1_[index] = coeffs.a1_;
+	a2_[index] = coeffs.a2_;
+}
+
+BiquadCoeffs
+		BiquadBank::get_coeffs	(size_t index) const
+{
+	BiquadCoeffs const c = { b0_[index], b1_[index], b2_[index], a1_[index], a2_[index] };
+	return c;
+}
+
+void	BiquadBank::clear_buffer	()
+{
+	std::fill(s0_.begin(), s0_.end(), 0.0);
+	std::fill(s1_.begin(), s1_.end(), 0.0);
+}
+
+void	BiquadBank::clear_buffer	(size_t index)
+{
+	s0_[index] = 0.0;
+	s1_[index] = 0.0;
+}
+
+void	BiquadBank::flush_denormals	()
+{
+	if(!s0_.empty()) {
+		dsp::flush_denormals(&s0_[0], s0_.size());
+		dsp::flush_denormals(&s1_[0], s1_.size());
+	}
+}
+
+void	BiquadBank::set_state_precision	(size_t precision)
+{
+	precision_ = precision;
+}
+
+size_t	BiquadBank::get_state_precision	() const
+{
+	return precision_;
+}
+
+void	BiquadBank::process	(float const * const *in, float * const *out,
+							 size_t first, size_t last, size_t n)
+{
+	process_range(in, out, first, last, n);
+}
+
+void	BiquadBank::process	(double const * const *in, double * const *out,
+							 size_t first, size_t last, size_t n)
+{
+	process_range(in, out, first, last, n);
+}
+
+template<class T>
+void	BiquadBank::process_range	(T const * const *in, T * const *out,
+									 size_t first, size_t last, size_t n)
+{
+	if(first >= last) {
+		return;
+	}
+
+	BankArrays const a = {
+		&b0_[0], &b1_[0], &b2_[0], &a1_[0], &a2_[0], &s0_[0], &s1_[0]
+	};
+	size_t f = first;
+
+#if HWM_DSP_X86_SIMD
+	size_t const level = get_simd_level();
+	if(precision_ == StatePrecision::Float) {
+		if(level >= SimdLevel::AVX) {
+			for( ; f + 16 <= last; f += 16) {
+				process_bank_lanes_avx<AVX256FloatOps, 2>(a, f, in, out, n);
+			}
+			for( ; f + 8 <= last; f += 8) {
+				process_bank_lanes_avx<AVX256FloatOps, 1>(a, f, in, out, n);
+			}
+			for( ; f + 4 <= last; f += 4) {
+				process_bank_lanes_avx<AVXFloatOps, 1>(a, f, in, out, n);
+			}
+		} else if(level >= SimdLevel::SSE2) {
+			for( ; f + 8 <= last; f += 8) {
+				process_bank_lanes<SSEFloatOps, 2>(a, f, in, out, n);
+			}
+			for( ; f + 4 <= last; f += 4) {
+				process_bank_lanes<SSEFloatOps, 1>(a, f, in, out, n);
+			}
+		}
+	} else {
+		if(level >= SimdLevel::AVX) {
+			for( ; f + 8 <= last; f += 8) {
+				process_bank_lanes_avx<AVX256Ops, 2>(a, f, in, out, n);
+			}
+			for( ; f + 4 <= last; f += 4) {
+				process_bank_lanes_avx<AVX256Ops, 1>(a, f, in, out, n);
+			}
+			for( ; f + 2 <= last; f += 2) {
+				process_bank_lanes_avx<AVXOps, 1>(a, f, in, out, n);
+			}
+		} else if(level >= SimdLevel::SSE2) {
+			for( ; f + 4 <= last; f += 4) {
+				process_bank_lanes<SSE2Ops, 2>(a, f, in, out, n);
+			}
+			for( ; f + 2 <= last; f += 2) {
+				process_bank_lanes<SSE2Ops, 1>(a, f, in, out, n);
+			}
+		}
+	}
+#endif
+
+	if(precision_ == StatePrecision::Float) {
+		for( ; f < last; ++f) {
+			process_bank_lanes<ScalarFloatOps, 1>(a, f, in, out, n);
+		}
+	} else {
+		for( ; f < last; ++f) {
+			process_bank_lanes<ScalarOps, 1>(a, f, in, out, n);
+		}
+	}
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,94 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_BIQUADBANK_HPP
+#define	HWM_MINIVSTEFFECT_DSP_BIQUADBANK_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! 独立した多数のモノラルのbi-quadフィルタ
+//!
+//! パラメータ、係数、遅延子は、フィルタの番号で引く連続した配列(SoA)に持つ。
+//! 隣り合うフィルタをSIMDのレーンに並べ(AVXでは倍精度4本、単精度8本)、
+//! 係数もレーンごとに違う値のまま1サンプルずつ全レーンを計算する。
+//! 入出力はフィルタごとのバッファで、MultiBiquadと同じくWサンプルずつ転置して処理する。
+//!
+//! フィルタごとに係数が違うので、フィルタタイプに特殊化したカーネルは使わない
+struct BiquadBank
+{
+	//! 1つのフィルタのパラメータ
+	struct Params
+	{
+		//! FilterTypeのいずれか
+		size_t	filter_type_;
+		//! 正規化周波数(0.0 ~ 0.5)
+		double	cutoff_;
+		double	db_gain_;
+		double	Q_;
+	};
+
+	explicit
+	BiquadBank	(size_t num_filters = 0);
+
+	//! フィルタの数を変更する。追加されたフィルタは入力をそのまま出力する
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	resize				(size_t num_filters);
+	size_t	size				() const;
+
+	//! パラメータを設定し、係数を計算する
+	void	set_params			(size_t index, Params const &params);
+	Params	get_params			(size_t index) const;
+
+	//! 係数を直接設定する。get_paramsの値は更新されない
+	void	set_coeffs			(size_t index, BiquadCoeffs const &coeffs);
+	BiquadCoeffs
+			get_coeffs			(size_t index) const;
+
+	//! 遅延子をクリア
+	void	clear_buffer		();
+	void	clear_buffer		(size_t index);
+	//! 絶対値がkDenormalFlushLimit未満の遅延子を0にする
+	void	flush_denormals		();
+
+	//! StatePrecisionのいずれか
+	//! Floatでは、ブロックの間、係数と遅延子を単精度で保持してレーンを2倍にする
+	void	set_state_precision	(size_t precision);
+	size_t	get_state_precision	() const;
+
+	//! フィルタ[first, last)に、in[i]のnサンプルを処理してout[i]に書く(i = first ~ last - 1)
+	//! in と out は同じバッファでもよい
+	//! 範囲が重ならなければ、別々のスレッドから同時に呼び出してよい
+	void	process				(float const * const *in, float * const *out,
+								 size_t first, size_t last, size_t n);
+	void	process				(double const * const *in, double * const *out,
+								 size_t first, size_t last, size_t n);
+
+private:
+	template<class T>
+	void	process_range		(T const * const *in, T * const *out,
+								 size_t first, size_t last, size_t n);
+
+	//! パラメータ
+	std::vector<size_t>	filter_type_;
+	std::vector<double>	cutoff_;
+	std::vector<double>	db_gain_;
+	std::vector<double>	Q_;
+
+	//! 係数
+	std::vector<double>	b0_;
+	std::vector<double>	b1_;
+	std::vector<double>	b2_;
+	std::vector<double>	a1_;
+	std::vector<double>	a2_;
+
+	//! 遅延子(転置直接形IIの状態変数)
+	std::vector<double>	s0_;
+	std::vector<double>	s1_;
+
+	size_t				precision_;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_BIQUADBANK_HPP
@@ -0,0 +1,363 @@
+#include "./BiquadCascade.hpp"
+#include "./BiquadKernels.hpp"
+#include "./Denormals.hpp"
+#include "./SimdOps.hpp"
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+void	set_entry	(CascadeCoeffs &c, size_t k, BiquadCoeffs const &coeffs)
+{
+	c.b0_[k] = coeffs.b0_;
+	c.b1_[k] = coeffs.b1_;
+	c.b2_[k] = coeffs.b2_;
+	c.a1_[k] = coeffs.a1_;
+	c.a2_[k] = coeffs.a2_;
+}
+
+BiquadCoeffs
+		get_entry	(CascadeCoeffs const &c, size_t k)
+{
+	BiquadCoeffs const coeffs = { c.b0_[k], c.b1_[k], c.b2_[k], c.a1_[k], c.a2_[k] };
+	return coeffs;
+}
+
+//! 先頭のnum_sections個のセクションの係数を、deltaのk倍だけ進める
+void	advance_cascade_coeffs	(CascadeCoeffs &c, CascadeCoeffs const &delta,
+								 size_t num_sections, double k)
+{
+	for(size_t i = 0; i < num_sections; ++i) {
+		c.b0_[i] += delta.b0_[i] * k;
+		c.b1_[i] += delta.b1_[i] * k;
+		c.b2_[i] += delta.b2_[i] * k;
+		c.a1_[i] += delta.a1_[i] * k;
+		c.a2_[i] += delta.a2_[i] * k;
+	}
+}
+
+//! セクションごとに、x[0] ~ x[count - 1]のcountサンプル分を順に通す
+//! 1つのセクションの遅延子と係数をレジスタに置いたままcountサンプル処理してから、
+//! 次のセクションに進む。遅延子の依存チェーンがメモリを経由しない
+template<class Ops, bool Ramp>
+void	run_sections	(CascadeCoeffs const &coeffs, CascadeCoeffs const &delta,
+						 size_t num_sections,
+						 typename Ops::value_type *s0, typename Ops::value_type *s1,
+						 typename Ops::value_type *x, size_t count)
+{
+	typedef typename Ops::value_type	V;
+
+	for(size_t k = 0; k < num_sections; ++k) {
+		//! フィルタタイプはセクションごとに異なるので、汎用のカーネルを使う
+		KernelCoeffs<Ops> c = make_kernel_coeffs<Ops>(get_entry(coeffs, k));
+		KernelCoeffs<Ops> d;
+		if(Ramp) {
+			d = make_kernel_coeffs<Ops>(get_entry(delta, k));
+		}
+
+		V a = s0[k];
+		V b = s1[k];
+		for(size_t t = 0; t < count; ++t) {
+			x[t] = BiquadKernel<kGenericKernel>::template tick<Ops>(c, x[t], a, b);
+			if(Ramp) {
+				step_kernel_coeffs(c, d);
+			}
+		}
+		s0[k] = a;
+		s1[k] = b;
+	}
+}
+
+//! Ops::kWidthチャンネル分を、全セクションまとめて処理する
+//! kChunkSizeサンプルずつ、レーンに並べ替えてから全セクションに通す
+//! @param st 先頭のチャンネルの遅延子。チャンネルごとにkMaxCascadeSections個ずつ並んでいる
+template<class Ops, bool Ramp, class T>
+void	process_group	(CascadeCoeffs const &coeffs, CascadeCoeffs const &delta,
+						 size_t num_sections, BiquadState *st,
+						 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	typedef typename Ops::value_type	V;
+	typedef typename Ops::scalar_type	S;
+
+	enum {
+		W = Ops::kWidth,
+		kChunkSize = 16
+	};
+
+	T const *src[W];
+	T *dst[W];
+	for(size_t ch = 0; ch < W; ++ch) {
+		src[ch] = in[ch] + offset;
+		dst[ch] = out[ch] + offset;
+	}
+
+	//! Rampのときはチャンクごとに進める
+	CascadeCoeffs c = coeffs;
+
+	//! 遅延子と端数のサンプルの並べ替えに使う
+	V buf[1];
+	S * const sbuf = reinterpret_cast<S *>(buf);
+
+	V s0[kMaxCascadeSections];
+	V s1[kMaxCascadeSections];
+	for(size_t k = 0; k < num_sections; ++k) {
+		for(size_t ch = 0; ch < W; ++ch) {
+			sbuf[ch] = st[ch * kMaxCascadeSections + k].s_[0];
+		}
+		s0[k] = Ops::load(sbuf);
+		for(size_t ch = 0; ch < W; ++ch) {
+			sbuf[ch] = st[ch * kMaxCascadeSections + k].s_[1];
+		}
+		s1[k] = Ops::load(sbuf);
+	}
+
+	V x[kChunkSize];
+
+	size_t i = 0;
+	for( ; i + kChunkSize <= n; i += kChunkSize) {
+		for(size_t j = 0; j < kChunkSize; j += W) {
+			load_tile(x + j, src, i + j);
+		}
+		run_sections<Ops, Ramp>(c, delta, num_sections, s0, s1, x, kChunkSize);
+		for(size_t j = 0; j < kChunkSize; j += W) {
+			store_tile(x + j, dst, i + j);
+		}
+		if(Ramp) {
+			advance_cascade_coeffs(c, delta, num_sections, kChunkSize);
+		}
+	}
+
+	//! 端数のサンプルは1サンプルずつ並べ替える
+	size_t const rest = n - i;
+	if(rest > 0) {
+		for(size_t j = 0; j < rest; ++j) {
+			for(size_t ch = 0; ch < W; ++ch) {
+				sbuf[ch] = static_cast<S>(src[ch][i + j]);
+			}
+			x[j] = Ops::load(sbuf);
+		}
+		run_sections<Ops, Ramp>(c, delta, num_sections, s0, s1, x, rest);
+		for(size_t j = 0; j < rest; ++j) {
+			Ops::store(sbuf, x[j]);
+			for(size_t ch = 0; ch < W; ++ch) {
+				dst[ch][i + j] = static_cast<T>(sbuf[ch]);
+			}
+		}
+	}
+
+	for(size_t k = 0; k < num_sections; ++k) {
+		Ops::store(sbuf, s0[k]);
+		for(size_t ch = 0; ch < W; ++ch) {
+			st[ch * kMaxCascadeSections + k].s_[0] = sbuf[ch];
+		}
+		Ops::store(sbuf, s1[k]);
+		for(size_t ch = 0; ch < W; ++ch) {
+			st[ch * kMaxCascadeSections + k].s_[1] = sbuf[ch];
+		}
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+template<class Ops, bool Ramp, class T>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	process_group_avx	(CascadeCoeffs const &coeffs, CascadeCoeffs const &delta,
+							 size_t num_sections, BiquadState *st,
+							 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	process_group<Ops, Ramp, T>(coeffs, delta, num_sections, st, in, out, offset, n);
+}
+
+#endif	//HWM_DSP_X86_SIMD
+
+template<bool Ramp, class T>
+void	dispatch_cascade	(CascadeCoeffs const &c, CascadeCoeffs const &delta,
+							 size_t num_sections, std::vector<BiquadState> &states,
+							 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	size_t const num_channels = states.size() / kMaxCascadeSections;
+	size_t ch = 0;
+
+#if HWM_DSP_X86_SIMD
+	size_t const level = get_simd_level();
+	if(level >= SimdLevel::AVX) {
+		for( ; ch + 4 <= num_channels; ch += 4) {
+			process_group_avx<AVX256Ops, Ramp>(c, delta, num_sections,
+				&states[ch * kMaxCascadeSections], in + ch, out + ch, offset, n);
+		}
+		for( ; ch + 2 <= num_channels; ch += 2) {
+			process_group_avx<AVXOps, Ramp>(c, delta, num_sections,
+				&states[ch * kMaxCascadeSections], in + ch, out + ch, offset, n);
+		}
+	} else if(level >= SimdLevel::SSE2) {
+		for( ; ch + 2 <= num_channels; ch += 2) {
+			process_group<SSE2Ops, Ramp>(c, delta, num_sections,
+				&states[ch * kMaxCascadeSections], in + ch, out + ch, offset, n);
+		}
+	}
+#endif
+
+	for( ; ch < num_channels; ++ch) {
+		process_group<ScalarOps, Ramp>(c, delta, num_sections,
+			&states[ch * kMaxCascadeSections], in + ch, out + ch, offset, n);
+	}
+}
+
+}	//unnamed namespace
+
+BiquadCascade::BiquadCascade	(size_t num_channels, size_t num_sections)
+	:	num_sections_(0)
+	,	states_(num_channels * kMaxCascadeSections)
+	,	ramp_remaining_(0)
+{
+	BiquadCoeffs const through = { 1.0, 0.0, 0.0, 0.0, 0.0 };
+	for(size_t k = 0; k < kMaxCascadeSections; ++k) {
+		set_entry(coeffs_, k, through);
+		set_entry(ramp_target_, k, through);
+	}
+	ramp_delta_ = CascadeCoeffs();
+
+	set_num_sections(num_sections);
+}
+
+void	BiquadCascade::set_num_sections	(size_t num_sections)
+{
+	if(num_sections < 1) {
+		num_sections = 1;
+	} else if(num_sections > kMaxCascadeSections) {
+		num_sections = kMaxCascadeSections;
+	}
+
+	BiquadCoeffs const through = { 1.0, 0.0, 0.0, 0.0, 0.0 };
+	for(size_t k = num_sections_; k < num_sections; ++k) {
+		set_section(k, through);
+	}
+
+	num_sections_ = num_sections;
+	clear_buffer();
+}
+
+size_t	BiquadCascade::get_num_sections	() const
+{
+	return num_sections_;
+}
+
+void	BiquadCascade::set_section	(size_t index, BiquadCoeffs const &coeffs)
+{
+	set_entry(coeffs_, index, coeffs);
+	set_entry(ramp_target_, index, coeffs);
+	set_entry(ramp_delta_, index, BiquadCoeffs());
+}
+
+BiquadCoeffs
+		BiquadCascade::get_section	(size_t index) const
+{
+	return get_entry(coeffs_, index);
+}
+
+void	BiquadCascade::ramp_sections	(BiquadCoeffs const *coeffs, size_t num_samples)
+{
+	if(num_samples == 0) {
+		ramp_remaining_ = 0;
+		for(size_t k = 0; k < num_sections_; ++k) {
+			set_section(k, coeffs[k]);
+		}
+		return;
+	}
+
+	double const r = 1.0 / num_samples;
+	for(size_t k = 0; k < num_sections_; ++k) {
+		BiquadCoeffs const &to = coeffs[k];
+		BiquadCoeffs const from = get_entry(coeffs_, k);
+		BiquadCoeffs const delta = {
+			(to.b0_ - from.b0_) * r,
+			(to.b1_ - from.b1_) * r,
+			(to.b2_ - from.b2_) * r,
+			(to.a1_ - from.a1_) * r,
+			(to.a2_ - from.a2_) * r
+		};
+		set_entry(ramp_target_, k, to);
+		set_entry(ramp_delta_, k, delta);
+	}
+	ramp_remaining_ = num_samples;
+}
+
+size_t	BiquadCascade::get_ramp_remaining	() const
+{
+	return ramp_remaining_;
+}
+
+void	BiquadCascade::clear_buffer	()
+{
+	for(size_t i = 0; i < states_.size(); ++i) {
+		states_[i].s_[0] = 0.0;
+		states_[i].s_[1] = 0.0;
+	}
+}
+
+void	BiquadCascade::flush_denormals	()
+{
+	if(!states_.empty()) {
+		dsp::flush_denormals(states_[0].s_, states_.size() * 2);
+	}
+}
+
+size_t	BiquadCascade::get_num_channels	() const
+{
+	return states_.size() / kMaxCascadeSections;
+}
+
+void	BiquadCascade::set_num_channels	(size_t num_channels)
+{
+	states_.resize(num_channels * kMaxCascadeSections);
+	clear_buffer();
+}
+
+template<class T>
+void	BiquadCascade::process_channels	(T const * const *in, T * const *out,
+										 size_t offset, size_t n)
+{
+	if(ramp_remaining_ > 0) {
+		size_t const m = (n < ramp_remaining_) ? n : ramp_remaining_;
+		dispatch_cascade<true>(coeffs_, ramp_delta_, num_sections_, states_, in, out, offset, m);
+
+		ramp_remaining_ -= m;
+		if(ramp_remaining_ == 0) {
+			//! 足し込みの丸め誤差を残さないように、最後は目標の係数に合わせる
+			coeffs_ = ramp_target_;
+		} else {
+			advance_cascade_coeffs(coeffs_, ramp_delta_, num_sections_, static_cast<double>(m));
+		}
+
+		offset += m;
+		n -= m;
+	}
+
+	if(n > 0) {
+		dispatch_cascade<false>(coeffs_, ramp_delta_, num_sections_, states_, in, out, offset, n);
+	}
+}
+
+void	BiquadCascade::process_block	(float const * const *in, float * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	BiquadCascade::process_block	(double const * const *in, double * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	BiquadCascade::process_block	(float const * const *in, float * const *out,
+										 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+void	BiquadCascade::process_block	(double const * const *in, double * const *out,
+										 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,91 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_BIQUADCASCADE_HPP
+#define	HWM_MINIVSTEFFECT_DSP_BIQUADCASCADE_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+enum {
+	//! 縦続接続できるセクション数の上限
+	kMaxCascadeSections = 16
+};
+
+//! 縦続接続の係数
+//! 係数の種類ごとにセクションを並べたSoA
+struct CascadeCoeffs
+{
+	double	b0_[kMaxCascadeSections];
+	double	b1_[kMaxCascadeSections];
+	double	b2_[kMaxCascadeSections];
+	double	a1_[kMaxCascadeSections];
+	double	a2_[kMaxCascadeSections];
+};
+
+//! bi-quadの縦続接続
+//!
+//! セクションごとに個別の係数を持つ。入力を16サンプルずつレジスタに読み込み、
+//! 各セクションが遅延子と係数をレジスタに置いたまま16サンプルを処理してから次のセクションに渡す。
+//! 入出力のバッファの読み書きはセクション数によらず1回で、遅延子の依存チェーンはメモリを経由しない。
+//!
+//! チャンネルはSIMDのレーンに並べて処理する(AVXでは4ch、SSE2では2ch)。
+//! 遅延子とセクションの計算は常に倍精度で行う。
+struct BiquadCascade
+{
+	explicit
+	BiquadCascade	(size_t num_channels, size_t num_sections = 1);
+
+	//! セクション数を変更する。1 ~ kMaxCascadeSections
+	//! 追加されたセクションは素通しになり、遅延子はクリアされる
+	void	set_num_sections	(size_t num_sections);
+	size_t	get_num_sections	() const;
+
+	//! セクションの係数を設定する
+	//! 係数を変化させている途中であれば、そのセクションだけ変化を止める
+	void	set_section			(size_t index, BiquadCoeffs const &coeffs);
+	BiquadCoeffs
+			get_section			(size_t index) const;
+
+	//! 全セクションの係数を、process_blockのnum_samplesサンプルをかけて
+	//! 現在の値からcoeffs[0] ~ coeffs[get_num_sections() - 1]まで線形に変化させる
+	void	ramp_sections		(BiquadCoeffs const *coeffs, size_t num_samples);
+	size_t	get_ramp_remaining	() const;
+
+	//! 遅延子をクリア
+	void	clear_buffer		();
+	//! 絶対値がkDenormalFlushLimit未満の遅延子を0にする
+	//! FTZ, DAZを設定できない環境で、非正規化数での演算を避けるためにブロックの境界で呼び出す
+	void	flush_denormals		();
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。遅延子はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! 全チャンネルをまとめて処理する
+	void	process_block		(float const * const *in, float * const *out, size_t n);
+	void	process_block		(double const * const *in, double * const *out, size_t n);
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	void	process_block		(float const * const *in, float * const *out,
+								 size_t offset, size_t n);
+	void	process_block		(double const * const *in, double * const *out,
+								 size_t offset, size_t n);
+
+private:
+	CascadeCoeffs				coeffs_;
+	size_t						num_sections_;
+	//! チャンネルごとにkMaxCascadeSections個ずつ並べる
+	std::vector<BiquadState>	states_;
+
+	CascadeCoeffs				ramp_target_;
+	CascadeCoeffs				ramp_delta_;
+	size_t						ramp_remaining_;
+
+	template<class T>
+	void	process_channels	(T const * const *in, T * const *out, size_t offset, size_t n);
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_BIQUADCASCADE_HPP
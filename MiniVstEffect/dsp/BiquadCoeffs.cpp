@@ -0,0 +1,137 @@
+#define _USE_MATH_DEFINES
+#include "./BiquadCoeffs.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+BiquadCoeffs
+		design_biquad	(size_t filter_type, double cutoff, double db_gain, double Q)
+{
+	double const A = pow(10.0, db_gain / 40);
+	double const w0 = 2.0 * M_PI * cutoff;
+
+	return design_biquad_from(filter_type, cos(w0), sin(w0), A, Q);
+}
+
+BiquadCoeffs
+		design_biquad_from	(size_t filter_type, double cos_w0, double sin_w0, double A, double Q)
+{
+	double const alpha = sin_w0 / (2.0 * Q);
+	double const K = 2.0 * sqrt(A) * alpha;
+
+	//! 未知のフィルタタイプでは素通し
+	double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+	double a0 = 1.0, a1 = 0.0, a2 = 0.0;
+
+	switch(filter_type) {
+		case FilterType::LPF:
+			b0 = (1.0 - cos_w0) / 2.0;
+			b1 = 1.0 - cos_w0;
+			b2 = (1.0 - cos_w0) / 2.0;
+			a0 = 1.0 + alpha;
+			a1 = -2.0 * cos_w0;
+			a2 = 1.0 - alpha;
+			break;
+
+		case FilterType::HPF:
+			b0 = (1.0 + cos_w0) / 2.0;
+			b1 = -(1.0 + cos_w0);
+			b2 = (1.0 + cos_w0) / 2.0;
+			a0 = 1.0 + alpha;
+			a1 = -2.0 * cos_w0;
+			a2 = 1.0 - alpha;
+			break;
+
+		case FilterType::BPF:
+			//(constant skirt gain, peak gain = Q)
+			b0 = sin_w0 / 2.0;
+			b1 = 0;
+			b2 = -sin_w0 / 2.0;
+			a0 = 1 + alpha;
+			a1 = -2 * cos_w0;
+			a2 = 1 - alpha;
+			break;
+
+		case FilterType::notch:
+			b0 = 1;
+			b1 = -2 * cos_w0;
+			b2 = 1;
+			a0 = 1 + alpha;
+			a1 = -2 * cos_w0;
+			a2 = 1 - alpha;
+			break;
+
+		case FilterType::APF:
+			b0 = 1.0 - alpha;
+			b1 = -2.0 * cos_w0;
+			b2 = 1.0 + alpha;
+			a0 = 1.0 + alpha;
+			a1 = -2.0 * cos_w0;
+			a2 = 1.0 - alpha;
+			break;
+
+		case FilterType::PeakingEQ:
+			b0 = 1 + alpha * A;
+			b1 = -2 * cos_w0;
+			b2 = 1 - alpha * A;
+			a0 = 1 + alpha / A;
+			a1 = -2.0 * cos_w0;
+			a2 = 1 - alpha / A;
+			break;
+
+		case FilterType::LowShelf:
+			b0 = A * ( (A+1) - (A-1) * cos_w0 + K );
+			b1 = 2 * A * ( (A-1) - (A+1) * cos_w0 );
+			b2 = A * ( (A+1) - (A-1) * cos_w0 - K );
+			a0 = (A+1) + (A-1) * cos_w0 + K;
+			a1 = -2 * ( (A-1) + (A+1) * cos_w0 );
+			a2 = (A+1) + (A-1) * cos_w0 - K;
+			break;
+
+		case FilterType::HighShelf:
+			b0 = A * ( (A+1) + (A-1) * cos_w0 + K );
+			b1 = -2 * A * ( (A-1) + (A+1) * cos_w0 );
+			b2 = A * ( (A+1) + (A-1) * cos_w0 - K );
+			a0 = (A+1) - (A-1) * cos_w0 + K;
+			a1 = 2 * ( (A-1) - (A+1) * cos_w0 );
+			a2 = (A+1) - (A-1) * cos_w0 - K;
+			break;
+	}
+
+	//! a0で正規化しておき、処理中の除算をなくす
+	BiquadCoeffs const c = { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+
+	return c;
+}
+
+double	get_pole_radius		(BiquadCoeffs const &coeffs)
+{
+	double const a1 = coeffs.a1_;
+	double const a2 = coeffs.a2_;
+	double const disc = a1 * a1 - 4.0 * a2;
+
+	//! 複素共役の極なら、絶対値はどちらもsqrt(a2)
+	if(disc < 0) {
+		return sqrt(a2);
+	}
+
+	double const root = sqrt(disc);
+	return std::max(fabs(-a1 + root), fabs(-a1 - root)) / 2.0;
+}
+
+size_t	get_decay_length	(double radius, double decay, size_t max_length)
+{
+	if(radius <= 0) {
+		return 0;
+	}
+	if(radius >= 1.0) {
+		return max_length;
+	}
+
+	double const length = ceil(log(decay) / log(radius));
+	return (length < max_length) ? static_cast<size_t>(length) : max_length;
+}
+
+}}	//namespace hwm::dsp
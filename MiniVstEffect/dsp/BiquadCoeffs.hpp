@@ -0,0 +1,65 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_BIQUADCOEFFS_HPP
+#define	HWM_MINIVSTEFFECT_DSP_BIQUADCOEFFS_HPP
+
+#include <cstddef>
+
+namespace hwm { namespace dsp {
+
+//! フィルタタイプの定義
+struct FilterType
+{
+	enum {
+		LPF,
+		HPF,
+		BPF,
+		notch,
+		APF,
+		PeakingEQ,
+		LowShelf,
+		HighShelf,
+		kNumFilterType
+	};
+};
+
+//! bi-quadフィルタの係数
+//! a0で正規化済みなので、a0は持たない
+struct BiquadCoeffs
+{
+	double	b0_;
+	double	b1_;
+	double	b2_;
+	double	a1_;
+	double	a2_;
+};
+
+//! RBJ Audio-EQ-Cookbookに従ってフィルタの係数を計算する
+//! @param filter_type FilterTypeのいずれか
+//! @param cutoff 正規化周波数(0.0 ~ 0.5)
+//! @param db_gain Peaking EQ, Low Shelving, High Shelving以外では使用されない
+BiquadCoeffs
+		design_biquad	(size_t filter_type, double cutoff, double db_gain, double Q);
+
+//! design_biquadのうち、三角関数とpowを計算した後の部分
+//! @param cos_w0, sin_w0 w0 = 2 * pi * cutoff の余弦と正弦
+//! @param A pow(10, db_gain / 40)
+BiquadCoeffs
+		design_biquad_from	(size_t filter_type, double cos_w0, double sin_w0, double A, double Q);
+
+//! 極(z^2 + a1 z + a2 = 0の根)の絶対値の最大
+//! 1未満なら安定で、インパルス応答の包絡線は1サンプルごとにこの値の割合で減衰する
+double	get_pole_radius		(BiquadCoeffs const &coeffs);
+
+//! 極の絶対値がradiusのフィルタの応答が、decay倍(0.0 ~ 1.0)まで減衰するサンプル数
+//! radiusが1以上なら減衰しないので、max_length
+size_t	get_decay_length	(double radius, double decay, size_t max_length);
+
+//! 1チャンネル分の遅延子
+//! 転置直接形IIの状態変数
+struct BiquadState
+{
+	double	s_[2];
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_BIQUADCOEFFS_HPP
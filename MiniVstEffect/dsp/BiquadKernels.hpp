@@ -0,0 +1,265 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_BIQUADKERNELS_HPP
+#define	HWM_MINIVSTEFFECT_DSP_BIQUADKERNELS_HPP
+
+#include "./BiquadCoeffs.hpp"
+
+namespace hwm { namespace dsp {
+
+//! 遅延子と演算の精度
+//! 入出力の精度(float / double)とは独立に選択できる
+//!   double入出力 + Double : すべて倍精度
+//!   float入出力  + Double : 信号は単精度、遅延子と演算は倍精度
+//!   float入出力  + Float  : すべて単精度。SIMDでは倍の幅で処理できる
+struct StatePrecision
+{
+	enum {
+		Double,
+		Float,
+		kNumStatePrecision
+	};
+};
+
+//! カーネルで使う演算
+//! SIMD版は同じインターフェイスでレジスタ型を扱う
+template<class S>
+struct BasicScalarOps
+{
+	typedef S	value_type;
+	typedef S	scalar_type;
+	enum { kWidth = 1 };
+
+	static S	set1	(double v)			{ return static_cast<S>(v); }
+	static S	zero	()					{ return 0; }
+	static S	load	(S const *p)		{ return *p; }
+	static S	loadu	(S const *p)		{ return *p; }
+	static void	store	(S *p, S v)			{ *p = v; }
+	static void	storeu	(S *p, S v)			{ *p = v; }
+	static S	add		(S a, S b)			{ return a + b; }
+	static S	sub		(S a, S b)			{ return a - b; }
+	static S	mul		(S a, S b)			{ return a * b; }
+	static S	maximum	(S a, S b)			{ return (a < b) ? b : a; }
+	static S	abs		(S a)				{ return (a < 0) ? -a : a; }
+	//! a * b + c
+	static S	madd	(S a, S b, S c)		{ return a * b + c; }
+	//! c - a * b
+	static S	nmadd	(S a, S b, S c)		{ return c - a * b; }
+};
+
+typedef BasicScalarOps<double>	ScalarOps;
+typedef BasicScalarOps<float>	ScalarFloatOps;
+
+//! カーネル用に展開した係数
+template<class Ops>
+struct KernelCoeffs
+{
+	typedef typename Ops::value_type	V;
+
+	V	b0_;
+	V	b1_;
+	V	b2_;
+	V	a1_;
+	V	a2_;
+};
+
+template<class Ops>
+KernelCoeffs<Ops>
+		make_kernel_coeffs	(BiquadCoeffs const &c)
+{
+	KernelCoeffs<Ops> k;
+	k.b0_ = Ops::set1(c.b0_);
+	k.b1_ = Ops::set1(c.b1_);
+	k.b2_ = Ops::set1(c.b2_);
+	k.a1_ = Ops::set1(c.a1_);
+	k.a2_ = Ops::set1(c.a2_);
+	return k;
+}
+
+//! 係数の線形補間で、1サンプル分cにdを足す
+template<class Ops>
+void	step_kernel_coeffs	(KernelCoeffs<Ops> &c, KernelCoeffs<Ops> const &d)
+{
+	c.b0_ = Ops::add(c.b0_, d.b0_);
+	c.b1_ = Ops::add(c.b1_, d.b1_);
+	c.b2_ = Ops::add(c.b2_, d.b2_);
+	c.a1_ = Ops::add(c.a1_, d.a1_);
+	c.a2_ = Ops::add(c.a2_, d.a2_);
+}
+
+//! 転置直接形IIの1サンプル分の処理
+//! 汎用版。特殊化されていないフィルタタイプ(APF, Peaking EQ, Low Shelf, High Shelf)もこれを使う
+//! APF(b0 = a2, b1 = a1, b2 = 1)とPeaking EQ(b1 = a1)は、定数を畳み込んでもyの後の依存は短くならず、
+//! 汎用版より速くならないので特殊化しない
+template<size_t Type>
+struct BiquadKernel
+{
+	template<class Ops>
+	static typename Ops::value_type
+				tick	(KernelCoeffs<Ops> const &c, typename Ops::value_type x,
+						 typename Ops::value_type &s0, typename Ops::value_type &s1)
+	{
+		typedef typename Ops::value_type V;
+
+		V const y = Ops::madd(c.b0_, x, s0);
+		s0 = Ops::nmadd(c.a1_, y, Ops::madd(c.b1_, x, s1));
+		s1 = Ops::nmadd(c.a2_, y, Ops::mul(c.b2_, x));
+		return y;
+	}
+};
+
+//! 以下、design_biquadが正規化後に作る構造上の定数を畳み込んだもの
+//! (正規化してもこれらの関係は丸め誤差なしに保たれる)
+//! 次のサンプルのyはs0から求めるので、yからs0までは汎用カーネルと同じくFMA1回にする
+//! b1 = a1 を a1 * (x - y) とまとめると、減算がyの後に入って1サンプルあたりの依存が長くなる
+//! 特殊化するのは、yに依存しない側の演算が減るフィルタタイプだけ
+
+//! b1 = 2 * b0, b2 = b0
+template<>
+struct BiquadKernel<FilterType::LPF>
+{
+	template<class Ops>
+	static typename Ops::value_type
+				tick	(KernelCoeffs<Ops> const &c, typename Ops::value_type x,
+						 typename Ops::value_type &s0, typename Ops::value_type &s1)
+	{
+		typedef typename Ops::value_type V;
+
+		V const bx = Ops::mul(c.b0_, x);
+		V const y = Ops::add(bx, s0);
+		s0 = Ops::nmadd(c.a1_, y, Ops::add(Ops::add(bx, bx), s1));
+		s1 = Ops::nmadd(c.a2_, y, bx);
+		return y;
+	}
+};
+
+//! b1 = -2 * b0, b2 = b0
+template<>
+struct BiquadKernel<FilterType::HPF>
+{
+	template<class Ops>
+	static typename Ops::value_type
+				tick	(KernelCoeffs<Ops> const &c, typename Ops::value_type x,
+						 typename Ops::value_type &s0, typename Ops::value_type &s1)
+	{
+		typedef typename Ops::value_type V;
+
+		V const bx = Ops::mul(c.b0_, x);
+		V const y = Ops::add(bx, s0);
+		s0 = Ops::nmadd(c.a1_, y, Ops::sub(s1, Ops::add(bx, bx)));
+		s1 = Ops::nmadd(c.a2_, y, bx);
+		return y;
+	}
+};
+
+//! b1 = 0, b2 = -b0
+template<>
+struct BiquadKernel<FilterType::BPF>
+{
+	template<class Ops>
+	static typename Ops::value_type
+				tick	(KernelCoeffs<Ops> const &c, typename Ops::value_type x,
+						 typename Ops::value_type &s0, typename Ops::value_type &s1)
+	{
+		typedef typename Ops::value_type V;
+
+		V const bx = Ops::mul(c.b0_, x);
+		V const y = Ops::add(bx, s0);
+		s0 = Ops::nmadd(c.a1_, y, s1);
+		s1 = Ops::sub(Ops::zero(), Ops::madd(c.a2_, y, bx));
+		return y;
+	}
+};
+
+//! b1 = a1, b2 = b0
+template<>
+struct BiquadKernel<FilterType::notch>
+{
+	template<class Ops>
+	static typename Ops::value_type
+				tick	(KernelCoeffs<Ops> const &c, typename Ops::value_type x,
+						 typename Ops::value_type &s0, typename Ops::value_type &s1)
+	{
+		typedef typename Ops::value_type V;
+
+		V const bx = Ops::mul(c.b0_, x);
+		V const y = Ops::add(bx, s0);
+		s0 = Ops::nmadd(c.a1_, y, Ops::madd(c.a1_, x, s1));
+		s1 = Ops::nmadd(c.a2_, y, bx);
+		return y;
+	}
+};
+
+//! 汎用カーネルを表すフィルタタイプ
+//! 係数を直接設定したときなど、構造上の定数が保証されない場合に使う
+enum {
+	kGenericKernel = FilterType::kNumFilterType
+};
+
+//! フィルタタイプに特殊化されたカーネルを選んで、func.run<Type>()を呼び出す
+//! ブロックの先頭で1度だけ呼び出す
+template<class Func>
+void	dispatch_filter_type	(size_t filter_type, Func &func)
+{
+	switch(filter_type) {
+		case FilterType::LPF:
+			func.template run<FilterType::LPF>();
+			return;
+		case FilterType::HPF:
+			func.template run<FilterType::HPF>();
+			return;
+		case FilterType::BPF:
+			func.template run<FilterType::BPF>();
+			return;
+		case FilterType::notch:
+			func.template run<FilterType::notch>();
+			return;
+		default:
+			func.template run<kGenericKernel>();
+			return;
+	}
+}
+
+//! 1チャンネル分のブロック処理
+//! delta_を指定すると、1サンプルごとに係数にdelta_を足しながら処理する
+template<class T, class Ops = ScalarOps>
+struct MonoBlockKernel
+{
+	typedef typename Ops::value_type	S;
+
+	BiquadCoeffs const &	coeffs_;
+	BiquadCoeffs const *	delta_;
+	BiquadState &			state_;
+	T const *				in_;
+	T *						out_;
+	size_t					n_;
+
+	template<size_t Type>
+	void	run	()
+	{
+		KernelCoeffs<Ops> c = make_kernel_coeffs<Ops>(coeffs_);
+		S s0 = static_cast<S>(state_.s_[0]);
+		S s1 = static_cast<S>(state_.s_[1]);
+
+		if(delta_) {
+			KernelCoeffs<Ops> const d = make_kernel_coeffs<Ops>(*delta_);
+			for(size_t i = 0; i < n_; ++i) {
+				S const y =
+					BiquadKernel<Type>::template tick<Ops>(c, static_cast<S>(in_[i]), s0, s1);
+				out_[i] = static_cast<T>(y);
+				step_kernel_coeffs<Ops>(c, d);
+			}
+		} else {
+			for(size_t i = 0; i < n_; ++i) {
+				S const y =
+					BiquadKernel<Type>::template tick<Ops>(c, static_cast<S>(in_[i]), s0, s1);
+				out_[i] = static_cast<T>(y);
+			}
+		}
+
+		state_.s_[0] = s0;
+		state_.s_[1] = s1;
+	}
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_BIQUADKERNELS_HPP
@@ -0,0 +1,146 @@
+#define _USE_MATH_DEFINES
+#include "./CoeffTable.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! paramを区間の番号と区間内の位置に分ける
+inline
+void	split_param	(double param, size_t size, size_t &index, double &frac)
+{
+	double const x = param * size;
+	if(!(x > 0.0)) {
+		index = 0;
+		frac = 0.0;
+	} else if(x >= size) {
+		index = size - 1;
+		frac = 1.0;
+	} else {
+		index = static_cast<size_t>(x);
+		frac = x - index;
+	}
+}
+
+inline
+double	lerp	(double a, double b, double t)
+{
+	return a + (b - a) * t;
+}
+
+//! これより小さいゲインは、Aの補間の誤差の計測から除く
+//! Aがパラメータの平方根のように0で発散する写像では、0付近の相対誤差が大きくなるため
+double const kGainErrorFloor = -40.0;
+
+}	//unnamed namespace
+
+CoeffTable::CoeffTable	(size_t size)
+	:	size_(size > 0 ? size : 1)
+	,	trig_(size_ + 1)
+	,	A_(size_ + 1)
+	,	trig_error_(0)
+	,	gain_error_(0)
+	,	built_(false)
+{}
+
+bool	CoeffTable::is_built	() const
+{
+	return built_;
+}
+
+size_t	CoeffTable::get_size	() const
+{
+	return size_;
+}
+
+BiquadCoeffs
+		CoeffTable::design	(size_t filter_type, double cutoff_param,
+							 double gain_param, double Q) const
+{
+	double cos_w0, sin_w0, A;
+	lookup(cutoff_param, gain_param, cos_w0, sin_w0, A);
+
+	return design_biquad_from(filter_type, cos_w0, sin_w0, A, Q);
+}
+
+SvfCoeffs
+		CoeffTable::design_svf	(size_t filter_type, double cutoff_param,
+								 double gain_param, double Q) const
+{
+	double cos_w0, sin_w0, A;
+	lookup(cutoff_param, gain_param, cos_w0, sin_w0, A);
+
+	return design_svf_from(filter_type, sin_w0 / (1.0 + cos_w0), A, Q);
+}
+
+SlopeCoeffs
+		CoeffTable::design_slope	(size_t filter_type, double cutoff_param,
+									 size_t num_sections, size_t alignment) const
+{
+	double cos_w0, sin_w0, A;
+	lookup(cutoff_param, 0.0, cos_w0, sin_w0, A);
+
+	return design_slope_from(filter_type, cos_w0, sin_w0, num_sections, alignment);
+}
+
+double	CoeffTable::get_trig_error	() const
+{
+	return trig_error_;
+}
+
+double	CoeffTable::get_gain_error	() const
+{
+	return gain_error_;
+}
+
+void	CoeffTable::set_entry	(size_t index, double cutoff, double db_gain)
+{
+	double const w0 = 2.0 * M_PI * cutoff;
+	trig_[index].cos_w0_ = cos(w0);
+	trig_[index].sin_w0_ = sin(w0);
+	A_[index] = pow(10.0, db_gain / 40);
+}
+
+void	CoeffTable::reset_error	()
+{
+	trig_error_ = 0;
+	gain_error_ = 0;
+}
+
+void	CoeffTable::add_error_sample	(double param, double cutoff, double db_gain)
+{
+	double cos_w0, sin_w0, A;
+	lookup(param, param, cos_w0, sin_w0, A);
+
+	double const w0 = 2.0 * M_PI * cutoff;
+	double const exact_A = pow(10.0, db_gain / 40);
+
+	double const trig_error =
+		std::max(std::abs(cos_w0 - cos(w0)), std::abs(sin_w0 - sin(w0)));
+	trig_error_ = std::max(trig_error_, trig_error);
+
+	if(db_gain >= kGainErrorFloor) {
+		gain_error_ = std::max(gain_error_, std::abs(A - exact_A) / exact_A);
+	}
+}
+
+void	CoeffTable::lookup	(double cutoff_param, double gain_param,
+							 double &cos_w0, double &sin_w0, double &A) const
+{
+	size_t i;
+	double t;
+
+	split_param(cutoff_param, size_, i, t);
+	TrigEntry const &e0 = trig_[i];
+	TrigEntry const &e1 = trig_[i+1];
+	cos_w0 = lerp(e0.cos_w0_, e1.cos_w0_, t);
+	sin_w0 = lerp(e0.sin_w0_, e1.sin_w0_, t);
+
+	split_param(gain_param, size_, i, t);
+	A = lerp(A_[i], A_[i+1], t);
+}
+
+}}	//namespace hwm::dsp
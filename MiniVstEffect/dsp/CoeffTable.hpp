@@ -0,0 +1,103 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_COEFFTABLE_HPP
+#define	HWM_MINIVSTEFFECT_DSP_COEFFTABLE_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include "./SlopeFilter.hpp"
+#include "./Svf.hpp"
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! テーブル引きによる係数計算
+//!
+//! 0.0 ~ 1.0 のパラメータから cos(w0), sin(w0), A への写像を
+//! 等間隔の格子点で事前に計算しておき、格子点の間は線形補間する。
+//! 係数の再計算はpow, log10, 三角関数を使わず、数回のテーブル参照と
+//! design_biquad_fromだけになるので、サンプルごとの変調にも使える。
+//!
+//! 線形補間の誤差は格子の間隔の2乗に比例する。
+//! build時に各区間の中点で厳密な値と比較した最大誤差を
+//! get_trig_error, get_gain_errorで取得できる。
+struct CoeffTable
+{
+	enum {
+		kDefaultSize = 4096
+	};
+
+	//! @param size 格子の区間数。格子点はsize + 1個
+	explicit
+	CoeffTable	(size_t size = kDefaultSize);
+
+	//! テーブルを計算する
+	//! サンプリング周波数が変わるたびに、処理を止めている間に呼び出すこと
+	//! @param mapping パラメータからの写像
+	//!   double cutoff(double param) const  : 正規化周波数(0.0 ~ 0.5)
+	//!   double db_gain(double param) const : dB
+	template<class Mapping>
+	void	build				(Mapping const &mapping)
+	{
+		for(size_t i = 0; i <= size_; ++i) {
+			double const param = static_cast<double>(i) / size_;
+			set_entry(i, mapping.cutoff(param), mapping.db_gain(param));
+		}
+
+		reset_error();
+		for(size_t i = 0; i < size_; ++i) {
+			double const param = (i + 0.5) / size_;
+			add_error_sample(param, mapping.cutoff(param), mapping.db_gain(param));
+		}
+		built_ = true;
+	}
+
+	bool	is_built			() const;
+	size_t	get_size			() const;
+
+	//! テーブルを引いて係数を計算する
+	//! @param cutoff_param, gain_param buildに渡した写像のパラメータ(0.0 ~ 1.0)
+	BiquadCoeffs
+			design				(size_t filter_type, double cutoff_param,
+								 double gain_param, double Q) const;
+
+	//! テーブルを引いてSVFの係数を計算する
+	//! tan(w0 / 2) = sin(w0) / (1 + cos(w0)) なので、同じテーブルから計算できる
+	SvfCoeffs
+			design_svf			(size_t filter_type, double cutoff_param,
+								 double gain_param, double Q) const;
+
+	//! テーブルを引いて高次のLPF, HPFの係数を計算する
+	SlopeCoeffs
+			design_slope		(size_t filter_type, double cutoff_param,
+								 size_t num_sections, size_t alignment) const;
+
+	//! 区間の中点で測った、cos(w0)とsin(w0)の補間の最大絶対誤差
+	double	get_trig_error		() const;
+	//! 区間の中点で測った、Aの補間の最大相対誤差
+	//! -40dBより小さいゲインの区間は含まない
+	double	get_gain_error		() const;
+
+private:
+	//! 三角関数は連続して参照するのでまとめて持つ
+	struct TrigEntry
+	{
+		double	cos_w0_;
+		double	sin_w0_;
+	};
+
+	size_t					size_;
+	std::vector<TrigEntry>	trig_;
+	std::vector<double>		A_;
+	double					trig_error_;
+	double					gain_error_;
+	bool					built_;
+
+	void	set_entry			(size_t index, double cutoff, double db_gain);
+	void	reset_error			();
+	void	add_error_sample	(double param, double cutoff, double db_gain);
+
+	void	lookup				(double cutoff_param, double gain_param,
+								 double &cos_w0, double &sin_w0, double &A) const;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_COEFFTABLE_HPP
@@ -0,0 +1,70 @@
+#include "./CpuFeatures.hpp"
+
+#if HWM_DSP_X86_SIMD && defined(_MSC_VER)
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+size_t	detect_simd_level	()
+{
+#if HWM_DSP_X86_SIMD
+	#if defined(_MSC_VER)
+	int info[4] = {};
+	__cpuid(info, 1);
+
+	bool const has_fma		= (info[2] & (1 << 12)) != 0;
+	bool const has_osxsave	= (info[2] & (1 << 27)) != 0;
+	bool const has_avx		= (info[2] & (1 << 28)) != 0;
+
+	//! OSがYMMレジスタを退避してくれるか
+	if(has_fma && has_osxsave && has_avx && (_xgetbv(0) & 0x6) == 0x6) {
+		return SimdLevel::AVX;
+	}
+	#else
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx") && __builtin_cpu_supports("fma")) {
+		return SimdLevel::AVX;
+	}
+	#endif
+	return SimdLevel::SSE2;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+size_t	g_simd_level_limit	= SimdLevel::kNumSimdLevel;
+
+}	//unnamed namespace
+
+size_t	get_simd_level		()
+{
+	static size_t const detected = detect_simd_level();
+
+	return
+		(detected < g_simd_level_limit) ? detected : g_simd_level_limit;
+}
+
+void	set_simd_level_limit	(size_t level)
+{
+	g_simd_level_limit = level;
+}
+
+char const *
+		get_simd_level_string	(size_t level)
+{
+	switch(level) {
+		case SimdLevel::Scalar:
+			return "scalar";
+		case SimdLevel::SSE2:
+			return "SSE2";
+		case SimdLevel::AVX:
+			return "AVX";
+	}
+	return "Unknown";
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,59 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_CPUFEATURES_HPP
+#define	HWM_MINIVSTEFFECT_DSP_CPUFEATURES_HPP
+
+#include <cstddef>
+
+//! x86のSIMDカーネルをビルドするかどうか
+//! SSE2がベースラインになる x86-64 でのみ有効にする
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+	#define HWM_DSP_X86_SIMD 1
+#else
+	#define HWM_DSP_X86_SIMD 0
+#endif
+
+//! AVXカーネル用の関数属性
+#if HWM_DSP_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+	#define HWM_DSP_TARGET_AVX __attribute__((target("avx,fma")))
+#else
+	#define HWM_DSP_TARGET_AVX
+#endif
+
+//! 呼び出し先をすべてインライン展開させる関数属性
+//! AVXの演算をテンプレート越しに呼び出すカーネルに付ける。
+//! 付けないと、属性のない中間の関数からはAVXの演算をインライン展開できず、1命令ごとの関数呼び出しになる
+#if defined(__GNUC__) || defined(__clang__)
+	#define HWM_DSP_FLATTEN __attribute__((flatten))
+#else
+	#define HWM_DSP_FLATTEN
+#endif
+
+namespace hwm { namespace dsp {
+
+//! SIMDカーネルの種類
+//! 値が大きいほど幅の広い命令セットを表す
+struct SimdLevel
+{
+	enum {
+		Scalar,
+		SSE2,
+		//! AVX + FMA
+		AVX,
+		kNumSimdLevel
+	};
+};
+
+//! 実行中のCPUで使用できるもっとも広いSIMDカーネルを返す
+//! set_simd_level_limitで上限が設定されていればそれに従う
+size_t	get_simd_level			();
+
+//! 使用するSIMDカーネルの上限を設定する
+//! ベンチマークで各カーネルを比較するときに使う
+void	set_simd_level_limit	(size_t level);
+
+//! SIMDカーネルの名前を取得
+char const *
+		get_simd_level_string	(size_t level);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_CPUFEATURES_HPP
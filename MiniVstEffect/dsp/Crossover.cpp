@@ -0,0 +1,424 @@
+#define _USE_MATH_DEFINES
+#include "./Crossover.hpp"
+#include "./BiquadKernels.hpp"
+#include "./CpuFeatures.hpp"
+#include "./Denormals.hpp"
+#include "./SimdOps.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+typedef CrossoverSection	Sections[kMaxCrossoverBands - 1][kMaxCrossoverSections];
+
+enum {
+	//! CrossoverStateに並んでいる段の数
+	kNumStates = sizeof(CrossoverState) / sizeof(BiquadState),
+	//! 1回にレーンに並べ替えて各段に通すサンプル数
+	kChunkSize = 16
+};
+
+//! CrossoverStateをBiquadStateの配列として見たときの位置
+inline
+size_t	split_index		(size_t split, size_t stage)
+{
+	return split * kMaxCrossoverStages + stage;
+}
+
+inline
+size_t	allpass_index	(size_t band, size_t split, size_t section)
+{
+	return
+		(kMaxCrossoverBands - 1) * kMaxCrossoverStages +
+		(band * (kMaxCrossoverBands - 1) + split) * kMaxCrossoverSections + section;
+}
+
+//! 1段分のbi-quadに、x[0] ~ x[count - 1]を通す
+//! 遅延子と係数はレジスタに置いたままcountサンプル処理する
+template<class Ops, size_t Type>
+void	run_stage	(BiquadCoeffs const &coeffs,
+					 typename Ops::value_type &s0, typename Ops::value_type &s1,
+					 typename Ops::value_type *x, size_t count)
+{
+	typedef typename Ops::value_type	V;
+
+	KernelCoeffs<Ops> const c = make_kernel_coeffs<Ops>(coeffs);
+	V a = s0;
+	V b = s1;
+	for(size_t t = 0; t < count; ++t) {
+		x[t] = BiquadKernel<Type>::template tick<Ops>(c, x[t], a, b);
+	}
+	s0 = a;
+	s1 = b;
+}
+
+//! 分割点の最初の段。LPFをlpに、HPFをxに書く
+//! LPFとHPFは分母が同じで、分子はそれぞれ b0 * (1, 2, 1), b0 * (1, -2, 1) なので、
+//! 直接形IIで再帰の部分 w = x - a1 * w1 - a2 * w2 を1回だけ計算する
+template<class Ops>
+void	run_shared_stage	(CrossoverSection const &cs,
+							 typename Ops::value_type &w1, typename Ops::value_type &w2,
+							 typename Ops::value_type *x, typename Ops::value_type *lp, size_t count)
+{
+	typedef typename Ops::value_type	V;
+
+	V const a1 = Ops::set1(cs.lpf_.a1_);
+	V const a2 = Ops::set1(cs.lpf_.a2_);
+	V const b_lpf = Ops::set1(cs.lpf_.b0_);
+	V const b_hpf = Ops::set1(cs.hpf_.b0_);
+	V p = w1;
+	V q = w2;
+
+	for(size_t t = 0; t < count; ++t) {
+		V const w = Ops::nmadd(a2, q, Ops::nmadd(a1, p, x[t]));
+		V const ends = Ops::add(w, q);
+		V const mid = Ops::add(p, p);
+		lp[t] = Ops::mul(b_lpf, Ops::add(ends, mid));
+		x[t] = Ops::mul(b_hpf, Ops::sub(ends, mid));
+		q = p;
+		p = w;
+	}
+
+	w1 = p;
+	w2 = q;
+}
+
+//! countサンプル分を全分割点に通し、バンドごとに書き出す
+//! x, lpはcountサンプル分の作業領域
+template<class Ops, class T>
+void	run_bands	(Sections const &coeffs, size_t num_bands, size_t num_sections,
+					 typename Ops::value_type *s1, typename Ops::value_type *s2,
+					 typename Ops::value_type *x, typename Ops::value_type *lp,
+					 T * const (*dst)[Ops::kWidth], size_t i, size_t count)
+{
+	typedef typename Ops::value_type	V;
+	typedef typename Ops::scalar_type	S;
+
+	size_t const num_splits = num_bands - 1;
+	size_t const num_chain = num_sections * 2 - 1;
+
+	for(size_t k = 0; k < num_bands; ++k) {
+		V *y = x;
+		if(k < num_splits) {
+			CrossoverSection const *c = coeffs[k];
+			size_t const base = split_index(k, 0);
+
+			run_shared_stage<Ops>(c[0], s1[base], s2[base], x, lp, count);
+
+			//! Butterworthの各セクションを2回ずつ通す
+			for(size_t j = 1; j <= num_chain; ++j) {
+				run_stage<Ops, FilterType::LPF>(
+					c[j % num_sections].lpf_, s1[base + j], s2[base + j], lp, count);
+			}
+			for(size_t j = 1; j <= num_chain; ++j) {
+				run_stage<Ops, FilterType::HPF>(
+					c[j % num_sections].hpf_, s1[base + num_chain + j], s2[base + num_chain + j], x, count);
+			}
+
+			//! 上の分割点の全域通過フィルタで位相を揃える
+			for(size_t m = k + 1; m < num_splits; ++m) {
+				for(size_t j = 0; j < num_sections; ++j) {
+					size_t const a = allpass_index(k, m, j);
+					run_stage<Ops, kGenericKernel>(coeffs[m][j].apf_, s1[a], s2[a], lp, count);
+				}
+			}
+			y = lp;
+		}
+
+		if(count == kChunkSize) {
+			for(size_t j = 0; j < kChunkSize; j += Ops::kWidth) {
+				store_tile(y + j, dst[k], i + j);
+			}
+		} else {
+			V buf[1];
+			S * const sbuf = reinterpret_cast<S *>(buf);
+			for(size_t j = 0; j < count; ++j) {
+				Ops::store(sbuf, y[j]);
+				for(size_t ch = 0; ch < Ops::kWidth; ++ch) {
+					dst[k][ch][i + j] = static_cast<T>(sbuf[ch]);
+				}
+			}
+		}
+	}
+}
+
+//! Ops::kWidthチャンネル分を処理する
+//! kChunkSizeサンプルずつレーンに並べ替えて、段ごとにチャンク全体を通す
+//! 1つの段の遅延子をレジスタに置いたまま処理するので、遅延子の依存チェーンがメモリを経由しない
+//! @param out バンドbのチャンネルchは out[b * stride + ch]
+template<class Ops, class T>
+void	process_group	(Sections const &coeffs, size_t num_bands, size_t num_sections,
+						 CrossoverState *st, T const * const *in, T * const *out, size_t stride,
+						 size_t offset, size_t n)
+{
+	typedef typename Ops::value_type	V;
+	typedef typename Ops::scalar_type	S;
+
+	enum {
+		W = Ops::kWidth
+	};
+
+	T const *src[W];
+	T *dst[kMaxCrossoverBands][W];
+	for(size_t ch = 0; ch < W; ++ch) {
+		src[ch] = in[ch] + offset;
+		for(size_t b = 0; b < num_bands; ++b) {
+			dst[b][ch] = out[b * stride + ch] + offset;
+		}
+	}
+
+	V buf[1];
+	S * const sbuf = reinterpret_cast<S *>(buf);
+
+	V s1[kNumStates];
+	V s2[kNumStates];
+	for(size_t k = 0; k < kNumStates; ++k) {
+		for(size_t ch = 0; ch < W; ++ch) {
+			sbuf[ch] = static_cast<S>(reinterpret_cast<BiquadState const *>(st + ch)[k].s_[0]);
+		}
+		s1[k] = Ops::load(sbuf);
+		for(size_t ch = 0; ch < W; ++ch) {
+			sbuf[ch] = static_cast<S>(reinterpret_cast<BiquadState const *>(st + ch)[k].s_[1]);
+		}
+		s2[k] = Ops::load(sbuf);
+	}
+
+	V x[kChunkSize];
+	V lp[kChunkSize];
+
+	size_t i = 0;
+	for( ; i + kChunkSize <= n; i += kChunkSize) {
+		for(size_t j = 0; j < kChunkSize; j += W) {
+			load_tile(x + j, src, i + j);
+		}
+		run_bands<Ops>(coeffs, num_bands, num_sections, s1, s2, x, lp, dst, i, kChunkSize);
+	}
+
+	//! 端数のサンプルは1サンプルずつ並べ替える
+	size_t const rest = n - i;
+	if(rest > 0) {
+		for(size_t j = 0; j < rest; ++j) {
+			for(size_t ch = 0; ch < W; ++ch) {
+				sbuf[ch] = static_cast<S>(src[ch][i + j]);
+			}
+			x[j] = Ops::load(sbuf);
+		}
+		run_bands<Ops>(coeffs, num_bands, num_sections, s1, s2, x, lp, dst, i, rest);
+	}
+
+	for(size_t k = 0; k < kNumStates; ++k) {
+		Ops::store(sbuf, s1[k]);
+		for(size_t ch = 0; ch < W; ++ch) {
+			reinterpret_cast<BiquadState *>(st + ch)[k].s_[0] = sbuf[ch];
+		}
+		Ops::store(sbuf, s2[k]);
+		for(size_t ch = 0; ch < W; ++ch) {
+			reinterpret_cast<BiquadState *>(st + ch)[k].s_[1] = sbuf[ch];
+		}
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+template<class Ops, class T>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	process_group_avx	(Sections const &coeffs, size_t num_bands, size_t num_sections,
+							 CrossoverState *st, T const * const *in, T * const *out, size_t stride,
+							 size_t offset, size_t n)
+{
+	process_group<Ops, T>(coeffs, num_bands, num_sections, st, in, out, stride, offset, n);
+}
+
+#endif	//HWM_DSP_X86_SIMD
+
+template<class T>
+void	dispatch_crossover	(Sections const &coeffs, size_t num_bands, size_t num_sections,
+							 std::vector<CrossoverState> &states,
+							 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	size_t const num_channels = states.size();
+	size_t ch = 0;
+
+#if HWM_DSP_X86_SIMD
+	size_t const level = get_simd_level();
+	if(level >= SimdLevel::AVX) {
+		for( ; ch + 4 <= num_channels; ch += 4) {
+			process_group_avx<AVX256Ops>(coeffs, num_bands, num_sections,
+				&states[ch], in + ch, out + ch, num_channels, offset, n);
+		}
+		for( ; ch + 2 <= num_channels; ch += 2) {
+			process_group_avx<AVXOps>(coeffs, num_bands, num_sections,
+				&states[ch], in + ch, out + ch, num_channels, offset, n);
+		}
+	} else if(level >= SimdLevel::SSE2) {
+		for( ; ch + 2 <= num_channels; ch += 2) {
+			process_group<SSE2Ops>(coeffs, num_bands, num_sections,
+				&states[ch], in + ch, out + ch, num_channels, offset, n);
+		}
+	}
+#endif
+
+	for( ; ch < num_channels; ++ch) {
+		process_group<ScalarOps>(coeffs, num_bands, num_sections,
+			&states[ch], in + ch, out + ch, num_channels, offset, n);
+	}
+}
+
+}	//unnamed namespace
+
+Crossover::Crossover	(size_t num_channels, size_t num_bands)
+	:	num_bands_(num_bands)
+	,	slope_(CrossoverSlope::LR24)
+	,	states_(num_channels)
+{
+	//! 既定の分割周波数は、48kHzで200Hz, 2kHz, 8kHzくらい
+	double const defaults[kMaxCrossoverBands - 1] = { 0.004, 0.04, 0.16 };
+	for(size_t i = 0; i < kMaxCrossoverBands - 1; ++i) {
+		splits_[i].reset(defaults[i]);
+	}
+	update_coeffs();
+	clear_buffer();
+}
+
+size_t	Crossover::get_num_bands	() const
+{
+	return num_bands_;
+}
+
+void	Crossover::set_num_bands	(size_t num_bands)
+{
+	num_bands_ = num_bands;
+	clear_buffer();
+}
+
+size_t	Crossover::get_slope	() const
+{
+	return slope_;
+}
+
+void	Crossover::set_slope	(size_t slope)
+{
+	slope_ = slope;
+	update_coeffs();
+	clear_buffer();
+}
+
+void	Crossover::set_split	(size_t index, double cutoff, size_t smoothing_length)
+{
+	splits_[index].set_target(cutoff, smoothing_length);
+	if(smoothing_length == 0) {
+		update_coeffs();
+	}
+}
+
+double	Crossover::get_split	(size_t index) const
+{
+	return splits_[index].get_target();
+}
+
+bool	Crossover::is_smoothing	() const
+{
+	for(size_t i = 0; i + 1 < num_bands_; ++i) {
+		if(splits_[i].is_ramping()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void	Crossover::update_coeffs	()
+{
+	size_t const num_sections = slope_ + 1;
+	double Q[kMaxCrossoverSections];
+	get_slope_Qs(num_sections, Alignment::Butterworth, Q);
+
+	for(size_t i = 0; i < kMaxCrossoverBands - 1; ++i) {
+		double const w0 = 2.0 * M_PI * splits_[i].get_value();
+		double const cos_w0 = cos(w0);
+		double const sin_w0 = sin(w0);
+		for(size_t j = 0; j < num_sections; ++j) {
+			CrossoverSection &c = coeffs_[i][j];
+			c.lpf_ = design_biquad_from(FilterType::LPF, cos_w0, sin_w0, 1.0, Q[j]);
+			c.hpf_ = design_biquad_from(FilterType::HPF, cos_w0, sin_w0, 1.0, Q[j]);
+			c.apf_ = design_biquad_from(FilterType::APF, cos_w0, sin_w0, 1.0, Q[j]);
+		}
+	}
+}
+
+void	Crossover::clear_buffer	()
+{
+	if(!states_.empty()) {
+		std::memset(&states_[0], 0, sizeof(CrossoverState) * states_.size());
+	}
+}
+
+void	Crossover::flush_denormals	()
+{
+	//! CrossoverStateはBiquadStateだけを並べたもの
+	if(!states_.empty()) {
+		dsp::flush_denormals(reinterpret_cast<double *>(&states_[0]),
+			states_.size() * sizeof(CrossoverState) / sizeof(double));
+	}
+}
+
+size_t	Crossover::get_num_channels	() const
+{
+	return states_.size();
+}
+
+void	Crossover::set_num_channels	(size_t num_channels)
+{
+	states_.resize(num_channels);
+	clear_buffer();
+}
+
+template<class T>
+void	Crossover::process_channels	(T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	size_t const num_sections = slope_ + 1;
+
+	while(n > 0) {
+		//! 分割周波数を動かしている間は、制御周期ごとに係数を計算し直す
+		size_t m = n;
+		if(is_smoothing()) {
+			m = std::min(n, static_cast<size_t>(kControlInterval));
+			for(size_t i = 0; i + 1 < num_bands_; ++i) {
+				splits_[i].advance(m);
+			}
+			update_coeffs();
+		}
+
+		dispatch_crossover(coeffs_, num_bands_, num_sections, states_, in, out, offset, m);
+
+		offset += m;
+		n -= m;
+	}
+}
+
+void	Crossover::process_block	(float const * const *in, float * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	Crossover::process_block	(double const * const *in, double * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	Crossover::process_block	(float const * const *in, float * const *out,
+									 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+void	Crossover::process_block	(double const * const *in, double * const *out,
+									 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+}}	//namespace hwm::dsp
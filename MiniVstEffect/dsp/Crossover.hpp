@@ -0,0 +1,129 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_CROSSOVER_HPP
+#define	HWM_MINIVSTEFFECT_DSP_CROSSOVER_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include "./SmoothedFilter.hpp"
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+enum {
+	//! 分割するバンド数の上限
+	kMaxCrossoverBands = 4,
+	//! Linkwitz-Rileyの元になるButterworthのセクション数の上限
+	kMaxCrossoverSections = 2,
+	//! 1つの分割点で使うbi-quadの段数の上限
+	//! LPFとHPFで共有する最初の段と、LPF, HPFそれぞれの残りの段
+	kMaxCrossoverStages = kMaxCrossoverSections * 4 - 1
+};
+
+//! クロスオーバーの傾き
+//!   LR24 : 24dB/octのLinkwitz-Riley。2次のButterworthの2乗
+//!   LR48 : 48dB/octのLinkwitz-Riley。4次のButterworthの2乗
+struct CrossoverSlope
+{
+	enum {
+		LR24,
+		LR48,
+		kNumCrossoverSlope
+	};
+};
+
+//! 分割点の、Butterworthの1セクション分の係数
+//! 3つとも分母(a1, a2)は同じ
+struct CrossoverSection
+{
+	BiquadCoeffs	lpf_;
+	BiquadCoeffs	hpf_;
+	BiquadCoeffs	apf_;
+};
+
+//! 1チャンネル分の遅延子
+struct CrossoverState
+{
+	//! 分割点ごとの段
+	//! [0]はLPFとHPFで共有する直接形IIの遅延子で、続いてLPFの残りの段、HPFの残りの段が並ぶ
+	BiquadState	split_[kMaxCrossoverBands - 1][kMaxCrossoverStages];
+	//! バンドごとの、それより上の分割点の全域通過フィルタ
+	//! LPF側を通ったバンドの位相を、HPF側を通ったバンドに揃える
+	BiquadState	allpass_[kMaxCrossoverBands - 2][kMaxCrossoverBands - 1][kMaxCrossoverSections];
+};
+
+//! Linkwitz-Rileyのクロスオーバー
+//!
+//! 入力を2 ~ kMaxCrossoverBandsのバンドに分けて、バンドごとに出力する。
+//! 低い分割点から順に、LPF側をそのバンドの出力、HPF側を次の分割点の入力にするので、
+//! 高いバンドで共通のHPFは1回だけ計算する。
+//! 各段はdesign_biquadのbi-quadで、同じ分割点のLPFとHPFは極が同じなので、
+//! 最初の段は直接形IIにして再帰の部分をLPFとHPFで共有する。
+//! 低いバンドにはそれより上の分割点の全域通過フィルタをかけて位相を揃えるので、
+//! 全バンドの和は振幅が平坦な全域通過になる。
+//!
+//! 分割周波数はset_splitで設定する。滑らかに変える間は、kControlIntervalサンプルごとに係数を計算し直す
+struct Crossover
+{
+	enum {
+		kControlInterval = 32
+	};
+
+	//! @param num_bands 2 ~ kMaxCrossoverBands
+	Crossover	(size_t num_channels, size_t num_bands = 2);
+
+	size_t	get_num_bands		() const;
+	//! バンド数を変更する。状態はクリアされる
+	//! 分割周波数は、増えた分も含めてそのまま残る
+	void	set_num_bands		(size_t num_bands);
+
+	size_t	get_slope			() const;
+	//! 傾きを変更する。状態はクリアされる
+	//! @param slope CrossoverSlopeのいずれか
+	void	set_slope			(size_t slope);
+
+	//! index番目(0 ~ num_bands - 2)の分割周波数を、smoothing_lengthサンプルかけて変える
+	//! 分割周波数は低い順に並べること
+	//! @param cutoff 正規化周波数(0.0 ~ 0.5)
+	void	set_split			(size_t index, double cutoff, size_t smoothing_length = 0);
+	double	get_split			(size_t index) const;
+	bool	is_smoothing		() const;
+
+	//! 状態をクリア
+	void	clear_buffer		();
+	//! 絶対値がkDenormalFlushLimit未満の状態を0にする
+	//! FTZ, DAZを設定できない環境で、非正規化数での演算を避けるためにブロックの境界で呼び出す
+	void	flush_denormals		();
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。状態はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! 全チャンネルをまとめて処理する
+	//! outはバンドごとにチャンネルを並べた、num_bands * num_channels個のバッファ
+	//! バンドbのチャンネルchは out[b * num_channels + ch]
+	//! 入力は各サンプルを読んでから出力を書くので、inとバンド0のoutは同じバッファでもよい
+	void	process_block		(float const * const *in, float * const *out, size_t n);
+	void	process_block		(double const * const *in, double * const *out, size_t n);
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	void	process_block		(float const * const *in, float * const *out,
+								 size_t offset, size_t n);
+	void	process_block		(double const * const *in, double * const *out,
+								 size_t offset, size_t n);
+
+private:
+	size_t							num_bands_;
+	size_t							slope_;
+	LinearSmoother					splits_[kMaxCrossoverBands - 1];
+	CrossoverSection				coeffs_[kMaxCrossoverBands - 1][kMaxCrossoverSections];
+	std::vector<CrossoverState>		states_;
+
+	//! 分割周波数の現在の値から係数を計算する
+	void	update_coeffs		();
+
+	template<class T>
+	void	process_channels	(T const * const *in, T * const *out, size_t offset, size_t n);
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_CROSSOVER_HPP
@@ -0,0 +1,80 @@
+#include "./Denormals.hpp"
+#include "./CpuFeatures.hpp"
+
+#if HWM_DSP_X86_SIMD
+	#include <xmmintrin.h>
+#endif
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+#if HWM_DSP_X86_SIMD
+
+//! MXCSRのFlush To Zero(15bit目)とDenormals Are Zero(6bit目)
+unsigned int const	kFlushBits = 0x8040;
+
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+
+#define HWM_DSP_AARCH64_FPCR 1
+
+//! FPCRのFlush-to-zero(24bit目)。入力の非正規化数も0として扱われる
+unsigned long long const	kFlushBits = 1ull << 24;
+
+unsigned long long	read_fpcr	()
+{
+	unsigned long long value;
+	__asm__ __volatile__("mrs %0, fpcr" : "=r"(value));
+	return value;
+}
+
+void	write_fpcr	(unsigned long long value)
+{
+	__asm__ __volatile__("msr fpcr, %0" : : "r"(value));
+}
+
+#endif
+
+}	//unnamed namespace
+
+ScopedFlushDenormals::ScopedFlushDenormals	()
+	:	saved_(0)
+{
+#if HWM_DSP_X86_SIMD
+	unsigned int const csr = _mm_getcsr();
+	saved_ = csr;
+	_mm_setcsr(csr | kFlushBits);
+#elif defined(HWM_DSP_AARCH64_FPCR)
+	saved_ = read_fpcr();
+	write_fpcr(saved_ | kFlushBits);
+#endif
+}
+
+ScopedFlushDenormals::~ScopedFlushDenormals	()
+{
+#if HWM_DSP_X86_SIMD
+	_mm_setcsr(static_cast<unsigned int>(saved_));
+#elif defined(HWM_DSP_AARCH64_FPCR)
+	write_fpcr(saved_);
+#endif
+}
+
+bool	ScopedFlushDenormals::is_supported	()
+{
+#if HWM_DSP_X86_SIMD || defined(HWM_DSP_AARCH64_FPCR)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void	flush_denormals	(double *p, size_t n)
+{
+	for(size_t i = 0; i < n; ++i) {
+		if(p[i] < kDenormalFlushLimit && p[i] > -kDenormalFlushLimit) {
+			p[i] = 0.0;
+		}
+	}
+}
+
+}}	//namespace hwm::dsp
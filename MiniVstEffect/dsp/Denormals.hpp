@@ -0,0 +1,39 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_DENORMALS_HPP
+#define	HWM_MINIVSTEFFECT_DSP_DENORMALS_HPP
+
+#include <cstddef>
+
+namespace hwm { namespace dsp {
+
+//! スコープの間、このスレッドの浮動小数点演算で非正規化数を0として扱う
+//! x86ではMXCSRのFTZとDAZ、AArch64ではFPCRのFZを立て、デストラクタで元に戻す
+//!
+//! 無音の入力でフィルタの状態が減衰していくと、いずれ非正規化数になり、
+//! x86では1演算ごとに数十〜百サイクルかかるようになる。
+//! オーディオスレッドの処理の入口で作ること
+struct ScopedFlushDenormals
+{
+	ScopedFlushDenormals	();
+	~ScopedFlushDenormals	();
+
+	//! この環境でFTZ, DAZを設定できるかどうか
+	//! できない環境では、ブロックの境界でフィルタのflush_denormalsを呼び出して状態を0にする
+	static bool	is_supported	();
+
+private:
+	ScopedFlushDenormals	(ScopedFlushDenormals const &);
+	ScopedFlushDenormals &	operator=	(ScopedFlushDenormals const &);
+
+	unsigned long long	saved_;
+};
+
+//! 非正規化数になる前に0にする、フィルタの状態の絶対値の閾値
+//! -300dBなので出力には影響しない。1ブロックの間に減衰しても倍精度の正規化数の範囲に収まる
+double const	kDenormalFlushLimit = 1e-15;
+
+//! p[0] ~ p[n - 1]のうち、絶対値がkDenormalFlushLimit未満の値を0にする
+void	flush_denormals	(double *p, size_t n);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_DENORMALS_HPP
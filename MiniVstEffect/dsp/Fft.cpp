@@ -0,0 +1,144 @@
+#define _USE_MATH_DEFINES
+#include "./Fft.hpp"
+
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+RealFft::RealFft	(size_t size)
+	:	size_(size)
+	,	half_(size / 2)
+	,	bitrev_(half_)
+	,	twiddle_re_(half_)
+	,	twiddle_im_(half_)
+	,	split_re_(half_)
+	,	split_im_(half_)
+	,	work_re_(half_)
+	,	work_im_(half_)
+{
+	size_t bits = 0;
+	while((static_cast<size_t>(1) << bits) < half_) {
+		++bits;
+	}
+	for(size_t i = 0; i < half_; ++i) {
+		size_t r = 0;
+		for(size_t b = 0; b < bits; ++b) {
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+		bitrev_[i] = r;
+	}
+
+	for(size_t h = 1; h < half_; h *= 2) {
+		for(size_t j = 0; j < h; ++j) {
+			double const w = -M_PI * j / h;
+			twiddle_re_[h + j] = static_cast<float>(cos(w));
+			twiddle_im_[h + j] = static_cast<float>(sin(w));
+		}
+	}
+
+	for(size_t k = 0; k < half_; ++k) {
+		double const w = -2.0 * M_PI * k / size_;
+		split_re_[k] = static_cast<float>(cos(w));
+		split_im_[k] = static_cast<float>(sin(w));
+	}
+}
+
+size_t	RealFft::get_size	() const
+{
+	return size_;
+}
+
+void	RealFft::transform	()
+{
+	float * const re = &work_re_[0];
+	float * const im = &work_im_[0];
+
+	for(size_t i = 0; i < half_; ++i) {
+		size_t const j = bitrev_[i];
+		if(i < j) {
+			float const tr = re[i]; re[i] = re[j]; re[j] = tr;
+			float const ti = im[i]; im[i] = im[j]; im[j] = ti;
+		}
+	}
+
+	//! 同じ段の回転因子を連続して読むので、内側のループはベクトル化できる
+	for(size_t h = 1; h < half_; h *= 2) {
+		float const * const wr = &twiddle_re_[h];
+		float const * const wi = &twiddle_im_[h];
+		for(size_t i = 0; i < half_; i += 2 * h) {
+			float * const ar = re + i;
+			float * const ai = im + i;
+			float * const br = re + i + h;
+			float * const bi = im + i + h;
+			for(size_t j = 0; j < h; ++j) {
+				float const tr = br[j] * wr[j] - bi[j] * wi[j];
+				float const ti = br[j] * wi[j] + bi[j] * wr[j];
+				br[j] = ar[j] - tr;
+				bi[j] = ai[j] - ti;
+				ar[j] += tr;
+				ai[j] += ti;
+			}
+		}
+	}
+}
+
+void	RealFft::forward	(float const *in, float *re, float *im)
+{
+	//! 偶数番目を実部、奇数番目を虚部に詰める
+	for(size_t n = 0; n < half_; ++n) {
+		work_re_[n] = in[2 * n];
+		work_im_[n] = in[2 * n + 1];
+	}
+	transform();
+
+	float const * const zr = &work_re_[0];
+	float const * const zi = &work_im_[0];
+
+	re[0] = zr[0] + zi[0];
+	im[0] = zr[0] - zi[0];
+
+	//! 偶数番目のスペクトル E = (Z[k] + conj(Z[N-k])) / 2
+	//! 奇数番目のスペクトル O = (Z[k] - conj(Z[N-k])) / 2i
+	//! X[k] = E + exp(-2 pi i k / size) * O
+	for(size_t k = 1; k < half_; ++k) {
+		float const ar = zr[k], ai = zi[k];
+		float const br = zr[half_ - k], bi = -zi[half_ - k];
+		float const er = (ar + br) * 0.5f;
+		float const ei = (ai + bi) * 0.5f;
+		float const or_ = (ai - bi) * 0.5f;
+		float const oi = -(ar - br) * 0.5f;
+		re[k] = er + split_re_[k] * or_ - split_im_[k] * oi;
+		im[k] = ei + split_re_[k] * oi + split_im_[k] * or_;
+	}
+}
+
+void	RealFft::inverse	(float const *re, float const *im, float *out)
+{
+	//! forwardの逆で Z[k] = E + i * O を作る
+	//!   E = X[k] + conj(X[N-k])
+	//!   O = (X[k] - conj(X[N-k])) * exp(2 pi i k / size)
+	//! 逆変換は虚部の符号を反転して順変換する
+	work_re_[0] = re[0] + im[0];
+	work_im_[0] = -(re[0] - im[0]);
+
+	for(size_t k = 1; k < half_; ++k) {
+		float const ar = re[k], ai = im[k];
+		float const br = re[half_ - k], bi = -im[half_ - k];
+		float const er = ar + br;
+		float const ei = ai + bi;
+		float const dr = ar - br;
+		float const di = ai - bi;
+		float const or_ = dr * split_re_[k] + di * split_im_[k];
+		float const oi = di * split_re_[k] - dr * split_im_[k];
+		work_re_[k] = er - oi;
+		work_im_[k] = -(ei + or_);
+	}
+	transform();
+
+	for(size_t n = 0; n < half_; ++n) {
+		out[2 * n] = work_re_[n];
+		out[2 * n + 1] = -work_im_[n];
+	}
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,52 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_FFT_HPP
+#define	HWM_MINIVSTEFFECT_DSP_FFT_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! 実数列の高速フーリエ変換(単精度)
+//!
+//! size点の実数列を、size / 2点の複素数列に詰めて基数2のFFTで変換する。
+//! スペクトルは実部と虚部を別の配列に持つ(split形式)。
+//! DCとナイキスト周波数の成分はどちらも実数なので、
+//! re[0]にDC、im[0]にナイキスト周波数の成分を入れて、size / 2個のビンにまとめる。
+//!
+//! 作業領域を持つので、1つのインスタンスを複数のスレッドから同時に使わないこと
+struct RealFft
+{
+	//! @param size 2のべき乗。4以上
+	explicit
+	RealFft		(size_t size);
+
+	size_t	get_size	() const;
+
+	//! in[0] ~ in[size - 1]を変換し、re, imにsize / 2個ずつのビンを書き込む
+	void	forward		(float const *in, float *re, float *im);
+
+	//! forwardの逆変換。1 / sizeの正規化はしない
+	//! inverse(forward(x))はsize * xになる
+	void	inverse		(float const *re, float const *im, float *out);
+
+private:
+	size_t				size_;
+	//! 複素FFTの点数。size / 2
+	size_t				half_;
+	std::vector<size_t>	bitrev_;
+	//! 段ごとに並べた回転因子。半分の長さhの段は[h, 2h)を使う
+	std::vector<float>	twiddle_re_;
+	std::vector<float>	twiddle_im_;
+	//! 実数列の分離に使う exp(-2 pi i k / size)
+	std::vector<float>	split_re_;
+	std::vector<float>	split_im_;
+	std::vector<float>	work_re_;
+	std::vector<float>	work_im_;
+
+	//! work_re_, work_im_を複素FFTする
+	void	transform	();
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_FFT_HPP
@@ -0,0 +1,380 @@
+#include "./InterleavedBiquad.hpp"
+#include "./SimdOps.hpp"
+#include <algorithm>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! 全チャンネルを処理する単位のフレーム数を、このバイト数に収まるように決める
+enum { kChunkBytes = 16 * 1024 };
+
+//! 1フレームから連続して読み書きするチャンネル数
+template<size_t K>
+struct Lanes
+{};
+
+//! 以下のload_frameは、pからK個の連続したサンプルをレジスタの下位Kレーンに読み込む
+//! store_frameはその逆。使わない上位のレーンは0にする
+
+template<class S, class T>
+void	load_frame	(S &v, T const *p, Lanes<1>)
+{
+	v = static_cast<S>(*p);
+}
+
+template<class S, class T>
+void	store_frame	(S v, T *p, Lanes<1>)
+{
+	*p = static_cast<T>(v);
+}
+
+#if HWM_DSP_X86_SIMD
+
+inline
+void	load_frame	(__m128d &v, float const *p, Lanes<2>)
+{
+	v = _mm_cvtps_pd(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64 const *>(p)));
+}
+
+inline
+void	load_frame	(__m128d &v, double const *p, Lanes<2>)
+{
+	v = _mm_loadu_pd(p);
+}
+
+inline
+void	store_frame	(__m128d v, float *p, Lanes<2>)
+{
+	_mm_storel_pi(reinterpret_cast<__m64 *>(p), _mm_cvtpd_ps(v));
+}
+
+inline
+void	store_frame	(__m128d v, double *p, Lanes<2>)
+{
+	_mm_storeu_pd(p, v);
+}
+
+inline
+void	load_frame	(__m128 &v, float const *p, Lanes<2>)
+{
+	v = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64 const *>(p));
+}
+
+inline
+void	load_frame	(__m128 &v, double const *p, Lanes<2>)
+{
+	v = _mm_cvtpd_ps(_mm_loadu_pd(p));
+}
+
+inline
+void	store_frame	(__m128 v, float *p, Lanes<2>)
+{
+	_mm_storel_pi(reinterpret_cast<__m64 *>(p), v);
+}
+
+inline
+void	store_frame	(__m128 v, double *p, Lanes<2>)
+{
+	_mm_storeu_pd(p, _mm_cvtps_pd(v));
+}
+
+inline
+void	load_frame	(__m128 &v, float const *p, Lanes<4>)
+{
+	v = _mm_loadu_ps(p);
+}
+
+inline
+void	load_frame	(__m128 &v, double const *p, Lanes<4>)
+{
+	v = load_4_as_float(p);
+}
+
+inline
+void	store_frame	(__m128 v, float *p, Lanes<4>)
+{
+	_mm_storeu_ps(p, v);
+}
+
+inline
+void	store_frame	(__m128 v, double *p, Lanes<4>)
+{
+	store_4_as_double(p, v);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_frame	(__m256d &v, float const *p, Lanes<4>)
+{
+	v = _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_frame	(__m256d &v, double const *p, Lanes<4>)
+{
+	v = _mm256_loadu_pd(p);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_frame	(__m256d v, float *p, Lanes<4>)
+{
+	_mm_storeu_ps(p, _mm256_cvtpd_ps(v));
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_frame	(__m256d v, double *p, Lanes<4>)
+{
+	_mm256_storeu_pd(p, v);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_frame	(__m256 &v, float const *p, Lanes<8>)
+{
+	v = _mm256_loadu_ps(p);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_frame	(__m256 &v, double const *p, Lanes<8>)
+{
+	__m128 const lo = _mm256_cvtpd_ps(_mm256_loadu_pd(p));
+	__m128 const hi = _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4));
+	v = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_frame	(__m256 v, float *p, Lanes<8>)
+{
+	_mm256_storeu_ps(p, v);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_frame	(__m256 v, double *p, Lanes<8>)
+{
+	_mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+	_mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+#endif	//HWM_DSP_X86_SIMD
+
+//! K個のチャンネルの遅延子をレジスタの下位Kレーンに読み込む
+template<class Ops, size_t K>
+void	load_states	(typename Ops::value_type &s0, typename Ops::value_type &s1,
+					 BiquadState const *st)
+{
+	typedef typename Ops::scalar_type S;
+	S t0[Ops::kWidth] = {};
+	S t1[Ops::kWidth] = {};
+	for(size_t j = 0; j < K; ++j) {
+		t0[j] = static_cast<S>(st[j].s_[0]);
+		t1[j] = static_cast<S>(st[j].s_[1]);
+	}
+	s0 = Ops::loadu(t0);
+	s1 = Ops::loadu(t1);
+}
+
+template<class Ops, size_t K>
+void	store_states	(typename Ops::value_type s0, typename Ops::value_type s1,
+						 BiquadState *st)
+{
+	typedef typename Ops::scalar_type S;
+	S t0[Ops::kWidth];
+	S t1[Ops::kWidth];
+	Ops::storeu(t0, s0);
+	Ops::storeu(t1, s1);
+	for(size_t j = 0; j < K; ++j) {
+		st[j].s_[0] = t0[j];
+		st[j].s_[1] = t1[j];
+	}
+}
+
+//! K個の連続したチャンネルを、1フレームずつレジスタに読み込んで処理する
+template<class Ops, size_t K, size_t Type, class T>
+void	process_frames	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 BiquadState *st, T *data, size_t stride, size_t n)
+{
+	typedef typename Ops::value_type V;
+
+	KernelCoeffs<Ops> c = make_kernel_coeffs<Ops>(coeffs);
+
+	V s0, s1;
+	load_states<Ops, K>(s0, s1, st);
+
+	if(delta) {
+		KernelCoeffs<Ops> const d = make_kernel_coeffs<Ops>(*delta);
+		for(size_t i = 0; i < n; ++i, data += stride) {
+			V x;
+			load_frame(x, data, Lanes<K>());
+			store_frame(BiquadKernel<Type>::template tick<Ops>(c, x, s0, s1), data, Lanes<K>());
+			step_kernel_coeffs<Ops>(c, d);
+		}
+	} else {
+		for(size_t i = 0; i < n; ++i, data += stride) {
+			V x;
+			load_frame(x, data, Lanes<K>());
+			store_frame(BiquadKernel<Type>::template tick<Ops>(c, x, s0, s1), data, Lanes<K>());
+		}
+	}
+
+	store_states<Ops, K>(s0, s1, st);
+}
+
+//! AVXの属性をつけて実体化するかどうかで、process_framesの呼び出し方を切り替える
+template<bool UseAvx>
+struct FrameCall
+{
+	template<class Ops, size_t K, size_t Type, class T>
+	static void	call	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 BiquadState *st, T *data, size_t stride, size_t n)
+	{
+		process_frames<Ops, K, Type>(coeffs, delta, st, data, stride, n);
+	}
+};
+
+#if HWM_DSP_X86_SIMD
+
+template<class Ops, size_t K, size_t Type, class T>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	process_frames_avx	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 BiquadState *st, T *data, size_t stride, size_t n)
+{
+	process_frames<Ops, K, Type>(coeffs, delta, st, data, stride, n);
+}
+
+template<>
+struct FrameCall<true>
+{
+	template<class Ops, size_t K, size_t Type, class T>
+	static void	call	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 BiquadState *st, T *data, size_t stride, size_t n)
+	{
+		process_frames_avx<Ops, K, Type>(coeffs, delta, st, data, stride, n);
+	}
+};
+
+#endif	//HWM_DSP_X86_SIMD
+
+//! 全チャンネルを処理するフレームの範囲
+template<class T>
+struct Chunk
+{
+	BiquadCoeffs const &	coeffs_;
+	BiquadCoeffs const *	delta_;
+	size_t					filter_type_;
+	BiquadState *			states_;
+	T *						data_;
+	size_t					stride_;
+	size_t					n_;
+};
+
+template<class Ops, size_t K, bool UseAvx, class T>
+struct InterleavedKernel
+{
+	Chunk<T> const &	chunk_;
+	size_t				channel_;
+
+	template<size_t Type>
+	void	run	()
+	{
+		FrameCall<UseAvx>::template call<Ops, K, Type>(
+			chunk_.coeffs_, chunk_.delta_, chunk_.states_ + channel_,
+			chunk_.data_ + channel_, chunk_.stride_, chunk_.n_);
+	}
+};
+
+//! チャンネルchからK個ずつ、num_channelsを超えない範囲で処理し、処理していない最初のチャンネルを返す
+template<class Ops, size_t K, bool UseAvx, class T>
+size_t	process_groups	(Chunk<T> const &chunk, size_t ch, size_t num_channels)
+{
+	for( ; ch + K <= num_channels; ch += K) {
+		InterleavedKernel<Ops, K, UseAvx, T> kernel = { chunk, ch };
+		dispatch_filter_type(chunk.filter_type_, kernel);
+	}
+	return ch;
+}
+
+template<class T>
+void	process_chunk	(Chunk<T> const &chunk, size_t num_channels, size_t precision, size_t level)
+{
+	bool const use_float = (precision == StatePrecision::Float);
+	size_t ch = 0;
+
+#if HWM_DSP_X86_SIMD
+	if(use_float) {
+		if(level >= SimdLevel::AVX) {
+			ch = process_groups<AVX256FloatOps, 8, true>(chunk, ch, num_channels);
+			ch = process_groups<AVXFloatOps, 4, true>(chunk, ch, num_channels);
+			ch = process_groups<AVXFloatOps, 2, true>(chunk, ch, num_channels);
+		} else if(level >= SimdLevel::SSE2) {
+			ch = process_groups<SSEFloatOps, 4, false>(chunk, ch, num_channels);
+			ch = process_groups<SSEFloatOps, 2, false>(chunk, ch, num_channels);
+		}
+	} else {
+		if(level >= SimdLevel::AVX) {
+			ch = process_groups<AVX256Ops, 4, true>(chunk, ch, num_channels);
+			ch = process_groups<AVXOps, 2, true>(chunk, ch, num_channels);
+		} else if(level >= SimdLevel::SSE2) {
+			ch = process_groups<SSE2Ops, 2, false>(chunk, ch, num_channels);
+		}
+	}
+#endif
+
+	(void)level;
+	if(use_float) {
+		process_groups<ScalarFloatOps, 1, false>(chunk, ch, num_channels);
+	} else {
+		process_groups<ScalarOps, 1, false>(chunk, ch, num_channels);
+	}
+}
+
+template<class T>
+void	dispatch_interleaved	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+								 size_t filter_type, size_t precision,
+								 BiquadState *states, size_t num_channels,
+								 T *data, size_t stride, size_t n)
+{
+	if(num_channels == 0) {
+		return;
+	}
+
+	size_t const level = get_simd_level();
+	size_t const chunk_frames = std::max<size_t>(kChunkBytes / (stride * sizeof(T)), 1);
+
+	BiquadCoeffs c = coeffs;
+	for(size_t i = 0; i < n; i += chunk_frames) {
+		size_t const m = std::min(chunk_frames, n - i);
+		Chunk<T> const chunk = { c, delta, filter_type, states, data + i * stride, stride, m };
+		process_chunk(chunk, num_channels, precision, level);
+
+		if(delta) {
+			double const k = static_cast<double>(m);
+			BiquadCoeffs const next = {
+				c.b0_ + delta->b0_ * k,
+				c.b1_ + delta->b1_ * k,
+				c.b2_ + delta->b2_ * k,
+				c.a1_ + delta->a1_ * k,
+				c.a2_ + delta->a2_ * k
+			};
+			c = next;
+		}
+	}
+}
+
+}	//unnamed namespace
+
+void	process_interleaved	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 size_t filter_type, size_t precision,
+							 BiquadState *states, size_t num_channels,
+							 float *data, size_t stride, size_t n)
+{
+	dispatch_interleaved(coeffs, delta, filter_type, precision, states, num_channels, data, stride, n);
+}
+
+void	process_interleaved	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 size_t filter_type, size_t precision,
+							 BiquadState *states, size_t num_channels,
+							 double *data, size_t stride, size_t n)
+{
+	dispatch_interleaved(coeffs, delta, filter_type, precision, states, num_channels, data, stride, n);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,34 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_INTERLEAVEDBIQUAD_HPP
+#define	HWM_MINIVSTEFFECT_DSP_INTERLEAVEDBIQUAD_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include "./BiquadKernels.hpp"
+
+namespace hwm { namespace dsp {
+
+//! インターリーブされたフレームを、その場で処理する
+//! チャンネルchのiフレーム目はdata[i * stride + ch](ch = 0 ~ num_channels - 1)
+//!
+//! 1フレームの中で隣り合うチャンネル(L/Rなど)は連続しているので、
+//! そのまま1本のレジスタのレーンに読み込み、転置もチャンネルごとのバッファへのコピーもしない。
+//! AVXでは倍精度4チャンネル/単精度8チャンネル、SSE2では2/4チャンネルずつ、余りを1チャンネルずつ処理する。
+//! レジスタに収まらないチャンネル数では、L1に収まる数のフレームごとに全チャンネルを処理するので、
+//! バッファがメモリを行き来するのは1度だけになる
+//! @param filter_type FilterTypeのいずれか。特殊化しない場合はkGenericKernel
+//! @param precision StatePrecisionのいずれか
+//! @param delta 0でなければ、1フレームごとに係数にdeltaを足しながら処理する
+//! @param states num_channels分の遅延子
+//! @param stride 1フレームの間隔(サンプル数)。num_channels以上
+void	process_interleaved	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 size_t filter_type, size_t precision,
+							 BiquadState *states, size_t num_channels,
+							 float *data, size_t stride, size_t n);
+
+void	process_interleaved	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 size_t filter_type, size_t precision,
+							 BiquadState *states, size_t num_channels,
+							 double *data, size_t stride, size_t n);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_INTERLEAVEDBIQUAD_HPP
@@ -0,0 +1,509 @@
+#define _USE_MATH_DEFINES
+#include "./LinearPhase.hpp"
+#include "./CpuFeatures.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! 設計スレッドがset_responseの要求を確認する間隔
+//! オーディオスレッドからは起こさない(pthread_cond_signalは待っているスレッドがあるとfutexのシステムコールになる)
+//! ので、要求が設計に回るまで最大でこの時間だけ遅れる
+//! 設計スレッドはプロセスで1つなので、起床はインスタンスの数によらずこの間隔で1回になる
+std::chrono::milliseconds const kWorkerPollInterval(5);
+
+//! acc += x * h をビン1 ~ n-1について計算する
+//! ビン0はDCとナイキスト周波数の実数の組なので、呼び出し側で別に計算する
+template<class Dummy>
+void	complex_mac	(float const *xr, float const *xi, float const *hr, float const *hi,
+					 float *acc_re, float *acc_im, size_t n)
+{
+	for(size_t k = 1; k < n; ++k) {
+		acc_re[k] += xr[k] * hr[k] - xi[k] * hi[k];
+		acc_im[k] += xr[k] * hi[k] + xi[k] * hr[k];
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+//! 同じループをAVXでベクトル化させる
+HWM_DSP_TARGET_AVX
+void	complex_mac_avx	(float const *xr, float const *xi, float const *hr, float const *hi,
+						 float *acc_re, float *acc_im, size_t n)
+{
+	for(size_t k = 1; k < n; ++k) {
+		acc_re[k] += xr[k] * hr[k] - xi[k] * hi[k];
+		acc_im[k] += xr[k] * hi[k] + xi[k] * hr[k];
+	}
+}
+
+#endif
+
+}	//unnamed namespace
+
+LinearPhaseDesigner::LinearPhaseDesigner	(size_t fir_length, size_t block_size)
+	:	fir_length_(fir_length)
+	,	block_size_(block_size)
+	,	design_fft_(fir_length)
+	,	partition_fft_(block_size * 2)
+	,	cos1_(fir_length / 2 + 1)
+	,	sin1_(fir_length / 2 + 1)
+	,	cos2_(fir_length / 2 + 1)
+	,	sin2_(fir_length / 2 + 1)
+	,	window_(fir_length)
+	,	re_(fir_length / 2)
+	,	im_(fir_length / 2)
+	,	impulse_(fir_length)
+	,	fir_(fir_length)
+	,	partition_(block_size * 2)
+{
+	for(size_t k = 0; k <= fir_length / 2; ++k) {
+		double const w = 2.0 * M_PI * k / fir_length;
+		cos1_[k] = cos(w);
+		sin1_[k] = sin(w);
+		cos2_[k] = cos(2.0 * w);
+		sin2_[k] = sin(2.0 * w);
+	}
+
+	//! 中心が1になる周期的なBlackman窓
+	for(size_t n = 0; n < fir_length; ++n) {
+		double const x = 2.0 * M_PI * n / fir_length;
+		window_[n] = static_cast<float>(0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x));
+	}
+}
+
+size_t	LinearPhaseDesigner::get_fir_length	() const
+{
+	return fir_length_;
+}
+
+size_t	LinearPhaseDesigner::get_block_size	() const
+{
+	return block_size_;
+}
+
+size_t	LinearPhaseDesigner::get_num_partitions	() const
+{
+	return fir_length_ / block_size_;
+}
+
+void	LinearPhaseDesigner::design	(ResponseSections const &response, LinearPhaseKernel &kernel)
+{
+	size_t const half = fir_length_ / 2;
+
+	//! 各セクションの |B(e^jw)| / |A(e^jw)| の積
+	for(size_t k = 0; k <= half; ++k) {
+		double mag = 1.0;
+		for(size_t i = 0; i < response.num_sections_; ++i) {
+			BiquadCoeffs const &c = response.sections_[i];
+			double const br = c.b0_ + c.b1_ * cos1_[k] + c.b2_ * cos2_[k];
+			double const bi = c.b1_ * sin1_[k] + c.b2_ * sin2_[k];
+			double const ar = 1.0 + c.a1_ * cos1_[k] + c.a2_ * cos2_[k];
+			double const ai = c.a1_ * sin1_[k] + c.a2_ * sin2_[k];
+			mag *= sqrt((br * br + bi * bi) / (ar * ar + ai * ai));
+		}
+
+		if(k < half) {
+			re_[k] = static_cast<float>(mag);
+			im_[k] = 0.0f;
+		} else {
+			im_[0] = static_cast<float>(mag);
+		}
+	}
+
+	//! 位相0のインパルス応答を、中心がhalfサンプル目になるように回して窓をかける
+	design_fft_.inverse(&re_[0], &im_[0], &impulse_[0]);
+	float const scale = 1.0f / fir_length_;
+	for(size_t n = 0; n < fir_length_; ++n) {
+		fir_[n] = impulse_[(n + half) % fir_length_] * scale * window_[n];
+	}
+
+	//! block_sizeごとに分け、後ろを0で埋めてFFTする
+	size_t const num_partitions = get_num_partitions();
+	kernel.re_.resize(num_partitions * block_size_);
+	kernel.im_.resize(num_partitions * block_size_);
+
+	float const partition_scale = 1.0f / (2 * block_size_);
+	for(size_t p = 0; p < num_partitions; ++p) {
+		for(size_t n = 0; n < block_size_; ++n) {
+			partition_[n] = fir_[p * block_size_ + n] * partition_scale;
+			partition_[block_size_ + n] = 0.0f;
+		}
+		partition_fft_.forward(
+			&partition_[0], &kernel.re_[p * block_size_], &kernel.im_[p * block_size_]);
+	}
+}
+
+std::vector<float> const &
+		LinearPhaseDesigner::get_fir	() const
+{
+	return fir_;
+}
+
+//! 全てのLinearPhaseFilterのFIRを設計する、プロセスで1つのスレッド
+//! activateしたフィルタがある間だけ動き、kWorkerPollIntervalごとに各フィルタの要求を確認する
+//! 最後のフィルタが外れたらスレッドを終わらせるので、プラグインを閉じた後に残らない
+struct LinearPhaseFilter::DesignThread
+{
+	static
+	DesignThread &	get_instance	()
+	{
+		static DesignThread instance;
+		return instance;
+	}
+
+	void	add		(LinearPhaseFilter *filter)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		filters_.push_back(filter);
+		if(!thread_.joinable()) {
+			thread_ = std::thread([this] { run(); });
+		}
+	}
+
+	//! 戻った後は、filterを設計しない
+	void	remove	(LinearPhaseFilter *filter)
+	{
+		std::thread finished;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			filters_.erase(std::remove(filters_.begin(), filters_.end(), filter), filters_.end());
+			if(filters_.empty()) {
+				finished.swap(thread_);
+			}
+		}
+
+		if(finished.joinable()) {
+			wake_.notify_all();
+			finished.join();
+		}
+	}
+
+private:
+	DesignThread	()
+	{}
+
+	//! removeでthread_から外されたら終わる
+	//! 外された後にaddで次のスレッドが作られていても、自分のidとは違うので終わる
+	void	run		()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while(thread_.get_id() == std::this_thread::get_id()) {
+			for(size_t i = 0; i < filters_.size(); ++i) {
+				filters_[i]->design_requested();
+			}
+			wake_.wait_for(lock, kWorkerPollInterval);
+		}
+	}
+
+	std::mutex							mutex_;
+	//! removeで最後のフィルタを外したときだけ使う
+	std::condition_variable				wake_;
+	std::vector<LinearPhaseFilter *>	filters_;
+	std::thread							thread_;
+
+	DesignThread	(DesignThread const &);
+	DesignThread &	operator=	(DesignThread const &);
+};
+
+LinearPhaseFilter::LinearPhaseFilter	(size_t num_channels, size_t fir_length, size_t block_size)
+	:	fir_length_(fir_length)
+	,	block_size_(block_size)
+	,	num_partitions_(fir_length / block_size)
+	,	num_channels_(num_channels)
+	,	fill_(0)
+	,	head_(0)
+	,	prepared_(false)
+	,	active_(false)
+	,	crossfade_remaining_(0)
+	,	requests_(Request())
+	,	designs_(Design())
+	,	num_requests_(0)
+	,	num_designs_(0)
+	,	designed_(0)
+{}
+
+LinearPhaseFilter::~LinearPhaseFilter	()
+{
+	deactivate();
+}
+
+void	LinearPhaseFilter::activate	()
+{
+	if(active_) {
+		return;
+	}
+
+	if(!prepared_.load(std::memory_order_relaxed)) {
+		fft_.reset(new RealFft(block_size_ * 2));
+		designer_.reset(new LinearPhaseDesigner(fir_length_, block_size_));
+		acc_re_.resize(block_size_);
+		acc_im_.resize(block_size_);
+		time_.resize(block_size_ * 2);
+		previous_time_.resize(block_size_ * 2);
+		allocate_channels();
+
+		//! 最初は遅延だけの素通し
+		ResponseSections through;
+		through.num_sections_ = 0;
+		designer_->design(through, current_);
+		previous_ = current_;
+
+		prepared_.store(true, std::memory_order_release);
+	}
+
+	DesignThread::get_instance().add(this);
+	active_ = true;
+}
+
+void	LinearPhaseFilter::deactivate	()
+{
+	if(!active_) {
+		return;
+	}
+
+	DesignThread::get_instance().remove(this);
+	active_ = false;
+}
+
+bool	LinearPhaseFilter::is_active	() const
+{
+	return active_;
+}
+
+void	LinearPhaseFilter::set_response	(ResponseSections const &response)
+{
+	Request r;
+	r.serial_ = num_requests_.load(std::memory_order_relaxed) + 1;
+	r.response_ = response;
+	requests_.write(r);
+	//! 設計スレッドは起こさない。kWorkerPollIntervalごとにnum_requests_を見て気づく
+	num_requests_.store(r.serial_, std::memory_order_release);
+}
+
+void	LinearPhaseFilter::wait_for_design	()
+{
+	size_t const serial = num_requests_.load(std::memory_order_acquire);
+	while(num_designs_.load(std::memory_order_acquire) < serial) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void	LinearPhaseFilter::design_requested	()
+{
+	if(num_requests_.load(std::memory_order_acquire) == designed_ || !requests_.update()) {
+		return;
+	}
+
+	Request const &request = requests_.get();
+	designer_->design(request.response_, design_.kernel_);
+	design_.serial_ = request.serial_;
+	designed_ = request.serial_;
+
+	designs_.write(design_);
+	num_designs_.store(design_.serial_, std::memory_order_release);
+}
+
+size_t	LinearPhaseFilter::get_latency	() const
+{
+	return fir_length_ / 2 + block_size_;
+}
+
+size_t	LinearPhaseFilter::get_fir_length	() const
+{
+	return fir_length_;
+}
+
+size_t	LinearPhaseFilter::get_block_size	() const
+{
+	return block_size_;
+}
+
+void	LinearPhaseFilter::clear_buffer	()
+{
+	if(!prepared_.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	for(size_t i = 0; i < channels_.size(); ++i) {
+		Channel &ch = channels_[i];
+		std::fill(ch.input_.begin(), ch.input_.end(), 0.0f);
+		std::fill(ch.output_.begin(), ch.output_.end(), 0.0f);
+		std::fill(ch.spectra_re_.begin(), ch.spectra_re_.end(), 0.0f);
+		std::fill(ch.spectra_im_.begin(), ch.spectra_im_.end(), 0.0f);
+	}
+	fill_ = 0;
+	head_ = 0;
+}
+
+size_t	LinearPhaseFilter::get_num_channels	() const
+{
+	return num_channels_;
+}
+
+void	LinearPhaseFilter::set_num_channels	(size_t num_channels)
+{
+	num_channels_ = num_channels;
+	if(prepared_.load(std::memory_order_relaxed)) {
+		allocate_channels();
+	}
+}
+
+void	LinearPhaseFilter::allocate_channels	()
+{
+	channels_.resize(num_channels_);
+	for(size_t i = 0; i < num_channels_; ++i) {
+		Channel &ch = channels_[i];
+		ch.input_.resize(block_size_ * 2);
+		ch.output_.resize(block_size_);
+		ch.spectra_re_.resize(num_partitions_ * block_size_);
+		ch.spectra_im_.resize(num_partitions_ * block_size_);
+	}
+	clear_buffer();
+}
+
+void	LinearPhaseFilter::convolve	(Channel const &ch, LinearPhaseKernel const &kernel, float *out)
+{
+	size_t const B = block_size_;
+	std::fill(acc_re_.begin(), acc_re_.end(), 0.0f);
+	std::fill(acc_im_.begin(), acc_im_.end(), 0.0f);
+
+#if HWM_DSP_X86_SIMD
+	bool const use_avx = (get_simd_level() >= SimdLevel::AVX);
+#endif
+
+	//! 分割pには、pブロック前の入力のスペクトルを掛ける
+	for(size_t p = 0; p < num_partitions_; ++p) {
+		size_t const slot = (head_ + num_partitions_ - p) % num_partitions_;
+		float const *xr = &ch.spectra_re_[slot * B];
+		float const *xi = &ch.spectra_im_[slot * B];
+		float const *hr = &kernel.re_[p * B];
+		float const *hi = &kernel.im_[p * B];
+
+		acc_re_[0] += xr[0] * hr[0];
+		acc_im_[0] += xi[0] * hi[0];
+
+#if HWM_DSP_X86_SIMD
+		if(use_avx) {
+			complex_mac_avx(xr, xi, hr, hi, &acc_re_[0], &acc_im_[0], B);
+			continue;
+		}
+#endif
+		complex_mac<void>(xr, xi, hr, hi, &acc_re_[0], &acc_im_[0], B);
+	}
+
+	fft_->inverse(&acc_re_[0], &acc_im_[0], out);
+}
+
+void	LinearPhaseFilter::process_partition	()
+{
+	size_t const B = block_size_;
+
+	//! クロスフェードの途中では次のFIRを取り込まない
+	if(crossfade_remaining_ == 0 && designs_.update()) {
+		previous_.re_.swap(current_.re_);
+		previous_.im_.swap(current_.im_);
+		LinearPhaseKernel const &kernel = designs_.get().kernel_;
+		std::copy(kernel.re_.begin(), kernel.re_.end(), current_.re_.begin());
+		std::copy(kernel.im_.begin(), kernel.im_.end(), current_.im_.begin());
+		crossfade_remaining_ = kCrossfadeBlocks;
+	}
+
+	for(size_t i = 0; i < channels_.size(); ++i) {
+		Channel &ch = channels_[i];
+
+		fft_->forward(&ch.input_[0], &ch.spectra_re_[head_ * B], &ch.spectra_im_[head_ * B]);
+
+		//! overlap-saveなので、後半のblock_sizeサンプルだけが正しい畳み込みになる
+		convolve(ch, current_, &time_[0]);
+		if(crossfade_remaining_ > 0) {
+			convolve(ch, previous_, &previous_time_[0]);
+			double const total = static_cast<double>(kCrossfadeBlocks * B);
+			double const start = static_cast<double>((kCrossfadeBlocks - crossfade_remaining_) * B);
+			for(size_t n = 0; n < B; ++n) {
+				float const g = static_cast<float>((start + n) / total);
+				float const a = previous_time_[B + n];
+				ch.output_[n] = a + (time_[B + n] - a) * g;
+			}
+		} else {
+			std::copy(time_.begin() + B, time_.end(), ch.output_.begin());
+		}
+
+		std::copy(ch.input_.begin() + B, ch.input_.end(), ch.input_.begin());
+	}
+
+	head_ = (head_ + 1) % num_partitions_;
+	if(crossfade_remaining_ > 0) {
+		--crossfade_remaining_;
+	}
+}
+
+template<class T>
+void	LinearPhaseFilter::process_channels	(T const * const *in, T * const *out,
+											 size_t offset, size_t n)
+{
+	if(!prepared_.load(std::memory_order_acquire)) {
+		for(size_t i = 0; i < num_channels_; ++i) {
+			std::fill(out[i] + offset, out[i] + offset + n, static_cast<T>(0));
+		}
+		return;
+	}
+
+	size_t const B = block_size_;
+	size_t pos = 0;
+
+	while(pos < n) {
+		size_t const m = std::min(n - pos, B - fill_);
+
+		//! 入出力が同じバッファでもよいように、先に入力を読む
+		for(size_t i = 0; i < channels_.size(); ++i) {
+			Channel &ch = channels_[i];
+			T const *src = in[i] + offset + pos;
+			T *dst = out[i] + offset + pos;
+			for(size_t k = 0; k < m; ++k) {
+				ch.input_[B + fill_ + k] = static_cast<float>(src[k]);
+			}
+			for(size_t k = 0; k < m; ++k) {
+				dst[k] = static_cast<T>(ch.output_[fill_ + k]);
+			}
+		}
+
+		fill_ += m;
+		pos += m;
+		if(fill_ == B) {
+			process_partition();
+			fill_ = 0;
+		}
+	}
+}
+
+void	LinearPhaseFilter::process_block	(float const * const *in, float * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	LinearPhaseFilter::process_block	(double const * const *in, double * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	LinearPhaseFilter::process_block	(float const * const *in, float * const *out,
+											 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+void	LinearPhaseFilter::process_block	(double const * const *in, double * const *out,
+											 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+}}	//namespace hwm::dsp
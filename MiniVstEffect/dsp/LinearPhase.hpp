@@ -0,0 +1,231 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_LINEARPHASE_HPP
+#define	HWM_MINIVSTEFFECT_DSP_LINEARPHASE_HPP
+
+#include "./BiquadCascade.hpp"
+#include "./Fft.hpp"
+#include "./TripleBuffer.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! 線形位相FIRの設計に使う振幅特性
+//! bi-quadのセクションを縦続接続したときの振幅特性を使う
+struct ResponseSections
+{
+	size_t			num_sections_;
+	BiquadCoeffs	sections_[kMaxCascadeSections];
+};
+
+//! ブロック長ごとに分割したFIRのスペクトル
+//! 分割pのビンkが[p * block_size + k]に入る。ビンの並びはRealFftと同じ
+struct LinearPhaseKernel
+{
+	std::vector<float>	re_;
+	std::vector<float>	im_;
+};
+
+//! 振幅特性から線形位相FIRを設計する
+//!
+//! 振幅特性をfir_length / 2 + 1点で標本化し、位相0として逆FFTしたものを
+//! fir_length / 2サンプル遅らせてBlackman窓をかける。群遅延はfir_length / 2サンプルになる
+struct LinearPhaseDesigner
+{
+	//! @param fir_length, block_size 2のべき乗。fir_lengthはblock_sizeの倍数
+	LinearPhaseDesigner	(size_t fir_length, size_t block_size);
+
+	size_t	get_fir_length		() const;
+	size_t	get_block_size		() const;
+	size_t	get_num_partitions	() const;
+
+	//! FIRを設計し、分割したスペクトルをkernelに書き込む
+	//! スペクトルには逆FFTの1 / (2 * block_size)の正規化を含める
+	void	design		(ResponseSections const &response, LinearPhaseKernel &kernel);
+
+	//! 最後にdesignで作ったFIR
+	std::vector<float> const &
+			get_fir		() const;
+
+private:
+	size_t				fir_length_;
+	size_t				block_size_;
+	RealFft				design_fft_;
+	RealFft				partition_fft_;
+	//! 標本化する周波数での cos(w), sin(w), cos(2w), sin(2w)
+	std::vector<double>	cos1_;
+	std::vector<double>	sin1_;
+	std::vector<double>	cos2_;
+	std::vector<double>	sin2_;
+	std::vector<float>	window_;
+	std::vector<float>	re_;
+	std::vector<float>	im_;
+	std::vector<float>	impulse_;
+	std::vector<float>	fir_;
+	std::vector<float>	partition_;
+};
+
+//! 線形位相のイコライザ
+//!
+//! set_responseで渡された振幅特性の線形位相FIRを、一様分割のoverlap-save法で畳み込む。
+//! 入力をblock_sizeサンプルずつFFTして周波数領域の遅延線に並べ、
+//! FIRの分割ごとのスペクトルとの積和を1回の逆FFTで時間領域に戻す。
+//! 1サンプルあたりの積和は fir_length / block_size 回になる。
+//!
+//! FIRの設計はバックグラウンドのスレッドで行う。オーディオスレッドはset_responseで
+//! 要求を置くだけで待たない。設計が終わると、ブロックの境界から
+//! kCrossfadeBlocksブロックかけて新しいFIRの出力にクロスフェードする。
+//!
+//! 設計スレッドはプロセスで1つを全てのフィルタで共有し、activateしたフィルタがある間だけ動かす。
+//! バッファもactivateで確保するので、線形位相を使わないインスタンスは畳み込みのメモリも
+//! 設計スレッドの起床も使わない。
+//!
+//! 遅延は fir_length / 2 + block_size サンプル。get_latencyで取得できる
+struct LinearPhaseFilter
+{
+	enum {
+		kDefaultFirLength	= 4096,
+		kDefaultBlockSize	= 512,
+		kCrossfadeBlocks	= 4
+	};
+
+	//! 大きさを決めるだけで、バッファは確保しない
+	//! @param fir_length, block_size 2のべき乗。fir_lengthはblock_sizeの倍数
+	LinearPhaseFilter	(size_t num_channels,
+						 size_t fir_length = kDefaultFirLength,
+						 size_t block_size = kDefaultBlockSize);
+	~LinearPhaseFilter	();
+
+	//! 使い始める。初回はバッファを確保し、最初のFIRを遅延だけの素通しにする
+	//! 共有の設計スレッドに登録し、動いていなければ開始する
+	//! メモリを確保するので、オーディオスレッド以外から呼び出すこと
+	void	activate			();
+
+	//! 共有の設計スレッドから外す。バッファは残す
+	//! 設計中なら終わるまで待つ。オーディオスレッド以外から呼び出すこと
+	void	deactivate			();
+
+	bool	is_active			() const;
+
+	//! 振幅特性を設定する。オーディオスレッドから呼び出せる(wait-free)
+	//! 要求を書いて通し番号を更新するだけで、設計スレッドは起こさない(システムコールに入らない)
+	//! activateしている間、設計スレッドは最大5msで要求に気づく
+	//! 設計が終わる前に次の要求が来た場合は、最新のものだけを設計する
+	void	set_response		(ResponseSections const &response);
+
+	//! 最後に要求した設計が終わるまで待つ。activateしてから呼び出すこと
+	//! オフラインの処理や計測用。オーディオスレッドからは呼び出さないこと
+	void	wait_for_design		();
+
+	//! 処理の遅延(サンプル数)
+	size_t	get_latency			() const;
+	size_t	get_fir_length		() const;
+	size_t	get_block_size		() const;
+
+	//! 遅延線をクリア
+	void	clear_buffer		();
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。遅延線はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! 全チャンネルをまとめて処理する
+	//! 一度もactivateしていなければ、0を出力する
+	void	process_block		(float const * const *in, float * const *out, size_t n);
+	void	process_block		(double const * const *in, double * const *out, size_t n);
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	void	process_block		(float const * const *in, float * const *out,
+								 size_t offset, size_t n);
+	void	process_block		(double const * const *in, double * const *out,
+								 size_t offset, size_t n);
+
+private:
+	//! 全てのフィルタで共有する設計スレッド
+	struct DesignThread;
+
+	//! 設計の要求
+	struct Request
+	{
+		size_t				serial_;
+		ResponseSections	response_;
+	};
+
+	//! 設計したFIR
+	struct Design
+	{
+		size_t				serial_;
+		LinearPhaseKernel	kernel_;
+	};
+
+	//! チャンネルごとの遅延線
+	struct Channel
+	{
+		//! 直前のブロックと現在のブロックの入力。2 * block_size
+		std::vector<float>	input_;
+		//! 直前のブロックの出力。block_size
+		std::vector<float>	output_;
+		//! 入力のスペクトルの遅延線。num_partitions * block_size
+		std::vector<float>	spectra_re_;
+		std::vector<float>	spectra_im_;
+	};
+
+	size_t					fir_length_;
+	size_t					block_size_;
+	size_t					num_partitions_;
+
+	size_t					num_channels_;
+	std::vector<Channel>	channels_;
+	//! 現在のブロックに溜まっているサンプル数
+	size_t					fill_;
+	//! 遅延線の先頭の分割
+	size_t					head_;
+
+	//! activateでバッファを確保したか。オーディオスレッドはこれを見てから処理する
+	std::atomic<bool>		prepared_;
+	//! 設計スレッドに登録しているか。activate, deactivateを呼び出すスレッドだけが使う
+	bool					active_;
+
+	std::unique_ptr<RealFft>	fft_;
+	LinearPhaseKernel		current_;
+	LinearPhaseKernel		previous_;
+	//! クロスフェードの残りのブロック数
+	size_t					crossfade_remaining_;
+	std::vector<float>		acc_re_;
+	std::vector<float>		acc_im_;
+	std::vector<float>		time_;
+	std::vector<float>		previous_time_;
+
+	//! 設計スレッドとの受け渡し
+	std::unique_ptr<LinearPhaseDesigner>	designer_;
+	TripleBuffer<Request>	requests_;
+	TripleBuffer<Design>	designs_;
+	std::atomic<size_t>		num_requests_;
+	std::atomic<size_t>		num_designs_;
+	//! 設計スレッドだけが使う。最後に設計した要求と、設計の作業領域
+	size_t					designed_;
+	Design					design_;
+
+	//! 新しい要求があれば設計する。設計スレッドから呼び出す
+	void	design_requested	();
+
+	//! num_channels_分の遅延線を確保してクリアする
+	void	allocate_channels	();
+
+	//! block_sizeサンプル溜まった入力を処理する
+	void	process_partition	();
+
+	//! 遅延線とkernelの積和を逆FFTしてoutに書き込む
+	void	convolve			(Channel const &ch, LinearPhaseKernel const &kernel, float *out);
+
+	template<class T>
+	void	process_channels	(T const * const *in, T * const *out, size_t offset, size_t n);
+
+	LinearPhaseFilter	(LinearPhaseFilter const &);
+	LinearPhaseFilter &	operator=	(LinearPhaseFilter const &);
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_LINEARPHASE_HPP
@@ -0,0 +1,240 @@
+#include "./MultiBiquad.hpp"
+#include "./SimdOps.hpp"
+
+namespace hwm { namespace dsp {
+
+#if HWM_DSP_X86_SIMD
+
+namespace {
+
+//! Lanes組のレジスタで、Ops::kWidth * Lanesチャンネルをまとめて処理する
+//! Ops::kWidthサンプルずつ転置して読み込み、サンプルの順に計算して、転置して書き戻す
+template<class Ops, size_t Lanes, class T, size_t Type>
+void	process_lanes	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 BiquadState *st, T const * const *in, T * const *out,
+						 size_t offset, size_t n)
+{
+	typedef typename Ops::value_type	V;
+	typedef typename Ops::scalar_type	S;
+
+	enum {
+		W = Ops::kWidth,
+		kNumChannels = W * Lanes
+	};
+
+	T const *src[kNumChannels];
+	T *dst[kNumChannels];
+	for(size_t ch = 0; ch < kNumChannels; ++ch) {
+		src[ch] = in[ch] + offset;
+		dst[ch] = out[ch] + offset;
+	}
+
+	KernelCoeffs<Ops> c = make_kernel_coeffs<Ops>(coeffs);
+	KernelCoeffs<Ops> const d = make_kernel_coeffs<Ops>(delta ? *delta : BiquadCoeffs());
+
+	//! ブロック端での遅延子とサンプルの並べ替えに使う
+	//! レジスタの型で確保してアラインメントを揃える
+	V buf[Lanes * 2];
+	S * const sbuf = reinterpret_cast<S *>(buf);
+
+	V s0[Lanes];
+	V s1[Lanes];
+	for(size_t ch = 0; ch < kNumChannels; ++ch) {
+		sbuf[ch] = static_cast<S>(st[ch].s_[0]);
+		sbuf[kNumChannels + ch] = static_cast<S>(st[ch].s_[1]);
+	}
+	for(size_t l = 0; l < Lanes; ++l) {
+		s0[l] = Ops::load(sbuf + l * W);
+		s1[l] = Ops::load(sbuf + kNumChannels + l * W);
+	}
+
+	size_t i = 0;
+	for( ; i + W <= n; i += W) {
+		V x[Lanes][W];
+		for(size_t l = 0; l < Lanes; ++l) {
+			load_tile(x[l], src + l * W, i);
+		}
+
+		for(size_t k = 0; k < W; ++k) {
+			for(size_t l = 0; l < Lanes; ++l) {
+				x[l][k] = BiquadKernel<Type>::template tick<Ops>(c, x[l][k], s0[l], s1[l]);
+			}
+			if(delta) {
+				step_kernel_coeffs<Ops>(c, d);
+			}
+		}
+
+		for(size_t l = 0; l < Lanes; ++l) {
+			store_tile(x[l], dst + l * W, i);
+		}
+	}
+
+	//! 端数のサンプルは1サンプルずつ並べ替える
+	for( ; i < n; ++i) {
+		for(size_t ch = 0; ch < kNumChannels; ++ch) {
+			sbuf[ch] = static_cast<S>(src[ch][i]);
+		}
+		for(size_t l = 0; l < Lanes; ++l) {
+			V const x = Ops::load(sbuf + l * W);
+			Ops::store(sbuf + l * W, BiquadKernel<Type>::template tick<Ops>(c, x, s0[l], s1[l]));
+		}
+		for(size_t ch = 0; ch < kNumChannels; ++ch) {
+			dst[ch][i] = static_cast<T>(sbuf[ch]);
+		}
+		if(delta) {
+			step_kernel_coeffs<Ops>(c, d);
+		}
+	}
+
+	for(size_t l = 0; l < Lanes; ++l) {
+		Ops::store(sbuf + l * W, s0[l]);
+		Ops::store(sbuf + kNumChannels + l * W, s1[l]);
+	}
+	for(size_t ch = 0; ch < kNumChannels; ++ch) {
+		st[ch].s_[0] = sbuf[ch];
+		st[ch].s_[1] = sbuf[kNumChannels + ch];
+	}
+}
+
+template<class Ops, size_t Lanes, class T, size_t Type>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	process_lanes_avx	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 BiquadState *st, T const * const *in, T * const *out,
+							 size_t offset, size_t n)
+{
+	process_lanes<Ops, Lanes, T, Type>(coeffs, delta, st, in, out, offset, n);
+}
+
+//! AVXの演算はprocess_lanes_avxを経由して呼び出す
+template<bool UseAvx>
+struct LaneRunner
+{
+	template<class Ops, size_t Lanes, class T, size_t Type>
+	static void	run	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+					 BiquadState *st, T const * const *in, T * const *out,
+					 size_t offset, size_t n)
+	{
+		process_lanes<Ops, Lanes, T, Type>(coeffs, delta, st, in, out, offset, n);
+	}
+};
+
+template<>
+struct LaneRunner<true>
+{
+	template<class Ops, size_t Lanes, class T, size_t Type>
+	static void	run	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+					 BiquadState *st, T const * const *in, T * const *out,
+					 size_t offset, size_t n)
+	{
+		process_lanes_avx<Ops, Lanes, T, Type>(coeffs, delta, st, in, out, offset, n);
+	}
+};
+
+template<class T, class Ops, size_t Lanes, bool UseAvx>
+struct MultiKernel
+{
+	BiquadCoeffs const &	coeffs_;
+	BiquadCoeffs const *	delta_;
+	BiquadState *			st_;
+	T const * const *		in_;
+	T * const *				out_;
+	size_t					offset_;
+	size_t					n_;
+
+	template<size_t Type>
+	void	run	()
+	{
+		LaneRunner<UseAvx>::template run<Ops, Lanes, T, Type>(
+			coeffs_, delta_, st_, in_, out_, offset_, n_);
+	}
+};
+
+//! 先頭からOps::kWidth * Lanesチャンネル分を処理する
+template<class Ops, size_t Lanes, bool UseAvx, class T>
+void	process_group	(BiquadCoeffs const &c, BiquadCoeffs const *delta, size_t filter_type,
+						 BiquadState *st, T const * const *in, T * const *out,
+						 size_t offset, size_t n)
+{
+	MultiKernel<T, Ops, Lanes, UseAvx> kernel = { c, delta, st, in, out, offset, n };
+	dispatch_filter_type(filter_type, kernel);
+}
+
+template<class T>
+size_t	dispatch_multi	(BiquadCoeffs const &c, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *st, size_t num_channels,
+						 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	size_t const level = get_simd_level();
+	size_t ch = 0;
+
+	if(precision == StatePrecision::Float) {
+		if(level >= SimdLevel::AVX) {
+			for( ; ch + 16 <= num_channels; ch += 16) {
+				process_group<AVX256FloatOps, 2, true>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+			for( ; ch + 8 <= num_channels; ch += 8) {
+				process_group<AVX256FloatOps, 1, true>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+			for( ; ch + 4 <= num_channels; ch += 4) {
+				process_group<AVXFloatOps, 1, true>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+		} else if(level >= SimdLevel::SSE2) {
+			for( ; ch + 8 <= num_channels; ch += 8) {
+				process_group<SSEFloatOps, 2, false>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+			for( ; ch + 4 <= num_channels; ch += 4) {
+				process_group<SSEFloatOps, 1, false>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+		}
+	} else {
+		//! SSE2の倍精度は2チャンネル幅なので、process_stereoに任せる
+		if(level >= SimdLevel::AVX) {
+			for( ; ch + 8 <= num_channels; ch += 8) {
+				process_group<AVX256Ops, 2, true>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+			for( ; ch + 4 <= num_channels; ch += 4) {
+				process_group<AVX256Ops, 1, true>(c, delta, filter_type, st + ch, in + ch, out + ch, offset, n);
+			}
+		}
+	}
+
+	return ch;
+}
+
+}	//unnamed namespace
+
+#else	//HWM_DSP_X86_SIMD
+
+namespace {
+
+template<class T>
+size_t	dispatch_multi	(BiquadCoeffs const &, BiquadCoeffs const *, size_t, size_t,
+						 BiquadState *, size_t, T const * const *, T * const *, size_t, size_t)
+{
+	return 0;
+}
+
+}	//unnamed namespace
+
+#endif	//HWM_DSP_X86_SIMD
+
+size_t	process_multi	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states, size_t num_channels,
+						 float const * const *in, float * const *out,
+						 size_t offset, size_t n)
+{
+	return dispatch_multi(coeffs, delta, filter_type, precision, states, num_channels, in, out, offset, n);
+}
+
+size_t	process_multi	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states, size_t num_channels,
+						 double const * const *in, double * const *out,
+						 size_t offset, size_t n)
+{
+	return dispatch_multi(coeffs, delta, filter_type, precision, states, num_channels, in, out, offset, n);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,40 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_MULTIBIQUAD_HPP
+#define	HWM_MINIVSTEFFECT_DSP_MULTIBIQUAD_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include "./BiquadKernels.hpp"
+
+namespace hwm { namespace dsp {
+
+//! 多チャンネルをSIMDのレーンに並べて処理する
+//!
+//! チャンネルをレジスタのレーンに割り当て(AVXでは倍精度4ch、単精度8ch)、
+//! 1サンプルごとに全レーンを1度に計算する。遅延子はブロックの間、チャンネルごとの
+//! レーンに並べたSoAのレジスタに保持する。
+//! 入出力はチャンネルごとのバッファなので、数十サンプルずつ一時バッファに転置して処理する。
+//! レーン幅の2倍以上のチャンネルがある場合は、2組のレジスタを交互に計算して
+//! 依存チェーンのレイテンシを隠す。
+//!
+//! 先頭から、レーン幅の倍数のチャンネルだけを処理する。残りのチャンネルは呼び出し側で
+//! process_stereoなどを使って処理する。
+//! @param filter_type FilterTypeのいずれか。特殊化しない場合はkGenericKernel
+//! @param precision StatePrecisionのいずれか
+//! @param delta 0でなければ、1サンプルごとに係数にdeltaを足しながら処理する
+//! @param states num_channels分の遅延子
+//! @param in, out 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+//! @return 処理したチャンネル数。SIMDが使えないか、チャンネル数が足りなければ0
+size_t	process_multi	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states, size_t num_channels,
+						 float const * const *in, float * const *out,
+						 size_t offset, size_t n);
+
+size_t	process_multi	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states, size_t num_channels,
+						 double const * const *in, double * const *out,
+						 size_t offset, size_t n);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_MULTIBIQUAD_HPP
@@ -0,0 +1,364 @@
+#define _USE_MATH_DEFINES
+#include "./Oversampler.hpp"
+#include "./BiquadKernels.hpp"
+#include "./CpuFeatures.hpp"
+#include "./SimdOps.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+enum {
+	//! 1段目のタップ数。48kHzで20kHzまでを通し、28kHz以上を96dB以上減衰させる
+	kFirstStageTaps = 75,
+	//! 2段目のタップ数。1段目で20kHz ~ 28kHzより上は落ちているので、遷移帯域が広い
+	kSecondStageTaps = 31
+};
+
+//! Kaiser窓の阻止域の減衰量に対応するβ(96dB)
+double const kKaiserBeta = 9.62;
+
+//! 第1種変形ベッセル関数 I0
+double	bessel_i0	(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for(int k = 1; k < 64; ++k) {
+		double const t = x / (2.0 * k);
+		term *= t * t;
+		sum += term;
+		if(term < sum * 1e-17) {
+			break;
+		}
+	}
+	return sum;
+}
+
+//! num_taps(4m + 3)タップのハーフバンドFIRをKaiser窓の窓関数法で設計し、
+//! 0でない側の位相のタップ(偶数番目)を返す。残りの位相は中央の0.5だけになる
+std::vector<double>
+		design_halfband	(size_t num_taps)
+{
+	double const center = (num_taps - 1) / 2.0;
+	double const norm = bessel_i0(kKaiserBeta);
+
+	std::vector<double> taps;
+	for(size_t k = 0; k < num_taps; k += 2) {
+		double const t = k - center;
+		double const r = t / center;
+		double const window = bessel_i0(kKaiserBeta * sqrt(1.0 - r * r)) / norm;
+		taps.push_back(sin(M_PI * t / 2.0) / (M_PI * t) * window);
+	}
+
+	//! 通過域のゲインを1にそろえる。0でない側の位相の和が0.5になればよい
+	double sum = 0;
+	for(size_t i = 0; i < taps.size(); ++i) {
+		sum += taps[i];
+	}
+	for(size_t i = 0; i < taps.size(); ++i) {
+		taps[i] *= 0.5 / sum;
+	}
+	return taps;
+}
+
+//! y[t] = sum_i c[i] * x[t + i] (0 <= i < num_taps)
+//! cが対称なので、両端から組にして乗算を半分にする
+//! kRegs本のレジスタ分の出力を保持したまま全タップを足し込み、残りは1サンプルずつ処理する
+template<class Ops>
+void	symmetric_fir	(double const *c, size_t num_taps, double const *x, double *y, size_t n)
+{
+	typedef typename Ops::value_type V;
+	enum { W = Ops::kWidth, kRegs = 4, kChunk = W * kRegs };
+
+	size_t const half = num_taps / 2;
+	size_t t = 0;
+	for( ; t + kChunk <= n; t += kChunk) {
+		V acc[kRegs];
+		for(size_t r = 0; r < kRegs; ++r) {
+			acc[r] = Ops::zero();
+		}
+		for(size_t i = 0; i < half; ++i) {
+			V const ci = Ops::set1(c[i]);
+			double const *a = x + t + i;
+			double const *b = x + t + num_taps - 1 - i;
+			for(size_t r = 0; r < kRegs; ++r) {
+				acc[r] = Ops::madd(ci, Ops::add(Ops::loadu(a + r * W), Ops::loadu(b + r * W)), acc[r]);
+			}
+		}
+		for(size_t r = 0; r < kRegs; ++r) {
+			Ops::storeu(y + t + r * W, acc[r]);
+		}
+	}
+
+	for( ; t < n; ++t) {
+		double acc = 0;
+		for(size_t i = 0; i < half; ++i) {
+			acc += c[i] * (x[t + i] + x[t + num_taps - 1 - i]);
+		}
+		y[t] = acc;
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+template<class Ops>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	symmetric_fir_avx	(double const *c, size_t num_taps, double const *x, double *y, size_t n)
+{
+	symmetric_fir<Ops>(c, num_taps, x, y, n);
+}
+
+#endif
+
+void	run_symmetric_fir	(double const *c, size_t num_taps, double const *x, double *y, size_t n)
+{
+#if HWM_DSP_X86_SIMD
+	size_t const level = get_simd_level();
+	if(level >= SimdLevel::AVX) {
+		symmetric_fir_avx<AVX256Ops>(c, num_taps, x, y, n);
+	} else if(level >= SimdLevel::SSE2) {
+		symmetric_fir<SSE2Ops>(c, num_taps, x, y, n);
+	} else {
+		symmetric_fir<ScalarOps>(c, num_taps, x, y, n);
+	}
+#else
+	symmetric_fir<ScalarOps>(c, num_taps, x, y, n);
+#endif
+}
+
+}	//unnamed namespace
+
+HalfbandStage::HalfbandStage	(size_t num_taps, size_t max_block_size, size_t num_channels)
+	:	num_taps_(num_taps)
+	,	num_phase_taps_((num_taps + 1) / 2)
+	,	max_block_size_(max_block_size)
+	,	taps_(design_halfband(num_taps))
+	,	up_taps_(taps_)
+	,	work_(max_block_size)
+{
+	for(size_t i = 0; i < up_taps_.size(); ++i) {
+		up_taps_[i] *= 2.0;
+	}
+	set_num_channels(num_channels);
+}
+
+size_t	HalfbandStage::get_num_taps	() const
+{
+	return num_taps_;
+}
+
+void	HalfbandStage::clear_buffer	()
+{
+	for(size_t i = 0; i < channels_.size(); ++i) {
+		Channel &ch = channels_[i];
+		std::fill(ch.up_.begin(), ch.up_.end(), 0.0);
+		std::fill(ch.down_even_.begin(), ch.down_even_.end(), 0.0);
+		std::fill(ch.down_odd_.begin(), ch.down_odd_.end(), 0.0);
+	}
+}
+
+void	HalfbandStage::set_num_channels	(size_t num_channels)
+{
+	size_t const size = num_phase_taps_ - 1 + max_block_size_;
+	channels_.resize(num_channels);
+	for(size_t i = 0; i < num_channels; ++i) {
+		Channel &ch = channels_[i];
+		ch.up_.resize(size);
+		ch.down_even_.resize(size);
+		ch.down_odd_.resize(size);
+	}
+	clear_buffer();
+}
+
+void	HalfbandStage::upsample	(size_t ch, double const *in, double *out, size_t n)
+{
+	size_t const history = num_phase_taps_ - 1;
+	//! 遅延だけの位相の遅延。中央のタップの位置 (num_taps - 1) / 2 = 2m + 1 の半分
+	size_t const delay = (num_taps_ - 3) / 4;
+	double *x = &channels_[ch].up_[0];
+
+	std::copy(in, in + n, x + history);
+	run_symmetric_fir(&up_taps_[0], num_phase_taps_, x, &work_[0], n);
+
+	for(size_t t = 0; t < n; ++t) {
+		out[2 * t] = work_[t];
+		out[2 * t + 1] = x[history + t - delay];
+	}
+
+	std::copy(x + n, x + n + history, x);
+}
+
+void	HalfbandStage::downsample	(size_t ch, double const *in, double *out, size_t n)
+{
+	size_t const history = num_phase_taps_ - 1;
+	//! 奇数番目の入力の遅延。(中央のタップの位置 + 1) / 2
+	size_t const delay = (num_taps_ + 1) / 4;
+	Channel &c = channels_[ch];
+	double *even = &c.down_even_[0];
+	double *odd = &c.down_odd_[0];
+
+	for(size_t t = 0; t < n; ++t) {
+		even[history + t] = in[2 * t];
+		odd[history + t] = in[2 * t + 1];
+	}
+	run_symmetric_fir(&taps_[0], num_phase_taps_, even, out, n);
+
+	for(size_t t = 0; t < n; ++t) {
+		out[t] += 0.5 * odd[history + t - delay];
+	}
+
+	std::copy(even + n, even + n + history, even);
+	std::copy(odd + n, odd + n + history, odd);
+}
+
+Oversampler::Oversampler	(size_t num_channels, size_t factor)
+	:	factor_(1)
+	,	first_(kFirstStageTaps, kMaxBlockSize, num_channels)
+	,	second_(kSecondStageTaps, kMaxBlockSize * 2, num_channels)
+	,	pad_(0)
+	,	work_in_(kMaxBlockSize)
+	,	work_mid_(kMaxBlockSize * 2)
+	,	work_fast_(kMaxBlockSize * kMaxFactor)
+{
+	set_num_channels(num_channels);
+	set_factor(factor);
+}
+
+size_t	Oversampler::get_factor	() const
+{
+	return factor_;
+}
+
+void	Oversampler::set_factor	(size_t factor)
+{
+	factor_ = factor;
+
+	//! 各段の遅延を一番高いレートのサンプル数で足し、factorの倍数に切り上げる
+	size_t fast_delay = 0;
+	if(factor_ >= 2) {
+		fast_delay += (first_.get_num_taps() - 1) * (factor_ / 2);
+	}
+	if(factor_ >= 4) {
+		fast_delay += second_.get_num_taps() - 1;
+	}
+	pad_ = (factor_ - fast_delay % factor_) % factor_;
+
+	clear_buffer();
+}
+
+size_t	Oversampler::get_latency	() const
+{
+	return get_latency(factor_);
+}
+
+size_t	Oversampler::get_latency	(size_t factor)
+{
+	size_t fast_delay = 0;
+	if(factor >= 2) {
+		fast_delay += (kFirstStageTaps - 1) * (factor / 2);
+	}
+	if(factor >= 4) {
+		fast_delay += kSecondStageTaps - 1;
+	}
+	return (fast_delay + factor - 1) / factor;
+}
+
+void	Oversampler::clear_buffer	()
+{
+	first_.clear_buffer();
+	second_.clear_buffer();
+	std::fill(pad_buffers_.begin(), pad_buffers_.end(), 0.0);
+	std::fill(pad_positions_.begin(), pad_positions_.end(), 0);
+}
+
+size_t	Oversampler::get_num_channels	() const
+{
+	return pad_positions_.size();
+}
+
+void	Oversampler::set_num_channels	(size_t num_channels)
+{
+	first_.set_num_channels(num_channels);
+	second_.set_num_channels(num_channels);
+	pad_buffers_.resize(num_channels * kMaxFactor);
+	pad_positions_.resize(num_channels);
+	clear_buffer();
+}
+
+template<class T>
+void	Oversampler::upsample_channel	(size_t ch, T const *in, double *out, size_t n)
+{
+	if(factor_ == 1) {
+		std::copy(in, in + n, out);
+		return;
+	}
+
+	std::copy(in, in + n, work_in_.begin());
+	if(factor_ == 2) {
+		first_.upsample(ch, &work_in_[0], out, n);
+	} else {
+		first_.upsample(ch, &work_in_[0], &work_mid_[0], n);
+		second_.upsample(ch, &work_mid_[0], out, n * 2);
+	}
+}
+
+template<class T>
+void	Oversampler::downsample_channel	(size_t ch, double const *in, T *out, size_t n)
+{
+	if(factor_ == 1) {
+		for(size_t t = 0; t < n; ++t) {
+			out[t] = static_cast<T>(in[t]);
+		}
+		return;
+	}
+
+	if(factor_ == 2) {
+		first_.downsample(ch, in, &work_in_[0], n);
+	} else {
+		double const *fast = in;
+		if(pad_ > 0) {
+			//! 遅延を整数サンプルにそろえる
+			double *ring = &pad_buffers_[ch * kMaxFactor];
+			size_t pos = pad_positions_[ch];
+			for(size_t t = 0; t < n * 4; ++t) {
+				double const x = in[t];
+				work_fast_[t] = ring[pos];
+				ring[pos] = x;
+				pos = (pos + 1 == pad_) ? 0 : pos + 1;
+			}
+			pad_positions_[ch] = pos;
+			fast = &work_fast_[0];
+		}
+		second_.downsample(ch, fast, &work_mid_[0], n * 2);
+		first_.downsample(ch, &work_mid_[0], &work_in_[0], n);
+	}
+
+	for(size_t t = 0; t < n; ++t) {
+		out[t] = static_cast<T>(work_in_[t]);
+	}
+}
+
+void	Oversampler::upsample	(size_t ch, float const *in, double *out, size_t n)
+{
+	upsample_channel(ch, in, out, n);
+}
+
+void	Oversampler::upsample	(size_t ch, double const *in, double *out, size_t n)
+{
+	upsample_channel(ch, in, out, n);
+}
+
+void	Oversampler::downsample	(size_t ch, double const *in, float *out, size_t n)
+{
+	downsample_channel(ch, in, out, n);
+}
+
+void	Oversampler::downsample	(size_t ch, double const *in, double *out, size_t n)
+{
+	downsample_channel(ch, in, out, n);
+}
+
+}}	//namespace hwm::dsp
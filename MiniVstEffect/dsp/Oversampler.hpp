@@ -0,0 +1,119 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_OVERSAMPLER_HPP
+#define	HWM_MINIVSTEFFECT_DSP_OVERSAMPLER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! 2倍のアップサンプリングとダウンサンプリングを行う、ハーフバンドFIRの1段
+//!
+//! ハーフバンドFIRは中央以外の奇数番目のタップが0なので、ポリフェーズに分けると
+//! 片方の位相は中央のタップ(0.5)による遅延だけになる。
+//! 残りの位相は対称なので、1サンプルあたりの乗算は (num_taps + 1) / 4 回になる。
+//! 遅延はアップとダウンを合わせて、2倍のレートで num_taps - 1 サンプル
+struct HalfbandStage
+{
+	//! @param num_taps 4m + 3
+	//! @param max_block_size 1回のupsampleの入力、downsampleの出力のサンプル数の上限
+	HalfbandStage	(size_t num_taps, size_t max_block_size, size_t num_channels);
+
+	size_t	get_num_taps		() const;
+
+	void	clear_buffer		();
+	void	set_num_channels	(size_t num_channels);
+
+	//! チャンネルchのnサンプルを2倍のレートにして、outに2nサンプル書く
+	void	upsample			(size_t ch, double const *in, double *out, size_t n);
+	//! チャンネルchの2nサンプルを1/2のレートにして、outにnサンプル書く
+	void	downsample			(size_t ch, double const *in, double *out, size_t n);
+
+private:
+	//! 遅延線
+	//! 先頭のnum_phase_taps_ - 1サンプルが直前の入力、続いて今回の入力が入る
+	struct Channel
+	{
+		std::vector<double>	up_;
+		std::vector<double>	down_even_;
+		std::vector<double>	down_odd_;
+	};
+
+	size_t					num_taps_;
+	//! 0でない側の位相のタップ数。(num_taps + 1) / 2
+	size_t					num_phase_taps_;
+	size_t					max_block_size_;
+	//! 0でない側の位相のタップ。ダウンサンプリング用
+	std::vector<double>		taps_;
+	//! アップサンプリング用。0を挿入した分のゲインを補うために2倍してある
+	std::vector<double>		up_taps_;
+	std::vector<Channel>	channels_;
+	std::vector<double>		work_;
+};
+
+//! 2倍, 4倍のオーバーサンプリング
+//!
+//! 双一次変換で設計したフィルタは、ナイキスト周波数に近いほど周波数軸が縮む(cramping)。
+//! 高いレートで処理すると、可聴域の特性がアナログのプロトタイプに近くなる。
+//! ハーフバンドFIRの段を縦続接続して2倍ずつ変換する。
+//! 2段目以降は遷移帯域が広くてよいので、タップ数を減らしてある。
+//!
+//! 遅延はget_latencyで取得できる。4倍のときは、遅延がもとのレートで整数サンプルになるように
+//! ダウンサンプリングの前に高いレートで少し遅らせる
+struct Oversampler
+{
+	enum {
+		kMaxFactor = 4,
+		//! 1回に処理できるサンプル数(もとのレート)
+		kMaxBlockSize = 64
+	};
+
+	//! @param factor 1, 2, 4のいずれか。1ならそのままコピーする
+	Oversampler		(size_t num_channels, size_t factor = 1);
+
+	size_t	get_factor			() const;
+	//! 倍率を変更する。遅延線はクリアされる
+	//! メモリは確保しないので、オーディオスレッドから呼び出せる
+	void	set_factor			(size_t factor);
+
+	//! アップとダウンを合わせた遅延(もとのレートのサンプル数)
+	size_t	get_latency			() const;
+	static size_t
+			get_latency			(size_t factor);
+
+	//! 遅延線をクリア
+	void	clear_buffer		();
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。遅延線はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! チャンネルchのnサンプル(kMaxBlockSize以下)をfactor倍のレートにして、outにn * factorサンプル書く
+	void	upsample			(size_t ch, float const *in, double *out, size_t n);
+	void	upsample			(size_t ch, double const *in, double *out, size_t n);
+
+	//! チャンネルchのn * factorサンプルをもとのレートに戻して、outにnサンプル書く
+	void	downsample			(size_t ch, double const *in, float *out, size_t n);
+	void	downsample			(size_t ch, double const *in, double *out, size_t n);
+
+private:
+	size_t						factor_;
+	HalfbandStage				first_;
+	HalfbandStage				second_;
+	//! 4倍のときに遅延を整数サンプルにそろえるための、高いレートでの遅延
+	size_t						pad_;
+	std::vector<double>			pad_buffers_;
+	std::vector<size_t>			pad_positions_;
+	std::vector<double>			work_in_;
+	std::vector<double>			work_mid_;
+	std::vector<double>			work_fast_;
+
+	template<class T>
+	void	upsample_channel	(size_t ch, T const *in, double *out, size_t n);
+	template<class T>
+	void	downsample_channel	(size_t ch, double const *in, T *out, size_t n);
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_OVERSAMPLER_HPP
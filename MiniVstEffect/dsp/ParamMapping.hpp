@@ -0,0 +1,108 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_PARAMMAPPING_HPP
+#define	HWM_MINIVSTEFFECT_DSP_PARAMMAPPING_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+//! プラグインのパラメータ(0.0 ~ 1.0)から、フィルタの設計に使う値への写像と、プリセット
+//! VST SDKに依存しないので、プラグインのdefinesとベンチマーク、mve_renderがこれを使う
+
+//! パラメータと正規化周波数
+//! 0.x(30Hz) <= value <= 0.5
+inline
+double	param_to_cutoff	(double value, double sampling_rate)
+{
+	double const E = 10.0;
+	double const e_range = E - 1.0;
+
+	double const f_E = std::pow(E, value);
+	double const norm_f_E = (f_E - 1) / e_range;
+
+	double const freq_range_reduce	= 75.0 / (sampling_rate / 2.0);
+	double const min_freq			= 30.0 / (sampling_rate / 2.0);
+	return
+		(norm_f_E / 2.0)	//0.0~0.5
+		* (1-freq_range_reduce)		//0.0~0.4X(-75Hz)
+		+ min_freq / 2.0;			//0.X(30Hz)~0.4X
+}
+
+//! パラメータとQ
+//! 0.3 - 18.0
+inline
+double	param_to_Q		(double value)
+{
+	double const q_range = 18.0 - 0.3;
+	return
+		(value * q_range) + 0.3;
+}
+
+//! パラメータとdB
+inline
+double	param_to_db		(double value)
+{
+	return 20.0 * std::log10(value * 4.0);
+}
+
+//! dBとパラメータ
+inline
+double	db_to_param		(double dB)
+{
+	return std::pow(10.0, dB / 20.0) / 4.0;
+}
+
+//! CoeffTable::buildに渡す写像
+struct ParamMapping
+{
+	double	sampling_rate_;
+
+	double	cutoff	(double param) const
+	{
+		return param_to_cutoff(param, sampling_rate_);
+	}
+
+	double	db_gain	(double param) const
+	{
+		return param_to_db(param);
+	}
+};
+
+enum {
+	//! プラグインのプリセットの数
+	kNumPresets = 8
+};
+
+//! プラグインのプリセットの、フィルタの設定
+//! 値はパラメータ(0.0 ~ 1.0)。mve_renderもこれを使い、プラグインと同じ設定で処理する
+struct PresetParams
+{
+	char const *	name_;
+	//! FilterTypeのいずれか
+	size_t			filter_type_;
+	double			cutoff_;
+	double			db_gain_;
+	double			Q_;
+};
+
+inline
+PresetParams const &
+		get_preset_params	(size_t index)
+{
+	//! ゲインを使うタイプは0dB(db_to_param(0.0) == 0.25)、使わないタイプは0.0
+	static PresetParams const presets[kNumPresets] = {
+		{ "Low Pass Filter",		FilterType::LPF,		0.5, 0.0,	0.0 },
+		{ "High Pass Filter",		FilterType::HPF,		0.5, 0.0,	0.0 },
+		{ "Band Pass Filter",		FilterType::BPF,		0.5, 0.0,	0.0 },
+		{ "notch Filter",			FilterType::notch,		0.5, 0.0,	0.0 },
+		{ "All-Pass Filter",		FilterType::APF,		0.5, 0.0,	0.0 },
+		{ "peaking EQ",				FilterType::PeakingEQ,	0.5, 0.25,	0.0 },
+		{ "Low Shelving Filter",	FilterType::LowShelf,	0.5, 0.25,	0.0 },
+		{ "High Shelving Filter",	FilterType::HighShelf,	0.5, 0.25,	0.0 },
+	};
+	return presets[index];
+}
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_PARAMMAPPING_HPP
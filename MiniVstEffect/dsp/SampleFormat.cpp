@@ -0,0 +1,321 @@
+#include "./SampleFormat.hpp"
+#include "./CpuFeatures.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if HWM_DSP_X86_SIMD
+	#include <emmintrin.h>
+#endif
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+typedef unsigned char	byte_t;
+
+float const	kInt16Scale		= 1.0f / 32768.0f;
+float const	kInt24Scale		= 1.0f / 8388608.0f;
+float const	kInt32Scale		= 1.0f / 2147483648.0f;
+
+//! floatで表せる2^31未満の最大の値
+//! これより大きい値をint32に変換すると0x80000000になってしまう
+float const	kInt32Max		= 2147483520.0f;
+
+int		read_int16	(byte_t const *p)
+{
+	return static_cast<short>(p[0] | (p[1] << 8));
+}
+
+int		read_int24	(byte_t const *p)
+{
+	unsigned int const u =
+		(static_cast<unsigned int>(p[0]) << 8) |
+		(static_cast<unsigned int>(p[1]) << 16) |
+		(static_cast<unsigned int>(p[2]) << 24);
+	return static_cast<int>(u) >> 8;
+}
+
+int		read_int32	(byte_t const *p)
+{
+	unsigned int const u =
+		static_cast<unsigned int>(p[0]) |
+		(static_cast<unsigned int>(p[1]) << 8) |
+		(static_cast<unsigned int>(p[2]) << 16) |
+		(static_cast<unsigned int>(p[3]) << 24);
+	return static_cast<int>(u);
+}
+
+void	write_bytes	(byte_t *p, int value, size_t num_bytes)
+{
+	unsigned int const u = static_cast<unsigned int>(value);
+	for(size_t i = 0; i < num_bytes; ++i) {
+		p[i] = static_cast<byte_t>(u >> (i * 8));
+	}
+}
+
+//! 2^(bits-1)倍して最近接に丸め、[lo, hi]に飽和させる
+//! SIMDの経路と同じく、丸めは現在の丸めモード(既定では偶数丸め)に従う
+int		to_int		(float x, float scale, float lo, float hi)
+{
+	float v = x * scale;
+	v = (v < hi) ? v : hi;
+	v = (v > lo) ? v : lo;
+	return static_cast<int>(std::lrint(v));
+}
+
+//! SIMDの経路で処理しきれなかった末尾も、これらの関数で変換する
+void	decode_scalar	(size_t format, byte_t const *src, float *dst, size_t n)
+{
+	switch(format) {
+		case SampleFormat::Int16:
+			for(size_t i = 0; i < n; ++i) {
+				dst[i] = read_int16(src + i * 2) * kInt16Scale;
+			}
+			break;
+		case SampleFormat::Int24:
+			for(size_t i = 0; i < n; ++i) {
+				dst[i] = read_int24(src + i * 3) * kInt24Scale;
+			}
+			break;
+		case SampleFormat::Int32:
+			for(size_t i = 0; i < n; ++i) {
+				dst[i] = read_int32(src + i * 4) * kInt32Scale;
+			}
+			break;
+		case SampleFormat::Float32:
+			//! ホストのfloatがリトルエンディアンのIEEE754であることを前提にする
+			std::memcpy(dst, src, n * sizeof(float));
+			break;
+		default:
+			assert(false);
+	}
+}
+
+void	encode_scalar	(size_t format, float const *src, byte_t *dst, size_t n)
+{
+	switch(format) {
+		case SampleFormat::Int16:
+			for(size_t i = 0; i < n; ++i) {
+				write_bytes(dst + i * 2, to_int(src[i], 32768.0f, -32768.0f, 32767.0f), 2);
+			}
+			break;
+		case SampleFormat::Int24:
+			for(size_t i = 0; i < n; ++i) {
+				write_bytes(dst + i * 3, to_int(src[i], 8388608.0f, -8388608.0f, 8388607.0f), 3);
+			}
+			break;
+		case SampleFormat::Int32:
+			for(size_t i = 0; i < n; ++i) {
+				write_bytes(dst + i * 4, to_int(src[i], 2147483648.0f, -2147483648.0f, kInt32Max), 4);
+			}
+			break;
+		case SampleFormat::Float32:
+			std::memcpy(dst, src, n * sizeof(float));
+			break;
+		default:
+			assert(false);
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+//! x86はリトルエンディアンなので、ファイルのバイト列をそのままレジスタに読み込める
+
+//! 処理したサンプル数を返す。残りはdecode_scalarで処理する
+size_t	decode_sse2		(size_t format, byte_t const *src, float *dst, size_t n)
+{
+	size_t i = 0;
+	switch(format) {
+		case SampleFormat::Int16: {
+			__m128 const scale = _mm_set1_ps(kInt16Scale);
+			for( ; i + 8 <= n; i += 8) {
+				__m128i const x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 2));
+				//! 上位16bitに置いてから算術シフトで符号拡張する
+				__m128i const lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+				__m128i const hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+				_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+				_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+			}
+			break;
+		}
+		case SampleFormat::Int24: {
+			//! 3バイトおきに4バイトずつ読み、8bit左シフトして上位24bitに置く
+			//! 最後のサンプルを読むときに1バイト先まで読むので、最後の1サンプルはスカラーで処理する
+			__m128 const scale = _mm_set1_ps(kInt32Scale);
+			for( ; i + 5 <= n; i += 4) {
+				byte_t const *p = src + i * 3;
+				int w[4];
+				std::memcpy(&w[0], p, 4);
+				std::memcpy(&w[1], p + 3, 4);
+				std::memcpy(&w[2], p + 6, 4);
+				std::memcpy(&w[3], p + 9, 4);
+				__m128i const x = _mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(w)), 8);
+				_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+			}
+			break;
+		}
+		case SampleFormat::Int32: {
+			__m128 const scale = _mm_set1_ps(kInt32Scale);
+			for( ; i + 8 <= n; i += 8) {
+				__m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 4));
+				__m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 4 + 16));
+				_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+				_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+			}
+			break;
+		}
+	}
+	return i;
+}
+
+//! 2^(bits-1)倍して[lo, hi]に飽和させてから、整数に変換する
+__m128i	to_int_sse2		(float const *src, __m128 scale, __m128 lo, __m128 hi)
+{
+	__m128 v = _mm_mul_ps(_mm_loadu_ps(src), scale);
+	v = _mm_max_ps(_mm_min_ps(v, hi), lo);
+	return _mm_cvtps_epi32(v);
+}
+
+size_t	encode_sse2		(size_t format, float const *src, byte_t *dst, size_t n)
+{
+	size_t i = 0;
+	switch(format) {
+		case SampleFormat::Int16: {
+			__m128 const scale = _mm_set1_ps(32768.0f);
+			__m128 const lo = _mm_set1_ps(-32768.0f);
+			__m128 const hi = _mm_set1_ps(32767.0f);
+			for( ; i + 8 <= n; i += 8) {
+				__m128i const a = to_int_sse2(src + i, scale, lo, hi);
+				__m128i const b = to_int_sse2(src + i + 4, scale, lo, hi);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2), _mm_packs_epi32(a, b));
+			}
+			break;
+		}
+		case SampleFormat::Int24: {
+			//! SSE2にはバイト単位のシャッフルがないので、64bitのレーンごとに
+			//! 奇数番目のサンプルを8bit右にずらして、2サンプルを下位48bitに詰める
+			__m128 const scale = _mm_set1_ps(8388608.0f);
+			__m128 const lo = _mm_set1_ps(-8388608.0f);
+			__m128 const hi = _mm_set1_ps(8388607.0f);
+			__m128i const mask24 = _mm_set1_epi32(0xFFFFFF);
+			__m128i const mask_even = _mm_set_epi32(0, -1, 0, -1);
+			for( ; i + 4 <= n; i += 4) {
+				__m128i const x = _mm_and_si128(to_int_sse2(src + i, scale, lo, hi), mask24);
+				__m128i const even = _mm_and_si128(x, mask_even);
+				__m128i const odd = _mm_srli_epi64(_mm_andnot_si128(mask_even, x), 8);
+				unsigned char packed[16];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(packed), _mm_or_si128(even, odd));
+				std::memcpy(dst + i * 3, packed, 6);
+				std::memcpy(dst + i * 3 + 6, packed + 8, 6);
+			}
+			break;
+		}
+		case SampleFormat::Int32: {
+			__m128 const scale = _mm_set1_ps(2147483648.0f);
+			__m128 const lo = _mm_set1_ps(-2147483648.0f);
+			__m128 const hi = _mm_set1_ps(kInt32Max);
+			for( ; i + 4 <= n; i += 4) {
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), to_int_sse2(src + i, scale, lo, hi));
+			}
+			break;
+		}
+	}
+	return i;
+}
+
+#endif
+
+}	//unnamed namespace
+
+size_t	get_sample_size		(size_t format)
+{
+	switch(format) {
+		case SampleFormat::Int16:
+			return 2;
+		case SampleFormat::Int24:
+			return 3;
+		case SampleFormat::Int32:
+		case SampleFormat::Float32:
+			return 4;
+	}
+	return 0;
+}
+
+void	decode_samples		(size_t format, void const *src, float *dst, size_t n)
+{
+	byte_t const *p = static_cast<byte_t const *>(src);
+	size_t i = 0;
+#if HWM_DSP_X86_SIMD
+	if(get_simd_level() >= SimdLevel::SSE2) {
+		i = decode_sse2(format, p, dst, n);
+	}
+#endif
+	decode_scalar(format, p + i * get_sample_size(format), dst + i, n - i);
+}
+
+void	encode_samples		(size_t format, float const *src, void *dst, size_t n)
+{
+	byte_t *p = static_cast<byte_t *>(dst);
+	size_t i = 0;
+#if HWM_DSP_X86_SIMD
+	if(get_simd_level() >= SimdLevel::SSE2) {
+		i = encode_sse2(format, src, p, n);
+	}
+#endif
+	encode_scalar(format, src + i, p + i * get_sample_size(format), n - i);
+}
+
+void	deinterleave		(float const *src, size_t num_channels,
+							 float * const *dst, size_t num_frames)
+{
+	if(num_channels == 1) {
+		std::memcpy(dst[0], src, num_frames * sizeof(float));
+		return;
+	}
+
+	size_t i = 0;
+#if HWM_DSP_X86_SIMD
+	if(num_channels == 2 && get_simd_level() >= SimdLevel::SSE2) {
+		for( ; i + 4 <= num_frames; i += 4) {
+			__m128 const a = _mm_loadu_ps(src + i * 2);
+			__m128 const b = _mm_loadu_ps(src + i * 2 + 4);
+			_mm_storeu_ps(dst[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(dst[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	}
+#endif
+	for( ; i < num_frames; ++i) {
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			dst[ch][i] = src[i * num_channels + ch];
+		}
+	}
+}
+
+void	interleave			(float const * const *src, size_t num_channels,
+							 float *dst, size_t num_frames)
+{
+	if(num_channels == 1) {
+		std::memcpy(dst, src[0], num_frames * sizeof(float));
+		return;
+	}
+
+	size_t i = 0;
+#if HWM_DSP_X86_SIMD
+	if(num_channels == 2 && get_simd_level() >= SimdLevel::SSE2) {
+		for( ; i + 4 <= num_frames; i += 4) {
+			__m128 const l = _mm_loadu_ps(src[0] + i);
+			__m128 const r = _mm_loadu_ps(src[1] + i);
+			_mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+		}
+	}
+#endif
+	for( ; i < num_frames; ++i) {
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			dst[i * num_channels + ch] = src[ch][i];
+		}
+	}
+}
+
+}}	//namespace hwm::dsp
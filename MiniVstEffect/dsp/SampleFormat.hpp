@@ -0,0 +1,43 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SAMPLEFORMAT_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SAMPLEFORMAT_HPP
+
+#include <cstddef>
+
+namespace hwm { namespace dsp {
+
+//! ファイルに格納されるサンプルの形式
+//! すべてリトルエンディアン。Int24は3バイトに詰めて格納される
+struct SampleFormat
+{
+	enum {
+		Int16,
+		Int24,
+		Int32,
+		Float32,
+		kNumSampleFormat
+	};
+};
+
+//! 1サンプルのバイト数
+size_t	get_sample_size		(size_t format);
+
+//! src(formatのサンプルがn個)を-1.0 ~ 1.0のfloatに変換する
+//! 整数は2^(bits-1)で割る。SIMDで変換する
+void	decode_samples		(size_t format, void const *src, float *dst, size_t n);
+
+//! src(floatがn個)をformatのサンプルに変換してdstに書き込む
+//! 整数へは2^(bits-1)を掛けて最近接に丸め、範囲外の値は飽和させる
+//! Float32へはそのままコピーする
+void	encode_samples		(size_t format, float const *src, void *dst, size_t n);
+
+//! インターリーブされたsrc(num_channels * num_frames)をチャンネルごとのバッファに分ける
+void	deinterleave		(float const *src, size_t num_channels,
+							 float * const *dst, size_t num_frames);
+
+//! チャンネルごとのバッファをインターリーブしてdst(num_channels * num_frames)に書き込む
+void	interleave			(float const * const *src, size_t num_channels,
+							 float *dst, size_t num_frames);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SAMPLEFORMAT_HPP
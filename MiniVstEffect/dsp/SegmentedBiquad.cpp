@@ -0,0 +1,110 @@
+#include "./SegmentedBiquad.hpp"
+#include "./Denormals.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! 打ち切りの判定をするサンプル数の間隔
+size_t const	kCheckInterval = 64;
+
+StateTransition
+		multiply	(StateTransition const &a, StateTransition const &b)
+{
+	StateTransition r;
+	for(size_t i = 0; i < 2; ++i) {
+		for(size_t j = 0; j < 2; ++j) {
+			r.m_[i][j] = a.m_[i][0] * b.m_[0][j] + a.m_[i][1] * b.m_[1][j];
+		}
+	}
+	return r;
+}
+
+//! 零入力応答を、4サンプルおきの4本の独立な系列 s[k + 4m] = A^4 s[k + 4(m-1)] として計算する
+//! 1本の漸化式は前のサンプルの結果を待つので、依存のない4本を並べてレイテンシを隠す
+template<class T>
+void	add_zero_input_response_impl	(BiquadCoeffs const &c, BiquadState const &state,
+										 T *out, size_t n, size_t stride)
+{
+	enum { kLanes = 4 };
+	StateTransition const step = make_state_transition(c, kLanes);
+
+	//! s[j] = A^j state
+	double s0[kLanes];
+	double s1[kLanes];
+	s0[0] = state.s_[0];
+	s1[0] = state.s_[1];
+	for(size_t j = 1; j < kLanes; ++j) {
+		s0[j] = s1[j - 1] - c.a1_ * s0[j - 1];
+		s1[j] = -c.a2_ * s0[j - 1];
+	}
+
+	size_t i = 0;
+	while(i + kLanes <= n) {
+		size_t const end = std::min(n - n % kLanes, i + kCheckInterval);
+		for( ; i < end; i += kLanes) {
+			for(size_t j = 0; j < kLanes; ++j) {
+				T &y = out[(i + j) * stride];
+				y = static_cast<T>(y + s0[j]);
+				double const t0 = step.m_[0][0] * s0[j] + step.m_[0][1] * s1[j];
+				double const t1 = step.m_[1][0] * s0[j] + step.m_[1][1] * s1[j];
+				s0[j] = t0;
+				s1[j] = t1;
+			}
+		}
+		//! 連続する4サンプルの状態がすべて小さければ、以降の応答もその程度の大きさに収まる
+		double peak = 0;
+		for(size_t j = 0; j < kLanes; ++j) {
+			peak = std::max(peak, std::max(std::abs(s0[j]), std::abs(s1[j])));
+		}
+		if(peak < kDenormalFlushLimit) {
+			return;
+		}
+	}
+	for(size_t j = 0; i < n; ++i, ++j) {
+		out[i * stride] = static_cast<T>(out[i * stride] + s0[j]);
+	}
+}
+
+}	//unnamed namespace
+
+StateTransition
+		make_state_transition	(BiquadCoeffs const &c, size_t n)
+{
+	StateTransition result = { { { 1.0, 0.0 }, { 0.0, 1.0 } } };
+	StateTransition power = { { { -c.a1_, 1.0 }, { -c.a2_, 0.0 } } };
+	for( ; n > 0; n >>= 1) {
+		if(n & 1) {
+			result = multiply(power, result);
+		}
+		power = multiply(power, power);
+	}
+	return result;
+}
+
+BiquadState
+		carry_state				(StateTransition const &t,
+								 BiquadState const &initial, BiquadState const &zero_state_final)
+{
+	BiquadState s;
+	for(size_t i = 0; i < 2; ++i) {
+		s.s_[i] = t.m_[i][0] * initial.s_[0] + t.m_[i][1] * initial.s_[1] + zero_state_final.s_[i];
+	}
+	return s;
+}
+
+void	add_zero_input_response	(BiquadCoeffs const &coeffs, BiquadState const &state,
+								 float *out, size_t n, size_t stride)
+{
+	add_zero_input_response_impl(coeffs, state, out, n, stride);
+}
+
+void	add_zero_input_response	(BiquadCoeffs const &coeffs, BiquadState const &state,
+								 double *out, size_t n, size_t stride)
+{
+	add_zero_input_response_impl(coeffs, state, out, n, stride);
+}
+
+}}	//namespace hwm::dsp
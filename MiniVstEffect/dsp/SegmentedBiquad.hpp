@@ -0,0 +1,52 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SEGMENTEDBIQUAD_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SEGMENTEDBIQUAD_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include <cstddef>
+
+namespace hwm { namespace dsp {
+
+//! 長い信号を区間に分け、各区間を別々のスレッドでフィルタにかけるための計算
+//!
+//! フィルタは線形なので、区間の出力は
+//!   (状態0から区間の入力を処理した出力) + (区間の先頭の状態に対する零入力応答)
+//! に分けられる。状態空間表現 s[n+1] = A s[n] + B x[n], y[n] = C s[n] + D x[n] で、
+//! 零入力応答は y[k] = C A^k s[0]、区間の長さをLとして終端の状態は A^L s[0] + (状態0から処理した終端の状態)。
+//!
+//! 1. 各区間を状態0から並列に処理し、終端の状態を記録する
+//! 2. 先頭から順にcarry_stateで各区間の先頭の状態を求める(区間あたり2x2の行列とベクトルの積)
+//! 3. 各区間の出力に、並列にadd_zero_input_responseで先頭の状態に対する応答を足す
+//!
+//! 逐次処理との差は丸め誤差の並び替え分だけになる
+
+//! 入力0で状態を進める行列 A = [[-a1, 1], [-a2, 0]] のべき
+struct StateTransition
+{
+	//! m_[i][j] : 状態の第j成分が、nサンプル後の状態の第i成分に与える寄与
+	double	m_[2][2];
+};
+
+//! A^nを計算する。二乗を繰り返すので、nが大きくてもO(log n)
+StateTransition
+		make_state_transition	(BiquadCoeffs const &coeffs, size_t n);
+
+//! 先頭の状態がinitialの区間の、終端の状態を求める
+//! @param transition 区間の長さLに対するA^L
+//! @param zero_state_final 区間を状態0から処理したときの終端の状態
+BiquadState
+		carry_state				(StateTransition const &transition,
+								 BiquadState const &initial, BiquadState const &zero_state_final);
+
+//! 状態stateに対する零入力応答 y[k] = C A^k state を、out[0] ~ out[n - 1]に足す
+//! 状態0から処理した区間の出力に足すと、stateから処理した出力になる
+//! 状態の絶対値がkDenormalFlushLimitを下回ったところで打ち切るので、
+//! 応答が減衰しきる長さより区間が長ければ、コストは区間の長さによらない
+//! strideはoutのサンプルの間隔。インターリーブされたバッファでは、outにチャンネルの位置を足してチャンネル数を渡す
+void	add_zero_input_response	(BiquadCoeffs const &coeffs, BiquadState const &state,
+								 float *out, size_t n, size_t stride = 1);
+void	add_zero_input_response	(BiquadCoeffs const &coeffs, BiquadState const &state,
+								 double *out, size_t n, size_t stride = 1);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SEGMENTEDBIQUAD_HPP
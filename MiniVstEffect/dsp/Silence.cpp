@@ -0,0 +1,111 @@
+#include "./Silence.hpp"
+#include "./BiquadKernels.hpp"
+#include "./CpuFeatures.hpp"
+#include "./SimdOps.hpp"
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! 4本のレジスタで最大を取ってから1本にまとめる
+template<class Ops>
+typename Ops::scalar_type
+		get_peak_impl	(typename Ops::scalar_type const *p, size_t n)
+{
+	typedef typename Ops::value_type V;
+	typedef typename Ops::scalar_type S;
+	enum { W = Ops::kWidth, kRegs = 4, kChunk = W * kRegs };
+
+	V peak[kRegs];
+	for(size_t r = 0; r < kRegs; ++r) {
+		peak[r] = Ops::zero();
+	}
+
+	size_t i = 0;
+	for( ; i + kChunk <= n; i += kChunk) {
+		for(size_t r = 0; r < kRegs; ++r) {
+			peak[r] = Ops::maximum(peak[r], Ops::abs(Ops::loadu(p + i + r * W)));
+		}
+	}
+	for(size_t r = 1; r < kRegs; ++r) {
+		peak[0] = Ops::maximum(peak[0], peak[r]);
+	}
+
+	S lanes[W];
+	Ops::storeu(lanes, peak[0]);
+	S result = 0;
+	for(size_t k = 0; k < W; ++k) {
+		result = ScalarOps::maximum(result, lanes[k]);
+	}
+	for( ; i < n; ++i) {
+		S const x = (p[i] < 0) ? -p[i] : p[i];
+		result = (result < x) ? x : result;
+	}
+	return result;
+}
+
+#if HWM_DSP_X86_SIMD
+
+template<class Ops>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+typename Ops::scalar_type
+		get_peak_avx	(typename Ops::scalar_type const *p, size_t n)
+{
+	return get_peak_impl<Ops>(p, n);
+}
+
+#endif
+
+template<class T>
+bool	is_silent_impl	(T const * const *channels, size_t num_channels,
+						 size_t offset, size_t n, double threshold)
+{
+	for(size_t ch = 0; ch < num_channels; ++ch) {
+		if(get_peak(channels[ch] + offset, n) > threshold) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}	//unnamed namespace
+
+float	get_peak	(float const *p, size_t n)
+{
+#if HWM_DSP_X86_SIMD
+	size_t const level = get_simd_level();
+	if(level >= SimdLevel::AVX) {
+		return get_peak_avx<AVX256FloatOps>(p, n);
+	} else if(level >= SimdLevel::SSE2) {
+		return get_peak_impl<SSEFloatOps>(p, n);
+	}
+#endif
+	return get_peak_impl<ScalarFloatOps>(p, n);
+}
+
+double	get_peak	(double const *p, size_t n)
+{
+#if HWM_DSP_X86_SIMD
+	size_t const level = get_simd_level();
+	if(level >= SimdLevel::AVX) {
+		return get_peak_avx<AVX256Ops>(p, n);
+	} else if(level >= SimdLevel::SSE2) {
+		return get_peak_impl<SSE2Ops>(p, n);
+	}
+#endif
+	return get_peak_impl<ScalarOps>(p, n);
+}
+
+bool	is_silent	(float const * const *channels, size_t num_channels,
+					 size_t offset, size_t n, double threshold)
+{
+	return is_silent_impl(channels, num_channels, offset, n, threshold);
+}
+
+bool	is_silent	(double const * const *channels, size_t num_channels,
+					 size_t offset, size_t n, double threshold)
+{
+	return is_silent_impl(channels, num_channels, offset, n, threshold);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,22 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SILENCE_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SILENCE_HPP
+
+#include <cstddef>
+
+namespace hwm { namespace dsp {
+
+//! p[0] ~ p[n - 1]の絶対値の最大
+//! SIMDで計算する
+float	get_peak	(float const *p, size_t n);
+double	get_peak	(double const *p, size_t n);
+
+//! 各チャンネルのoffsetサンプル目からnサンプル分が、すべて絶対値threshold以下かどうか
+//! 無音でないチャンネルが見つかった時点で打ち切る
+bool	is_silent	(float const * const *channels, size_t num_channels,
+					 size_t offset, size_t n, double threshold);
+bool	is_silent	(double const * const *channels, size_t num_channels,
+					 size_t offset, size_t n, double threshold);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SILENCE_HPP
@@ -0,0 +1,388 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SIMDOPS_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SIMDOPS_HPP
+
+#include "./CpuFeatures.hpp"
+#include <cstddef>
+
+#if HWM_DSP_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+//! SIMDカーネルで使う演算と、チャンネルごとのバッファとレーンの間の転置
+//! BasicScalarOpsと同じインターフェイスで、レジスタ型を扱う
+//! カーネルの翻訳単位からだけインクルードする
+//!
+//! kWidthはレーン数、load/storeはアラインされたメモリとの読み書き
+//! loadu/storeuはアラインされていないメモリとの読み書き
+
+#if HWM_DSP_X86_SIMD
+
+namespace hwm { namespace dsp {
+
+struct SSE2Ops
+{
+	typedef __m128d	value_type;
+	typedef double	scalar_type;
+	enum { kWidth = 2 };
+
+	static __m128d	set1	(double v)						{ return _mm_set1_pd(v); }
+	static __m128d	zero	()								{ return _mm_setzero_pd(); }
+	static __m128d	load	(double const *p)				{ return _mm_load_pd(p); }
+	static __m128d	loadu	(double const *p)				{ return _mm_loadu_pd(p); }
+	static void		store	(double *p, __m128d v)			{ _mm_store_pd(p, v); }
+	static void		storeu	(double *p, __m128d v)			{ _mm_storeu_pd(p, v); }
+	static __m128d	add		(__m128d a, __m128d b)			{ return _mm_add_pd(a, b); }
+	static __m128d	sub		(__m128d a, __m128d b)			{ return _mm_sub_pd(a, b); }
+	static __m128d	mul		(__m128d a, __m128d b)			{ return _mm_mul_pd(a, b); }
+	static __m128d	maximum	(__m128d a, __m128d b)			{ return _mm_max_pd(a, b); }
+	static __m128d	abs		(__m128d a)				{ return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+	static __m128d	madd	(__m128d a, __m128d b, __m128d c)	{ return _mm_add_pd(_mm_mul_pd(a, b), c); }
+	static __m128d	nmadd	(__m128d a, __m128d b, __m128d c)	{ return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+};
+
+//! FMAで依存チェーンを短くしたもの
+struct AVXOps
+{
+	typedef __m128d	value_type;
+	typedef double	scalar_type;
+	enum { kWidth = 2 };
+
+	HWM_DSP_TARGET_AVX static __m128d	set1	(double v)						{ return _mm_set1_pd(v); }
+	HWM_DSP_TARGET_AVX static __m128d	zero	()								{ return _mm_setzero_pd(); }
+	HWM_DSP_TARGET_AVX static __m128d	load	(double const *p)				{ return _mm_load_pd(p); }
+	HWM_DSP_TARGET_AVX static __m128d	loadu	(double const *p)				{ return _mm_loadu_pd(p); }
+	HWM_DSP_TARGET_AVX static void		store	(double *p, __m128d v)			{ _mm_store_pd(p, v); }
+	HWM_DSP_TARGET_AVX static void		storeu	(double *p, __m128d v)			{ _mm_storeu_pd(p, v); }
+	HWM_DSP_TARGET_AVX static __m128d	add		(__m128d a, __m128d b)			{ return _mm_add_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m128d	sub		(__m128d a, __m128d b)			{ return _mm_sub_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m128d	mul		(__m128d a, __m128d b)			{ return _mm_mul_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m128d	maximum	(__m128d a, __m128d b)			{ return _mm_max_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m128d	abs		(__m128d a)				{ return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+	HWM_DSP_TARGET_AVX static __m128d	madd	(__m128d a, __m128d b, __m128d c)	{ return _mm_fmadd_pd(a, b, c); }
+	HWM_DSP_TARGET_AVX static __m128d	nmadd	(__m128d a, __m128d b, __m128d c)	{ return _mm_fnmadd_pd(a, b, c); }
+};
+
+//! 256bit幅。4チャンネルを1本のレジスタで処理する
+struct AVX256Ops
+{
+	typedef __m256d	value_type;
+	typedef double	scalar_type;
+	enum { kWidth = 4 };
+
+	HWM_DSP_TARGET_AVX static __m256d	set1	(double v)						{ return _mm256_set1_pd(v); }
+	HWM_DSP_TARGET_AVX static __m256d	zero	()								{ return _mm256_setzero_pd(); }
+	HWM_DSP_TARGET_AVX static __m256d	load	(double const *p)				{ return _mm256_load_pd(p); }
+	HWM_DSP_TARGET_AVX static __m256d	loadu	(double const *p)				{ return _mm256_loadu_pd(p); }
+	HWM_DSP_TARGET_AVX static void		store	(double *p, __m256d v)			{ _mm256_store_pd(p, v); }
+	HWM_DSP_TARGET_AVX static void		storeu	(double *p, __m256d v)			{ _mm256_storeu_pd(p, v); }
+	HWM_DSP_TARGET_AVX static __m256d	add		(__m256d a, __m256d b)			{ return _mm256_add_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m256d	sub		(__m256d a, __m256d b)			{ return _mm256_sub_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m256d	mul		(__m256d a, __m256d b)			{ return _mm256_mul_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m256d	maximum	(__m256d a, __m256d b)			{ return _mm256_max_pd(a, b); }
+	HWM_DSP_TARGET_AVX static __m256d	abs		(__m256d a)				{ return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+	HWM_DSP_TARGET_AVX static __m256d	madd	(__m256d a, __m256d b, __m256d c)	{ return _mm256_fmadd_pd(a, b, c); }
+	HWM_DSP_TARGET_AVX static __m256d	nmadd	(__m256d a, __m256d b, __m256d c)	{ return _mm256_fnmadd_pd(a, b, c); }
+};
+
+//! StatePrecision::Float用
+struct SSEFloatOps
+{
+	typedef __m128	value_type;
+	typedef float	scalar_type;
+	enum { kWidth = 4 };
+
+	static __m128	set1	(double v)						{ return _mm_set1_ps(static_cast<float>(v)); }
+	static __m128	zero	()								{ return _mm_setzero_ps(); }
+	static __m128	load	(float const *p)				{ return _mm_load_ps(p); }
+	static __m128	loadu	(float const *p)				{ return _mm_loadu_ps(p); }
+	static void		store	(float *p, __m128 v)			{ _mm_store_ps(p, v); }
+	static void		storeu	(float *p, __m128 v)			{ _mm_storeu_ps(p, v); }
+	static __m128	add		(__m128 a, __m128 b)			{ return _mm_add_ps(a, b); }
+	static __m128	sub		(__m128 a, __m128 b)			{ return _mm_sub_ps(a, b); }
+	static __m128	mul		(__m128 a, __m128 b)			{ return _mm_mul_ps(a, b); }
+	static __m128	maximum	(__m128 a, __m128 b)			{ return _mm_max_ps(a, b); }
+	static __m128	abs		(__m128 a)				{ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static __m128	madd	(__m128 a, __m128 b, __m128 c)	{ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	static __m128	nmadd	(__m128 a, __m128 b, __m128 c)	{ return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+};
+
+struct AVXFloatOps
+{
+	typedef __m128	value_type;
+	typedef float	scalar_type;
+	enum { kWidth = 4 };
+
+	HWM_DSP_TARGET_AVX static __m128	set1	(double v)						{ return _mm_set1_ps(static_cast<float>(v)); }
+	HWM_DSP_TARGET_AVX static __m128	zero	()								{ return _mm_setzero_ps(); }
+	HWM_DSP_TARGET_AVX static __m128	load	(float const *p)				{ return _mm_load_ps(p); }
+	HWM_DSP_TARGET_AVX static __m128	loadu	(float const *p)				{ return _mm_loadu_ps(p); }
+	HWM_DSP_TARGET_AVX static void		store	(float *p, __m128 v)			{ _mm_store_ps(p, v); }
+	HWM_DSP_TARGET_AVX static void		storeu	(float *p, __m128 v)			{ _mm_storeu_ps(p, v); }
+	HWM_DSP_TARGET_AVX static __m128	add		(__m128 a, __m128 b)			{ return _mm_add_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m128	sub		(__m128 a, __m128 b)			{ return _mm_sub_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m128	mul		(__m128 a, __m128 b)			{ return _mm_mul_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m128	maximum	(__m128 a, __m128 b)			{ return _mm_max_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m128	abs		(__m128 a)				{ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	HWM_DSP_TARGET_AVX static __m128	madd	(__m128 a, __m128 b, __m128 c)	{ return _mm_fmadd_ps(a, b, c); }
+	HWM_DSP_TARGET_AVX static __m128	nmadd	(__m128 a, __m128 b, __m128 c)	{ return _mm_fnmadd_ps(a, b, c); }
+};
+
+//! 256bit幅の単精度。8チャンネルを1本のレジスタで処理する
+struct AVX256FloatOps
+{
+	typedef __m256	value_type;
+	typedef float	scalar_type;
+	enum { kWidth = 8 };
+
+	HWM_DSP_TARGET_AVX static __m256	set1	(double v)						{ return _mm256_set1_ps(static_cast<float>(v)); }
+	HWM_DSP_TARGET_AVX static __m256	zero	()								{ return _mm256_setzero_ps(); }
+	HWM_DSP_TARGET_AVX static __m256	load	(float const *p)				{ return _mm256_load_ps(p); }
+	HWM_DSP_TARGET_AVX static __m256	loadu	(float const *p)				{ return _mm256_loadu_ps(p); }
+	HWM_DSP_TARGET_AVX static void		store	(float *p, __m256 v)			{ _mm256_store_ps(p, v); }
+	HWM_DSP_TARGET_AVX static void		storeu	(float *p, __m256 v)			{ _mm256_storeu_ps(p, v); }
+	HWM_DSP_TARGET_AVX static __m256	add		(__m256 a, __m256 b)			{ return _mm256_add_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m256	sub		(__m256 a, __m256 b)			{ return _mm256_sub_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m256	mul		(__m256 a, __m256 b)			{ return _mm256_mul_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m256	maximum	(__m256 a, __m256 b)			{ return _mm256_max_ps(a, b); }
+	HWM_DSP_TARGET_AVX static __m256	abs		(__m256 a)				{ return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	HWM_DSP_TARGET_AVX static __m256	madd	(__m256 a, __m256 b, __m256 c)	{ return _mm256_fmadd_ps(a, b, c); }
+	HWM_DSP_TARGET_AVX static __m256	nmadd	(__m256 a, __m256 b, __m256 c)	{ return _mm256_fnmadd_ps(a, b, c); }
+};
+
+//! 以下のload_tileは、W個のチャンネルのiサンプル目からWサンプル分を読み込み、
+//! x[k]のレーンjがチャンネルjのi + kサンプル目になるように転置する
+//! store_tileはその逆
+//! Wはレジスタのレーン数
+
+inline
+void	load_tile	(__m128d *x, double const * const *src, size_t i)
+{
+	__m128d const r0 = _mm_loadu_pd(src[0] + i);
+	__m128d const r1 = _mm_loadu_pd(src[1] + i);
+	x[0] = _mm_unpacklo_pd(r0, r1);
+	x[1] = _mm_unpackhi_pd(r0, r1);
+}
+
+inline
+void	load_tile	(__m128d *x, float const * const *src, size_t i)
+{
+	x[0] = _mm_set_pd(src[1][i], src[0][i]);
+	x[1] = _mm_set_pd(src[1][i + 1], src[0][i + 1]);
+}
+
+inline
+void	store_tile	(__m128d const *y, double * const *dst, size_t i)
+{
+	_mm_storeu_pd(dst[0] + i, _mm_unpacklo_pd(y[0], y[1]));
+	_mm_storeu_pd(dst[1] + i, _mm_unpackhi_pd(y[0], y[1]));
+}
+
+inline
+void	store_tile	(__m128d const *y, float * const *dst, size_t i)
+{
+	//! [L(i), L(i+1), R(i), R(i+1)]
+	__m128 const v = _mm_unpacklo_ps(_mm_cvtpd_ps(y[0]), _mm_cvtpd_ps(y[1]));
+	_mm_storel_pi(reinterpret_cast<__m64 *>(dst[0] + i), v);
+	_mm_storeh_pi(reinterpret_cast<__m64 *>(dst[1] + i), v);
+}
+
+inline
+void	load_tile	(__m128 *x, float const * const *src, size_t i)
+{
+	__m128 r0 = _mm_loadu_ps(src[0] + i);
+	__m128 r1 = _mm_loadu_ps(src[1] + i);
+	__m128 r2 = _mm_loadu_ps(src[2] + i);
+	__m128 r3 = _mm_loadu_ps(src[3] + i);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	x[0] = r0; x[1] = r1; x[2] = r2; x[3] = r3;
+}
+
+inline
+__m128	load_4_as_float	(double const *p)
+{
+	return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+}
+
+inline
+void	load_tile	(__m128 *x, double const * const *src, size_t i)
+{
+	__m128 r0 = load_4_as_float(src[0] + i);
+	__m128 r1 = load_4_as_float(src[1] + i);
+	__m128 r2 = load_4_as_float(src[2] + i);
+	__m128 r3 = load_4_as_float(src[3] + i);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	x[0] = r0; x[1] = r1; x[2] = r2; x[3] = r3;
+}
+
+inline
+void	store_tile	(__m128 const *y, float * const *dst, size_t i)
+{
+	__m128 r0 = y[0], r1 = y[1], r2 = y[2], r3 = y[3];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(dst[0] + i, r0);
+	_mm_storeu_ps(dst[1] + i, r1);
+	_mm_storeu_ps(dst[2] + i, r2);
+	_mm_storeu_ps(dst[3] + i, r3);
+}
+
+inline
+void	store_4_as_double	(double *p, __m128 v)
+{
+	_mm_storeu_pd(p, _mm_cvtps_pd(v));
+	_mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+inline
+void	store_tile	(__m128 const *y, double * const *dst, size_t i)
+{
+	__m128 r0 = y[0], r1 = y[1], r2 = y[2], r3 = y[3];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	store_4_as_double(dst[0] + i, r0);
+	store_4_as_double(dst[1] + i, r1);
+	store_4_as_double(dst[2] + i, r2);
+	store_4_as_double(dst[3] + i, r3);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	transpose4	(__m256d *r)
+{
+	__m256d const t0 = _mm256_unpacklo_pd(r[0], r[1]);
+	__m256d const t1 = _mm256_unpackhi_pd(r[0], r[1]);
+	__m256d const t2 = _mm256_unpacklo_pd(r[2], r[3]);
+	__m256d const t3 = _mm256_unpackhi_pd(r[2], r[3]);
+	r[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+	r[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+	r[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+	r[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_tile	(__m256d *x, double const * const *src, size_t i)
+{
+	for(size_t k = 0; k < 4; ++k) {
+		x[k] = _mm256_loadu_pd(src[k] + i);
+	}
+	transpose4(x);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_tile	(__m256d *x, float const * const *src, size_t i)
+{
+	for(size_t k = 0; k < 4; ++k) {
+		x[k] = _mm256_cvtps_pd(_mm_loadu_ps(src[k] + i));
+	}
+	transpose4(x);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_tile	(__m256d const *y, double * const *dst, size_t i)
+{
+	__m256d r[4] = { y[0], y[1], y[2], y[3] };
+	transpose4(r);
+	for(size_t k = 0; k < 4; ++k) {
+		_mm256_storeu_pd(dst[k] + i, r[k]);
+	}
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_tile	(__m256d const *y, float * const *dst, size_t i)
+{
+	__m256d r[4] = { y[0], y[1], y[2], y[3] };
+	transpose4(r);
+	for(size_t k = 0; k < 4; ++k) {
+		_mm_storeu_ps(dst[k] + i, _mm256_cvtpd_ps(r[k]));
+	}
+}
+
+HWM_DSP_TARGET_AVX inline
+void	transpose8	(__m256 *r)
+{
+	__m256 t[8];
+	for(size_t k = 0; k < 8; k += 2) {
+		t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+		t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+	}
+
+	__m256 u[8];
+	for(size_t k = 0; k < 8; k += 4) {
+		u[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+		u[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+		u[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+		u[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	for(size_t k = 0; k < 4; ++k) {
+		r[k] = _mm256_permute2f128_ps(u[k], u[k + 4], 0x20);
+		r[k + 4] = _mm256_permute2f128_ps(u[k], u[k + 4], 0x31);
+	}
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_tile	(__m256 *x, float const * const *src, size_t i)
+{
+	for(size_t k = 0; k < 8; ++k) {
+		x[k] = _mm256_loadu_ps(src[k] + i);
+	}
+	transpose8(x);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	load_tile	(__m256 *x, double const * const *src, size_t i)
+{
+	for(size_t k = 0; k < 8; ++k) {
+		__m128 const lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src[k] + i));
+		__m128 const hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src[k] + i + 4));
+		x[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+	transpose8(x);
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_tile	(__m256 const *y, float * const *dst, size_t i)
+{
+	__m256 r[8];
+	for(size_t k = 0; k < 8; ++k) {
+		r[k] = y[k];
+	}
+	transpose8(r);
+	for(size_t k = 0; k < 8; ++k) {
+		_mm256_storeu_ps(dst[k] + i, r[k]);
+	}
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_tile	(__m256 const *y, double * const *dst, size_t i)
+{
+	__m256 r[8];
+	for(size_t k = 0; k < 8; ++k) {
+		r[k] = y[k];
+	}
+	transpose8(r);
+	for(size_t k = 0; k < 8; ++k) {
+		_mm256_storeu_pd(dst[k] + i, _mm256_cvtps_pd(_mm256_castps256_ps128(r[k])));
+		_mm256_storeu_pd(dst[k] + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(r[k], 1)));
+	}
+}
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_DSP_X86_SIMD
+
+namespace hwm { namespace dsp {
+
+//! 1チャンネル分(W = 1)のload_tile, store_tile。BasicScalarOpsで使う
+template<class S, class T>
+void	load_tile	(S *x, T const * const *src, size_t i)
+{
+	x[0] = static_cast<S>(src[0][i]);
+}
+
+template<class S, class T>
+void	store_tile	(S const *y, T * const *dst, size_t i)
+{
+	dst[0][i] = static_cast<T>(y[0]);
+}
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SIMDOPS_HPP
@@ -0,0 +1,159 @@
+#define _USE_MATH_DEFINES
+#include "./SlopeFilter.hpp"
+#include "./Denormals.hpp"
+
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! n次のButterworthの2次のセクションのQ
+//! 極の角度から 1 / (2 * sin((2k - 1) * pi / (2n)))。kが大きいほどQは小さい
+double	butterworth_Q	(size_t order, size_t k)
+{
+	return 1.0 / (2.0 * sin((2 * k - 1) * M_PI / (2 * order)));
+}
+
+}	//unnamed namespace
+
+void	get_slope_Qs	(size_t num_sections, size_t alignment, double *Q)
+{
+	if(alignment == Alignment::LinkwitzRiley) {
+		//! 2 * num_sections次のLinkwitz-Rileyは、num_sections次のButterworthの2乗
+		//! 各セクションを2回ずつ使い、num_sectionsが奇数なら1次同士の積をQ = 0.5のセクションにする
+		size_t const order = num_sections;
+		size_t i = 0;
+		if(order % 2 == 1) {
+			Q[i++] = 0.5;
+		}
+		for(size_t k = order / 2; k >= 1; --k) {
+			Q[i++] = butterworth_Q(order, k);
+			Q[i++] = butterworth_Q(order, k);
+		}
+		return;
+	}
+
+	size_t const order = num_sections * 2;
+	for(size_t k = num_sections; k >= 1; --k) {
+		Q[num_sections - k] = butterworth_Q(order, k);
+	}
+}
+
+SlopeCoeffs
+		design_slope		(size_t filter_type, double cutoff,
+							 size_t num_sections, size_t alignment)
+{
+	double const w0 = 2.0 * M_PI * cutoff;
+	return design_slope_from(filter_type, cos(w0), sin(w0), num_sections, alignment);
+}
+
+SlopeCoeffs
+		design_slope_from	(size_t filter_type, double cos_w0, double sin_w0,
+							 size_t num_sections, size_t alignment)
+{
+	if(num_sections < 1) {
+		num_sections = 1;
+	} else if(num_sections > kMaxSlopeSections) {
+		num_sections = kMaxSlopeSections;
+	}
+
+	SlopeCoeffs c;
+	c.num_sections_ = num_sections;
+
+	if(filter_type != FilterType::LPF && filter_type != FilterType::HPF) {
+		BiquadCoeffs const through = { 1.0, 0.0, 0.0, 0.0, 0.0 };
+		for(size_t i = 0; i < num_sections; ++i) {
+			c.sections_[i] = through;
+		}
+		return c;
+	}
+
+	double Q[kMaxSlopeSections];
+	get_slope_Qs(num_sections, alignment, Q);
+
+	for(size_t i = 0; i < num_sections; ++i) {
+		c.sections_[i] = design_biquad_from(filter_type, cos_w0, sin_w0, 1.0, Q[i]);
+	}
+	return c;
+}
+
+SlopeFilter::SlopeFilter	(size_t num_channels)
+	:	cascade_(num_channels, 1)
+	,	filter_type_(FilterType::kNumFilterType)
+{}
+
+void	SlopeFilter::set_coeffs	(SlopeCoeffs const &coeffs, size_t filter_type)
+{
+	if(coeffs.num_sections_ != cascade_.get_num_sections()) {
+		cascade_.set_num_sections(coeffs.num_sections_);
+	}
+	cascade_.ramp_sections(coeffs.sections_, 0);
+	filter_type_ = filter_type;
+}
+
+size_t	SlopeFilter::get_filter_type	() const
+{
+	return filter_type_;
+}
+
+void	SlopeFilter::ramp_coeffs	(SlopeCoeffs const &coeffs, size_t filter_type,
+								 size_t num_samples)
+{
+	if(coeffs.num_sections_ != cascade_.get_num_sections()) {
+		set_coeffs(coeffs, filter_type);
+		return;
+	}
+
+	cascade_.ramp_sections(coeffs.sections_, num_samples);
+	filter_type_ = filter_type;
+}
+
+size_t	SlopeFilter::get_ramp_remaining	() const
+{
+	return cascade_.get_ramp_remaining();
+}
+
+void	SlopeFilter::clear_buffer	()
+{
+	cascade_.clear_buffer();
+}
+
+void	SlopeFilter::flush_denormals	()
+{
+	cascade_.flush_denormals();
+}
+
+size_t	SlopeFilter::get_num_channels	() const
+{
+	return cascade_.get_num_channels();
+}
+
+void	SlopeFilter::set_num_channels	(size_t num_channels)
+{
+	cascade_.set_num_channels(num_channels);
+}
+
+void	SlopeFilter::process_block	(float const * const *in, float * const *out, size_t n)
+{
+	cascade_.process_block(in, out, n);
+}
+
+void	SlopeFilter::process_block	(double const * const *in, double * const *out, size_t n)
+{
+	cascade_.process_block(in, out, n);
+}
+
+void	SlopeFilter::process_block	(float const * const *in, float * const *out,
+								 size_t offset, size_t n)
+{
+	cascade_.process_block(in, out, offset, n);
+}
+
+void	SlopeFilter::process_block	(double const * const *in, double * const *out,
+								 size_t offset, size_t n)
+{
+	cascade_.process_block(in, out, offset, n);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,98 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SLOPEFILTER_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SLOPEFILTER_HPP
+
+#include "./BiquadCascade.hpp"
+
+namespace hwm { namespace dsp {
+
+//! 高次のLPF, HPFの特性
+//!   Butterworth   : 通過域が最も平坦。カットオフで-3dB
+//!   LinkwitzRiley : 同じ次数のButterworthの半分の次数を2回通したもの。カットオフで-6dB
+//!                   LPFとHPFの和が全域通過になるので、クロスオーバーに使う
+struct Alignment
+{
+	enum {
+		Butterworth,
+		LinkwitzRiley,
+		kNumAlignment
+	};
+};
+
+enum {
+	//! 縦続接続するセクション数の上限。1セクションごとに12dB/oct
+	kMaxSlopeSections = 8
+};
+
+//! 縦続接続の各セクションの係数
+struct SlopeCoeffs
+{
+	size_t			num_sections_;
+	BiquadCoeffs	sections_[kMaxSlopeSections];
+};
+
+//! 各セクションのQを計算する
+//! Qの小さいセクションから順に並べる。前のセクションでピークを作らないため
+//! @param num_sections 1 ~ kMaxSlopeSections。傾きは12dB/oct * num_sections
+//! @param Q num_sections個のQを受け取る
+void	get_slope_Qs	(size_t num_sections, size_t alignment, double *Q);
+
+//! 12dB/oct * num_sectionsの傾きのLPF, HPFを、2次のセクションの縦続接続として設計する
+//! LPF, HPF以外のフィルタタイプでは素通し
+//! @param cutoff 正規化周波数(0.0 ~ 0.5)
+SlopeCoeffs
+		design_slope		(size_t filter_type, double cutoff,
+							 size_t num_sections, size_t alignment);
+
+//! design_slopeのうち、三角関数を計算した後の部分
+//! @param cos_w0, sin_w0 w0 = 2 * pi * cutoff の余弦と正弦
+SlopeCoeffs
+		design_slope_from	(size_t filter_type, double cos_w0, double sin_w0,
+							 size_t num_sections, size_t alignment);
+
+//! 高次のLPF, HPF
+//! Biquadと同じインターフェイスで、SmoothedFilterから使えるようにしてある
+//! 全セクションはBiquadCascadeで1パスで処理する
+struct SlopeFilter
+{
+	explicit
+	SlopeFilter		(size_t num_channels);
+
+	//! セクション数が変わる場合は、遅延子もクリアされる
+	void	set_coeffs			(SlopeCoeffs const &coeffs, size_t filter_type);
+	size_t	get_filter_type		() const;
+
+	//! 係数を、process_blockのnum_samplesサンプルをかけて現在の値からcoeffsまで線形に変化させる
+	//! セクション数が変わる場合は補間できないので、set_coeffsと同じになる
+	void	ramp_coeffs			(SlopeCoeffs const &coeffs, size_t filter_type,
+								 size_t num_samples);
+	size_t	get_ramp_remaining	() const;
+
+	//! 遅延子をクリア
+	void	clear_buffer		();
+	//! 絶対値がkDenormalFlushLimit未満の遅延子を0にする
+	//! FTZ, DAZを設定できない環境で、非正規化数での演算を避けるためにブロックの境界で呼び出す
+	void	flush_denormals		();
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。遅延子はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! 全チャンネルをまとめて処理する
+	void	process_block		(float const * const *in, float * const *out, size_t n);
+	void	process_block		(double const * const *in, double * const *out, size_t n);
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	void	process_block		(float const * const *in, float * const *out,
+								 size_t offset, size_t n);
+	void	process_block		(double const * const *in, double * const *out,
+								 size_t offset, size_t n);
+
+private:
+	BiquadCascade	cascade_;
+	size_t			filter_type_;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SLOPEFILTER_HPP
@@ -0,0 +1,184 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SMOOTHEDCASCADE_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SMOOTHEDCASCADE_HPP
+
+#include "./BiquadCascade.hpp"
+#include "./SmoothedFilter.hpp"
+
+namespace hwm { namespace dsp {
+
+//! バンドごとのパラメータを滑らかに変化させるマルチバンドのイコライザ
+//!
+//! 各バンドがBiquadCascadeの1セクションになる。SmoothedFilterと同じく、
+//! 制御周期ごとに係数を再計算してその間を線形補間する。
+//! 再計算するのは変化しているバンドだけで、他のバンドは前回の係数をそのまま使う。
+//!
+//! パラメータから係数への変換は、process_blockに渡すdesignで行う
+//!   BiquadCoeffs design(size_t filter_type, double cutoff, double gain, double Q) const
+struct SmoothedCascade
+{
+	enum {
+		kDefaultControlInterval = 32
+	};
+
+	explicit
+	SmoothedCascade	(size_t num_channels, size_t num_bands = 1)
+		:	filter_(num_channels, num_bands)
+		,	control_interval_(kDefaultControlInterval)
+		,	smoothing_length_(0)
+		,	needs_reset_(true)
+	{
+		for(size_t k = 0; k < kMaxCascadeSections; ++k) {
+			bands_[k].filter_type_ = kGenericKernel;
+		}
+	}
+
+	BiquadCascade &			get_filter		()			{ return filter_; }
+	BiquadCascade const &	get_filter		() const	{ return filter_; }
+
+	//! バンド数を変更する。1 ~ kMaxCascadeSections
+	//! 遅延子はクリアされ、次のprocess_blockで全バンドの係数を再計算する
+	void	set_num_bands			(size_t num_bands)
+	{
+		filter_.set_num_sections(num_bands);
+		needs_reset_ = true;
+	}
+
+	size_t	get_num_bands			() const	{ return filter_.get_num_sections(); }
+
+	//! 係数を再計算する間隔(サンプル数)。1以上
+	void	set_control_interval	(size_t interval)
+	{
+		control_interval_ = (interval > 0) ? interval : 1;
+	}
+
+	size_t	get_control_interval	() const	{ return control_interval_; }
+
+	//! 目標値に達するまでのサンプル数。0なら変化させない
+	void	set_smoothing_length	(size_t length)	{ smoothing_length_ = length; }
+	size_t	get_smoothing_length	() const		{ return smoothing_length_; }
+
+	//! バンドの目標値を設定する
+	//! フィルタタイプが変わる場合は補間できないので、変化させずに切り替える
+	void	set_band_params			(size_t band, size_t filter_type,
+									 double cutoff, double gain, double Q)
+	{
+		Band &b = bands_[band];
+		if(filter_type != b.filter_type_) {
+			reset_band_params(band, filter_type, cutoff, gain, Q);
+			return;
+		}
+
+		b.cutoff_.set_target(cutoff, smoothing_length_);
+		b.gain_.set_target(gain, smoothing_length_);
+		b.Q_.set_target(Q, smoothing_length_);
+
+		if(!b.is_smoothing()) {
+			needs_reset_ = true;
+		}
+	}
+
+	//! 変化させずにバンドのパラメータを設定し、次のprocess_blockで係数を再計算する
+	void	reset_band_params		(size_t band, size_t filter_type,
+									 double cutoff, double gain, double Q)
+	{
+		Band &b = bands_[band];
+		b.filter_type_ = filter_type;
+		b.cutoff_.reset(cutoff);
+		b.gain_.reset(gain);
+		b.Q_.reset(Q);
+		needs_reset_ = true;
+	}
+
+	bool	is_smoothing			() const
+	{
+		for(size_t k = 0; k < get_num_bands(); ++k) {
+			if(bands_[k].is_smoothing()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//! 全チャンネルをまとめて処理する
+	template<class Designer, class T>
+	void	process_block			(Designer const &design,
+									 T const * const *in, T * const *out, size_t n)
+	{
+		process_block(design, in, out, 0, n);
+	}
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	//! ブロックの途中でset_band_paramsを呼ぶときは、その位置でブロックを分けて呼び出す
+	template<class Designer, class T>
+	void	process_block			(Designer const &design,
+									 T const * const *in, T * const *out,
+									 size_t offset, size_t n)
+	{
+		size_t const num_bands = get_num_bands();
+		size_t pos = offset;
+		size_t const end = offset + n;
+
+		if(needs_reset_) {
+			needs_reset_ = false;
+			for(size_t k = 0; k < num_bands; ++k) {
+				coeffs_[k] = bands_[k].design_current(design);
+				filter_.set_section(k, coeffs_[k]);
+			}
+		}
+
+		//! 制御周期ごとに区切り、変化しているバンドだけ区間の終わりの係数を計算し直す
+		while(pos < end && is_smoothing()) {
+			size_t const m = (end - pos < control_interval_) ? (end - pos) : control_interval_;
+			for(size_t k = 0; k < num_bands; ++k) {
+				Band &b = bands_[k];
+				if(b.is_smoothing()) {
+					b.cutoff_.advance(m);
+					b.gain_.advance(m);
+					b.Q_.advance(m);
+					coeffs_[k] = b.design_current(design);
+				}
+			}
+
+			filter_.ramp_sections(coeffs_, m);
+			filter_.process_block(in, out, pos, m);
+			pos += m;
+		}
+
+		if(pos < end) {
+			filter_.process_block(in, out, pos, end - pos);
+		}
+	}
+
+private:
+	struct Band
+	{
+		size_t			filter_type_;
+		LinearSmoother	cutoff_;
+		LinearSmoother	gain_;
+		LinearSmoother	Q_;
+
+		bool	is_smoothing	() const
+		{
+			return cutoff_.is_ramping() || gain_.is_ramping() || Q_.is_ramping();
+		}
+
+		template<class Designer>
+		BiquadCoeffs
+				design_current	(Designer const &design) const
+		{
+			return design(filter_type_, cutoff_.get_value(), gain_.get_value(), Q_.get_value());
+		}
+	};
+
+	BiquadCascade	filter_;
+	Band			bands_[kMaxCascadeSections];
+	//! 各バンドの最後に計算した係数
+	BiquadCoeffs	coeffs_[kMaxCascadeSections];
+	size_t			control_interval_;
+	size_t			smoothing_length_;
+	bool			needs_reset_;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SMOOTHEDCASCADE_HPP
@@ -0,0 +1,200 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SMOOTHEDFILTER_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SMOOTHEDFILTER_HPP
+
+#include "./Biquad.hpp"
+#include "./SlopeFilter.hpp"
+#include "./Svf.hpp"
+
+namespace hwm { namespace dsp {
+
+//! 目標値まで一定のサンプル数をかけて直線的に変化する値
+struct LinearSmoother
+{
+	LinearSmoother	()
+		:	value_(0)
+		,	target_(0)
+		,	step_(0)
+		,	remaining_(0)
+	{}
+
+	//! 変化させずに値を設定する
+	void	reset		(double value)
+	{
+		value_ = target_ = value;
+		step_ = 0;
+		remaining_ = 0;
+	}
+
+	//! 現在の値からlengthサンプルかけてvalueまで変化させる
+	void	set_target	(double value, size_t length)
+	{
+		if(length == 0) {
+			reset(value);
+			return;
+		}
+		target_ = value;
+		step_ = (target_ - value_) / length;
+		remaining_ = length;
+	}
+
+	//! nサンプル進めた値を返す
+	double	advance		(size_t n)
+	{
+		if(n >= remaining_) {
+			value_ = target_;
+			remaining_ = 0;
+		} else {
+			value_ += step_ * n;
+			remaining_ -= n;
+		}
+		return value_;
+	}
+
+	double	get_value	() const	{ return value_; }
+	double	get_target	() const	{ return target_; }
+	bool	is_ramping	() const	{ return remaining_ > 0; }
+
+private:
+	double	value_;
+	double	target_;
+	double	step_;
+	size_t	remaining_;
+};
+
+//! パラメータを滑らかに変化させるフィルタ
+//!
+//! カットオフ、ゲイン、Qの3つのパラメータを、設定されたサンプル数をかけて目標値まで変化させる。
+//! 係数の再計算は制御周期(control interval)ごとに行い、その間の係数はFilter::ramp_coeffsで
+//! 1サンプルずつ線形補間する。制御周期を短くすると滑らかになり、長くすると軽くなる。
+//!
+//! FilterはBiquad, Svf, SlopeFilterのいずれか。パラメータから係数への変換は、process_blockに渡すdesignで行う
+//!   Coeffs design(size_t filter_type, double cutoff, double gain, double Q) const
+//! CoeffTable::design, CoeffTable::design_svfを使えば、制御周期ごとの再計算はテーブル参照だけになる
+template<class Filter>
+struct SmoothedFilter
+{
+	enum {
+		kDefaultControlInterval = 32
+	};
+
+	explicit
+	SmoothedFilter	(size_t num_channels)
+		:	filter_(num_channels)
+		,	filter_type_(kGenericKernel)
+		,	control_interval_(kDefaultControlInterval)
+		,	smoothing_length_(0)
+		,	needs_reset_(false)
+	{}
+
+	Filter &			get_filter			()			{ return filter_; }
+	Filter const &		get_filter			() const	{ return filter_; }
+
+	//! 係数を再計算する間隔(サンプル数)。1以上
+	void	set_control_interval	(size_t interval)
+	{
+		control_interval_ = (interval > 0) ? interval : 1;
+	}
+
+	size_t	get_control_interval	() const	{ return control_interval_; }
+
+	//! 目標値に達するまでのサンプル数。0なら変化させない
+	void	set_smoothing_length	(size_t length)	{ smoothing_length_ = length; }
+	size_t	get_smoothing_length	() const		{ return smoothing_length_; }
+
+	//! 目標値を設定する
+	//! フィルタタイプが変わる場合は補間できないので、変化させずに切り替える
+	void	set_params				(size_t filter_type, double cutoff, double gain, double Q)
+	{
+		if(filter_type != filter_type_) {
+			reset_params(filter_type, cutoff, gain, Q);
+			return;
+		}
+
+		cutoff_.set_target(cutoff, smoothing_length_);
+		gain_.set_target(gain, smoothing_length_);
+		Q_.set_target(Q, smoothing_length_);
+
+		//! 変化させない場合は、次のブロックの先頭で係数を計算し直す
+		if(!is_smoothing()) {
+			needs_reset_ = true;
+		}
+	}
+
+	//! 変化させずにパラメータを設定し、次のprocess_blockで係数を再計算する
+	void	reset_params			(size_t filter_type, double cutoff, double gain, double Q)
+	{
+		filter_type_ = filter_type;
+		cutoff_.reset(cutoff);
+		gain_.reset(gain);
+		Q_.reset(Q);
+		needs_reset_ = true;
+	}
+
+	bool	is_smoothing			() const
+	{
+		return cutoff_.is_ramping() || gain_.is_ramping() || Q_.is_ramping();
+	}
+
+	//! 全チャンネルをまとめて処理する
+	template<class Designer, class T>
+	void	process_block			(Designer const &design,
+									 T const * const *in, T * const *out, size_t n)
+	{
+		process_block(design, in, out, 0, n);
+	}
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	//! ブロックの途中でset_paramsを呼ぶときは、その位置でブロックを分けて呼び出す。
+	//! 係数の再計算は分けた位置から始まる
+	template<class Designer, class T>
+	void	process_block			(Designer const &design,
+									 T const * const *in, T * const *out,
+									 size_t offset, size_t n)
+	{
+		size_t pos = offset;
+		size_t const end = offset + n;
+
+		if(needs_reset_) {
+			needs_reset_ = false;
+			filter_.set_coeffs(
+				design(filter_type_, cutoff_.get_value(), gain_.get_value(), Q_.get_value()),
+				filter_type_);
+		}
+
+		//! 制御周期ごとに区切り、区間の終わりの係数に向けて補間する
+		while(pos < end && is_smoothing()) {
+			size_t const m = (end - pos < control_interval_) ? (end - pos) : control_interval_;
+			cutoff_.advance(m);
+			gain_.advance(m);
+			Q_.advance(m);
+
+			filter_.ramp_coeffs(
+				design(filter_type_, cutoff_.get_value(), gain_.get_value(), Q_.get_value()),
+				filter_type_, m);
+			filter_.process_block(in, out, pos, m);
+			pos += m;
+		}
+
+		if(pos < end) {
+			filter_.process_block(in, out, pos, end - pos);
+		}
+	}
+
+private:
+	Filter			filter_;
+	size_t			filter_type_;
+	LinearSmoother	cutoff_;
+	LinearSmoother	gain_;
+	LinearSmoother	Q_;
+	size_t			control_interval_;
+	size_t			smoothing_length_;
+	bool			needs_reset_;
+};
+
+typedef SmoothedFilter<Biquad>		SmoothedBiquad;
+typedef SmoothedFilter<Svf>			SmoothedSvf;
+typedef SmoothedFilter<SlopeFilter>	SmoothedSlopeFilter;
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SMOOTHEDFILTER_HPP
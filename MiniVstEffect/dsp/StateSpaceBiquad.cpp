@@ -0,0 +1,265 @@
+#include "./StateSpaceBiquad.hpp"
+#include "./CpuFeatures.hpp"
+
+#if HWM_DSP_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+namespace hwm { namespace dsp {
+
+StateSpaceCoeffs
+		make_state_space	(BiquadCoeffs const &c)
+{
+	size_t const K = StateSpaceCoeffs::kBlockSize;
+
+	//! A = [[-a1, 1], [-a2, 0]], B = [b1 - a1*b0, b2 - a2*b0], C = [1, 0], D = b0
+	double const A[2][2] = { { -c.a1_, 1.0 }, { -c.a2_, 0.0 } };
+	double const B[2] = { c.b1_ - c.a1_ * c.b0_, c.b2_ - c.a2_ * c.b0_ };
+
+	//! インパルス応答 h[0] = D, h[m] = C A^(m-1) B
+	//! 同時に A^m B (m = 0 ~ K-1) と A^m (m = 0 ~ K) を求めておく
+	double AmB[K][2];
+	double Am[K+1][2][2];
+	double h[K];
+
+	Am[0][0][0] = 1.0; Am[0][0][1] = 0.0;
+	Am[0][1][0] = 0.0; Am[0][1][1] = 1.0;
+	for(size_t m = 1; m <= K; ++m) {
+		for(size_t i = 0; i < 2; ++i) {
+			for(size_t j = 0; j < 2; ++j) {
+				Am[m][i][j] = A[i][0] * Am[m-1][0][j] + A[i][1] * Am[m-1][1][j];
+			}
+		}
+	}
+
+	for(size_t m = 0; m < K; ++m) {
+		for(size_t i = 0; i < 2; ++i) {
+			AmB[m][i] = Am[m][i][0] * B[0] + Am[m][i][1] * B[1];
+		}
+	}
+
+	h[0] = c.b0_;
+	for(size_t m = 1; m < K; ++m) {
+		h[m] = AmB[m-1][0];
+	}
+
+	StateSpaceCoeffs ss;
+
+	for(size_t j = 0; j < K; ++j) {
+		for(size_t k = 0; k < K; ++k) {
+			ss.y_x_[j][k] = (k >= j) ? h[k - j] : 0.0;
+		}
+	}
+
+	//! P の第k行は C A^k
+	for(size_t j = 0; j < 2; ++j) {
+		for(size_t k = 0; k < K; ++k) {
+			ss.y_s_[j][k] = Am[k][0][j];
+		}
+	}
+
+	//! G の第j列は A^(K-1-j) B
+	for(size_t j = 0; j < K; ++j) {
+		for(size_t i = 0; i < 2; ++i) {
+			ss.s_x_[j][i] = AmB[K-1-j][i];
+		}
+	}
+
+	for(size_t j = 0; j < 2; ++j) {
+		for(size_t i = 0; i < 2; ++i) {
+			ss.s_s_[j][i] = Am[K][i][j];
+		}
+	}
+
+	return ss;
+}
+
+namespace {
+
+//! 端数サンプルの処理
+template<class T>
+void	process_direct	(BiquadCoeffs const &c, double &s0, double &s1,
+						 T const *in, T *out, size_t n)
+{
+	for(size_t i = 0; i < n; ++i) {
+		double const x = in[i];
+		double const y = c.b0_ * x + s0;
+		s0 = c.b1_ * x - c.a1_ * y + s1;
+		s1 = c.b2_ * x - c.a2_ * y;
+		out[i] = static_cast<T>(y);
+	}
+}
+
+#if HWM_DSP_X86_SIMD
+
+inline
+void	store_block	(__m128d lo, __m128d hi, float *out)
+{
+	_mm_storeu_ps(out, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+}
+
+inline
+void	store_block	(__m128d lo, __m128d hi, double *out)
+{
+	_mm_storeu_pd(out, lo);
+	_mm_storeu_pd(out + 2, hi);
+}
+
+template<class T>
+void	process_state_space_sse2	(BiquadCoeffs const &c, StateSpaceCoeffs const &ss,
+									 BiquadState &st, T const *in, T *out, size_t n)
+{
+	size_t const K = StateSpaceCoeffs::kBlockSize;
+
+	__m128d y_x_lo[K], y_x_hi[K], s_x[K];
+	for(size_t j = 0; j < K; ++j) {
+		y_x_lo[j]	= _mm_loadu_pd(&ss.y_x_[j][0]);
+		y_x_hi[j]	= _mm_loadu_pd(&ss.y_x_[j][2]);
+		s_x[j]		= _mm_loadu_pd(&ss.s_x_[j][0]);
+	}
+	__m128d const y_s0_lo	= _mm_loadu_pd(&ss.y_s_[0][0]);
+	__m128d const y_s0_hi	= _mm_loadu_pd(&ss.y_s_[0][2]);
+	__m128d const y_s1_lo	= _mm_loadu_pd(&ss.y_s_[1][0]);
+	__m128d const y_s1_hi	= _mm_loadu_pd(&ss.y_s_[1][2]);
+	__m128d const s_s0		= _mm_loadu_pd(&ss.s_s_[0][0]);
+	__m128d const s_s1		= _mm_loadu_pd(&ss.s_s_[1][0]);
+
+	__m128d s = _mm_loadu_pd(st.s_);
+
+	size_t i = 0;
+	for( ; i + K <= n; i += K) {
+		__m128d y_lo = _mm_setzero_pd();
+		__m128d y_hi = _mm_setzero_pd();
+		__m128d ns = _mm_setzero_pd();
+
+		//! 入力の寄与は状態に依存しないので、依存チェーンの外で計算される
+		for(size_t j = 0; j < K; ++j) {
+			__m128d const x = _mm_set1_pd(in[i + j]);
+			y_lo	= _mm_add_pd(y_lo, _mm_mul_pd(y_x_lo[j], x));
+			y_hi	= _mm_add_pd(y_hi, _mm_mul_pd(y_x_hi[j], x));
+			ns		= _mm_add_pd(ns, _mm_mul_pd(s_x[j], x));
+		}
+
+		__m128d const s0 = _mm_unpacklo_pd(s, s);
+		__m128d const s1 = _mm_unpackhi_pd(s, s);
+
+		y_lo = _mm_add_pd(y_lo, _mm_add_pd(_mm_mul_pd(y_s0_lo, s0), _mm_mul_pd(y_s1_lo, s1)));
+		y_hi = _mm_add_pd(y_hi, _mm_add_pd(_mm_mul_pd(y_s0_hi, s0), _mm_mul_pd(y_s1_hi, s1)));
+		s = _mm_add_pd(ns, _mm_add_pd(_mm_mul_pd(s_s0, s0), _mm_mul_pd(s_s1, s1)));
+
+		store_block(y_lo, y_hi, out + i);
+	}
+
+	double s_tmp[2];
+	_mm_storeu_pd(s_tmp, s);
+	process_direct(c, s_tmp[0], s_tmp[1], in + i, out + i, n - i);
+	st.s_[0] = s_tmp[0];
+	st.s_[1] = s_tmp[1];
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_block_avx	(__m256d y, float *out)
+{
+	_mm_storeu_ps(out, _mm256_cvtpd_ps(y));
+}
+
+HWM_DSP_TARGET_AVX inline
+void	store_block_avx	(__m256d y, double *out)
+{
+	_mm256_storeu_pd(out, y);
+}
+
+//! 4サンプル分の出力を1本のYMMレジスタで計算する
+template<class T>
+HWM_DSP_TARGET_AVX
+void	process_state_space_avx	(BiquadCoeffs const &c, StateSpaceCoeffs const &ss,
+								 BiquadState &st, T const *in, T *out, size_t n)
+{
+	size_t const K = StateSpaceCoeffs::kBlockSize;
+
+	__m256d y_x[K];
+	__m128d s_x[K];
+	for(size_t j = 0; j < K; ++j) {
+		y_x[j] = _mm256_loadu_pd(&ss.y_x_[j][0]);
+		s_x[j] = _mm_loadu_pd(&ss.s_x_[j][0]);
+	}
+	__m256d const y_s0 = _mm256_loadu_pd(&ss.y_s_[0][0]);
+	__m256d const y_s1 = _mm256_loadu_pd(&ss.y_s_[1][0]);
+	__m128d const s_s0 = _mm_loadu_pd(&ss.s_s_[0][0]);
+	__m128d const s_s1 = _mm_loadu_pd(&ss.s_s_[1][0]);
+
+	__m128d s = _mm_loadu_pd(st.s_);
+
+	size_t i = 0;
+	for( ; i + K <= n; i += K) {
+		__m256d const x0 = _mm256_set1_pd(in[i + 0]);
+		__m256d const x1 = _mm256_set1_pd(in[i + 1]);
+		__m256d const x2 = _mm256_set1_pd(in[i + 2]);
+		__m256d const x3 = _mm256_set1_pd(in[i + 3]);
+
+		__m256d y = _mm256_mul_pd(y_x[0], x0);
+		y = _mm256_fmadd_pd(y_x[1], x1, y);
+		y = _mm256_fmadd_pd(y_x[2], x2, y);
+		y = _mm256_fmadd_pd(y_x[3], x3, y);
+
+		__m128d ns = _mm_mul_pd(s_x[0], _mm256_castpd256_pd128(x0));
+		ns = _mm_fmadd_pd(s_x[1], _mm256_castpd256_pd128(x1), ns);
+		ns = _mm_fmadd_pd(s_x[2], _mm256_castpd256_pd128(x2), ns);
+		ns = _mm_fmadd_pd(s_x[3], _mm256_castpd256_pd128(x3), ns);
+
+		__m128d const s0 = _mm_unpacklo_pd(s, s);
+		__m128d const s1 = _mm_unpackhi_pd(s, s);
+		__m256d const s0w = _mm256_insertf128_pd(_mm256_castpd128_pd256(s0), s0, 1);
+		__m256d const s1w = _mm256_insertf128_pd(_mm256_castpd128_pd256(s1), s1, 1);
+
+		y = _mm256_fmadd_pd(y_s0, s0w, _mm256_fmadd_pd(y_s1, s1w, y));
+		s = _mm_fmadd_pd(s_s0, s0, _mm_fmadd_pd(s_s1, s1, ns));
+
+		store_block_avx(y, out + i);
+	}
+
+	double s_tmp[2];
+	_mm_storeu_pd(s_tmp, s);
+	process_direct(c, s_tmp[0], s_tmp[1], in + i, out + i, n - i);
+	st.s_[0] = s_tmp[0];
+	st.s_[1] = s_tmp[1];
+}
+
+#endif	//HWM_DSP_X86_SIMD
+
+template<class T>
+void	dispatch_state_space	(BiquadCoeffs const &c, StateSpaceCoeffs const &ss,
+								 BiquadState &st, T const *in, T *out, size_t n)
+{
+	switch(get_simd_level()) {
+#if HWM_DSP_X86_SIMD
+		case SimdLevel::AVX:
+			process_state_space_avx(c, ss, st, in, out, n);
+			return;
+
+		case SimdLevel::SSE2:
+			process_state_space_sse2(c, ss, st, in, out, n);
+			return;
+#endif
+		default:
+			//! ベクトル演算が使えなければ、演算量の少ない直接形のほうが速い
+			process_direct(c, st.s_[0], st.s_[1], in, out, n);
+			return;
+	}
+}
+
+}	//unnamed namespace
+
+void	process_state_space	(BiquadCoeffs const &coeffs, StateSpaceCoeffs const &ss,
+							 BiquadState &state, float const *in, float *out, size_t n)
+{
+	dispatch_state_space(coeffs, ss, state, in, out, n);
+}
+
+void	process_state_space	(BiquadCoeffs const &coeffs, StateSpaceCoeffs const &ss,
+							 BiquadState &state, double const *in, double *out, size_t n)
+{
+	dispatch_state_space(coeffs, ss, state, in, out, n);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,256 @@
+#include "./StereoBiquad.hpp"
+#include "./SimdOps.hpp"
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+//! SIMDが使えない環境向け
+//! L/Rの依存チェーンは独立しているので、交互に計算すればCPUが並列に実行できる
+template<class T, class Ops>
+struct StereoScalarKernel
+{
+	typedef typename Ops::value_type	S;
+
+	BiquadCoeffs const &	coeffs_;
+	BiquadCoeffs const *	delta_;
+	BiquadState *			st_;
+	T const *				in_l_;
+	T const *				in_r_;
+	T *						out_l_;
+	T *						out_r_;
+	size_t					n_;
+
+	template<size_t Type>
+	void	run	()
+	{
+		KernelCoeffs<Ops> c = make_kernel_coeffs<Ops>(coeffs_);
+		KernelCoeffs<Ops> const d = make_kernel_coeffs<Ops>(delta_ ? *delta_ : BiquadCoeffs());
+		S l0 = static_cast<S>(st_[0].s_[0]), l1 = static_cast<S>(st_[0].s_[1]);
+		S r0 = static_cast<S>(st_[1].s_[0]), r1 = static_cast<S>(st_[1].s_[1]);
+
+		for(size_t i = 0; i < n_; ++i) {
+			S const yl = BiquadKernel<Type>::template tick<Ops>(c, static_cast<S>(in_l_[i]), l0, l1);
+			S const yr = BiquadKernel<Type>::template tick<Ops>(c, static_cast<S>(in_r_[i]), r0, r1);
+			out_l_[i] = static_cast<T>(yl);
+			out_r_[i] = static_cast<T>(yr);
+			if(delta_) {
+				step_kernel_coeffs<Ops>(c, d);
+			}
+		}
+
+		st_[0].s_[0] = l0; st_[0].s_[1] = l1;
+		st_[1].s_[0] = r0; st_[1].s_[1] = r1;
+	}
+};
+
+#if HWM_DSP_X86_SIMD
+
+//! 下位レーンにL、その次のレーンにRを読み込む
+//! 単精度のレジスタでも下位2レーンだけを使う
+inline
+void	load_pair	(__m128d &v, float const *l, float const *r, size_t i)
+{
+	v = _mm_set_pd(r[i], l[i]);
+}
+
+inline
+void	load_pair	(__m128d &v, double const *l, double const *r, size_t i)
+{
+	v = _mm_loadh_pd(_mm_load_sd(l + i), r + i);
+}
+
+inline
+void	load_pair	(__m128 &v, float const *l, float const *r, size_t i)
+{
+	v = _mm_unpacklo_ps(_mm_load_ss(l + i), _mm_load_ss(r + i));
+}
+
+inline
+void	load_pair	(__m128 &v, double const *l, double const *r, size_t i)
+{
+	v = _mm_cvtpd_ps(_mm_loadh_pd(_mm_load_sd(l + i), r + i));
+}
+
+inline
+void	store_pair	(__m128d v, float *l, float *r, size_t i)
+{
+	__m128 const f = _mm_cvtpd_ps(v);
+	_mm_store_ss(l + i, f);
+	_mm_store_ss(r + i, _mm_shuffle_ps(f, f, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+inline
+void	store_pair	(__m128d v, double *l, double *r, size_t i)
+{
+	_mm_storel_pd(l + i, v);
+	_mm_storeh_pd(r + i, v);
+}
+
+inline
+void	store_pair	(__m128 v, float *l, float *r, size_t i)
+{
+	_mm_store_ss(l + i, v);
+	_mm_store_ss(r + i, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+inline
+void	store_pair	(__m128 v, double *l, double *r, size_t i)
+{
+	store_pair(_mm_cvtps_pd(v), l, r, i);
+}
+
+inline
+void	load_state	(__m128d &v, BiquadState const *st, size_t k)
+{
+	v = _mm_set_pd(st[1].s_[k], st[0].s_[k]);
+}
+
+inline
+void	load_state	(__m128 &v, BiquadState const *st, size_t k)
+{
+	v = _mm_cvtpd_ps(_mm_set_pd(st[1].s_[k], st[0].s_[k]));
+}
+
+inline
+void	store_state	(__m128d v, BiquadState *st, size_t k)
+{
+	_mm_storel_pd(&st[0].s_[k], v);
+	_mm_storeh_pd(&st[1].s_[k], v);
+}
+
+inline
+void	store_state	(__m128 v, BiquadState *st, size_t k)
+{
+	store_state(_mm_cvtps_pd(v), st, k);
+}
+
+template<class Ops, class T, size_t Type>
+void	process_stereo_simd	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 BiquadState *st,
+							 T const *in_l, T const *in_r,
+							 T *out_l, T *out_r, size_t n)
+{
+	typedef typename Ops::value_type V;
+
+	KernelCoeffs<Ops> c = make_kernel_coeffs<Ops>(coeffs);
+
+	V s0, s1;
+	load_state(s0, st, 0);
+	load_state(s1, st, 1);
+
+	if(delta) {
+		KernelCoeffs<Ops> const d = make_kernel_coeffs<Ops>(*delta);
+		for(size_t i = 0; i < n; ++i) {
+			V x;
+			load_pair(x, in_l, in_r, i);
+			V const y = BiquadKernel<Type>::template tick<Ops>(c, x, s0, s1);
+			store_pair(y, out_l, out_r, i);
+			step_kernel_coeffs<Ops>(c, d);
+		}
+	} else {
+		for(size_t i = 0; i < n; ++i) {
+			V x;
+			load_pair(x, in_l, in_r, i);
+			V const y = BiquadKernel<Type>::template tick<Ops>(c, x, s0, s1);
+			store_pair(y, out_l, out_r, i);
+		}
+	}
+
+	store_state(s0, st, 0);
+	store_state(s1, st, 1);
+}
+
+template<class Ops, class T, size_t Type>
+HWM_DSP_TARGET_AVX HWM_DSP_FLATTEN
+void	process_stereo_avx	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+							 BiquadState *st,
+							 T const *in_l, T const *in_r,
+							 T *out_l, T *out_r, size_t n)
+{
+	process_stereo_simd<Ops, T, Type>(coeffs, delta, st, in_l, in_r, out_l, out_r, n);
+}
+
+//! SSEOpsはSSE2命令のみ、FMAOpsはFMAを使う演算
+template<class T, class SSEOps, class FMAOps>
+struct StereoSimdKernel
+{
+	BiquadCoeffs const &	coeffs_;
+	BiquadCoeffs const *	delta_;
+	BiquadState *			st_;
+	T const *				in_l_;
+	T const *				in_r_;
+	T *						out_l_;
+	T *						out_r_;
+	size_t					n_;
+	bool					use_avx_;
+
+	template<size_t Type>
+	void	run	()
+	{
+		if(use_avx_) {
+			process_stereo_avx<FMAOps, T, Type>(coeffs_, delta_, st_, in_l_, in_r_, out_l_, out_r_, n_);
+		} else {
+			process_stereo_simd<SSEOps, T, Type>(coeffs_, delta_, st_, in_l_, in_r_, out_l_, out_r_, n_);
+		}
+	}
+};
+
+#endif	//HWM_DSP_X86_SIMD
+
+template<class T>
+void	dispatch_stereo	(BiquadCoeffs const &c, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *st, T const *in_l, T const *in_r,
+						 T *out_l, T *out_r, size_t n)
+{
+	size_t const level = get_simd_level();
+	bool const use_float = (precision == StatePrecision::Float);
+
+#if HWM_DSP_X86_SIMD
+	if(level >= SimdLevel::SSE2) {
+		bool const use_avx = (level >= SimdLevel::AVX);
+		if(use_float) {
+			StereoSimdKernel<T, SSEFloatOps, AVXFloatOps> kernel =
+				{ c, delta, st, in_l, in_r, out_l, out_r, n, use_avx };
+			dispatch_filter_type(filter_type, kernel);
+		} else {
+			StereoSimdKernel<T, SSE2Ops, AVXOps> kernel =
+				{ c, delta, st, in_l, in_r, out_l, out_r, n, use_avx };
+			dispatch_filter_type(filter_type, kernel);
+		}
+		return;
+	}
+#endif
+
+	(void)level;
+	if(use_float) {
+		StereoScalarKernel<T, ScalarFloatOps> kernel = { c, delta, st, in_l, in_r, out_l, out_r, n };
+		dispatch_filter_type(filter_type, kernel);
+	} else {
+		StereoScalarKernel<T, ScalarOps> kernel = { c, delta, st, in_l, in_r, out_l, out_r, n };
+		dispatch_filter_type(filter_type, kernel);
+	}
+}
+
+}	//unnamed namespace
+
+void	process_stereo	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states,
+						 float const *in_l, float const *in_r,
+						 float *out_l, float *out_r, size_t n)
+{
+	dispatch_stereo(coeffs, delta, filter_type, precision, states, in_l, in_r, out_l, out_r, n);
+}
+
+void	process_stereo	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states,
+						 double const *in_l, double const *in_r,
+						 double *out_l, double *out_r, size_t n)
+{
+	dispatch_stereo(coeffs, delta, filter_type, precision, states, in_l, in_r, out_l, out_r, n);
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,29 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_STEREOBIQUAD_HPP
+#define	HWM_MINIVSTEFFECT_DSP_STEREOBIQUAD_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include "./BiquadKernels.hpp"
+
+namespace hwm { namespace dsp {
+
+//! L/Rの遅延子を1本のレジスタに並べ、2チャンネルを1パスで処理する
+//! カーネルはget_simd_level()とfilter_typeに従って呼び出しごとに選択される
+//! @param filter_type FilterTypeのいずれか。特殊化しない場合はkGenericKernel
+//! @param precision StatePrecisionのいずれか
+//! @param delta 0でなければ、1サンプルごとに係数にdeltaを足しながら処理する
+//! @param states L, Rの2チャンネル分の遅延子
+void	process_stereo	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states,
+						 float const *in_l, float const *in_r,
+						 float *out_l, float *out_r, size_t n);
+
+void	process_stereo	(BiquadCoeffs const &coeffs, BiquadCoeffs const *delta,
+						 size_t filter_type, size_t precision,
+						 BiquadState *states,
+						 double const *in_l, double const *in_r,
+						 double *out_l, double *out_r, size_t n);
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_STEREOBIQUAD_HPP
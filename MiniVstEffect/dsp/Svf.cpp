@@ -0,0 +1,303 @@
+#define _USE_MATH_DEFINES
+#include "./Svf.hpp"
+#include "./Denormals.hpp"
+
+#include <cmath>
+
+namespace hwm { namespace dsp {
+
+SvfCoeffs
+		design_svf		(size_t filter_type, double cutoff, double db_gain, double Q)
+{
+	double const A = pow(10.0, db_gain / 40);
+
+	return design_svf_from(filter_type, tan(M_PI * cutoff), A, Q);
+}
+
+SvfCoeffs
+		design_svf_from	(size_t filter_type, double g, double A, double Q)
+{
+	double k = 1.0 / Q;
+
+	//! 未知のフィルタタイプでは素通し
+	double m0 = 1.0, m1 = 0.0, m2 = 0.0;
+
+	switch(filter_type) {
+		case FilterType::LPF:
+			m0 = 0;
+			m1 = 0;
+			m2 = 1;
+			break;
+
+		case FilterType::HPF:
+			m0 = 1;
+			m1 = -k;
+			m2 = -1;
+			break;
+
+		case FilterType::BPF:
+			//(constant skirt gain, peak gain = Q)
+			m0 = 0;
+			m1 = 1;
+			m2 = 0;
+			break;
+
+		case FilterType::notch:
+			m0 = 1;
+			m1 = -k;
+			m2 = 0;
+			break;
+
+		case FilterType::APF:
+			m0 = 1;
+			m1 = -2 * k;
+			m2 = 0;
+			break;
+
+		case FilterType::PeakingEQ:
+			k = 1.0 / (Q * A);
+			m0 = 1;
+			m1 = k * (A * A - 1);
+			m2 = 0;
+			break;
+
+		case FilterType::LowShelf:
+			g /= sqrt(A);
+			m0 = 1;
+			m1 = k * (A - 1);
+			m2 = A * A - 1;
+			break;
+
+		case FilterType::HighShelf:
+			g *= sqrt(A);
+			m0 = A * A;
+			m1 = k * (1 - A) * A;
+			m2 = 1 - A * A;
+			break;
+	}
+
+	double const a1 = 1.0 / (1.0 + g * (g + k));
+	double const a2 = g * a1;
+	double const a3 = g * a2;
+
+	SvfCoeffs const c = { a1, a2, a3, m0, m1, m2 };
+
+	return c;
+}
+
+Svf::Svf	(size_t num_channels)
+	:	filter_type_(FilterType::kNumFilterType)
+	,	states_(num_channels)
+	,	ramp_remaining_(0)
+{
+	SvfCoeffs const through = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+	coeffs_ = through;
+	clear_buffer();
+}
+
+void	Svf::set_coeffs	(SvfCoeffs const &coeffs, size_t filter_type)
+{
+	ramp_remaining_ = 0;
+	coeffs_ = coeffs;
+	filter_type_ = filter_type;
+}
+
+SvfCoeffs const &
+		Svf::get_coeffs	() const
+{
+	return coeffs_;
+}
+
+size_t	Svf::get_filter_type	() const
+{
+	return filter_type_;
+}
+
+void	Svf::ramp_coeffs	(SvfCoeffs const &coeffs, size_t filter_type,
+						 size_t num_samples)
+{
+	if(num_samples == 0) {
+		set_coeffs(coeffs, filter_type);
+		return;
+	}
+
+	double const r = 1.0 / num_samples;
+	SvfCoeffs const delta = {
+		(coeffs.a1_ - coeffs_.a1_) * r,
+		(coeffs.a2_ - coeffs_.a2_) * r,
+		(coeffs.a3_ - coeffs_.a3_) * r,
+		(coeffs.m0_ - coeffs_.m0_) * r,
+		(coeffs.m1_ - coeffs_.m1_) * r,
+		(coeffs.m2_ - coeffs_.m2_) * r
+	};
+
+	filter_type_ = filter_type;
+	ramp_target_ = coeffs;
+	ramp_delta_ = delta;
+	ramp_remaining_ = num_samples;
+}
+
+size_t	Svf::get_ramp_remaining	() const
+{
+	return ramp_remaining_;
+}
+
+void	Svf::clear_buffer	()
+{
+	for(size_t ch = 0; ch < states_.size(); ++ch) {
+		states_[ch].ic1eq_ = 0.0;
+		states_[ch].ic2eq_ = 0.0;
+	}
+}
+
+void	Svf::flush_denormals	()
+{
+	for(size_t ch = 0; ch < states_.size(); ++ch) {
+		dsp::flush_denormals(&states_[ch].ic1eq_, 1);
+		dsp::flush_denormals(&states_[ch].ic2eq_, 1);
+	}
+}
+
+size_t	Svf::get_num_channels	() const
+{
+	return states_.size();
+}
+
+void	Svf::set_num_channels	(size_t num_channels)
+{
+	states_.resize(num_channels);
+	clear_buffer();
+}
+
+namespace {
+
+inline
+void	step_coeffs	(SvfCoeffs &c, SvfCoeffs const &d)
+{
+	c.a1_ += d.a1_;
+	c.a2_ += d.a2_;
+	c.a3_ += d.a3_;
+	c.m0_ += d.m0_;
+	c.m1_ += d.m1_;
+	c.m2_ += d.m2_;
+}
+
+inline
+double	tick	(SvfCoeffs const &c, double x, double &ic1eq, double &ic2eq)
+{
+	double const v3 = x - ic2eq;
+	double const v1 = c.a1_ * ic1eq + c.a2_ * v3;
+	double const v2 = ic2eq + c.a2_ * ic1eq + c.a3_ * v3;
+	ic1eq = 2 * v1 - ic1eq;
+	ic2eq = 2 * v2 - ic2eq;
+
+	return c.m0_ * x + c.m1_ * v1 + c.m2_ * v2;
+}
+
+//! 2チャンネル分の依存チェーンを交互に計算する
+//! Rampがtrueなら、1サンプルごとに係数にdeltaを足しながら処理する
+template<class T, bool Ramp>
+void	process_pair	(SvfCoeffs c, SvfCoeffs const &delta,
+						 SvfState &sl, SvfState &sr,
+						 T const *in_l, T const *in_r, T *out_l, T *out_r, size_t n)
+{
+	double l1 = sl.ic1eq_, l2 = sl.ic2eq_;
+	double r1 = sr.ic1eq_, r2 = sr.ic2eq_;
+
+	for(size_t i = 0; i < n; ++i) {
+		double const yl = tick(c, in_l[i], l1, l2);
+		double const yr = tick(c, in_r[i], r1, r2);
+		out_l[i] = static_cast<T>(yl);
+		out_r[i] = static_cast<T>(yr);
+		if(Ramp) {
+			step_coeffs(c, delta);
+		}
+	}
+
+	sl.ic1eq_ = l1; sl.ic2eq_ = l2;
+	sr.ic1eq_ = r1; sr.ic2eq_ = r2;
+}
+
+template<class T, bool Ramp>
+void	process_mono	(SvfCoeffs c, SvfCoeffs const &delta,
+						 SvfState &s, T const *in, T *out, size_t n)
+{
+	double s1 = s.ic1eq_, s2 = s.ic2eq_;
+
+	for(size_t i = 0; i < n; ++i) {
+		out[i] = static_cast<T>(tick(c, in[i], s1, s2));
+		if(Ramp) {
+			step_coeffs(c, delta);
+		}
+	}
+
+	s.ic1eq_ = s1; s.ic2eq_ = s2;
+}
+
+template<class T, bool Ramp>
+void	process_all	(SvfCoeffs const &c, SvfCoeffs const &delta,
+					 std::vector<SvfState> &states,
+					 T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	size_t ch = 0;
+	for( ; ch + 1 < states.size(); ch += 2) {
+		process_pair<T, Ramp>(c, delta, states[ch], states[ch+1],
+			in[ch] + offset, in[ch+1] + offset, out[ch] + offset, out[ch+1] + offset, n);
+	}
+	if(ch < states.size()) {
+		process_mono<T, Ramp>(c, delta, states[ch], in[ch] + offset, out[ch] + offset, n);
+	}
+}
+
+}	//unnamed namespace
+
+template<class T>
+void	Svf::process_channels	(T const * const *in, T * const *out, size_t offset, size_t n)
+{
+	if(ramp_remaining_ > 0) {
+		size_t const m = (n < ramp_remaining_) ? n : ramp_remaining_;
+		process_all<T, true>(coeffs_, ramp_delta_, states_, in, out, offset, m);
+
+		ramp_remaining_ -= m;
+		if(ramp_remaining_ == 0) {
+			set_coeffs(ramp_target_, filter_type_);
+		} else {
+			SvfCoeffs d = ramp_delta_;
+			double const k = static_cast<double>(m);
+			d.a1_ *= k; d.a2_ *= k; d.a3_ *= k;
+			d.m0_ *= k; d.m1_ *= k; d.m2_ *= k;
+			step_coeffs(coeffs_, d);
+		}
+
+		offset += m;
+		n -= m;
+	}
+
+	if(n > 0) {
+		process_all<T, false>(coeffs_, ramp_delta_, states_, in, out, offset, n);
+	}
+}
+
+void	Svf::process_block	(float const * const *in, float * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	Svf::process_block	(double const * const *in, double * const *out, size_t n)
+{
+	process_channels(in, out, 0, n);
+}
+
+void	Svf::process_block	(float const * const *in, float * const *out,
+							 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+void	Svf::process_block	(double const * const *in, double * const *out,
+							 size_t offset, size_t n)
+{
+	process_channels(in, out, offset, n);
+}
+
+}}	//namespace hwm::dsp
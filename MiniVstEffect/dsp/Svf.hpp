@@ -0,0 +1,120 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_SVF_HPP
+#define	HWM_MINIVSTEFFECT_DSP_SVF_HPP
+
+#include "./BiquadCoeffs.hpp"
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! TPT(topology-preserving transform)で離散化したステートバリアブルフィルタの係数
+//!
+//! 積分器を台形積分で置き換えたSVFのlow, band出力v2, v1と入力v0から
+//!   y = m0 * v0 + m1 * v1 + m2 * v2
+//! として各フィルタタイプを作る。周波数特性はdesign_biquadと一致する。
+//! インパルス応答の差は応答の最大値の1e-9以下で、mve_bench svfで確かめている。
+//!
+//! 係数の更新はtanが1回だけで、係数をサンプルごとに変えても
+//! 状態変数がそのまま積分器の状態なので、bi-quadのように発散したりノイズが出たりしない
+struct SvfCoeffs
+{
+	double	a1_;
+	double	a2_;
+	double	a3_;
+	double	m0_;
+	double	m1_;
+	double	m2_;
+};
+
+//! design_biquadと同じ周波数特性のSVFの係数を計算する
+//! @param filter_type FilterTypeのいずれか
+//! @param cutoff 正規化周波数(0.0 ~ 0.5)
+//! @param db_gain Peaking EQ, Low Shelving, High Shelving以外では使用されない
+SvfCoeffs
+		design_svf		(size_t filter_type, double cutoff, double db_gain, double Q);
+
+//! design_svfのうち、tanとpowを計算した後の部分
+//! @param g tan(pi * cutoff)
+//! @param A pow(10, db_gain / 40)
+SvfCoeffs
+		design_svf_from	(size_t filter_type, double g, double A, double Q);
+
+//! 1チャンネル分の積分器の状態
+struct SvfState
+{
+	double	ic1eq_;
+	double	ic2eq_;
+};
+
+//! SVF
+//! Biquadと同じインターフェイスで使えるようにしてある
+//! 係数は全チャンネルで共有し、状態はチャンネルごとに持つ
+struct Svf
+{
+	explicit
+	Svf		(size_t num_channels);
+
+	//! filter_typeはBiquadとの互換のために保持するだけで、処理には影響しない
+	void	set_coeffs			(SvfCoeffs const &coeffs, size_t filter_type);
+	SvfCoeffs const &
+			get_coeffs			() const;
+	size_t	get_filter_type		() const;
+
+	//! 係数を、全チャンネルをまとめて処理するprocess_blockのnum_samplesサンプルをかけて
+	//! 現在の値からcoeffsまで線形に変化させる
+	void	ramp_coeffs			(SvfCoeffs const &coeffs, size_t filter_type,
+								 size_t num_samples);
+	size_t	get_ramp_remaining	() const;
+
+	//! 状態をクリア
+	void	clear_buffer		();
+	//! 絶対値がkDenormalFlushLimit未満の状態を0にする
+	//! FTZ, DAZを設定できない環境で、非正規化数での演算を避けるためにブロックの境界で呼び出す
+	void	flush_denormals		();
+
+	size_t	get_num_channels	() const;
+	//! チャンネル数を変更する。状態はクリアされる
+	//! メモリを確保するので、処理を止めている間に呼び出すこと
+	void	set_num_channels	(size_t num_channels);
+
+	//! 1サンプル分の処理
+	double	process				(size_t channel, double input)
+	{
+		SvfCoeffs const &c = coeffs_;
+		SvfState &s = states_[channel];
+
+		double const v3 = input - s.ic2eq_;
+		double const v1 = c.a1_ * s.ic1eq_ + c.a2_ * v3;
+		double const v2 = s.ic2eq_ + c.a2_ * s.ic1eq_ + c.a3_ * v3;
+		s.ic1eq_ = 2 * v1 - s.ic1eq_;
+		s.ic2eq_ = 2 * v2 - s.ic2eq_;
+
+		return c.m0_ * input + c.m1_ * v1 + c.m2_ * v2;
+	}
+
+	//! 全チャンネルをまとめて処理する
+	//! 2チャンネルずつ、依存チェーンを交互に計算する
+	void	process_block		(float const * const *in, float * const *out, size_t n);
+	void	process_block		(double const * const *in, double * const *out, size_t n);
+
+	//! 各チャンネルのoffsetサンプル目からnサンプル分を処理する
+	void	process_block		(float const * const *in, float * const *out,
+								 size_t offset, size_t n);
+	void	process_block		(double const * const *in, double * const *out,
+								 size_t offset, size_t n);
+
+private:
+	SvfCoeffs				coeffs_;
+	size_t					filter_type_;
+	std::vector<SvfState>	states_;
+
+	SvfCoeffs				ramp_target_;
+	SvfCoeffs				ramp_delta_;
+	size_t					ramp_remaining_;
+
+	template<class T>
+	void	process_channels	(T const * const *in, T * const *out, size_t offset, size_t n);
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_SVF_HPP
@@ -0,0 +1,83 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_TRIPLEBUFFER_HPP
+#define	HWM_MINIVSTEFFECT_DSP_TRIPLEBUFFER_HPP
+
+#include <atomic>
+
+namespace hwm { namespace dsp {
+
+//! 書き込みスレッド1つと読み出しスレッド1つの間で、値を丸ごと受け渡すためのトリプルバッファ
+//!
+//! 書き込み側は裏のスロットに値を書いてから中間のスロットと交換し、
+//! 読み出し側は新しい値があるときだけ表のスロットと中間のスロットを交換する。
+//! どちらもatomicな交換1回で終わるのでwait-freeで、
+//! 読み出し側は書き込み途中の値(係数の一部だけが新しいものなど)を見ることがない。
+//!
+//! 書き込み側が複数のスレッドになる場合は、書き込み側だけで排他すること。
+template<class T>
+struct TripleBuffer
+{
+	explicit
+	TripleBuffer	(T const &initial)
+		:	state_(kMiddle | kFresh)
+		,	front_(kFront)
+		,	back_(kBack)
+	{
+		for(unsigned i = 0; i < 3; ++i) {
+			slots_[i] = initial;
+		}
+	}
+
+	//! 書き込み側
+	//! valueを公開する
+	void	write	(T const &value)
+	{
+		slots_[back_] = value;
+		unsigned const prev = state_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+		back_ = prev & kIndexMask;
+	}
+
+	//! 読み出し側
+	//! 新しい値が公開されていれば取り込んでtrueを返す
+	bool	update	()
+	{
+		if((state_.load(std::memory_order_relaxed) & kFresh) == 0) {
+			return false;
+		}
+		unsigned const prev = state_.exchange(front_, std::memory_order_acq_rel);
+		front_ = prev & kIndexMask;
+		return true;
+	}
+
+	//! 読み出し側
+	//! 最後にupdateで取り込んだ値
+	T const &
+			get		() const
+	{
+		return slots_[front_];
+	}
+
+private:
+	enum {
+		kFront		= 0,
+		kMiddle		= 1,
+		kBack		= 2,
+		kIndexMask	= 3,
+		//! 中間のスロットに、読み出し側がまだ取り込んでいない値がある
+		kFresh		= 4
+	};
+
+	T						slots_[3];
+	//! 中間のスロットの番号とkFresh
+	std::atomic<unsigned>	state_;
+	//! 読み出し側だけが触る
+	unsigned				front_;
+	//! 書き込み側だけが触る
+	unsigned				back_;
+
+	TripleBuffer	(TripleBuffer const &);
+	TripleBuffer &	operator=	(TripleBuffer const &);
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_TRIPLEBUFFER_HPP
@@ -0,0 +1,174 @@
+#include "./WorkStealingPool.hpp"
+#include <algorithm>
+
+namespace hwm { namespace dsp {
+
+namespace {
+
+unsigned long long
+		pack_range		(size_t begin, size_t end)
+{
+	return (static_cast<unsigned long long>(begin) << 32) | static_cast<unsigned long long>(end);
+}
+
+size_t	get_begin		(unsigned long long range)
+{
+	return static_cast<size_t>(range >> 32);
+}
+
+size_t	get_end			(unsigned long long range)
+{
+	return static_cast<size_t>(range & 0xFFFFFFFFull);
+}
+
+}	//unnamed namespace
+
+WorkStealingPool::WorkStealingPool	(size_t num_threads)
+	:	generation_(0)
+	,	num_active_(0)
+	,	quit_(false)
+	,	func_(nullptr)
+	,	grain_(1)
+{
+	if(num_threads == 0) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+	if(num_threads == 0) {
+		num_threads = 1;
+	}
+
+	ranges_.reset(new Range[num_threads]);
+	for(size_t i = 0; i < num_threads; ++i) {
+		ranges_[i].range_ = 0;
+	}
+
+	threads_.reserve(num_threads);
+	for(size_t i = 0; i < num_threads; ++i) {
+		threads_.push_back(std::thread(&WorkStealingPool::worker_main, this, i));
+	}
+}
+
+WorkStealingPool::~WorkStealingPool	()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	start_cv_.notify_all();
+	for(size_t i = 0; i < threads_.size(); ++i) {
+		threads_[i].join();
+	}
+}
+
+size_t	WorkStealingPool::get_num_threads	() const
+{
+	return threads_.size();
+}
+
+void	WorkStealingPool::run				(size_t num_items, size_t grain, job_type const &func)
+{
+	size_t const num_threads = threads_.size();
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	for(size_t i = 0; i < num_threads; ++i) {
+		ranges_[i].range_ = pack_range(num_items * i / num_threads, num_items * (i + 1) / num_threads);
+	}
+	func_		= &func;
+	grain_		= std::max<size_t>(grain, 1);
+	num_active_	= num_threads;
+	++generation_;
+	start_cv_.notify_all();
+
+	done_cv_.wait(lock, [this] { return num_active_ == 0; });
+	func_ = nullptr;
+}
+
+void	WorkStealingPool::worker_main		(size_t thread_index)
+{
+	size_t generation = 0;
+	for( ; ; ) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			start_cv_.wait(lock, [&] { return quit_ || generation_ != generation; });
+			if(quit_) {
+				return;
+			}
+			generation = generation_;
+		}
+
+		do_work(thread_index);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(--num_active_ == 0) {
+			done_cv_.notify_one();
+		}
+	}
+}
+
+void	WorkStealingPool::do_work			(size_t thread_index)
+{
+	job_type const &func = *func_;
+	for( ; ; ) {
+		size_t begin;
+		size_t end;
+		if(pop(thread_index, begin, end)) {
+			func(begin, end, thread_index);
+		} else if(!steal(thread_index)) {
+			//! どのスレッドの範囲も空。奪われて移動中の仕事は、奪ったスレッドが処理する
+			return;
+		}
+	}
+}
+
+bool	WorkStealingPool::pop				(size_t thread_index, size_t &begin, size_t &end)
+{
+	std::atomic<unsigned long long> &range = ranges_[thread_index].range_;
+	unsigned long long r = range.load();
+	for( ; ; ) {
+		begin = get_begin(r);
+		size_t const last = get_end(r);
+		if(begin >= last) {
+			return false;
+		}
+		end = std::min(last, begin + grain_);
+		if(range.compare_exchange_weak(r, pack_range(end, last))) {
+			return true;
+		}
+	}
+}
+
+bool	WorkStealingPool::steal			(size_t thread_index)
+{
+	size_t const num_threads = threads_.size();
+	for( ; ; ) {
+		//! 残りがもっとも多いスレッドを選ぶ
+		size_t victim = num_threads;
+		size_t max_remaining = 0;
+		unsigned long long victim_range = 0;
+		for(size_t i = 1; i < num_threads; ++i) {
+			size_t const t = (thread_index + i) % num_threads;
+			unsigned long long const r = ranges_[t].range_.load();
+			size_t const begin = get_begin(r);
+			size_t const end = get_end(r);
+			if(begin < end && end - begin > max_remaining) {
+				victim = t;
+				max_remaining = end - begin;
+				victim_range = r;
+			}
+		}
+		if(victim == num_threads) {
+			return false;
+		}
+
+		size_t const begin = get_begin(victim_range);
+		size_t const end = get_end(victim_range);
+		size_t const middle = end - (end - begin + 1) / 2;
+		if(ranges_[victim].range_.compare_exchange_strong(victim_range, pack_range(begin, middle))) {
+			//! 自分の範囲は空なので、他のスレッドが書き換えることはない
+			ranges_[thread_index].range_.store(pack_range(middle, end));
+			return true;
+		}
+	}
+}
+
+}}	//namespace hwm::dsp
@@ -0,0 +1,71 @@
+#ifndef	HWM_MINIVSTEFFECT_DSP_WORKSTEALINGPOOL_HPP
+#define	HWM_MINIVSTEFFECT_DSP_WORKSTEALINGPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hwm { namespace dsp {
+
+//! 0 ~ num_items - 1の番号の仕事を、ワーカースレッドで分け合って処理する
+//!
+//! 最初に番号の範囲をスレッド数で等分し、各スレッドは自分の範囲の先頭からgrain個ずつ取る。
+//! 自分の範囲が空になったら、残りがもっとも多いスレッドの範囲の後ろ半分を奪って続ける。
+//! 範囲は[begin, end)を1つの64bit整数に詰めてCASで更新するので、取り出しにロックは使わない。
+//! ワーカーの起床と終了待ちにだけミューテックスを使う
+struct WorkStealingPool
+{
+	//! num_threadsが0なら、ハードウェアのスレッド数だけ作る
+	explicit
+	WorkStealingPool	(size_t num_threads = 0);
+	~WorkStealingPool	();
+
+	size_t	get_num_threads	() const;
+
+	//! [0, num_items)を重ならない範囲[begin, end)に分けてfunc(begin, end, thread_index)を呼び出し、
+	//! すべて終わるまで待つ。1回に渡す範囲はgrain個以下
+	//! num_itemsは2^32未満であること
+	typedef std::function<void(size_t, size_t, size_t)>	job_type;
+	void	run				(size_t num_items, size_t grain, job_type const &func);
+
+private:
+	WorkStealingPool	(WorkStealingPool const &);
+	WorkStealingPool &	operator=	(WorkStealingPool const &);
+
+	//! スレッドごとの残りの範囲。隣のスレッドの範囲と同じキャッシュラインに載らないようにする
+	struct Range
+	{
+		std::atomic<unsigned long long>	range_;
+		char							padding_[64 - sizeof(std::atomic<unsigned long long>)];
+	};
+
+	void	worker_main		(size_t thread_index);
+	void	do_work			(size_t thread_index);
+	//! 自分の範囲の先頭から取る
+	bool	pop				(size_t thread_index, size_t &begin, size_t &end);
+	//! 他のスレッドの範囲の後ろ半分を自分の範囲に移す
+	bool	steal			(size_t thread_index);
+
+	std::vector<std::thread>	threads_;
+	std::unique_ptr<Range[]>	ranges_;
+
+	std::mutex					mutex_;
+	std::condition_variable		start_cv_;
+	std::condition_variable		done_cv_;
+	//! runを呼び出すたびに増える。ワーカーはこれが変わったら新しい仕事を取りに行く
+	size_t						generation_;
+	size_t						num_active_;
+	bool						quit_;
+
+	job_type const *			func_;
+	size_t						grain_;
+};
+
+}}	//namespace hwm::dsp
+
+#endif	//HWM_MINIVSTEFFECT_DSP_WORKSTEALINGPOOL_HPP
@@ -0,0 +1,143 @@
+#ifndef	HWM_MINIVSTEFFECT_BENCH_BENCH_HPP
+#define	HWM_MINIVSTEFFECT_BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+	#define HWM_BENCH_HAS_TSC 1
+#else
+	#define HWM_BENCH_HAS_TSC 0
+#endif
+
+namespace hwm { namespace bench {
+
+//! 計測結果
+struct Result
+{
+	double	ns_per_sample_;
+	//! TSCのカウント。TSCが使えない環境では0
+	double	cycles_per_sample_;
+};
+
+inline
+unsigned long long
+		read_cycles	()
+{
+#if HWM_BENCH_HAS_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+//! funcを繰り返し呼び出し、1サンプルあたりの処理時間を計測する
+//! 計測を数回行い、もっとも速かった回の値を返す
+//! @param samples_per_call funcを1回呼び出したときに処理されるサンプル数
+template<class Func>
+Result	measure	(Func func, size_t samples_per_call, double seconds_per_trial = 0.05)
+{
+	typedef std::chrono::steady_clock clock;
+	size_t const kNumTrials = 5;
+
+	func();
+
+	Result best = { 1e300, 1e300 };
+	for(size_t trial = 0; trial < kNumTrials; ++trial) {
+		size_t calls = 0;
+		clock::time_point const start = clock::now();
+		unsigned long long const start_cycles = read_cycles();
+		double elapsed = 0;
+
+		do {
+			for(size_t i = 0; i < 16; ++i) {
+				func();
+			}
+			calls += 16;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		} while(elapsed < seconds_per_trial);
+
+		double const samples = static_cast<double>(calls) * samples_per_call;
+		Result const r = {
+			elapsed * 1e9 / samples,
+			static_cast<double>(read_cycles() - start_cycles) / samples
+		};
+		if(r.ns_per_sample_ < best.ns_per_sample_) {
+			best = r;
+		}
+	}
+
+	return best;
+}
+
+inline
+void	print_title	(char const *title)
+{
+	std::printf("\n== %s ==\n", title);
+	std::printf("%-32s %12s %12s %10s\n", "", "ns/sample", "cycles/smp", "ratio");
+}
+
+//! baselineに対する比(baseline / r)も表示する。baselineがなければ0を渡す
+inline
+void	print_result	(char const *label, Result const &r, Result const *baseline)
+{
+	if(baseline) {
+		std::printf("%-32s %12.3f %12.2f %9.2fx\n",
+			label, r.ns_per_sample_, r.cycles_per_sample_,
+			baseline->ns_per_sample_ / r.ns_per_sample_);
+	} else {
+		std::printf("%-32s %12.3f %12.2f %10s\n",
+			label, r.ns_per_sample_, r.cycles_per_sample_, "-");
+	}
+}
+
+//! 検証の結果をPASS/FAILで表示する
+//! 1つでも失敗すれば、mve_benchは1を返して終わる
+void	report_check	(char const *name, bool passed);
+
+//! -1.0 ~ 1.0 の白色雑音
+template<class T>
+std::vector<T>
+		make_noise	(size_t n, unsigned int seed = 1)
+{
+	std::vector<T> v(n);
+	unsigned int x = seed;
+	for(size_t i = 0; i < n; ++i) {
+		x = x * 1664525u + 1013904223u;
+		v[i] = static_cast<T>((x >> 8) / 8388608.0 - 1.0);
+	}
+	return v;
+}
+
+//! 各ベンチマーク
+void	bench_filter_types	();
+void	bench_precision		();
+void	bench_handoff		();
+void	bench_coeff_table	();
+void	bench_smoothing		();
+void	bench_svf			();
+void	bench_events		();
+void	bench_channels		();
+void	bench_cascade		();
+void	bench_slope			();
+void	bench_linear_phase	();
+void	bench_crossover		();
+void	bench_oversampling	();
+void	bench_silence		();
+void	bench_denormals		();
+void	bench_sample_format	();
+void	bench_segments		();
+void	bench_batch			();
+void	bench_interleaved	();
+void	bench_state_space	();
+
+}}	//namespace hwm::bench
+
+#endif	//HWM_MINIVSTEFFECT_BENCH_BENCH_HPP
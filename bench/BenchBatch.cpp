@@ -0,0 +1,170 @@
+#include "./Bench.hpp"
+#include "dsp/BatchEngine.hpp"
+#include "dsp/Biquad.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 128;
+//! 入力の雑音の種類。フィルタi番の入力はi % kNumInputs番を共有する
+size_t const kNumInputs = 16;
+
+//! フィルタiのパラメータ。タイプ、周波数、Q、ゲインを散らす
+dsp::BiquadBank::Params
+		make_params	(size_t i)
+{
+	unsigned int x = static_cast<unsigned int>(i) * 2654435761u + 1;
+	double r[3];
+	for(size_t k = 0; k < 3; ++k) {
+		x = x * 1664525u + 1013904223u;
+		r[k] = (x >> 8) / 16777216.0;
+	}
+
+	dsp::BiquadBank::Params params;
+	params.filter_type_	= i % dsp::FilterType::kNumFilterType;
+	params.cutoff_		= 0.001 * std::pow(400.0, r[0]);
+	params.Q_			= 0.5 + 3.5 * r[1];
+	params.db_gain_		= -12.0 + 24.0 * r[2];
+	return params;
+}
+
+//! num_filters本分の入出力バッファ
+struct Buffers
+{
+	explicit
+	Buffers	(size_t num_filters)
+		:	noise_(kNumInputs)
+		,	out_(num_filters * kBlockSize)
+	{
+		for(size_t k = 0; k < kNumInputs; ++k) {
+			noise_[k] = make_noise<float>(kBlockSize, static_cast<unsigned int>(k + 1));
+		}
+		for(size_t i = 0; i < num_filters; ++i) {
+			in_ptr_.push_back(&noise_[i % kNumInputs][0]);
+			out_ptr_.push_back(&out_[i * kBlockSize]);
+		}
+	}
+
+	std::vector<std::vector<float> >	noise_;
+	std::vector<float>					out_;
+	std::vector<float const *>			in_ptr_;
+	std::vector<float *>				out_ptr_;
+};
+
+//! 1本ずつのdsp::Biquadのインスタンスを並べて処理する
+Result	measure_instances	(size_t num_filters)
+{
+	Buffers buffers(num_filters);
+	std::vector<dsp::Biquad> filters(num_filters, dsp::Biquad(1));
+	for(size_t i = 0; i < num_filters; ++i) {
+		dsp::BiquadBank::Params const p = make_params(i);
+		filters[i].set_coeffs(dsp::design_biquad(p.filter_type_, p.cutoff_, p.db_gain_, p.Q_), p.filter_type_);
+	}
+
+	return measure([&] {
+		for(size_t i = 0; i < num_filters; ++i) {
+			filters[i].process_block(&buffers.in_ptr_[i], &buffers.out_ptr_[i], kBlockSize);
+		}
+	}, kBlockSize * num_filters);
+}
+
+void	set_bank_params	(dsp::BiquadBank &bank, size_t precision)
+{
+	bank.set_state_precision(precision);
+	for(size_t i = 0; i < bank.size(); ++i) {
+		bank.set_params(i, make_params(i));
+	}
+}
+
+//! BiquadBankを呼び出したスレッドだけで処理する
+Result	measure_bank	(size_t num_filters, size_t precision)
+{
+	Buffers buffers(num_filters);
+	dsp::BiquadBank bank(num_filters);
+	set_bank_params(bank, precision);
+
+	return measure([&] {
+		bank.process(&buffers.in_ptr_[0], &buffers.out_ptr_[0], 0, num_filters, kBlockSize);
+	}, kBlockSize * num_filters);
+}
+
+//! BatchEngineで全スレッドに分けて処理する
+Result	measure_engine	(dsp::BatchEngine &engine, size_t num_filters)
+{
+	Buffers buffers(num_filters);
+	engine.get_bank().resize(num_filters);
+	set_bank_params(engine.get_bank(), dsp::StatePrecision::Double);
+	engine.get_bank().clear_buffer();
+
+	return measure([&] {
+		engine.process(&buffers.in_ptr_[0], &buffers.out_ptr_[0], kBlockSize);
+	}, kBlockSize * num_filters);
+}
+
+//! 1本ずつのインスタンスとの出力の差(出力の最大値に対する比)
+double	check_error	(dsp::BatchEngine &engine, size_t num_filters)
+{
+	size_t const kNumBlocks = 8;
+
+	Buffers expected(num_filters);
+	Buffers actual(num_filters);
+	std::vector<dsp::Biquad> filters(num_filters, dsp::Biquad(1));
+	for(size_t i = 0; i < num_filters; ++i) {
+		dsp::BiquadBank::Params const p = make_params(i);
+		filters[i].set_coeffs(dsp::design_biquad(p.filter_type_, p.cutoff_, p.db_gain_, p.Q_), p.filter_type_);
+	}
+	engine.get_bank().resize(num_filters);
+	set_bank_params(engine.get_bank(), dsp::StatePrecision::Double);
+	engine.get_bank().clear_buffer();
+
+	double peak = 0;
+	double error = 0;
+	for(size_t b = 0; b < kNumBlocks; ++b) {
+		for(size_t i = 0; i < num_filters; ++i) {
+			filters[i].process_block(&expected.in_ptr_[i], &expected.out_ptr_[i], kBlockSize);
+		}
+		engine.process(&actual.in_ptr_[0], &actual.out_ptr_[0], kBlockSize);
+
+		for(size_t i = 0; i < expected.out_.size(); ++i) {
+			peak = std::max(peak, std::abs(static_cast<double>(expected.out_[i])));
+			error = std::max(error, std::abs(static_cast<double>(expected.out_[i]) - actual.out_[i]));
+		}
+	}
+	return error / peak;
+}
+
+}	//unnamed namespace
+
+//! 多数の独立したモノラルのフィルタを処理したときのスループット
+//! 値は1秒あたりのフィルタ・サンプル数(百万)。フィルタごとにタイプと係数が違う
+void	bench_batch	()
+{
+	size_t const counts[] = { 1, 10, 100, 1000, 10000, 100000 };
+
+	dsp::BatchEngine engine(0);
+
+	std::printf("\n== batch: independent mono filters, float I/O, %u samples per block, %u threads ==\n",
+		static_cast<unsigned>(kBlockSize), static_cast<unsigned>(engine.get_num_threads()));
+	std::printf("%-8s %12s %12s %12s %12s %12s\n",
+		"filters", "instances", "bank", "bank float", "engine", "vs instances");
+	for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+		size_t const n = counts[i];
+		Result const inst = measure_instances(n);
+		Result const bank = measure_bank(n, dsp::StatePrecision::Double);
+		Result const bank_float = measure_bank(n, dsp::StatePrecision::Float);
+		Result const eng = measure_engine(engine, n);
+		std::printf("%-8u %10.1f M %10.1f M %10.1f M %10.1f M %11.2fx\n",
+			static_cast<unsigned>(n),
+			1e3 / inst.ns_per_sample_, 1e3 / bank.ns_per_sample_,
+			1e3 / bank_float.ns_per_sample_, 1e3 / eng.ns_per_sample_,
+			inst.ns_per_sample_ / eng.ns_per_sample_);
+	}
+
+	std::printf("max error vs instances (1000 filters, double state): %.2e\n", check_error(engine, 1000));
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,100 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/BiquadCascade.hpp"
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+
+//! バンドkの係数。タイプと周波数をばらけさせる
+dsp::BiquadCoeffs
+		band_coeffs	(size_t k, double db_gain)
+{
+	size_t const types[] = {
+		dsp::FilterType::LowShelf, dsp::FilterType::PeakingEQ,
+		dsp::FilterType::PeakingEQ, dsp::FilterType::HighShelf
+	};
+	double const cutoff = 0.002 * (k + 1) * (k + 1);
+	return dsp::design_biquad(types[k % 4], (cutoff < 0.45) ? cutoff : 0.45, db_gain, 1.0);
+}
+
+//! バンドごとにBiquadを並べ、1バンドずつブロック全体を処理する
+Result	measure_separate	(size_t num_bands)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+	float const *io_in[2] = { &out_l[0], &out_r[0] };
+
+	std::vector<dsp::Biquad> bands(num_bands, dsp::Biquad(2));
+	for(size_t k = 0; k < num_bands; ++k) {
+		bands[k].set_coeffs(band_coeffs(k, 3.0), dsp::kGenericKernel);
+	}
+
+	return measure([&] {
+		bands[0].process_block(in, out, kBlockSize);
+		for(size_t k = 1; k < num_bands; ++k) {
+			bands[k].process_block(io_in, out, kBlockSize);
+		}
+	}, kBlockSize * 2);
+}
+
+//! 全バンドを1パスで処理する
+//! rampがtrueなら、全バンドの係数を常に補間しながら処理する
+Result	measure_fused		(size_t num_bands, bool ramp)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	dsp::BiquadCascade cascade(2, num_bands);
+	dsp::BiquadCoeffs targets[2][dsp::kMaxCascadeSections];
+	for(size_t k = 0; k < num_bands; ++k) {
+		targets[0][k] = band_coeffs(k, 3.0);
+		targets[1][k] = band_coeffs(k, -3.0);
+		cascade.set_section(k, targets[0][k]);
+	}
+
+	size_t count = 0;
+	return measure([&] {
+		if(ramp) {
+			cascade.ramp_sections(targets[++count % 2], kBlockSize);
+		}
+		cascade.process_block(in, out, kBlockSize);
+	}, kBlockSize * 2);
+}
+
+}	//unnamed namespace
+
+//! マルチバンドのイコライザのバンド数による処理コスト
+//! バンドごとのBiquadを順に通す場合と、BiquadCascadeで1パスにまとめた場合を比べる
+void	bench_cascade	()
+{
+	print_title("cascade: stereo float, per-band passes vs fused cascade");
+
+	size_t const band_counts[] = { 1, 2, 3, 4, 6, 8, 12, 16 };
+	char label[64];
+	for(size_t i = 0; i < sizeof(band_counts) / sizeof(band_counts[0]); ++i) {
+		size_t const n = band_counts[i];
+
+		Result const separate = measure_separate(n);
+		std::snprintf(label, sizeof(label), "%2zu bands, separate", n);
+		print_result(label, separate, 0);
+
+		Result const fused = measure_fused(n, false);
+		std::snprintf(label, sizeof(label), "%2zu bands, fused", n);
+		print_result(label, fused, &separate);
+
+		Result const ramped = measure_fused(n, true);
+		std::snprintf(label, sizeof(label), "%2zu bands, fused, ramping", n);
+		print_result(label, ramped, &separate);
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,154 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+
+//! num_channels分の入出力バッファ
+struct Buffers
+{
+	explicit
+	Buffers	(size_t num_channels)
+		:	in_(num_channels)
+		,	out_(num_channels, std::vector<float>(kBlockSize))
+	{
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			in_[ch] = make_noise<float>(kBlockSize, static_cast<unsigned int>(ch + 1));
+			in_ptr_.push_back(&in_[ch][0]);
+			out_ptr_.push_back(&out_[ch][0]);
+		}
+	}
+
+	std::vector<std::vector<float> >	in_;
+	std::vector<std::vector<float> >	out_;
+	std::vector<float const *>			in_ptr_;
+	std::vector<float *>				out_ptr_;
+};
+
+//! num_channelsチャンネルを1つのインスタンスで処理する
+Result	measure_single	(size_t num_channels, size_t precision)
+{
+	Buffers buffers(num_channels);
+
+	dsp::Biquad filter(num_channels);
+	filter.set_state_precision(precision);
+	filter.set_coeffs(
+		dsp::design_biquad(dsp::FilterType::PeakingEQ, 0.05, 6.0, 2.0),
+		dsp::FilterType::PeakingEQ);
+
+	return measure([&] {
+		filter.process_block(&buffers.in_ptr_[0], &buffers.out_ptr_[0], kBlockSize);
+	}, kBlockSize * num_channels);
+}
+
+//! num_channelsチャンネルをステレオのインスタンスを並べて処理する
+Result	measure_stereo_instances	(size_t num_channels, size_t precision)
+{
+	Buffers buffers(num_channels);
+
+	std::vector<dsp::Biquad> filters(num_channels / 2, dsp::Biquad(2));
+	for(size_t i = 0; i < filters.size(); ++i) {
+		filters[i].set_state_precision(precision);
+		filters[i].set_coeffs(
+			dsp::design_biquad(dsp::FilterType::PeakingEQ, 0.05, 6.0, 2.0),
+			dsp::FilterType::PeakingEQ);
+	}
+
+	return measure([&] {
+		for(size_t i = 0; i < filters.size(); ++i) {
+			filters[i].process_block(
+				&buffers.in_ptr_[i * 2], &buffers.out_ptr_[i * 2], kBlockSize);
+		}
+	}, kBlockSize * num_channels);
+}
+
+//! チャンネルごとのインスタンスとの差の許容値
+//! 1つのインスタンスはSIMDのレーンでFMAを使うことがあるので、丸めの分だけ違ってよい
+double const	kMaxDiff[dsp::StatePrecision::kNumStatePrecision] = { 1e-12, 1e-5 };
+
+//! num_channelsチャンネルを1つのインスタンスで処理した出力と、
+//! チャンネルごとに1チャンネルのインスタンスで処理した出力の差の最大値
+//! 状態が引き継がれることも比べるため、レーン幅の倍数でない長さに分けて数ブロック続けて処理する
+double	max_diff_from_mono	(size_t num_channels, size_t precision, size_t filter_type)
+{
+	size_t const kNumBlocks = 4;
+	size_t const kSplit = 131;
+	Buffers buffers(num_channels);
+	Buffers mono_buffers(num_channels);
+	dsp::BiquadCoeffs const coeffs = dsp::design_biquad(filter_type, 0.05, 6.0, 2.0);
+
+	dsp::Biquad filter(num_channels);
+	filter.set_state_precision(precision);
+	filter.set_coeffs(coeffs, filter_type);
+
+	std::vector<dsp::Biquad> mono(num_channels, dsp::Biquad(1));
+	for(size_t ch = 0; ch < num_channels; ++ch) {
+		mono[ch].set_state_precision(precision);
+		mono[ch].set_coeffs(coeffs, filter_type);
+	}
+
+	double diff = 0;
+	for(size_t b = 0; b < kNumBlocks; ++b) {
+		filter.process_block(&buffers.in_ptr_[0], &buffers.out_ptr_[0], 0, kSplit);
+		filter.process_block(&buffers.in_ptr_[0], &buffers.out_ptr_[0], kSplit, kBlockSize - kSplit);
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			mono[ch].process_block(&mono_buffers.in_ptr_[ch], &mono_buffers.out_ptr_[ch], 0, kSplit);
+			mono[ch].process_block(&mono_buffers.in_ptr_[ch], &mono_buffers.out_ptr_[ch],
+				kSplit, kBlockSize - kSplit);
+			for(size_t i = 0; i < kBlockSize; ++i) {
+				diff = std::max(diff,
+					std::abs(static_cast<double>(buffers.out_[ch][i]) - mono_buffers.out_[ch][i]));
+			}
+		}
+	}
+	return diff;
+}
+
+}	//unnamed namespace
+
+//! 多チャンネルを1つのインスタンスで処理する場合と、ステレオのインスタンスを並べた場合の比較
+//! 値は1チャンネル1サンプルあたり
+//! 1つのインスタンスの出力が、チャンネルごとのインスタンスの出力と丸めの範囲で一致することも確かめる
+void	bench_channels	()
+{
+	size_t const channels[] = { 2, 4, 6, 8, 12, 16 };
+	char const * const precision_names[] = { "double state", "float state" };
+	char label[64];
+
+	for(size_t p = 0; p < dsp::StatePrecision::kNumStatePrecision; ++p) {
+		std::printf("\n== channels: PeakingEQ float I/O, %s, per channel-sample ==\n", precision_names[p]);
+		std::printf("%-8s %12s %12s %10s %12s\n", "", "stereo ns", "single ns", "ratio", "max diff");
+
+		for(size_t i = 0; i < sizeof(channels) / sizeof(channels[0]); ++i) {
+			size_t const n = channels[i];
+			Result const stereo = measure_stereo_instances(n, p);
+			Result const single = measure_single(n, p);
+
+			std::snprintf(label, sizeof(label), "%2zu ch", n);
+			std::printf("%-8s %12.3f %12.3f %9.2fx %12.2e\n", label,
+				stereo.ns_per_sample_, single.ns_per_sample_,
+				stereo.ns_per_sample_ / single.ns_per_sample_,
+				max_diff_from_mono(n, p, dsp::FilterType::PeakingEQ));
+		}
+	}
+
+	//! 全フィルタタイプについて、1 ~ 20チャンネルの差を調べる
+	bool within = true;
+	for(size_t p = 0; p < dsp::StatePrecision::kNumStatePrecision; ++p) {
+		for(size_t type = 0; type < dsp::FilterType::kNumFilterType; ++type) {
+			for(size_t n = 1; n <= 20; ++n) {
+				within = within && (max_diff_from_mono(n, p, type) <= kMaxDiff[p]);
+			}
+		}
+	}
+	std::printf("\n");
+	report_check("channels 1-20 vs. per-channel instances", within);
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,92 @@
+#include "./Bench.hpp"
+#include "dsp/CoeffTable.hpp"
+#include "dsp/ParamMapping.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+char const * const filter_names[dsp::FilterType::kNumFilterType] = {
+	"LPF", "HPF", "BPF", "notch", "APF", "PeakingEQ", "LowShelf", "HighShelf"
+};
+
+double	max_coeff_error	(dsp::BiquadCoeffs const &a, dsp::BiquadCoeffs const &b)
+{
+	double e = 0;
+	e = std::max(e, std::abs(a.b0_ - b.b0_));
+	e = std::max(e, std::abs(a.b1_ - b.b1_));
+	e = std::max(e, std::abs(a.b2_ - b.b2_));
+	e = std::max(e, std::abs(a.a1_ - b.a1_));
+	e = std::max(e, std::abs(a.a2_ - b.a2_));
+	return e;
+}
+
+}	//unnamed namespace
+
+//! 係数テーブルの精度と、厳密な計算に対する速度
+void	bench_coeff_table	()
+{
+	dsp::ParamMapping const mapping = { 48000.0 };
+	size_t const sizes[] = { 256, 1024, 4096 };
+	size_t const kNumProbes = 20000;
+
+	std::vector<double> const noise = make_noise<double>(kNumProbes * 3, 7);
+
+	std::printf("\n== coeff_table: accuracy vs. design_biquad (fs = 48kHz, Q 0.3 ~ 18) ==\n");
+	std::printf("%-12s %8s %12s %12s %14s\n", "", "size", "trig err", "gain err", "max coeff err");
+
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		dsp::CoeffTable table(sizes[s]);
+		table.build(mapping);
+
+		for(size_t type = 0; type < dsp::FilterType::kNumFilterType; ++type) {
+			double err = 0;
+			for(size_t i = 0; i < kNumProbes; ++i) {
+				double const cutoff_param = noise[i * 3 + 0] * 0.5 + 0.5;
+				//! ゲインは -20dB ~ +12dB
+				double const gain_param = 0.025 + (noise[i * 3 + 1] * 0.5 + 0.5) * (1.0 - 0.025);
+				double const Q = 0.3 + (noise[i * 3 + 2] * 0.5 + 0.5) * 17.7;
+
+				dsp::BiquadCoeffs const exact = dsp::design_biquad(
+					type, mapping.cutoff(cutoff_param), mapping.db_gain(gain_param), Q);
+				dsp::BiquadCoeffs const approx = table.design(type, cutoff_param, gain_param, Q);
+				err = std::max(err, max_coeff_error(exact, approx));
+			}
+			std::printf("%-12s %8zu %12.2e %12.2e %14.2e\n",
+				filter_names[type], table.get_size(),
+				table.get_trig_error(), table.get_gain_error(), err);
+		}
+	}
+
+	dsp::CoeffTable table;
+	table.build(mapping);
+
+	size_t const kCalls = 256;
+	double sink = 0;
+
+	Result const exact = measure([&] {
+		for(size_t i = 0; i < kCalls; ++i) {
+			double const p = noise[i] * 0.5 + 0.5;
+			sink += dsp::design_biquad(dsp::FilterType::PeakingEQ,
+				mapping.cutoff(p), mapping.db_gain(p), 2.0).b0_;
+		}
+	}, kCalls);
+	Result const tabled = measure([&] {
+		for(size_t i = 0; i < kCalls; ++i) {
+			double const p = noise[i] * 0.5 + 0.5;
+			sink += table.design(dsp::FilterType::PeakingEQ, p, p, 2.0).b0_;
+		}
+	}, kCalls);
+
+	print_title("coeff_table: cost per coefficient update (PeakingEQ)");
+	print_result("exact (pow, log10, sin, cos)", exact, 0);
+	print_result("table lookup", tabled, &exact);
+	if(sink == 0) {
+		std::printf("\n");
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,216 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/Crossover.hpp"
+#include "dsp/Fft.hpp"
+#include "dsp/SlopeFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+size_t const kNumChannels = 2;
+
+//! 48kHzで200Hz, 2kHz, 8kHz
+double const kSplits[dsp::kMaxCrossoverBands - 1] = { 200.0 / 48000.0, 2000.0 / 48000.0, 8000.0 / 48000.0 };
+
+//! インスタンスを並べた場合の1バンド分
+//! 入力を複製したバスごとに、そのバンドのLPF, HPFと、位相を揃える全域通過フィルタを通す
+struct BandChain
+{
+	std::vector<dsp::SlopeFilter>	slopes_;
+	std::vector<dsp::Biquad>		allpasses_;
+};
+
+//! バンドbを取り出すフィルタを並べる
+BandChain
+		make_band_chain	(size_t num_bands, size_t band, size_t num_sections)
+{
+	BandChain chain;
+	size_t const lr_sections = num_sections * 2;
+
+	//! 下の分割点のHPFと、上の分割点のLPF
+	for(size_t k = 0; k + 1 < num_bands; ++k) {
+		if(k + 1 == band || k == band) {
+			size_t const type = (k < band) ? dsp::FilterType::HPF : dsp::FilterType::LPF;
+			dsp::SlopeFilter f(kNumChannels);
+			f.set_coeffs(
+				dsp::design_slope(type, kSplits[k], lr_sections, dsp::Alignment::LinkwitzRiley), type);
+			chain.slopes_.push_back(f);
+		} else if(k < band) {
+			//! さらに下の分割点のHPF
+			dsp::SlopeFilter f(kNumChannels);
+			f.set_coeffs(
+				dsp::design_slope(dsp::FilterType::HPF, kSplits[k], lr_sections, dsp::Alignment::LinkwitzRiley),
+				dsp::FilterType::HPF);
+			chain.slopes_.push_back(f);
+		} else {
+			//! さらに上の分割点の全域通過
+			double Q[dsp::kMaxCrossoverSections];
+			dsp::get_slope_Qs(num_sections, dsp::Alignment::Butterworth, Q);
+			for(size_t j = 0; j < num_sections; ++j) {
+				dsp::Biquad ap(kNumChannels);
+				ap.set_coeffs(
+					dsp::design_biquad(dsp::FilterType::APF, kSplits[k], 0.0, Q[j]), dsp::FilterType::APF);
+				chain.allpasses_.push_back(ap);
+			}
+		}
+	}
+	return chain;
+}
+
+void	run_chain	(BandChain &chain, float const * const *in, float * const *out, size_t n)
+{
+	float const *io[kNumChannels];
+	for(size_t ch = 0; ch < kNumChannels; ++ch) {
+		io[ch] = out[ch];
+	}
+
+	bool first = true;
+	for(size_t i = 0; i < chain.slopes_.size(); ++i) {
+		chain.slopes_[i].process_block(first ? in : io, out, n);
+		first = false;
+	}
+	for(size_t i = 0; i < chain.allpasses_.size(); ++i) {
+		chain.allpasses_[i].process_block(first ? in : io, out, n);
+		first = false;
+	}
+}
+
+//! 全バンドの和の振幅特性の、0dBからの最大のずれ[dB]と、バンドごとの出力の最大の差
+void	check_crossover	(size_t num_bands, size_t slope)
+{
+	size_t const kLength = 8192;
+	std::vector<float> impulse(kLength);
+	impulse[0] = 1.0f;
+
+	dsp::Crossover crossover(1, num_bands);
+	crossover.set_slope(slope);
+	for(size_t k = 0; k + 1 < num_bands; ++k) {
+		crossover.set_split(k, kSplits[k]);
+	}
+
+	std::vector<float> bands(kLength * num_bands);
+	std::vector<float *> out(num_bands);
+	for(size_t b = 0; b < num_bands; ++b) {
+		out[b] = &bands[b * kLength];
+	}
+	float const *in[1] = { &impulse[0] };
+	crossover.process_block(in, &out[0], kLength);
+
+	//! 全バンドの和
+	std::vector<float> sum(kLength);
+	for(size_t b = 0; b < num_bands; ++b) {
+		for(size_t i = 0; i < kLength; ++i) {
+			sum[i] += out[b][i];
+		}
+	}
+
+	dsp::RealFft fft(kLength);
+	std::vector<float> re(kLength / 2), im(kLength / 2);
+	fft.forward(&sum[0], &re[0], &im[0]);
+	double deviation = std::abs(20.0 * std::log10(std::abs(re[0])));
+	for(size_t k = 1; k < kLength / 2; ++k) {
+		double const mag = std::sqrt(re[k] * re[k] + im[k] * im[k]);
+		deviation = std::max(deviation, std::abs(20.0 * std::log10(mag)));
+	}
+
+	//! 同じ特性をSlopeFilterとBiquadで作ったものとの差
+	double diff = 0;
+	std::vector<float> stereo_in(kLength * kNumChannels);
+	stereo_in[0] = stereo_in[kLength] = 1.0f;
+	std::vector<float> chain_out(kLength * kNumChannels);
+	float const *chain_in[kNumChannels] = { &stereo_in[0], &stereo_in[kLength] };
+	float *chain_io[kNumChannels] = { &chain_out[0], &chain_out[kLength] };
+	for(size_t b = 0; b < num_bands; ++b) {
+		BandChain chain = make_band_chain(num_bands, b, slope + 1);
+		run_chain(chain, chain_in, chain_io, kLength);
+		for(size_t i = 0; i < kLength; ++i) {
+			diff = std::max(diff, static_cast<double>(std::abs(chain_out[i] - out[b][i])));
+		}
+	}
+
+	std::printf("%6zu %8s %16.2e %16.2e\n",
+		num_bands, (slope == dsp::CrossoverSlope::LR24) ? "LR24" : "LR48", deviation, diff);
+}
+
+Result	measure_crossover	(size_t num_bands, size_t slope)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	float const *in[kNumChannels] = { &left[0], &right[0] };
+	std::vector<float> buffer(kBlockSize * kNumChannels * num_bands);
+	std::vector<float *> out(kNumChannels * num_bands);
+	for(size_t i = 0; i < out.size(); ++i) {
+		out[i] = &buffer[i * kBlockSize];
+	}
+
+	dsp::Crossover crossover(kNumChannels, num_bands);
+	crossover.set_slope(slope);
+	for(size_t k = 0; k + 1 < num_bands; ++k) {
+		crossover.set_split(k, kSplits[k]);
+	}
+
+	return measure([&] {
+		crossover.process_block(in, &out[0], kBlockSize);
+	}, kBlockSize * kNumChannels);
+}
+
+Result	measure_chains	(size_t num_bands, size_t slope)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	float const *in[kNumChannels] = { &left[0], &right[0] };
+	std::vector<float> buffer(kBlockSize * kNumChannels * num_bands);
+	std::vector<float *> out(kNumChannels * num_bands);
+	for(size_t i = 0; i < out.size(); ++i) {
+		out[i] = &buffer[i * kBlockSize];
+	}
+
+	std::vector<BandChain> chains;
+	for(size_t b = 0; b < num_bands; ++b) {
+		chains.push_back(make_band_chain(num_bands, b, slope + 1));
+	}
+
+	return measure([&] {
+		for(size_t b = 0; b < num_bands; ++b) {
+			run_chain(chains[b], in, &out[b * kNumChannels], kBlockSize);
+		}
+	}, kBlockSize * kNumChannels);
+}
+
+}	//unnamed namespace
+
+//! クロスオーバーの正しさと、バンドごとにフィルタを並べた場合との処理コストの比較
+void	bench_crossover	()
+{
+	std::printf("\n== crossover: sum of all bands (fs = 48kHz, splits 200Hz, 2kHz, 8kHz) ==\n");
+	std::printf("%6s %8s %16s %16s\n", "bands", "slope", "flatness [dB]", "vs. biquads");
+	for(size_t slope = 0; slope < dsp::CrossoverSlope::kNumCrossoverSlope; ++slope) {
+		for(size_t bands = 2; bands <= dsp::kMaxCrossoverBands; ++bands) {
+			check_crossover(bands, slope);
+		}
+	}
+
+	char label[64];
+	for(size_t slope = 0; slope < dsp::CrossoverSlope::kNumCrossoverSlope; ++slope) {
+		char const *name = (slope == dsp::CrossoverSlope::LR24) ? "LR24" : "LR48";
+		std::snprintf(label, sizeof(label),
+			"crossover: %s stereo float, per input sample (all bands)", name);
+		print_title(label);
+		for(size_t bands = 2; bands <= dsp::kMaxCrossoverBands; ++bands) {
+			Result const chains = measure_chains(bands, slope);
+			std::snprintf(label, sizeof(label), "%zu bands, chain per band", bands);
+			print_result(label, chains, 0);
+
+			Result const fused = measure_crossover(bands, slope);
+			std::snprintf(label, sizeof(label), "%zu bands, one pass", bands);
+			print_result(label, fused, &chains);
+		}
+	}
+}
+
+}}	//namespace hwm::bench
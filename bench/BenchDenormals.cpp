@@ -0,0 +1,160 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/Denormals.hpp"
+#include "dsp/Svf.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+size_t const kNumChannels = 2;
+double const kSampleRate = 48000.0;
+
+//! インパルスの後の無音の長さと、結果を表示する区間
+double const kDuration = 3.0;
+double const kSegment = 0.25;
+
+struct Protection
+{
+	enum {
+		None,
+		FlushToZero,
+		FlushStates,
+		kNumProtection
+	};
+};
+
+char const *	get_protection_string	(size_t protection)
+{
+	switch(protection) {
+		case Protection::None:			return "none";
+		case Protection::FlushToZero:	return "FTZ/DAZ";
+		case Protection::FlushStates:	return "flush states";
+	}
+	return "unknown";
+}
+
+//! インパルスの後に無音を流し、区間ごとの1サンプルあたりのサイクル数を求める
+//! 各区間は数回の実行のうちもっとも速かった値
+//! @param make_filter () -> 係数を設定したフィルタ
+template<class Filter, class MakeFilter>
+std::vector<double>
+		run_decay	(MakeFilter make_filter, size_t protection, size_t &denormal_blocks)
+{
+	size_t const kNumTrials = 3;
+	size_t const num_blocks = static_cast<size_t>(kDuration * kSampleRate) / kBlockSize;
+	size_t const segment_blocks = static_cast<size_t>(kSegment * kSampleRate) / kBlockSize;
+	size_t const num_segments = num_blocks / segment_blocks;
+
+	std::vector<double> result(num_segments, 1e300);
+	std::vector<float> left(kBlockSize), right(kBlockSize);
+	float *io[kNumChannels] = { &left[0], &right[0] };
+	float const *in[kNumChannels] = { &left[0], &right[0] };
+
+	for(size_t trial = 0; trial < kNumTrials; ++trial) {
+		Filter filter = make_filter();
+		std::vector<double> cycles(num_segments);
+		denormal_blocks = 0;
+
+		for(size_t block = 0; block < num_segments * segment_blocks; ++block) {
+			std::fill(left.begin(), left.end(), 0.0f);
+			std::fill(right.begin(), right.end(), 0.0f);
+			if(block == 0) {
+				left[0] = right[0] = 1.0f;
+			}
+
+			unsigned long long const start = read_cycles();
+			if(protection == Protection::FlushToZero) {
+				dsp::ScopedFlushDenormals const flush;
+				filter.process_block(in, io, kBlockSize);
+			} else {
+				filter.process_block(in, io, kBlockSize);
+				if(protection == Protection::FlushStates) {
+					filter.flush_denormals();
+				}
+			}
+			cycles[block / segment_blocks] += static_cast<double>(read_cycles() - start);
+
+			//! 出力に非正規化数が出ているブロックを数える
+			for(size_t i = 0; i < kBlockSize; ++i) {
+				if(left[i] != 0 && std::abs(left[i]) < FLT_MIN) {
+					++denormal_blocks;
+					break;
+				}
+			}
+		}
+
+		for(size_t s = 0; s < num_segments; ++s) {
+			double const per_sample = cycles[s] / (segment_blocks * kBlockSize * kNumChannels);
+			result[s] = std::min(result[s], per_sample);
+		}
+	}
+
+	return result;
+}
+
+template<class Filter, class MakeFilter>
+void	print_decay	(char const *name, MakeFilter make_filter)
+{
+	std::printf("\n== denormals: %s, impulse then silence, cycles/sample ==\n", name);
+
+	std::vector<double> results[Protection::kNumProtection];
+	size_t denormal_blocks[Protection::kNumProtection];
+	for(size_t p = 0; p < Protection::kNumProtection; ++p) {
+		results[p] = run_decay<Filter>(make_filter, p, denormal_blocks[p]);
+	}
+
+	std::printf("%10s", "time [s]");
+	for(size_t p = 0; p < Protection::kNumProtection; ++p) {
+		std::printf(" %14s", get_protection_string(p));
+	}
+	std::printf("\n");
+	for(size_t s = 0; s < results[0].size(); ++s) {
+		std::printf("%10.2f", s * kSegment);
+		for(size_t p = 0; p < Protection::kNumProtection; ++p) {
+			std::printf(" %14.2f", results[p][s]);
+		}
+		std::printf("\n");
+	}
+	std::printf("%10s", "subnormal");
+	for(size_t p = 0; p < Protection::kNumProtection; ++p) {
+		std::printf(" %8zu blks", denormal_blocks[p]);
+	}
+	std::printf("\n");
+}
+
+}	//unnamed namespace
+
+//! 無音で状態が非正規化数になったときの処理コストと、FTZ/DAZ、状態のフラッシュの効果
+void	bench_denormals	()
+{
+#if !HWM_BENCH_HAS_TSC
+	std::printf("\n== denormals: skipped (no TSC) ==\n");
+	return;
+#endif
+
+	std::printf("\nFTZ/DAZ supported: %s\n", dsp::ScopedFlushDenormals::is_supported() ? "yes" : "no");
+
+	print_decay<dsp::Biquad>("biquad LPF 100Hz Q0.707 stereo float", [] {
+		dsp::Biquad filter(kNumChannels);
+		filter.set_coeffs(
+			dsp::design_biquad(dsp::FilterType::LPF, 100.0 / kSampleRate, 0.0, 0.707),
+			dsp::FilterType::LPF);
+		return filter;
+	});
+
+	print_decay<dsp::Svf>("SVF LPF 100Hz Q0.707 stereo float", [] {
+		dsp::Svf filter(kNumChannels);
+		filter.set_coeffs(
+			dsp::design_svf(dsp::FilterType::LPF, 100.0 / kSampleRate, 0.0, 0.707),
+			dsp::FilterType::LPF);
+		return filter;
+	});
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,134 @@
+#include "./Bench.hpp"
+#include "dsp/SmoothedFilter.hpp"
+
+#include <algorithm>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+//! 係数を毎回厳密に計算する
+//! パラメータはそのまま正規化周波数、dB、Qとして使う
+struct Designer
+{
+	dsp::BiquadCoeffs
+			operator()	(size_t filter_type, double cutoff, double gain, double Q) const
+	{
+		return dsp::design_biquad(filter_type, cutoff, gain, Q);
+	}
+};
+
+//! 1ブロックの中にnum_events個のパラメータの変更がある場合
+//! プラグインと同じく、変更の位置でブロックを分け、その位置から平滑化せずに新しい値を使う
+Result	measure_events	(size_t num_events)
+{
+	size_t const kBlockSize = 512;
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	dsp::SmoothedBiquad filter(2);
+	filter.reset_params(dsp::FilterType::PeakingEQ, 0.01, 6.0, 1.0);
+
+	Designer const design = {};
+	size_t count = 0;
+
+	return measure([&] {
+		size_t pos = 0;
+		for(size_t i = 0; i < num_events; ++i) {
+			size_t const offset = kBlockSize * i / num_events;
+			if(offset > pos) {
+				filter.process_block(design, in, out, pos, offset - pos);
+				pos = offset;
+			}
+			double const cutoff = (++count % 2) ? 0.01 : 0.02;
+			filter.reset_params(dsp::FilterType::PeakingEQ, cutoff, 6.0, 1.0);
+		}
+		filter.process_block(design, in, out, pos, kBlockSize - pos);
+	}, kBlockSize * 2);
+}
+
+//! イベントの位置で分けて1ブロックとして処理した結果が、
+//! イベントの位置を先頭とする別々のブロックとして処理した結果と一致するか
+//! レンダリングの結果をCIで比較できるよう、1ビットでも違えば不一致とする
+bool	split_matches_blocks	()
+{
+	size_t const kBlockSize = 1024;
+	size_t const offsets[] = { 0, 100, 700, kBlockSize };
+	double const cutoffs[] = { 0.01, 0.02, 0.005 };
+	size_t const num_segments = sizeof(cutoffs) / sizeof(cutoffs[0]);
+
+	std::vector<float> const left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> const right = make_noise<float>(kBlockSize, 2);
+	Designer const design = {};
+
+	//! 1ブロックをイベントの位置で分けて処理する
+	std::vector<float> split_l(kBlockSize), split_r(kBlockSize);
+	{
+		float const *in[2] = { &left[0], &right[0] };
+		float *out[2] = { &split_l[0], &split_r[0] };
+
+		dsp::SmoothedBiquad filter(2);
+		filter.reset_params(dsp::FilterType::PeakingEQ, cutoffs[0], 6.0, 1.0);
+		for(size_t i = 0; i < num_segments; ++i) {
+			if(i > 0) {
+				filter.reset_params(dsp::FilterType::PeakingEQ, cutoffs[i], 6.0, 1.0);
+			}
+			filter.process_block(design, in, out, offsets[i], offsets[i + 1] - offsets[i]);
+		}
+	}
+
+	//! イベントの位置ごとに別のバッファとして処理する
+	std::vector<float> block_l(kBlockSize), block_r(kBlockSize);
+	{
+		dsp::SmoothedBiquad filter(2);
+		filter.reset_params(dsp::FilterType::PeakingEQ, cutoffs[0], 6.0, 1.0);
+		for(size_t i = 0; i < num_segments; ++i) {
+			size_t const n = offsets[i + 1] - offsets[i];
+			std::vector<float> in_l(left.begin() + offsets[i], left.begin() + offsets[i + 1]);
+			std::vector<float> in_r(right.begin() + offsets[i], right.begin() + offsets[i + 1]);
+			std::vector<float> out_l(n), out_r(n);
+			float const *in[2] = { &in_l[0], &in_r[0] };
+			float *out[2] = { &out_l[0], &out_r[0] };
+
+			if(i > 0) {
+				filter.reset_params(dsp::FilterType::PeakingEQ, cutoffs[i], 6.0, 1.0);
+			}
+			filter.process_block(design, in, out, n);
+			std::copy(out_l.begin(), out_l.end(), block_l.begin() + offsets[i]);
+			std::copy(out_r.begin(), out_r.end(), block_r.begin() + offsets[i]);
+		}
+	}
+
+	return split_l == block_l && split_r == block_r;
+}
+
+}	//unnamed namespace
+
+//! サンプル位置つきのパラメータ変更で、ブロックを分けて処理するときのコスト
+//! 分けて処理した結果が、変更の位置で区切った別々のブロックの処理と一致すること、
+//! 変更のないブロックはそのままの速さで処理されることと、変更の数に応じてコストが増えることを確認する
+//! 係数の計算は変更の位置ごとに1回なので、変更が多いときのコストはほぼその計算になる
+void	bench_events	()
+{
+	size_t const counts[] = { 1, 4, 16, 64, 512 };
+	char label[64];
+
+	std::printf("\n");
+	report_check("events split == separate blocks", split_matches_blocks());
+
+	Result const base = measure_events(0);
+
+	print_title("events: PeakingEQ stereo float, 512-sample block, steps at the events");
+	print_result("no events", base, 0);
+
+	for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+		Result const r = measure_events(counts[i]);
+		std::snprintf(label, sizeof(label), "%4zu events per block", counts[i]);
+		print_result(label, r, &base);
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,57 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+
+namespace hwm { namespace bench {
+
+namespace {
+
+char const * const filter_names[dsp::FilterType::kNumFilterType] = {
+	"LPF", "HPF", "BPF", "notch", "APF", "PeakingEQ", "LowShelf", "HighShelf"
+};
+
+}	//unnamed namespace
+
+//! フィルタタイプごとに特殊化したカーネルと汎用カーネルの比較
+void	bench_filter_types	()
+{
+	size_t const kBlockSize = 512;
+
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	float *buffers[2] = { &left[0], &right[0] };
+
+	for(size_t c = 0; c < 2; ++c) {
+		size_t const num_channels = (c == 0) ? 1 : 2;
+		print_title(num_channels == 1
+			? "filter type kernels (mono, float, 512 samples)"
+			: "filter type kernels (stereo, float, 512 frames)");
+
+		for(size_t type = 0; type < dsp::FilterType::kNumFilterType; ++type) {
+			dsp::BiquadCoeffs const coeffs = dsp::design_biquad(type, 0.05, 6.0, 0.7);
+
+			dsp::Biquad generic(num_channels);
+			generic.set_coeffs(coeffs);
+			dsp::Biquad specialized(num_channels);
+			specialized.set_coeffs(coeffs, type);
+
+			//! 出力を入力に戻して処理し続けると値が発散しうるので、毎回同じ入力を使う
+			std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+			float *outs[2] = { &out_l[0], &out_r[0] };
+
+			Result const g = measure([&]() {
+				generic.process_block(buffers, outs, kBlockSize);
+			}, kBlockSize * num_channels);
+			Result const s = measure([&]() {
+				specialized.process_block(buffers, outs, kBlockSize);
+			}, kBlockSize * num_channels);
+
+			char label[64];
+			std::snprintf(label, sizeof(label), "%s generic", filter_names[type]);
+			print_result(label, g, 0);
+			std::snprintf(label, sizeof(label), "%s specialized", filter_names[type]);
+			print_result(label, s, &g);
+		}
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,145 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/TripleBuffer.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+//! 受け渡す値
+//! check_は他のメンバから計算できるので、書き込み途中の値を読めば一致しなくなる
+struct Snapshot
+{
+	size_t				seq_;
+	size_t				filter_type_;
+	dsp::BiquadCoeffs	coeffs_;
+	unsigned long long	check_;
+};
+
+unsigned long long
+		calc_check	(Snapshot const &s)
+{
+	unsigned long long h = 1469598103934665603ull;
+	unsigned char const *p = reinterpret_cast<unsigned char const *>(&s.coeffs_);
+	for(size_t i = 0; i < sizeof(s.coeffs_); ++i) {
+		h = (h ^ p[i]) * 1099511628211ull;
+	}
+	return h ^ s.seq_ ^ (s.filter_type_ << 56);
+}
+
+Snapshot
+		make_snapshot	(size_t seq)
+{
+	Snapshot s;
+	s.seq_ = seq;
+	s.filter_type_ = seq % dsp::FilterType::kNumFilterType;
+	//! 0.001 ~ 0.45 の範囲で、毎回違う係数にする
+	double const cutoff = 0.001 + 0.449 * ((seq * 7919) % 1000) / 1000.0;
+	double const Q = 0.5 + 9.5 * ((seq * 104729) % 1000) / 1000.0;
+	s.coeffs_ = dsp::design_biquad(s.filter_type_, cutoff, 12.0, Q);
+	s.check_ = calc_check(s);
+	return s;
+}
+
+}	//unnamed namespace
+
+//! GUI/ホストのスレッドからオーディオスレッドへの係数の受け渡しのストレステスト
+//! 書き込み側は休まず新しい値を書き込み、オーディオスレッドは
+//! ブロックごとに値を取り込んでフィルタをかける。
+//! 書き込み途中の値、順序が戻った値、有限でない出力をそれぞれ数える。すべて0になること
+void	bench_handoff	()
+{
+	double const kSeconds = 1.0;
+	size_t const kBlockSize = 64;
+
+	dsp::TripleBuffer<Snapshot> buffer(make_snapshot(0));
+	std::atomic<bool> done(false);
+	size_t num_writes = 0;
+
+	std::thread writer([&] {
+		size_t seq = 1;
+		while(!done.load(std::memory_order_relaxed)) {
+			buffer.write(make_snapshot(seq++));
+		}
+		num_writes = seq - 1;
+	});
+
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	float *bufs[2] = { &left[0], &right[0] };
+
+	dsp::Biquad filter(2);
+	size_t num_blocks = 0;
+	size_t num_updates = 0;
+	size_t num_torn = 0;
+	size_t num_reordered = 0;
+	size_t num_non_finite = 0;
+	size_t last_seq = 0;
+
+	typedef std::chrono::steady_clock clock;
+	clock::time_point const start = clock::now();
+	while(std::chrono::duration<double>(clock::now() - start).count() < kSeconds) {
+		if(buffer.update()) {
+			Snapshot const &s = buffer.get();
+			if(s.check_ != calc_check(s)) {
+				++num_torn;
+			}
+			if(s.seq_ < last_seq) {
+				++num_reordered;
+			}
+			last_seq = s.seq_;
+			filter.set_coeffs(s.coeffs_, s.filter_type_);
+			++num_updates;
+		}
+
+		//! 入力を毎ブロック作り直して、フィルタタイプの切り替えで発散しないようにする
+		for(size_t i = 0; i < kBlockSize; ++i) {
+			left[i] = static_cast<float>(std::sin(0.1 * i));
+			right[i] = static_cast<float>(std::cos(0.1 * i));
+		}
+		filter.process_block(bufs, bufs, kBlockSize);
+		for(size_t i = 0; i < kBlockSize; ++i) {
+			if(!std::isfinite(left[i]) || !std::isfinite(right[i])) {
+				++num_non_finite;
+				filter.clear_buffer();
+				break;
+			}
+		}
+		++num_blocks;
+	}
+
+	done = true;
+	writer.join();
+
+	std::printf("\n== handoff: triple buffer stress (%.1fs, %zu-sample blocks) ==\n",
+		kSeconds, kBlockSize);
+	std::printf("%-32s %12zu\n", "writes", num_writes);
+	std::printf("%-32s %12zu\n", "blocks", num_blocks);
+	std::printf("%-32s %12zu\n", "snapshots taken", num_updates);
+	std::printf("%-32s %12zu\n", "torn snapshots", num_torn);
+	std::printf("%-32s %12zu\n", "out-of-order snapshots", num_reordered);
+	std::printf("%-32s %12zu\n", "non-finite blocks", num_non_finite);
+	report_check("handoff",
+		num_torn == 0 && num_reordered == 0 && num_non_finite == 0);
+
+	//! 書き込みがないときにupdateがオーディオスレッドに課すコスト
+	//! 最後に書き込まれた値は先に取り込んでおく
+	buffer.update();
+	size_t sink = 0;
+	Result const r = measure([&] {
+		for(size_t i = 0; i < kBlockSize; ++i) {
+			sink += buffer.update();
+		}
+	}, kBlockSize);
+	print_title("handoff: update() without writes");
+	print_result("TripleBuffer::update", r, 0);
+	if(sink != 0) {
+		std::printf("(unexpected update)\n");
+	}
+}
+
+}}	//namespace hwm::bench
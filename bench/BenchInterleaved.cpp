@@ -0,0 +1,99 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/SampleFormat.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockFrames = 512;
+
+dsp::BiquadCoeffs const &
+		get_coeffs	()
+{
+	static dsp::BiquadCoeffs const coeffs =
+		dsp::design_biquad(dsp::FilterType::PeakingEQ, 0.05, 6.0, 2.0);
+	return coeffs;
+}
+
+//! チャンネルごとのバッファに並べ替えて処理し、インターリーブし直す
+struct PlanarPath
+{
+	PlanarPath	(size_t num_channels, size_t precision)
+		:	filter_(num_channels)
+		,	planar_(num_channels * kBlockFrames)
+		,	channels_(num_channels)
+	{
+		filter_.set_state_precision(precision);
+		filter_.set_coeffs(get_coeffs(), dsp::FilterType::PeakingEQ);
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			channels_[ch] = &planar_[ch * kBlockFrames];
+		}
+	}
+
+	void	process	(float *data)
+	{
+		size_t const num_channels = channels_.size();
+		dsp::deinterleave(data, num_channels, &channels_[0], kBlockFrames);
+		filter_.process_block(&channels_[0], &channels_[0], kBlockFrames);
+		dsp::interleave(&channels_[0], num_channels, data, kBlockFrames);
+	}
+
+	dsp::Biquad				filter_;
+	std::vector<float>		planar_;
+	std::vector<float *>	channels_;
+};
+
+void	run_case	(size_t num_channels, size_t precision, char const *precision_name)
+{
+	std::vector<float> const x = make_noise<float>(num_channels * kBlockFrames);
+	std::vector<float> planar_data = x;
+	std::vector<float> interleaved_data = x;
+
+	PlanarPath planar(num_channels, precision);
+	dsp::Biquad filter(num_channels);
+	filter.set_state_precision(precision);
+	filter.set_coeffs(get_coeffs(), dsp::FilterType::PeakingEQ);
+
+	//! 同じ入力の1ブロック目で出力を比べる
+	planar.process(&planar_data[0]);
+	filter.process_interleaved(&interleaved_data[0], num_channels, kBlockFrames);
+	double error = 0;
+	for(size_t i = 0; i < x.size(); ++i) {
+		error = std::max(error, std::abs(static_cast<double>(planar_data[i]) - interleaved_data[i]));
+	}
+
+	//! 同じバッファを繰り返し処理する。値は発散しないので、入力を戻す必要はない
+	Result const p = measure([&] { planar.process(&planar_data[0]); }, kBlockFrames * num_channels);
+	Result const q = measure([&] {
+		filter.process_interleaved(&interleaved_data[0], num_channels, kBlockFrames);
+	}, kBlockFrames * num_channels);
+
+	std::printf("%3u ch  %-14s %12.3f %12.3f %9.2fx %12.2e\n",
+		static_cast<unsigned>(num_channels), precision_name,
+		p.ns_per_sample_, q.ns_per_sample_, p.ns_per_sample_ / q.ns_per_sample_, error);
+}
+
+}	//unnamed namespace
+
+//! インターリーブされたfloatのバッファを、並べ替えてprocess_blockで処理する場合と、
+//! process_interleavedでその場で処理する場合の比較。値は1チャンネル1サンプルあたり
+void	bench_interleaved	()
+{
+	size_t const channels[] = { 1, 2, 4, 6, 8, 16 };
+	char const * const precision_names[] = { "double state", "float state" };
+
+	std::printf("\n== interleaved: PeakingEQ float I/O, %u frames, in place ==\n",
+		static_cast<unsigned>(kBlockFrames));
+	std::printf("%-22s %12s %12s %10s %12s\n", "", "planar ns", "interleaved", "ratio", "max diff");
+	for(size_t p = 0; p < dsp::StatePrecision::kNumStatePrecision; ++p) {
+		for(size_t i = 0; i < sizeof(channels) / sizeof(channels[0]); ++i) {
+			run_case(channels[i], p, precision_names[p]);
+		}
+	}
+}
+
+}}	//namespace hwm::bench
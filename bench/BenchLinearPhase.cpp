@@ -0,0 +1,203 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/LinearPhase.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+double const kSamplingRate = 48000.0;
+size_t const kHostBlockSize = 512;
+
+//! 計測に使う特性。100Hzのローシェルフ, 1kHzのピーキング, 8kHzのハイシェルフ
+dsp::ResponseSections
+		make_response	()
+{
+	dsp::ResponseSections r;
+	r.num_sections_ = 3;
+	r.sections_[0] = dsp::design_biquad(dsp::FilterType::LowShelf, 100.0 / kSamplingRate, 6.0, 0.7);
+	r.sections_[1] = dsp::design_biquad(dsp::FilterType::PeakingEQ, 1000.0 / kSamplingRate, -9.0, 2.0);
+	r.sections_[2] = dsp::design_biquad(dsp::FilterType::HighShelf, 8000.0 / kSamplingRate, 4.0, 0.7);
+	return r;
+}
+
+//! 正規化周波数fでの振幅特性[dB]
+double	response_db	(dsp::ResponseSections const &r, double f)
+{
+	double const w = 2.0 * 3.14159265358979323846 * f;
+	std::complex<double> const z1 = std::polar(1.0, -w);
+	std::complex<double> const z2 = z1 * z1;
+
+	std::complex<double> h = 1.0;
+	for(size_t i = 0; i < r.num_sections_; ++i) {
+		dsp::BiquadCoeffs const &s = r.sections_[i];
+		h *= (s.b0_ + s.b1_ * z1 + s.b2_ * z2) / (1.0 + s.a1_ * z1 + s.a2_ * z2);
+	}
+	return 20.0 * std::log10(std::abs(h));
+}
+
+//! FIRの正規化周波数fでの振幅特性[dB]
+double	fir_response_db	(std::vector<float> const &h, double f)
+{
+	double const w = 2.0 * 3.14159265358979323846 * f;
+	std::complex<double> sum = 0.0;
+	for(size_t n = 0; n < h.size(); ++n) {
+		sum += static_cast<double>(h[n]) * std::polar(1.0, -w * n);
+	}
+	return 20.0 * std::log10(std::abs(sum));
+}
+
+//! インパルスを入れて、出力のピーク位置と、ピークの前後の非対称性を調べる
+void	check_impulse	(size_t fir_length, size_t block_size)
+{
+	dsp::LinearPhaseFilter filter(1, fir_length, block_size);
+	filter.activate();
+	filter.set_response(make_response());
+	filter.wait_for_design();
+
+	//! クロスフェードが終わるまで無音を流す
+	size_t const length = filter.get_latency() + fir_length + block_size * (dsp::LinearPhaseFilter::kCrossfadeBlocks + 2);
+	std::vector<float> silence(block_size * (dsp::LinearPhaseFilter::kCrossfadeBlocks + 1));
+	std::vector<float> dummy(silence.size());
+	{
+		float const *in[1] = { &silence[0] };
+		float *out[1] = { &dummy[0] };
+		filter.process_block(in, out, silence.size());
+	}
+
+	std::vector<float> x(length), y(length);
+	x[0] = 1.0f;
+	float const *in[1] = { &x[0] };
+	float *out[1] = { &y[0] };
+	for(size_t pos = 0; pos < length; pos += kHostBlockSize) {
+		filter.process_block(in, out, pos, std::min(kHostBlockSize, length - pos));
+	}
+
+	size_t peak = 0;
+	for(size_t n = 0; n < length; ++n) {
+		if(std::abs(y[n]) > std::abs(y[peak])) {
+			peak = n;
+		}
+	}
+
+	double asymmetry = 0;
+	for(size_t k = 1; k < fir_length / 2 && k <= peak; ++k) {
+		asymmetry = std::max(asymmetry, static_cast<double>(std::abs(y[peak - k] - y[peak + k])));
+	}
+
+	std::printf("%8zu %8zu %10zu %10zu %14.2e\n",
+		fir_length, block_size, filter.get_latency(), peak, asymmetry);
+}
+
+Result	measure_linear	(size_t fir_length, size_t block_size)
+{
+	std::vector<float> left = make_noise<float>(kHostBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kHostBlockSize, 2);
+	std::vector<float> out_l(kHostBlockSize), out_r(kHostBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	dsp::LinearPhaseFilter filter(2, fir_length, block_size);
+	filter.activate();
+	filter.set_response(make_response());
+	filter.wait_for_design();
+
+	return measure([&] {
+		filter.process_block(in, out, kHostBlockSize);
+	}, kHostBlockSize * 2);
+}
+
+Result	measure_minimum	()
+{
+	std::vector<float> left = make_noise<float>(kHostBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kHostBlockSize, 2);
+	std::vector<float> out_l(kHostBlockSize), out_r(kHostBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	dsp::ResponseSections const r = make_response();
+	dsp::BiquadCascade cascade(2, r.num_sections_);
+	for(size_t i = 0; i < r.num_sections_; ++i) {
+		cascade.set_section(i, r.sections_[i]);
+	}
+
+	return measure([&] {
+		cascade.process_block(in, out, kHostBlockSize);
+	}, kHostBlockSize * 2);
+}
+
+//! 1コアで実時間処理できるステレオのインスタンス数
+double	instances_per_core	(Result const &r)
+{
+	return 1e9 / (r.ns_per_sample_ * 2 * kSamplingRate);
+}
+
+}	//unnamed namespace
+
+//! 線形位相イコライザの正しさと処理コスト
+void	bench_linear_phase	()
+{
+	std::printf("\n== linear_phase: impulse response (3 sections, fs = 48kHz) ==\n");
+	std::printf("%8s %8s %10s %10s %14s\n", "FIR", "block", "latency", "peak at", "asymmetry");
+	size_t const fir_lengths[] = { 1024, 4096 };
+	for(size_t i = 0; i < sizeof(fir_lengths) / sizeof(fir_lengths[0]); ++i) {
+		check_impulse(fir_lengths[i], 128);
+		check_impulse(fir_lengths[i], 512);
+	}
+
+	std::printf("\n== linear_phase: magnitude of the designed FIR vs. the IIR response ==\n");
+	std::printf("%10s %10s %10s %10s\n", "Hz", "IIR dB", "FIR 1024", "FIR 4096");
+	dsp::ResponseSections const response = make_response();
+	dsp::LinearPhaseKernel kernel;
+	dsp::LinearPhaseDesigner short_designer(1024, 256);
+	dsp::LinearPhaseDesigner long_designer(4096, 512);
+	short_designer.design(response, kernel);
+	long_designer.design(response, kernel);
+	double const freqs[] = { 30, 100, 300, 1000, 3000, 8000, 16000 };
+	for(size_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); ++i) {
+		double const f = freqs[i] / kSamplingRate;
+		std::printf("%10.0f %10.2f %10.2f %10.2f\n", freqs[i], response_db(response, f),
+			fir_response_db(short_designer.get_fir(), f), fir_response_db(long_designer.get_fir(), f));
+	}
+
+	std::printf("\n== linear_phase: FIR design time (background thread) ==\n");
+	size_t const design_lengths[] = { 1024, 4096, 16384 };
+	for(size_t i = 0; i < sizeof(design_lengths) / sizeof(design_lengths[0]); ++i) {
+		dsp::LinearPhaseDesigner designer(design_lengths[i], 512);
+		size_t const kRepeat = 16;
+		std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+		for(size_t k = 0; k < kRepeat; ++k) {
+			designer.design(response, kernel);
+		}
+		double const elapsed =
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("FIR %6zu: %10.3f ms\n", design_lengths[i], elapsed * 1e3 / kRepeat);
+	}
+
+	print_title("linear_phase: stereo float, FIR 4096 taps");
+	Result const minimum = measure_minimum();
+	print_result("minimum phase (cascade)", minimum, 0);
+
+	size_t const block_sizes[] = { 128, 256, 512, 1024, 2048 };
+	Result results[sizeof(block_sizes) / sizeof(block_sizes[0])];
+	char label[64];
+	for(size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); ++i) {
+		results[i] = measure_linear(4096, block_sizes[i]);
+		std::snprintf(label, sizeof(label), "linear, block %4zu", block_sizes[i]);
+		print_result(label, results[i], &minimum);
+	}
+
+	std::printf("\n%-32s %10s %16s\n", "", "latency", "instances/core");
+	for(size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); ++i) {
+		std::snprintf(label, sizeof(label), "linear, block %4zu", block_sizes[i]);
+		std::printf("%-32s %10zu %16.0f\n",
+			label, static_cast<size_t>(4096 / 2 + block_sizes[i]), instances_per_core(results[i]));
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,202 @@
+#define _USE_MATH_DEFINES
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/Fft.hpp"
+#include "dsp/Oversampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+size_t const kNumChannels = 2;
+double const kSampleRate = 48000.0;
+
+//! 通過域と阻止域(48kHz)
+double const kPassband = 20000.0;
+double const kStopband = 28000.0;
+
+double	to_db	(double x)
+{
+	return 20.0 * std::log10(std::max(x, 1e-30));
+}
+
+//! インパルスをアップサンプリングして、イメージの減衰量と、
+//! もとのレートに戻したときの通過域のリップルを求める
+void	check_quality	(size_t factor)
+{
+	size_t const kLength = 4096;
+	size_t const n = dsp::Oversampler::kMaxBlockSize;
+
+	dsp::Oversampler os(1, factor);
+	std::vector<double> impulse(kLength);
+	impulse[0] = 1.0;
+	std::vector<double> fast(kLength * factor);
+	std::vector<double> round_trip(kLength);
+	for(size_t i = 0; i < kLength; i += n) {
+		os.upsample(0, &impulse[i], &fast[i * factor], n);
+		os.downsample(0, &fast[i * factor], &round_trip[i], n);
+	}
+
+	//! アップサンプリングだけ。0を挿入した分、ゲインはfactor倍で正しい
+	std::vector<float> x(fast.begin(), fast.end());
+	dsp::RealFft fast_fft(kLength * factor);
+	std::vector<float> re(kLength * factor / 2), im(kLength * factor / 2);
+	fast_fft.forward(&x[0], &re[0], &im[0]);
+	double image = 0;
+	for(size_t k = 1; k < re.size(); ++k) {
+		double const freq = k * kSampleRate * factor / (kLength * factor);
+		if(freq >= kStopband) {
+			image = std::max(image, std::sqrt(static_cast<double>(re[k] * re[k] + im[k] * im[k])) / factor);
+		}
+	}
+
+	std::vector<float> y(round_trip.begin(), round_trip.end());
+	dsp::RealFft fft(kLength);
+	re.resize(kLength / 2);
+	im.resize(kLength / 2);
+	fft.forward(&y[0], &re[0], &im[0]);
+	double ripple = std::abs(to_db(std::abs(re[0])));
+	for(size_t k = 1; k < re.size(); ++k) {
+		double const freq = k * kSampleRate / kLength;
+		if(freq <= kPassband) {
+			ripple = std::max(ripple, std::abs(to_db(std::sqrt(static_cast<double>(re[k] * re[k] + im[k] * im[k])))));
+		}
+	}
+
+	//! インパルスのピークの位置が遅延
+	size_t const peak = std::max_element(y.begin(), y.end()) - y.begin();
+
+	std::printf("%6zux %12zu %12zu %16.2e %14.1f\n",
+		factor, os.get_latency(), peak, ripple, to_db(image));
+}
+
+//! アップとダウンだけのコスト
+Result	measure_resampling	(size_t factor)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	float const *in[kNumChannels] = { &left[0], &right[0] };
+	std::vector<float> out(kBlockSize);
+	std::vector<double> fast(dsp::Oversampler::kMaxBlockSize * factor);
+	size_t const n = dsp::Oversampler::kMaxBlockSize;
+
+	dsp::Oversampler os(kNumChannels, factor);
+	return measure([&] {
+		for(size_t i = 0; i < kBlockSize; i += n) {
+			for(size_t ch = 0; ch < kNumChannels; ++ch) {
+				os.upsample(ch, in[ch] + i, &fast[0], n);
+				os.downsample(ch, &fast[0], &out[i], n);
+			}
+		}
+	}, kBlockSize * kNumChannels);
+}
+
+//! factor倍のレートでPeaking EQを1段かけたときの全体のコスト
+Result	measure_filter	(size_t factor)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	float const *in[kNumChannels] = { &left[0], &right[0] };
+	std::vector<float> out_left(kBlockSize), out_right(kBlockSize);
+	float *out[kNumChannels] = { &out_left[0], &out_right[0] };
+
+	size_t const n = dsp::Oversampler::kMaxBlockSize;
+	std::vector<double> fast(n * factor * kNumChannels);
+	double *io[kNumChannels] = { &fast[0], &fast[n * factor] };
+	double const *fast_in[kNumChannels] = { io[0], io[1] };
+
+	dsp::Oversampler os(kNumChannels, factor);
+	dsp::Biquad biquad(kNumChannels);
+	biquad.set_coeffs(
+		dsp::design_biquad(dsp::FilterType::PeakingEQ, 16000.0 / (kSampleRate * factor), 12.0, 2.0),
+		dsp::FilterType::PeakingEQ);
+
+	if(factor == 1) {
+		return measure([&] {
+			biquad.process_block(in, out, kBlockSize);
+		}, kBlockSize * kNumChannels);
+	}
+
+	return measure([&] {
+		for(size_t i = 0; i < kBlockSize; i += n) {
+			for(size_t ch = 0; ch < kNumChannels; ++ch) {
+				os.upsample(ch, in[ch] + i, io[ch], n);
+			}
+			biquad.process_block(fast_in, io, n * factor);
+			for(size_t ch = 0; ch < kNumChannels; ++ch) {
+				os.downsample(ch, io[ch], out[ch] + i, n);
+			}
+		}
+	}, kBlockSize * kNumChannels);
+}
+
+//! 係数のz = exp(j * 2pi * freq)での振幅
+double	get_magnitude	(dsp::BiquadCoeffs const &c, double freq)
+{
+	std::complex<double> const z1 = std::polar(1.0, -2.0 * M_PI * freq);
+	std::complex<double> const z2 = z1 * z1;
+	return std::abs((c.b0_ + c.b1_ * z1 + c.b2_ * z2) / (1.0 + c.a1_ * z1 + c.a2_ * z2));
+}
+
+//! アナログのPeaking EQの振幅
+double	get_analog_magnitude	(double freq, double center, double db_gain, double Q)
+{
+	double const A = std::pow(10.0, db_gain / 40.0);
+	std::complex<double> const s(0.0, freq / center);
+	return std::abs((s * s + s * (A / Q) + 1.0) / (s * s + s / (A * Q) + 1.0));
+}
+
+//! 16kHzのPeaking EQの、アナログのプロトタイプからのずれ
+void	print_cramping	()
+{
+	double const kCenter = 16000.0;
+	double const kGain = 12.0;
+	double const kQ = 2.0;
+	double const kFreqs[] = { 4000.0, 8000.0, 12000.0, 16000.0, 18000.0, 20000.0 };
+	size_t const kFactors[] = { 1, 2, 4 };
+
+	std::printf("\n== oversampling: peaking EQ 16kHz +12dB Q2 (fs = 48kHz), gain [dB] ==\n");
+	std::printf("%8s %10s %10s %10s %10s\n", "freq", "analog", "1x", "2x", "4x");
+	for(size_t i = 0; i < sizeof(kFreqs) / sizeof(kFreqs[0]); ++i) {
+		std::printf("%8.0f %10.2f", kFreqs[i], to_db(get_analog_magnitude(kFreqs[i], kCenter, kGain, kQ)));
+		for(size_t j = 0; j < sizeof(kFactors) / sizeof(kFactors[0]); ++j) {
+			double const fs = kSampleRate * kFactors[j];
+			dsp::BiquadCoeffs const c =
+				dsp::design_biquad(dsp::FilterType::PeakingEQ, kCenter / fs, kGain, kQ);
+			std::printf(" %10.2f", to_db(get_magnitude(c, kFreqs[i] / fs)));
+		}
+		std::printf("\n");
+	}
+}
+
+}	//unnamed namespace
+
+//! オーバーサンプリングの品質と処理コスト
+void	bench_oversampling	()
+{
+	print_cramping();
+
+	std::printf("\n== oversampling: half-band FIR (fs = 48kHz, pass %.0fHz, stop %.0fHz) ==\n",
+		kPassband, kStopband);
+	std::printf("%7s %12s %12s %16s %14s\n", "factor", "latency", "peak at", "ripple [dB]", "image [dB]");
+	check_quality(2);
+	check_quality(4);
+
+	print_title("oversampling: stereo float, per input sample");
+	Result const base = measure_filter(1);
+	print_result("peaking EQ at 1x", base, 0);
+	char label[64];
+	for(size_t factor = 2; factor <= dsp::Oversampler::kMaxFactor; factor *= 2) {
+		std::snprintf(label, sizeof(label), "up + down %zux", factor);
+		print_result(label, measure_resampling(factor), &base);
+		std::snprintf(label, sizeof(label), "peaking EQ at %zux", factor);
+		print_result(label, measure_filter(factor), &base);
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,107 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+char const * const filter_names[dsp::FilterType::kNumFilterType] = {
+	"LPF", "HPF", "BPF", "notch", "APF", "PeakingEQ", "LowShelf", "HighShelf"
+};
+
+//! 倍精度の結果に対する誤差のRMSを、倍精度の結果のRMSに対するdBで返す
+template<class T>
+double	error_floor_db	(std::vector<double> const &ref, std::vector<T> const &out)
+{
+	double err = 0, sig = 0;
+	for(size_t i = 0; i < ref.size(); ++i) {
+		double const d = static_cast<double>(out[i]) - ref[i];
+		err += d * d;
+		sig += ref[i] * ref[i];
+	}
+	if(err == 0) {
+		return -400.0;
+	}
+	return 10.0 * std::log10(err / sig);
+}
+
+}	//unnamed namespace
+
+//! 精度ポリシーごとのノイズフロアと処理速度
+//!   double        : double入出力、倍精度の遅延子
+//!   float/double  : float入出力、倍精度の遅延子
+//!   float         : float入出力、単精度の遅延子
+void	bench_precision	()
+{
+	size_t const kLength = 1 << 16;
+	//! 48kHzで 50Hz, 1kHz, 10kHz
+	double const cutoffs[] = { 50.0 / 48000, 1000.0 / 48000, 10000.0 / 48000 };
+
+	std::vector<float> const input = make_noise<float>(kLength);
+	std::vector<double> const input_d(input.begin(), input.end());
+
+	std::printf("\n== precision: error floor vs. double (dB re. output RMS) ==\n");
+	std::printf("%-12s %10s %14s %14s\n", "", "cutoff", "float/double", "float");
+
+	for(size_t type = 0; type < dsp::FilterType::kNumFilterType; ++type) {
+		for(size_t c = 0; c < sizeof(cutoffs) / sizeof(cutoffs[0]); ++c) {
+			dsp::BiquadCoeffs const coeffs = dsp::design_biquad(type, cutoffs[c], 6.0, 2.0);
+
+			std::vector<double> ref(kLength);
+			std::vector<float> mixed(kLength), single(kLength);
+
+			dsp::Biquad f(1);
+			f.set_coeffs(coeffs, type);
+			f.process_block(0, &input_d[0], &ref[0], kLength);
+
+			f.clear_buffer();
+			f.process_block(0, &input[0], &mixed[0], kLength);
+
+			f.clear_buffer();
+			f.set_state_precision(dsp::StatePrecision::Float);
+			f.process_block(0, &input[0], &single[0], kLength);
+
+			std::printf("%-12s %8.0fHz %14.1f %14.1f\n",
+				filter_names[type], cutoffs[c] * 48000,
+				error_floor_db(ref, mixed), error_floor_db(ref, single));
+		}
+	}
+
+	size_t const kBlockSize = 512;
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<double> left_d(left.begin(), left.end());
+	std::vector<double> right_d(right.begin(), right.end());
+	float *bufs[2] = { &left[0], &right[0] };
+	double *bufs_d[2] = { &left_d[0], &right_d[0] };
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	std::vector<double> out_l_d(kBlockSize), out_r_d(kBlockSize);
+	float *outs[2] = { &out_l[0], &out_r[0] };
+	double *outs_d[2] = { &out_l_d[0], &out_r_d[0] };
+
+	print_title("precision: speed (stereo, PeakingEQ, 512 frames)");
+
+	dsp::BiquadCoeffs const coeffs =
+		dsp::design_biquad(dsp::FilterType::PeakingEQ, 0.02, 6.0, 2.0);
+	dsp::Biquad f(2);
+	f.set_coeffs(coeffs, dsp::FilterType::PeakingEQ);
+
+	Result const d = measure([&]() {
+		f.process_block(bufs_d, outs_d, kBlockSize);
+	}, kBlockSize * 2);
+	Result const m = measure([&]() {
+		f.process_block(bufs, outs, kBlockSize);
+	}, kBlockSize * 2);
+	f.set_state_precision(dsp::StatePrecision::Float);
+	Result const s = measure([&]() {
+		f.process_block(bufs, outs, kBlockSize);
+	}, kBlockSize * 2);
+
+	print_result("double", d, 0);
+	print_result("float/double", m, &d);
+	print_result("float", s, &d);
+}
+
+}}	//namespace hwm::bench
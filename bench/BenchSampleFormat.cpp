@@ -0,0 +1,85 @@
+#include "./Bench.hpp"
+#include "dsp/CpuFeatures.hpp"
+#include "dsp/SampleFormat.hpp"
+
+#include <algorithm>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+//! インターリーブされたステレオ4096フレーム
+size_t const kNumFrames = 4096;
+size_t const kNumChannels = 2;
+size_t const kNumSamples = kNumFrames * kNumChannels;
+
+char const *	get_format_string	(size_t format)
+{
+	switch(format) {
+		case dsp::SampleFormat::Int16:		return "int16";
+		case dsp::SampleFormat::Int24:		return "int24";
+		case dsp::SampleFormat::Int32:		return "int32";
+		case dsp::SampleFormat::Float32:	return "float32";
+	}
+	return "unknown";
+}
+
+}	//unnamed namespace
+
+//! ファイルのサンプルとfloatの変換と、インターリーブの解除のコスト
+void	bench_sample_format	()
+{
+	std::vector<float> const noise = make_noise<float>(kNumSamples);
+	std::vector<float> decoded(kNumSamples);
+	std::vector<unsigned char> encoded(kNumSamples * 4);
+	std::vector<float> left(kNumFrames), right(kNumFrames);
+	float * const planar[kNumChannels] = { &left[0], &right[0] };
+
+	size_t const max_level = dsp::get_simd_level();
+	for(size_t format = 0; format < dsp::SampleFormat::kNumSampleFormat; ++format) {
+		char title[64];
+		std::snprintf(title, sizeof(title), "sample_format: %s <-> float, per sample", get_format_string(format));
+		print_title(title);
+
+		dsp::encode_samples(format, &noise[0], &encoded[0], kNumSamples);
+
+		Result decode_scalar = {};
+		Result encode_scalar = {};
+		for(size_t level = dsp::SimdLevel::Scalar; level <= std::min<size_t>(max_level, dsp::SimdLevel::SSE2); ++level) {
+			dsp::set_simd_level_limit(level);
+			Result const decode = measure([&] {
+				dsp::decode_samples(format, &encoded[0], &decoded[0], kNumSamples);
+			}, kNumSamples);
+			Result const encode = measure([&] {
+				dsp::encode_samples(format, &noise[0], &encoded[0], kNumSamples);
+			}, kNumSamples);
+			if(level == dsp::SimdLevel::Scalar) {
+				decode_scalar = decode;
+				encode_scalar = encode;
+			}
+
+			char label[64];
+			std::snprintf(label, sizeof(label), "decode, %s", dsp::get_simd_level_string(level));
+			print_result(label, decode, level == dsp::SimdLevel::Scalar ? 0 : &decode_scalar);
+			std::snprintf(label, sizeof(label), "encode, %s", dsp::get_simd_level_string(level));
+			print_result(label, encode, level == dsp::SimdLevel::Scalar ? 0 : &encode_scalar);
+		}
+	}
+
+	print_title("sample_format: stereo deinterleave + interleave, per sample");
+	Result scalar = {};
+	for(size_t level = dsp::SimdLevel::Scalar; level <= std::min<size_t>(max_level, dsp::SimdLevel::SSE2); ++level) {
+		dsp::set_simd_level_limit(level);
+		Result const r = measure([&] {
+			dsp::deinterleave(&noise[0], kNumChannels, planar, kNumFrames);
+			dsp::interleave(planar, kNumChannels, &decoded[0], kNumFrames);
+		}, kNumSamples);
+		if(level == dsp::SimdLevel::Scalar) {
+			scalar = r;
+		}
+		print_result(dsp::get_simd_level_string(level), r, level == dsp::SimdLevel::Scalar ? 0 : &scalar);
+	}
+	dsp::set_simd_level_limit(dsp::SimdLevel::kNumSimdLevel);
+}
+
+}}	//namespace hwm::bench
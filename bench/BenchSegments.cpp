@@ -0,0 +1,106 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/SegmentedBiquad.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+//! mve_renderの--parallelと同じ区間の長さ
+size_t const kSegmentLength = 1 << 16;
+size_t const kNumSegments = 8;
+size_t const kLength = kSegmentLength * kNumSegments;
+double const kSampleRate = 48000.0;
+
+struct SegmentCase
+{
+	char const *	name_;
+	size_t			filter_type_;
+	double			freq_;
+	double			db_gain_;
+	double			Q_;
+};
+
+//! 区間ごとに状態0から処理し、状態を引き継いで零入力応答を足す
+//! 実際には区間ごとの処理は別々のスレッドで行う
+void	process_segmented	(dsp::BiquadCoeffs const &coeffs, size_t filter_type,
+							 std::vector<dsp::Biquad> &biquads,
+							 double const *in, double *out)
+{
+	for(size_t k = 0; k < kNumSegments; ++k) {
+		double const *src[1] = { in + k * kSegmentLength };
+		double *dst[1] = { out + k * kSegmentLength };
+		biquads[k].set_coeffs(coeffs, filter_type);
+		biquads[k].clear_buffer();
+		biquads[k].process_block(src, dst, kSegmentLength);
+	}
+
+	dsp::StateTransition const transition = dsp::make_state_transition(coeffs, kSegmentLength);
+	dsp::BiquadState state = biquads[0].get_state(0);
+	for(size_t k = 1; k < kNumSegments; ++k) {
+		dsp::add_zero_input_response(coeffs, state, out + k * kSegmentLength, kSegmentLength);
+		state = dsp::carry_state(transition, state, biquads[k].get_state(0));
+	}
+}
+
+void	run_case	(SegmentCase const &c, std::vector<double> const &x)
+{
+	dsp::BiquadCoeffs const coeffs =
+		dsp::design_biquad(c.filter_type_, c.freq_ / kSampleRate, c.db_gain_, c.Q_);
+
+	std::vector<double> sequential(kLength);
+	std::vector<double> segmented(kLength);
+
+	dsp::Biquad biquad(1);
+	biquad.set_coeffs(coeffs, c.filter_type_);
+	double const *in[1] = { &x[0] };
+	double *out[1] = { &sequential[0] };
+	Result const seq = measure([&] {
+		biquad.clear_buffer();
+		biquad.process_block(in, out, kLength);
+	}, kLength);
+
+	std::vector<dsp::Biquad> biquads(kNumSegments, dsp::Biquad(1));
+	Result const seg = measure([&] {
+		process_segmented(coeffs, c.filter_type_, biquads, &x[0], &segmented[0]);
+	}, kLength);
+
+	double peak = 0;
+	double error = 0;
+	for(size_t i = 0; i < kLength; ++i) {
+		peak = std::max(peak, std::abs(sequential[i]));
+		error = std::max(error, std::abs(sequential[i] - segmented[i]));
+	}
+
+	std::printf("%-24s %10.3f %10.3f %9.3fx %12.2e\n",
+		c.name_, seq.ns_per_sample_, seg.ns_per_sample_,
+		seg.ns_per_sample_ / seq.ns_per_sample_, error / peak);
+}
+
+}	//unnamed namespace
+
+//! 区間に分けて処理したときの、逐次処理との誤差と、1スレッドあたりの仕事量の増加
+void	bench_segments	()
+{
+	static SegmentCase const cases[] = {
+		{ "LPF 1kHz Q0.707",		dsp::FilterType::LPF,		1000.0,	0.0,	0.707 },
+		{ "LPF 30Hz Q18",			dsp::FilterType::LPF,		30.0,	0.0,	18.0 },
+		{ "HPF 40Hz Q10",			dsp::FilterType::HPF,		40.0,	0.0,	10.0 },
+		{ "peaking 100Hz +20dB Q4",	dsp::FilterType::PeakingEQ,	100.0,	20.0,	4.0 },
+		{ "notch 1kHz Q30",			dsp::FilterType::notch,		1000.0,	0.0,	30.0 },
+	};
+
+	std::vector<double> const x = make_noise<double>(kLength);
+
+	std::printf("\n== segments: %u segments of %u samples, mono double (fs = 48kHz) ==\n",
+		static_cast<unsigned>(kNumSegments), static_cast<unsigned>(kSegmentLength));
+	std::printf("%-24s %10s %10s %10s %12s\n", "filter", "seq ns/smp", "seg ns/smp", "work", "max error");
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		run_case(cases[i], x);
+	}
+}
+
+}}	//namespace hwm::bench
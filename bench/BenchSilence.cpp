@@ -0,0 +1,133 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/CpuFeatures.hpp"
+#include "dsp/Silence.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+size_t const kNumChannels = 2;
+double const kSampleRate = 48000.0;
+
+//! プラグインと同じ、尾の長さを決める減衰量と無音の閾値
+double const kTailDecay = 1e-7;
+double const kSilenceThreshold = 1e-6;
+
+struct TailCase
+{
+	char const *	name_;
+	size_t			filter_type_;
+	double			freq_;
+	double			db_gain_;
+	double			Q_;
+};
+
+//! 極の絶対値から求めた尾の長さと、インパルス応答が実際に閾値を下回る位置を比べる
+void	check_tail	(TailCase const &c)
+{
+	dsp::BiquadCoeffs const coeffs =
+		dsp::design_biquad(c.filter_type_, c.freq_ / kSampleRate, c.db_gain_, c.Q_);
+	double const radius = dsp::get_pole_radius(coeffs);
+	size_t const max_length = static_cast<size_t>(10.0 * kSampleRate);
+	size_t const predicted = dsp::get_decay_length(radius, kTailDecay, max_length);
+
+	//! 0dBFSのインパルスの応答が最後にkSilenceThresholdを超えた位置
+	size_t const length = predicted * 2 + kBlockSize;
+	std::vector<double> x(length);
+	x[0] = 1.0;
+	dsp::Biquad biquad(1);
+	biquad.set_coeffs(coeffs, c.filter_type_);
+	double const *in[1] = { &x[0] };
+	double *out[1] = { &x[0] };
+	biquad.process_block(in, out, length);
+
+	size_t last = 0;
+	for(size_t i = 0; i < length; ++i) {
+		if(std::abs(x[i]) > kSilenceThreshold) {
+			last = i + 1;
+		}
+	}
+
+	std::printf("%-24s %12.8f %12zu %12zu\n", c.name_, radius, predicted, last);
+}
+
+//! 1チャンネルずつ、素直なループで最大を探す
+float	get_peak_scalar	(float const *p, size_t n)
+{
+	float peak = 0;
+	for(size_t i = 0; i < n; ++i) {
+		peak = std::max(peak, std::abs(p[i]));
+	}
+	return peak;
+}
+
+Result	measure_scalar	(std::vector<float> const &left, std::vector<float> const &right)
+{
+	float volatile sink = 0;
+	return measure([&] {
+		sink = std::max(get_peak_scalar(&left[0], kBlockSize), get_peak_scalar(&right[0], kBlockSize));
+	}, kBlockSize * kNumChannels);
+}
+
+Result	measure_is_silent	(float const * const *in)
+{
+	bool volatile sink = false;
+	return measure([&] {
+		sink = dsp::is_silent(in, kNumChannels, 0, kBlockSize, kSilenceThreshold);
+	}, kBlockSize * kNumChannels);
+}
+
+}	//unnamed namespace
+
+//! 無音の判定のコストと、極から求めた尾の長さの確認
+void	bench_silence	()
+{
+	static TailCase const cases[] = {
+		{ "LPF 1kHz Q0.707",		dsp::FilterType::LPF,		1000.0,	0.0,	0.707 },
+		{ "LPF 40Hz Q0.707",		dsp::FilterType::LPF,		40.0,	0.0,	0.707 },
+		{ "HPF 40Hz Q10",			dsp::FilterType::HPF,		40.0,	0.0,	10.0 },
+		{ "peaking 100Hz +20dB Q4",	dsp::FilterType::PeakingEQ,	100.0,	20.0,	4.0 },
+		{ "notch 1kHz Q30",			dsp::FilterType::notch,		1000.0,	0.0,	30.0 },
+	};
+
+	std::printf("\n== silence: tail length from pole radius (fs = 48kHz, -140dB / -120dBFS) ==\n");
+	std::printf("%-24s %12s %12s %12s\n", "filter", "radius", "predicted", "measured");
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		check_tail(cases[i]);
+	}
+
+	//! 無音の判定はブロック全体を読むので、判定が一番遅くなる無音の入力で測る
+	std::vector<float> left(kBlockSize, 1e-7f);
+	std::vector<float> right(kBlockSize, -1e-7f);
+	float const *in[kNumChannels] = { &left[0], &right[0] };
+
+	print_title("silence: stereo float, per input sample");
+	Result const scalar = measure_scalar(left, right);
+	print_result("peak, plain loop", scalar, 0);
+	size_t const max_level = dsp::get_simd_level();
+	for(size_t level = dsp::SimdLevel::Scalar; level <= max_level; ++level) {
+		dsp::set_simd_level_limit(level);
+		char label[64];
+		std::snprintf(label, sizeof(label), "is_silent, %s", dsp::get_simd_level_string(level));
+		print_result(label, measure_is_silent(in), &scalar);
+	}
+	dsp::set_simd_level_limit(dsp::SimdLevel::kNumSimdLevel);
+
+	//! バイパスしないときにかかる、最も軽いフィルタの処理
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float *out[kNumChannels] = { &out_l[0], &out_r[0] };
+	dsp::Biquad biquad(kNumChannels);
+	biquad.set_coeffs(
+		dsp::design_biquad(dsp::FilterType::PeakingEQ, 1000.0 / kSampleRate, 6.0, 0.707),
+		dsp::FilterType::PeakingEQ);
+	print_result("peaking EQ (not bypassed)", measure([&] {
+		biquad.process_block(in, out, kBlockSize);
+	}, kBlockSize * kNumChannels), &scalar);
+}
+
+}}	//namespace hwm::bench
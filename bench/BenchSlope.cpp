@@ -0,0 +1,106 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/SlopeFilter.hpp"
+
+#include <cmath>
+#include <complex>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+size_t const kBlockSize = 512;
+double const kCutoff = 1000.0 / 48000.0;
+
+//! 正規化周波数fでの振幅特性[dB]
+double	response_db	(dsp::SlopeCoeffs const &c, double f)
+{
+	double const w = 2.0 * 3.14159265358979323846 * f;
+	std::complex<double> const z1 = std::polar(1.0, -w);
+	std::complex<double> const z2 = z1 * z1;
+
+	std::complex<double> h = 1.0;
+	for(size_t i = 0; i < c.num_sections_; ++i) {
+		dsp::BiquadCoeffs const &s = c.sections_[i];
+		h *= (s.b0_ + s.b1_ * z1 + s.b2_ * z2) / (1.0 + s.a1_ * z1 + s.a2_ * z2);
+	}
+	return 20.0 * std::log10(std::abs(h));
+}
+
+//! セクションごとにBiquadを並べ、1セクションずつブロック全体を処理する
+//! 高次のフィルタをプラグインのインスタンスを並べて作った場合に相当する
+Result	measure_chained	(dsp::SlopeCoeffs const &c)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+	float const *io_in[2] = { &out_l[0], &out_r[0] };
+
+	std::vector<dsp::Biquad> stages(c.num_sections_, dsp::Biquad(2));
+	for(size_t i = 0; i < c.num_sections_; ++i) {
+		stages[i].set_coeffs(c.sections_[i], dsp::FilterType::LPF);
+	}
+
+	return measure([&] {
+		stages[0].process_block(in, out, kBlockSize);
+		for(size_t i = 1; i < stages.size(); ++i) {
+			stages[i].process_block(io_in, out, kBlockSize);
+		}
+	}, kBlockSize * 2);
+}
+
+Result	measure_slope	(dsp::SlopeCoeffs const &c)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	dsp::SlopeFilter filter(2);
+	filter.set_coeffs(c, dsp::FilterType::LPF);
+
+	return measure([&] {
+		filter.process_block(in, out, kBlockSize);
+	}, kBlockSize * 2);
+}
+
+}	//unnamed namespace
+
+//! 高次のLPFの特性と、傾きごとの処理コスト
+void	bench_slope	()
+{
+	char const * const alignment_names[dsp::Alignment::kNumAlignment] = {
+		"Butterworth", "Linkwitz-Riley"
+	};
+
+	std::printf("\n== slope: LPF response at fc = 1kHz (fs = 48kHz) ==\n");
+	std::printf("%-16s %8s %10s %10s %12s\n", "", "dB/oct", "at fc", "at 2 fc", "at fc / 2");
+	for(size_t a = 0; a < dsp::Alignment::kNumAlignment; ++a) {
+		for(size_t n = 1; n <= dsp::kMaxSlopeSections; ++n) {
+			dsp::SlopeCoeffs const c = dsp::design_slope(dsp::FilterType::LPF, kCutoff, n, a);
+			std::printf("%-16s %8zu %10.2f %10.2f %12.4f\n",
+				alignment_names[a], n * 12,
+				response_db(c, kCutoff), response_db(c, kCutoff * 2), response_db(c, kCutoff / 2));
+		}
+	}
+
+	print_title("slope: Butterworth LPF stereo float, chained biquads vs cascade");
+	char label[64];
+	for(size_t n = 1; n <= dsp::kMaxSlopeSections; ++n) {
+		dsp::SlopeCoeffs const c =
+			dsp::design_slope(dsp::FilterType::LPF, kCutoff, n, dsp::Alignment::Butterworth);
+
+		Result const chained = measure_chained(c);
+		std::snprintf(label, sizeof(label), "%2zu dB/oct, chained", n * 12);
+		print_result(label, chained, 0);
+
+		Result const fused = measure_slope(c);
+		std::snprintf(label, sizeof(label), "%2zu dB/oct, cascade", n * 12);
+		print_result(label, fused, &chained);
+	}
+}
+
+}}	//namespace hwm::bench
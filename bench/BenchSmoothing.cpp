@@ -0,0 +1,96 @@
+#include "./Bench.hpp"
+#include "dsp/CoeffTable.hpp"
+#include "dsp/ParamMapping.hpp"
+#include "dsp/SmoothedFilter.hpp"
+
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+double const kSamplingRate = 48000.0;
+
+//! 係数を毎回厳密に計算する
+struct ExactDesigner
+{
+	dsp::BiquadCoeffs
+			operator()	(size_t filter_type, double cutoff, double gain, double Q) const
+	{
+		return dsp::design_biquad(filter_type,
+			dsp::param_to_cutoff(cutoff, kSamplingRate), dsp::param_to_db(gain), dsp::param_to_Q(Q));
+	}
+};
+
+//! 係数をテーブルから計算する
+struct TableDesigner
+{
+	dsp::CoeffTable const *	table_;
+
+	dsp::BiquadCoeffs
+			operator()	(size_t filter_type, double cutoff, double gain, double Q) const
+	{
+		return table_->design(filter_type, cutoff, gain, dsp::param_to_Q(Q));
+	}
+};
+
+//! 常にパラメータが変化し続けている状態で計測する
+template<class Designer>
+Result	measure_smoothing	(Designer const &design, size_t control_interval, size_t smoothing_length)
+{
+	size_t const kBlockSize = 512;
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	dsp::SmoothedBiquad filter(2);
+	filter.set_control_interval(control_interval);
+	filter.set_smoothing_length(smoothing_length);
+	filter.reset_params(dsp::FilterType::PeakingEQ, 0.3, 0.3, 0.1);
+
+	size_t count = 0;
+	return measure([&] {
+		//! 目標値を行き来させる
+		double const target = (++count / 64 % 2) ? 0.8 : 0.2;
+		filter.set_params(dsp::FilterType::PeakingEQ, target, target, target);
+		filter.process_block(design, in, out, kBlockSize);
+	}, kBlockSize * 2);
+}
+
+}	//unnamed namespace
+
+//! パラメータを滑らかに変化させているときの処理コスト
+//! 制御周期ごとの係数の再計算と、サンプルごとの係数の補間のコストを含む
+void	bench_smoothing	()
+{
+	dsp::CoeffTable table;
+	dsp::ParamMapping const mapping = { kSamplingRate };
+	table.build(mapping);
+
+	ExactDesigner const exact = {};
+	TableDesigner const tabled = { &table };
+
+	//! 変化させない場合が基準
+	Result const base = measure_smoothing(exact, 32, 0);
+
+	print_title("smoothing: PeakingEQ stereo float, always ramping");
+	print_result("no smoothing", base, 0);
+
+	size_t const intervals[] = { 1, 4, 16, 32, 64, 256 };
+	char label[64];
+	for(size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); ++i) {
+		size_t const interval = intervals[i];
+
+		Result const r_exact = measure_smoothing(exact, interval, 1 << 30);
+		std::snprintf(label, sizeof(label), "interval %4zu, exact", interval);
+		print_result(label, r_exact, &base);
+
+		Result const r_table = measure_smoothing(tabled, interval, 1 << 30);
+		std::snprintf(label, sizeof(label), "interval %4zu, table", interval);
+		print_result(label, r_table, &base);
+	}
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,114 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+char const * const filter_names[dsp::FilterType::kNumFilterType] = {
+	"LPF", "HPF", "BPF", "notch", "APF", "PeakingEQ", "LowShelf", "HighShelf"
+};
+
+//! StateSpaceCoeffsに記載した誤差の上限(出力の最大値に対する比)
+double const	kMaxRelativeError = 1e-9;
+
+//! 1つの長い信号をblock_sizeずつ処理する
+//! mve_renderがモノラルのファイルを処理するのと同じ経路(process_interleaved)を使う
+template<class T>
+void	process_signal	(dsp::Biquad &f, std::vector<T> &data, size_t block_size)
+{
+	for(size_t i = 0; i < data.size(); i += block_size) {
+		f.process_interleaved(&data[i], 1, std::min(block_size, data.size() - i));
+	}
+}
+
+//! 直接形に対する状態空間表現の誤差(出力の最大値に対する比)
+double	relative_error	(size_t type, double cutoff, double db_gain, double Q,
+						 std::vector<double> const &x, size_t block_size)
+{
+	dsp::BiquadCoeffs const coeffs = dsp::design_biquad(type, cutoff, db_gain, Q);
+
+	std::vector<double> ref = x;
+	std::vector<double> out = x;
+
+	dsp::Biquad f(1);
+	f.set_coeffs(coeffs, type);
+	process_signal(f, ref, block_size);
+
+	f.clear_buffer();
+	f.set_process_mode(dsp::ProcessMode::StateSpace);
+	process_signal(f, out, block_size);
+
+	double err = 0, peak = 0;
+	for(size_t i = 0; i < x.size(); ++i) {
+		err = std::max(err, std::abs(out[i] - ref[i]));
+		peak = std::max(peak, std::abs(ref[i]));
+	}
+	return err / peak;
+}
+
+template<class T>
+void	run_speed	(char const *label, size_t block_size)
+{
+	std::vector<T> data = make_noise<T>(block_size);
+
+	dsp::Biquad f(1);
+	f.set_coeffs(dsp::design_biquad(dsp::FilterType::PeakingEQ, 1000.0 / 48000, 6.0, 2.0),
+		dsp::FilterType::PeakingEQ);
+
+	//! 同じバッファを繰り返し処理する。値は発散しないので、入力を戻す必要はない
+	Result const direct = measure([&] {
+		f.process_interleaved(&data[0], 1, block_size);
+	}, block_size);
+
+	f.set_process_mode(dsp::ProcessMode::StateSpace);
+	Result const ss = measure([&] {
+		f.process_interleaved(&data[0], 1, block_size);
+	}, block_size);
+
+	std::printf("%-8s %8u %12.3f %12.3f %9.2fx\n", label, static_cast<unsigned>(block_size),
+		direct.ns_per_sample_, ss.ns_per_sample_, direct.ns_per_sample_ / ss.ns_per_sample_);
+}
+
+}	//unnamed namespace
+
+//! モノラルの大きなブロックでの、状態空間表現と直接形の比較
+//! 誤差は、係数の丸めがもっとも効く低いカットオフと高いQ(30Hz @ 192kHz, Q = 18)で
+//! 10^6サンプル処理したときの値で、kMaxRelativeErrorを超えたら失敗にする
+void	bench_state_space	()
+{
+	size_t const kLength = 1000000;
+	size_t const kBlockSize = 4096;
+	double const cutoff = 30.0 / 192000;
+	double const Q = 18.0;
+
+	std::vector<double> const x = make_noise<double>(kLength);
+
+	std::printf("\n== state_space: error vs. direct form (30Hz @ 192kHz, Q 18, %u samples) ==\n",
+		static_cast<unsigned>(kLength));
+	std::printf("%-12s %14s\n", "", "max error");
+
+	double worst = 0;
+	for(size_t type = 0; type < dsp::FilterType::kNumFilterType; ++type) {
+		double const e = relative_error(type, cutoff, 6.0, Q, x, kBlockSize);
+		std::printf("%-12s %14.2e\n", filter_names[type], e);
+		worst = std::max(worst, e);
+	}
+	report_check("state_space error <= 1e-9", worst <= kMaxRelativeError);
+
+	size_t const block_sizes[] = { 4096, 16384, 65536 };
+
+	std::printf("\n== state_space: mono PeakingEQ, in place ==\n");
+	std::printf("%-8s %8s %12s %12s %10s\n", "", "frames", "direct ns", "state ns", "ratio");
+	for(size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); ++i) {
+		run_speed<double>("double", block_sizes[i]);
+	}
+	for(size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); ++i) {
+		run_speed<float>("float", block_sizes[i]);
+	}
+}
+
+}}	//namespace hwm::bench
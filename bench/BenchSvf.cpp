@@ -0,0 +1,210 @@
+#include "./Bench.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/CoeffTable.hpp"
+#include "dsp/ParamMapping.hpp"
+#include "dsp/Svf.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hwm { namespace bench {
+
+namespace {
+
+double const kSamplingRate = 48000.0;
+
+size_t const kBlockSize = 512;
+
+char const * const filter_names[dsp::FilterType::kNumFilterType] = {
+	"LPF", "HPF", "BPF", "notch", "APF", "PeakingEQ", "LowShelf", "HighShelf"
+};
+
+//! SvfCoeffsに記載した、design_biquadとの応答の一致の許容誤差(応答の最大値に対する比)
+double const	kMaxResponseError = 1e-9;
+
+//! インパルス応答の長さ
+size_t const	kResponseLength = 4096;
+
+//! 同じパラメータで設計したbi-quadとSVFのインパルス応答の差(応答の最大値に対する比)
+double	response_error	(size_t type, double cutoff, double db_gain, double Q)
+{
+	dsp::Biquad biquad(1);
+	biquad.set_coeffs(dsp::design_biquad(type, cutoff, db_gain, Q), type);
+	dsp::Svf svf(1);
+	svf.set_coeffs(dsp::design_svf(type, cutoff, db_gain, Q), type);
+
+	double err = 0, peak = 0;
+	for(size_t i = 0; i < kResponseLength; ++i) {
+		double const x = (i == 0) ? 1.0 : 0.0;
+		double const ref = biquad.process(0, x);
+		err = std::max(err, std::abs(svf.process(0, x) - ref));
+		peak = std::max(peak, std::abs(ref));
+	}
+	return err / peak;
+}
+
+//! 係数を変えずにブロック処理する
+template<class Filter, class Coeffs>
+Result	measure_static	(Coeffs const &coeffs)
+{
+	std::vector<float> left = make_noise<float>(kBlockSize, 1);
+	std::vector<float> right = make_noise<float>(kBlockSize, 2);
+	std::vector<float> out_l(kBlockSize), out_r(kBlockSize);
+	float const *in[2] = { &left[0], &right[0] };
+	float *out[2] = { &out_l[0], &out_r[0] };
+
+	Filter filter(2);
+	filter.set_coeffs(coeffs, dsp::FilterType::PeakingEQ);
+
+	return measure([&] {
+		filter.process_block(in, out, kBlockSize);
+	}, kBlockSize * 2);
+}
+
+//! 1サンプルごとにカットオフを変え、係数を計算し直して処理する
+//! @param design (cutoff_param) -> 係数
+template<class Filter, class Design>
+Result	measure_modulated	(Design design, std::vector<double> const &lfo)
+{
+	std::vector<double> const input = make_noise<double>(kBlockSize, 3);
+	std::vector<double> output(kBlockSize);
+
+	Filter filter(1);
+	size_t const filter_type = dsp::FilterType::PeakingEQ;
+
+	return measure([&] {
+		for(size_t i = 0; i < kBlockSize; ++i) {
+			filter.set_coeffs(design(lfo[i]), filter_type);
+			output[i] = filter.process(0, input[i]);
+		}
+	}, kBlockSize);
+}
+
+//! 1サンプルごとにカットオフを乱数で跳ばしたときの出力の最大振幅
+//! 入力は振幅1.0の正弦波
+template<class Filter, class Design>
+double	max_output_under_modulation	(Design design, std::vector<double> const &jumps)
+{
+	Filter filter(1);
+	size_t const filter_type = dsp::FilterType::LPF;
+
+	double peak = 0;
+	for(size_t i = 0; i < jumps.size(); ++i) {
+		filter.set_coeffs(design(jumps[i]), filter_type);
+		double const x = std::sin(2 * 3.14159265358979 * 1000.0 / kSamplingRate * i);
+		double const y = filter.process(0, x);
+		if(!(std::abs(y) <= peak)) {
+			peak = std::abs(y);
+		}
+	}
+	return peak;
+}
+
+void	print_peak	(char const *label, double peak)
+{
+	if(peak <= 1e6) {
+		std::printf("%-32s %12.3g\n", label, peak);
+	} else {
+		std::printf("%-32s %12s\n", label, "diverged");
+	}
+}
+
+}	//unnamed namespace
+
+//! bi-quadとSVFの比較
+//! 全フィルタタイプでのインパルス応答の一致、係数を固定したブロック処理と、
+//! カットオフをサンプルごとに変調したときの処理コスト、変調したときの出力の振幅
+void	bench_svf	()
+{
+	dsp::ParamMapping const mapping = { kSamplingRate };
+
+	//! カットオフ、ゲイン、Qのパラメータの全域を格子で調べる
+	//! ゲインのパラメータ0は-infdBなので除く
+	double const params[] = { 0.0, 0.125, 0.25, 0.375, 0.5, 0.625, 0.75, 0.875, 1.0 };
+	size_t const num_params = sizeof(params) / sizeof(params[0]);
+
+	std::printf("\n== svf: impulse response vs. design_biquad (%u samples) ==\n",
+		static_cast<unsigned>(kResponseLength));
+	std::printf("%-12s %14s\n", "", "max error");
+
+	double worst = 0;
+	for(size_t type = 0; type < dsp::FilterType::kNumFilterType; ++type) {
+		double type_worst = 0;
+		for(size_t c = 0; c < num_params; ++c) {
+			for(size_t g = 1; g < num_params; ++g) {
+				for(size_t q = 0; q < num_params; ++q) {
+					double const e = response_error(type,
+						mapping.cutoff(params[c]), mapping.db_gain(params[g]), dsp::param_to_Q(params[q]));
+					type_worst = std::max(type_worst, e);
+				}
+			}
+		}
+		std::printf("%-12s %14.2e\n", filter_names[type], type_worst);
+		worst = std::max(worst, type_worst);
+	}
+	report_check("svf response error <= 1e-9", worst <= kMaxResponseError);
+	dsp::CoeffTable table;
+	table.build(mapping);
+
+	double const Q = 2.0;
+	double const cutoff = mapping.cutoff(0.5);
+	double const db_gain = mapping.db_gain(0.5);
+
+	Result const biquad_static = measure_static<dsp::Biquad>(
+		dsp::design_biquad(dsp::FilterType::PeakingEQ, cutoff, db_gain, Q));
+	Result const svf_static = measure_static<dsp::Svf>(
+		dsp::design_svf(dsp::FilterType::PeakingEQ, cutoff, db_gain, Q));
+
+	print_title("svf: static coefficients, PeakingEQ stereo float");
+	print_result("biquad", biquad_static, 0);
+	print_result("svf", svf_static, &biquad_static);
+
+	//! 20Hzで全域をスイープするLFO
+	std::vector<double> lfo(kBlockSize);
+	for(size_t i = 0; i < kBlockSize; ++i) {
+		lfo[i] = 0.5 + 0.5 * std::sin(2 * 3.14159265358979 * 20.0 / kSamplingRate * i);
+	}
+
+	double const gain_param = 0.5;
+	Result const biquad_exact = measure_modulated<dsp::Biquad>([&](double p) {
+		return dsp::design_biquad(dsp::FilterType::PeakingEQ,
+			mapping.cutoff(p), mapping.db_gain(gain_param), Q);
+	}, lfo);
+	Result const biquad_table = measure_modulated<dsp::Biquad>([&](double p) {
+		return table.design(dsp::FilterType::PeakingEQ, p, gain_param, Q);
+	}, lfo);
+	Result const svf_exact = measure_modulated<dsp::Svf>([&](double p) {
+		return dsp::design_svf(dsp::FilterType::PeakingEQ,
+			mapping.cutoff(p), mapping.db_gain(gain_param), Q);
+	}, lfo);
+	Result const svf_table = measure_modulated<dsp::Svf>([&](double p) {
+		return table.design_svf(dsp::FilterType::PeakingEQ, p, gain_param, Q);
+	}, lfo);
+
+	print_title("svf: per-sample cutoff modulation, PeakingEQ mono double");
+	print_result("biquad, exact", biquad_exact, 0);
+	print_result("biquad, table", biquad_table, &biquad_exact);
+	print_result("svf, exact", svf_exact, &biquad_exact);
+	print_result("svf, table", svf_table, &biquad_exact);
+
+	//! Q = 18のLPFのカットオフを、1サンプルごとに全域で跳ばす
+	std::vector<double> const noise = make_noise<double>(static_cast<size_t>(kSamplingRate), 5);
+	std::vector<double> jumps(noise.size());
+	for(size_t i = 0; i < noise.size(); ++i) {
+		jumps[i] = (i / 4 % 2) ? (noise[i] * 0.5 + 0.5) : 0.0;
+	}
+
+	double const kHighQ = 18.0;
+	double const biquad_peak = max_output_under_modulation<dsp::Biquad>([&](double p) {
+		return dsp::design_biquad(dsp::FilterType::LPF, mapping.cutoff(p), 0.0, kHighQ);
+	}, jumps);
+	double const svf_peak = max_output_under_modulation<dsp::Svf>([&](double p) {
+		return dsp::design_svf(dsp::FilterType::LPF, mapping.cutoff(p), 0.0, kHighQ);
+	}, jumps);
+
+	std::printf("\n== svf: peak output, LPF Q = 18, cutoff jumping every 4 samples, 1kHz sine in ==\n");
+	print_peak("biquad (transposed direct form)", biquad_peak);
+	print_peak("svf", svf_peak);
+}
+
+}}	//namespace hwm::bench
@@ -0,0 +1,80 @@
+#include "./Bench.hpp"
+#include "dsp/CpuFeatures.hpp"
+
+#include <cstring>
+
+namespace {
+
+struct Entry
+{
+	char const *	name_;
+	void			(*func_)();
+};
+
+Entry const entries[] = {
+	{ "filter_types",	&hwm::bench::bench_filter_types },
+	{ "precision",		&hwm::bench::bench_precision },
+	{ "handoff",		&hwm::bench::bench_handoff },
+	{ "coeff_table",	&hwm::bench::bench_coeff_table },
+	{ "smoothing",		&hwm::bench::bench_smoothing },
+	{ "svf",			&hwm::bench::bench_svf },
+	{ "events",			&hwm::bench::bench_events },
+	{ "channels",		&hwm::bench::bench_channels },
+	{ "cascade",		&hwm::bench::bench_cascade },
+	{ "slope",			&hwm::bench::bench_slope },
+	{ "linear_phase",	&hwm::bench::bench_linear_phase },
+	{ "crossover",		&hwm::bench::bench_crossover },
+	{ "oversampling",	&hwm::bench::bench_oversampling },
+	{ "silence",		&hwm::bench::bench_silence },
+	{ "denormals",		&hwm::bench::bench_denormals },
+	{ "sample_format",	&hwm::bench::bench_sample_format },
+	{ "segments",		&hwm::bench::bench_segments },
+	{ "batch",			&hwm::bench::bench_batch },
+	{ "interleaved",	&hwm::bench::bench_interleaved },
+	{ "state_space",	&hwm::bench::bench_state_space },
+};
+
+size_t const kNumEntries = sizeof(entries) / sizeof(entries[0]);
+
+size_t	num_failed_checks = 0;
+
+}	//unnamed namespace
+
+namespace hwm { namespace bench {
+
+void	report_check	(char const *name, bool passed)
+{
+	std::printf("%s: %s\n", name, passed ? "PASS" : "FAIL");
+	if(!passed) {
+		++num_failed_checks;
+	}
+}
+
+}}	//namespace hwm::bench
+
+//! 使い方: mve_bench [name...]
+//! 名前を指定しなければすべてのベンチマークを実行する
+//! 出力の一致や誤差の検証に1つでも失敗すれば1を返す
+int main(int argc, char **argv)
+{
+	std::printf("SIMD level: %s\n",
+		hwm::dsp::get_simd_level_string(hwm::dsp::get_simd_level()));
+
+	for(size_t i = 0; i < kNumEntries; ++i) {
+		bool selected = (argc <= 1);
+		for(int a = 1; a < argc; ++a) {
+			if(std::strcmp(argv[a], entries[i].name_) == 0) {
+				selected = true;
+			}
+		}
+		if(selected) {
+			entries[i].func_();
+		}
+	}
+
+	if(num_failed_checks > 0) {
+		std::printf("\n%u check(s) failed\n", static_cast<unsigned>(num_failed_checks));
+		return 1;
+	}
+	return 0;
+}
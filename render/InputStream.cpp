@@ -0,0 +1,190 @@
+#include "./InputStream.hpp"
+#include <algorithm>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace hwm { namespace render {
+
+InputStream::InputStream	()
+	:	mapped_(nullptr)
+	,	mapped_size_(0)
+	,	position_(0)
+#if defined(_WIN32)
+	,	file_handle_(INVALID_HANDLE_VALUE)
+	,	mapping_handle_(nullptr)
+#endif
+	,	fp_(nullptr)
+{}
+
+InputStream::~InputStream	()
+{
+	close();
+}
+
+bool	InputStream::open		(std::string const &path, bool use_mmap)
+{
+	close();
+
+	if(use_mmap && map_file(path)) {
+		return true;
+	}
+
+	fp_ = std::fopen(path.c_str(), "rb");
+	if(!fp_) {
+		return false;
+	}
+	//! 読み込みはkChunkBytesごとにまとめて行われる
+	std::setvbuf(fp_, nullptr, _IOFBF, kChunkBytes);
+	return true;
+}
+
+void	InputStream::close		()
+{
+	unmap_file();
+	if(fp_) {
+		std::fclose(fp_);
+		fp_ = nullptr;
+	}
+}
+
+size_t	InputStream::acquire	(unsigned char const *&data, size_t bytes)
+{
+	if(mapped_) {
+		size_t const n = std::min(bytes, mapped_size_ - position_);
+		data = mapped_ + position_;
+		position_ += n;
+		return n;
+	}
+
+	if(!fp_) {
+		data = nullptr;
+		return 0;
+	}
+	if(buffer_.size() < bytes) {
+		buffer_.resize(bytes);
+	}
+	size_t const n = std::fread(buffer_.data(), 1, bytes, fp_);
+	data = buffer_.data();
+	return n;
+}
+
+size_t	InputStream::skip		(size_t bytes)
+{
+	size_t skipped = 0;
+	while(skipped < bytes) {
+		unsigned char const *data;
+		size_t const n = acquire(data, std::min(bytes - skipped, static_cast<size_t>(kChunkBytes)));
+		if(n == 0) {
+			break;
+		}
+		skipped += n;
+	}
+	return skipped;
+}
+
+bool	InputStream::is_mapped	() const
+{
+	return mapped_ != nullptr;
+}
+
+#if defined(_WIN32)
+
+bool	InputStream::map_file	(std::string const &path)
+{
+	HANDLE const file = CreateFileA(
+		path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void const *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if(!view) {
+		if(mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	file_handle_	= file;
+	mapping_handle_	= mapping;
+	mapped_			= static_cast<unsigned char const *>(view);
+	mapped_size_	= static_cast<size_t>(size.QuadPart);
+	position_		= 0;
+	return true;
+}
+
+void	InputStream::unmap_file	()
+{
+	if(mapped_) {
+		UnmapViewOfFile(mapped_);
+		CloseHandle(mapping_handle_);
+		CloseHandle(file_handle_);
+	}
+	mapped_			= nullptr;
+	mapped_size_	= 0;
+	position_		= 0;
+	file_handle_	= INVALID_HANDLE_VALUE;
+	mapping_handle_	= nullptr;
+}
+
+#else
+
+bool	InputStream::map_file	(std::string const &path)
+{
+	int const fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	//! 通常のファイルでなければ(パイプなど)マップしない
+	struct stat st;
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	size_t const size = static_cast<size_t>(st.st_size);
+	void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	//! マップした領域はファイルを閉じても有効
+	::close(fd);
+	if(p == MAP_FAILED) {
+		return false;
+	}
+	madvise(p, size, MADV_SEQUENTIAL);
+
+	mapped_			= static_cast<unsigned char const *>(p);
+	mapped_size_	= size;
+	position_		= 0;
+	return true;
+}
+
+void	InputStream::unmap_file	()
+{
+	if(mapped_) {
+		munmap(const_cast<unsigned char *>(mapped_), mapped_size_);
+	}
+	mapped_			= nullptr;
+	mapped_size_	= 0;
+	position_		= 0;
+}
+
+#endif
+
+}}	//namespace hwm::render
@@ -0,0 +1,62 @@
+#ifndef	HWM_MINIVSTEFFECT_RENDER_INPUTSTREAM_HPP
+#define	HWM_MINIVSTEFFECT_RENDER_INPUTSTREAM_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace hwm { namespace render {
+
+//! ファイルを先頭から順に読むストリーム
+//! 可能ならファイル全体をメモリマップし、読み出しはマップされた領域を指すポインタを返すだけにする
+//! マップできないとき(パイプなど)や、マップを使わない指定のときは、大きなバッファを介してまとめて読み込む
+struct InputStream
+{
+	//! ストリーミングで読むときの、ファイルからの1回の読み込みのバイト数
+	enum { kChunkBytes = 1 << 20 };
+
+	InputStream		();
+	~InputStream	();
+
+	//! ファイルを開く。失敗したらfalse
+	//! use_mmapがfalseなら、常にチャンク単位で読み込む
+	bool	open		(std::string const &path, bool use_mmap);
+	void	close		();
+
+	//! 現在位置から最大bytesバイトを読み、その先頭を指すポインタをdataに設定する
+	//! ポインタは次にacquire, skipを呼び出すまで有効
+	//! 戻り値は読めたバイト数。ファイルの終端ではbytesより小さくなる
+	//! ストリーミングではbytesがkChunkBytesより大きくても1回で返す
+	size_t	acquire		(unsigned char const *&data, size_t bytes);
+
+	//! 現在位置からbytesバイト読み飛ばす。読み飛ばせたバイト数を返す
+	size_t	skip		(size_t bytes);
+
+	//! メモリマップで読んでいるかどうか
+	bool	is_mapped	() const;
+
+private:
+	InputStream		(InputStream const &);
+	InputStream &	operator=	(InputStream const &);
+
+	bool	map_file	(std::string const &path);
+	void	unmap_file	();
+
+	//! メモリマップ
+	unsigned char const *		mapped_;
+	size_t						mapped_size_;
+	size_t						position_;
+#if defined(_WIN32)
+	void *						file_handle_;
+	void *						mapping_handle_;
+#endif
+
+	//! ストリーミング
+	std::FILE *					fp_;
+	std::vector<unsigned char>	buffer_;
+};
+
+}}	//namespace hwm::render
+
+#endif	//HWM_MINIVSTEFFECT_RENDER_INPUTSTREAM_HPP
@@ -0,0 +1,305 @@
+#include "./Renderer.hpp"
+#include "./ThreadPool.hpp"
+#include "dsp/Biquad.hpp"
+#include "dsp/BiquadCoeffs.hpp"
+#include "dsp/Denormals.hpp"
+#include "dsp/ParamMapping.hpp"
+#include "dsp/SampleFormat.hpp"
+#include "dsp/SegmentedBiquad.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+
+#if !defined(_WIN32)
+	#include <sys/stat.h>
+#endif
+
+namespace hwm { namespace render {
+
+namespace {
+
+//! 入力と出力が同じファイルかどうか
+//! 同じファイルに書き出すと、メモリマップで読んでいる途中の入力を切り詰めてしまう
+bool	is_same_file	(std::string const &a, std::string const &b)
+{
+#if defined(_WIN32)
+	return a == b;
+#else
+	struct stat sa;
+	struct stat sb;
+	if(stat(a.c_str(), &sa) != 0 || stat(b.c_str(), &sb) != 0) {
+		return false;
+	}
+	return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+#endif
+}
+
+}	//unnamed namespace
+
+char const *
+		get_preset_name		(size_t index)
+{
+	return dsp::get_preset_params(index).name_;
+}
+
+FilterSettings
+		get_preset			(size_t index)
+{
+	dsp::PresetParams const &preset = dsp::get_preset_params(index);
+
+	FilterSettings settings;
+	settings.filter_type_	= preset.filter_type_;
+	settings.cutoff_		= 0.0;
+	//! ゲインを使わないタイプのプリセットはパラメータが0.0(-infdB)なので、0dBにしておく
+	settings.db_gain_		= (preset.db_gain_ > 0) ? dsp::param_to_db(preset.db_gain_) : 0.0;
+	settings.Q_				= dsp::param_to_Q(preset.Q_);
+	return settings;
+}
+
+double	get_preset_cutoff	(double sampling_rate)
+{
+	//! カットオフのパラメータはどのプリセットも同じ
+	return dsp::param_to_cutoff(dsp::get_preset_params(0).cutoff_, sampling_rate) * sampling_rate;
+}
+
+size_t	get_file_type		(std::string const &path)
+{
+	std::string::size_type const dot = path.rfind('.');
+	if(dot == std::string::npos) {
+		return FileType::Wav;
+	}
+	std::string ext = path.substr(dot + 1);
+	for(size_t i = 0; i < ext.size(); ++i) {
+		ext[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(ext[i])));
+	}
+	return (ext == "raw" || ext == "pcm") ? FileType::Raw : FileType::Wav;
+}
+
+struct Renderer::Segment
+{
+	explicit
+	Segment	(size_t num_channels)
+		:	biquad_(num_channels)
+		,	initial_(num_channels)
+		,	offset_(0)
+		,	num_frames_(0)
+	{}
+
+	dsp::Biquad						biquad_;
+	//! デコードした区間のサンプル。その場でフィルタをかけてエンコードする
+	std::vector<float>				interleaved_;
+	//! 前の区間から引き継ぐ、区間の先頭の状態
+	std::vector<dsp::BiquadState>	initial_;
+	//! ブロックの中での位置とフレーム数
+	size_t							offset_;
+	size_t							num_frames_;
+};
+
+Renderer::Renderer	(ThreadPool *pool)
+	:	pool_(pool)
+	,	num_frames_(0)
+	,	block_data_(nullptr)
+	,	block_frames_(0)
+	,	segment_frames_(0)
+{}
+
+Renderer::~Renderer	()
+{}
+
+bool	Renderer::render	(std::string const &input, std::string const &output,
+							 RenderSettings const &settings, std::string &error)
+{
+	num_frames_ = 0;
+	error.clear();
+
+	if(is_same_file(input, output)) {
+		error = "output would overwrite the input";
+		return false;
+	}
+	if(!in_.open(input, settings.use_mmap_)) {
+		error = "cannot open input";
+		return false;
+	}
+
+	AudioFormat &format = in_format_;
+	unsigned long long data_bytes;
+	if(get_file_type(input) == FileType::Raw) {
+		format = settings.raw_format_;
+		data_bytes = ~0ull;
+	} else {
+		format.file_type_ = FileType::Wav;
+		if(!read_wav_header(in_, format, data_bytes, error)) {
+			in_.close();
+			return false;
+		}
+	}
+
+	out_format_ = format;
+	if(settings.output_format_ != dsp::SampleFormat::kNumSampleFormat) {
+		out_format_.sample_format_ = settings.output_format_;
+	}
+
+	FilterSettings filter = settings.filter_;
+	double const rate = static_cast<double>(format.sampling_rate_);
+	if(settings.preset_cutoff_) {
+		filter.cutoff_ = get_preset_cutoff(rate);
+	}
+	if(!(filter.cutoff_ > 0.0 && filter.cutoff_ < rate / 2.0)) {
+		error = "cutoff must be between 0 Hz and the Nyquist frequency";
+		in_.close();
+		return false;
+	}
+
+	std::FILE *fp = std::fopen(output.c_str(), "wb");
+	if(!fp) {
+		error = "cannot create output";
+		in_.close();
+		return false;
+	}
+	std::setvbuf(fp, nullptr, _IOFBF, InputStream::kChunkBytes);
+
+	bool ok = (format.file_type_ != FileType::Wav) || write_wav_header(fp, out_format_);
+
+	size_t const num_channels	= format.num_channels_;
+	size_t const in_frame_size	= get_frame_size(format);
+	size_t const out_frame_size	= get_frame_size(out_format_);
+	size_t const num_segments	= pool_ ? pool_->get_num_threads() : 1;
+	segment_frames_				= pool_ ? kSegmentFrames : kBlockFrames;
+	size_t const max_frames		= num_segments * segment_frames_;
+
+	dsp::BiquadCoeffs const coeffs =
+		dsp::design_biquad(filter.filter_type_, filter.cutoff_ / rate, filter.db_gain_, filter.Q_);
+	size_t const process_mode =
+		(settings.state_space_ && num_channels == 1)
+		?	dsp::ProcessMode::StateSpace
+		:	dsp::ProcessMode::Direct;
+
+	segments_.resize(num_segments);
+	for(size_t k = 0; k < num_segments; ++k) {
+		if(!segments_[k] || segments_[k]->biquad_.get_num_channels() != num_channels) {
+			segments_[k].reset(new Segment(num_channels));
+		}
+		Segment &seg = *segments_[k];
+		seg.interleaved_.resize(segment_frames_ * num_channels);
+		seg.biquad_.set_process_mode(process_mode);
+		seg.biquad_.set_coeffs(coeffs, filter.filter_type_);
+		seg.biquad_.clear_buffer();
+	}
+	encoded_.resize(max_frames * out_frame_size);
+
+	//! 1区間分の長さの状態遷移。端数の区間は都度計算する
+	dsp::StateTransition const full_transition = make_state_transition(coeffs, segment_frames_);
+
+	unsigned long long remaining = data_bytes;
+	while(ok && remaining > 0) {
+		size_t const want = static_cast<size_t>(
+			std::min<unsigned long long>(remaining, max_frames * in_frame_size));
+		size_t const got = in_.acquire(block_data_, want);
+		block_frames_ = got / in_frame_size;
+		if(block_frames_ == 0) {
+			break;
+		}
+		remaining -= got;
+
+		size_t const num_active = (block_frames_ + segment_frames_ - 1) / segment_frames_;
+		for(size_t k = 0; k < num_active; ++k) {
+			segments_[k]->offset_ = k * segment_frames_;
+			segments_[k]->num_frames_ = std::min(segment_frames_, block_frames_ - k * segment_frames_);
+		}
+
+		if(num_active == 1) {
+			filter_segment(0);
+			finish_segment(0);
+		} else {
+			pool_->run(num_active, [this] (size_t k, size_t) { filter_segment(k); });
+
+			//! 先頭の区間は正しい状態から処理しているので、その終端から順に状態を引き継ぐ
+			//! 最後の区間の終端の状態は、次のブロックの先頭の区間に引き継ぐ
+			for(size_t ch = 0; ch < num_channels; ++ch) {
+				dsp::BiquadState state = segments_[0]->biquad_.get_state(ch);
+				for(size_t k = 1; k < num_active; ++k) {
+					Segment &seg = *segments_[k];
+					seg.initial_[ch] = state;
+					dsp::StateTransition const transition =
+						(seg.num_frames_ == segment_frames_)
+						?	full_transition
+						:	make_state_transition(coeffs, seg.num_frames_);
+					state = carry_state(transition, state, seg.biquad_.get_state(ch));
+				}
+				segments_[0]->biquad_.set_state(ch, state);
+			}
+
+			pool_->run(num_active, [this] (size_t k, size_t) { finish_segment(k); });
+		}
+
+		ok = std::fwrite(encoded_.data(), out_frame_size, block_frames_, fp) == block_frames_;
+		num_frames_ += block_frames_;
+	}
+
+	if(ok && format.file_type_ == FileType::Wav) {
+		if(num_frames_ * out_frame_size > kMaxWavDataBytes) {
+			error = "output is too large for a WAV file";
+			ok = false;
+		} else {
+			ok = finish_wav_file(fp, num_frames_ * out_frame_size);
+		}
+	}
+	if(std::fclose(fp) != 0) {
+		ok = false;
+	}
+	if(!ok && error.empty()) {
+		error = "write error";
+	}
+	in_.close();
+	block_data_ = nullptr;
+	return ok;
+}
+
+void	Renderer::filter_segment	(size_t segment_index)
+{
+	//! 並列処理では、この関数はプールのスレッドで呼ばれる
+	dsp::ScopedFlushDenormals flush_denormals;
+
+	Segment &seg = *segments_[segment_index];
+	size_t const num_channels = in_format_.num_channels_;
+	size_t const n = seg.num_frames_;
+
+	dsp::decode_samples(
+		in_format_.sample_format_, block_data_ + seg.offset_ * get_frame_size(in_format_),
+		seg.interleaved_.data(), n * num_channels);
+
+	if(segment_index != 0) {
+		seg.biquad_.clear_buffer();
+	}
+	seg.biquad_.process_interleaved(seg.interleaved_.data(), num_channels, n);
+	if(!dsp::ScopedFlushDenormals::is_supported()) {
+		seg.biquad_.flush_denormals();
+	}
+}
+
+void	Renderer::finish_segment	(size_t segment_index)
+{
+	Segment &seg = *segments_[segment_index];
+	size_t const num_channels = in_format_.num_channels_;
+	size_t const n = seg.num_frames_;
+
+	if(segment_index != 0) {
+		for(size_t ch = 0; ch < num_channels; ++ch) {
+			dsp::add_zero_input_response(seg.biquad_.get_coeffs(), seg.initial_[ch],
+				seg.interleaved_.data() + ch, n, num_channels);
+		}
+	}
+
+	dsp::encode_samples(
+		out_format_.sample_format_, seg.interleaved_.data(),
+		encoded_.data() + seg.offset_ * get_frame_size(out_format_), n * num_channels);
+}
+
+unsigned long long
+		Renderer::get_num_frames	() const
+{
+	return num_frames_;
+}
+
+}}	//namespace hwm::render
@@ -0,0 +1,130 @@
+#ifndef	HWM_MINIVSTEFFECT_RENDER_RENDERER_HPP
+#define	HWM_MINIVSTEFFECT_RENDER_RENDERER_HPP
+
+#include "./InputStream.hpp"
+#include "./WavFile.hpp"
+#include "dsp/ParamMapping.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hwm { namespace render {
+
+//! かけるフィルタの設定
+struct FilterSettings
+{
+	//! dsp::FilterTypeのいずれか
+	size_t	filter_type_;
+	//! カットオフ周波数(Hz)
+	double	cutoff_;
+	double	db_gain_;
+	double	Q_;
+};
+
+//! プリセットの数
+//! プラグインと同じdsp::get_preset_paramsを使うので、同じ並びで同じ設定になる
+size_t const	kNumPresets = dsp::kNumPresets;
+
+//! プリセットの名前を取得
+//! プラグインのプログラム名("Low Pass Filter"など)
+char const *
+		get_preset_name		(size_t index);
+
+//! プリセットの設定を取得
+//! カットオフ周波数はプラグインと同じくサンプリングレートから決まるので、
+//! ここではカットオフを0にしておき、ファイルを開いてからget_preset_cutoffで決める
+FilterSettings
+		get_preset			(size_t index);
+
+//! プリセットのカットオフ周波数(Hz)
+//! プラグインのカットオフのパラメータ0.5を、sampling_rateで周波数に写像した値
+double	get_preset_cutoff	(double sampling_rate);
+
+//! 1ファイルの処理の設定
+struct RenderSettings
+{
+	FilterSettings	filter_;
+	//! カットオフがプリセットのままかどうか
+	//! trueならファイルのサンプリングレートからget_preset_cutoffで決める
+	bool			preset_cutoff_;
+	//! 出力のdsp::SampleFormat
+	//! kNumSampleFormatなら入力と同じ
+	size_t			output_format_;
+	//! 入力をメモリマップで読むかどうか
+	bool			use_mmap_;
+	//! FileType::Rawの入力の形式
+	AudioFormat		raw_format_;
+	//! モノラルのファイルを、状態空間表現(dsp::ProcessMode::StateSpace)で処理するかどうか
+	//! ブロックが大きいので直接形より速い。誤差は出力の最大値の1e-9程度(mve_bench state_space)
+	//! 2チャンネル以上のファイルは、チャンネルをSIMDのレーンに並べる直接形で処理する
+	bool			state_space_;
+};
+
+//! ファイルの拡張子からFileTypeを決める
+//! .raw, .pcmならRaw、それ以外はWav
+size_t	get_file_type		(std::string const &path);
+
+struct ThreadPool;
+
+//! 1ファイルずつフィルタをかけて書き出す
+//! 作業用のバッファを持つので、スレッドごとに1つ作る
+//!
+//! poolを指定すると、1つのファイルを区間に分けてpoolのスレッドで並列に処理する
+//! 各区間を状態0からフィルタにかけ、前の区間から引き継ぐ状態による応答を後から足すので
+//! (dsp/SegmentedBiquad.hpp)、出力は逐次処理と丸め誤差の範囲で一致する
+struct Renderer
+{
+	enum {
+		//! 逐次処理で1回にデコードしてフィルタにかけるフレーム数
+		kBlockFrames = 4096,
+		//! 並列処理での1区間のフレーム数
+		//! 引き継ぐ状態による応答は減衰したところで打ち切るので、
+		//! 区間が長いほど、その計算が全体に占める割合は小さくなる
+		kSegmentFrames = 1 << 16
+	};
+
+	explicit
+	Renderer	(ThreadPool *pool = nullptr);
+	~Renderer	();
+
+	//! inputを読み、フィルタをかけてoutputに書き出す
+	//! outputのファイルの種類はinputと同じ
+	//! 失敗したらerrorに理由を書いてfalseを返す
+	bool	render				(std::string const &input, std::string const &output,
+								 RenderSettings const &settings, std::string &error);
+
+	//! 直前のrenderで処理したフレーム数
+	unsigned long long
+			get_num_frames		() const;
+
+private:
+	Renderer	(Renderer const &);
+	Renderer &	operator=	(Renderer const &);
+
+	//! 1区間分の作業領域とフィルタ
+	struct Segment;
+
+	//! segment_indexの区間をデコードし、状態0から(先頭の区間は引き継いだ状態から)フィルタにかける
+	void	filter_segment		(size_t segment_index);
+	//! 引き継いだ状態による応答を足し、エンコードする
+	void	finish_segment		(size_t segment_index);
+
+	ThreadPool *				pool_;
+	InputStream					in_;
+	std::vector<std::unique_ptr<Segment>>
+								segments_;
+	std::vector<unsigned char>	encoded_;
+	unsigned long long			num_frames_;
+
+	//! 処理中のブロックの情報。各区間の処理から参照する
+	AudioFormat					in_format_;
+	AudioFormat					out_format_;
+	unsigned char const *		block_data_;
+	size_t						block_frames_;
+	size_t						segment_frames_;
+};
+
+}}	//namespace hwm::render
+
+#endif	//HWM_MINIVSTEFFECT_RENDER_RENDERER_HPP
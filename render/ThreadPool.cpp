@@ -0,0 +1,89 @@
+#include "./ThreadPool.hpp"
+
+namespace hwm { namespace render {
+
+ThreadPool::ThreadPool		(size_t num_threads)
+	:	generation_(0)
+	,	num_active_(0)
+	,	quit_(false)
+	,	func_(nullptr)
+	,	num_jobs_(0)
+	,	next_job_(0)
+{
+	if(num_threads == 0) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+	if(num_threads == 0) {
+		num_threads = 1;
+	}
+
+	threads_.reserve(num_threads);
+	for(size_t i = 0; i < num_threads; ++i) {
+		threads_.push_back(std::thread(&ThreadPool::worker_main, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool		()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	start_cv_.notify_all();
+	for(size_t i = 0; i < threads_.size(); ++i) {
+		threads_[i].join();
+	}
+}
+
+size_t	ThreadPool::get_num_threads	() const
+{
+	return threads_.size();
+}
+
+void	ThreadPool::run				(size_t num_jobs, job_type const &func)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	func_		= &func;
+	num_jobs_	= num_jobs;
+	next_job_	= 0;
+	num_active_	= threads_.size();
+	++generation_;
+	start_cv_.notify_all();
+
+	done_cv_.wait(lock, [this] { return num_active_ == 0; });
+	func_ = nullptr;
+}
+
+void	ThreadPool::worker_main		(size_t thread_index)
+{
+	size_t generation = 0;
+	for( ; ; ) {
+		job_type const *func;
+		size_t num_jobs;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			start_cv_.wait(lock, [&] { return quit_ || generation_ != generation; });
+			if(quit_) {
+				return;
+			}
+			generation	= generation_;
+			func		= func_;
+			num_jobs	= num_jobs_;
+		}
+
+		for( ; ; ) {
+			size_t const job = next_job_.fetch_add(1);
+			if(job >= num_jobs) {
+				break;
+			}
+			(*func)(job, thread_index);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(--num_active_ == 0) {
+			done_cv_.notify_one();
+		}
+	}
+}
+
+}}	//namespace hwm::render
@@ -0,0 +1,55 @@
+#ifndef	HWM_MINIVSTEFFECT_RENDER_THREADPOOL_HPP
+#define	HWM_MINIVSTEFFECT_RENDER_THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hwm { namespace render {
+
+//! 固定数のワーカースレッドでジョブを並列に実行する
+//! ジョブは共有のカウンタから、空いたスレッドが1つずつ取る
+//! 1ジョブ(1ファイル)の処理時間がばらついても、先に終わったスレッドが残りを引き受ける
+struct ThreadPool
+{
+	//! num_threadsが0なら、ハードウェアのスレッド数だけ作る
+	explicit
+	ThreadPool		(size_t num_threads);
+	~ThreadPool		();
+
+	size_t	get_num_threads	() const;
+
+	//! job_index = 0 ~ num_jobs - 1についてfunc(job_index, thread_index)を呼び出し、
+	//! すべて終わるまで待つ
+	//! thread_indexは0 ~ get_num_threads() - 1で、スレッドごとの作業領域を選ぶのに使う
+	typedef std::function<void(size_t, size_t)>	job_type;
+	void	run				(size_t num_jobs, job_type const &func);
+
+private:
+	ThreadPool		(ThreadPool const &);
+	ThreadPool &	operator=	(ThreadPool const &);
+
+	void	worker_main		(size_t thread_index);
+
+	std::vector<std::thread>	threads_;
+
+	std::mutex					mutex_;
+	std::condition_variable		start_cv_;
+	std::condition_variable		done_cv_;
+	//! runを呼び出すたびに増える。ワーカーはこれが変わったら新しいジョブを取りに行く
+	size_t						generation_;
+	size_t						num_active_;
+	bool						quit_;
+
+	job_type const *			func_;
+	size_t						num_jobs_;
+	std::atomic<size_t>			next_job_;
+};
+
+}}	//namespace hwm::render
+
+#endif	//HWM_MINIVSTEFFECT_RENDER_THREADPOOL_HPP
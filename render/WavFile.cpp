@@ -0,0 +1,215 @@
+#include "./WavFile.hpp"
+#include "./InputStream.hpp"
+#include "dsp/SampleFormat.hpp"
+#include <cstring>
+
+namespace hwm { namespace render {
+
+namespace {
+
+typedef unsigned char	byte_t;
+
+//! WAVE_FORMAT_*
+unsigned int const	kFormatPcm			= 0x0001;
+unsigned int const	kFormatFloat		= 0x0003;
+unsigned int const	kFormatExtensible	= 0xFFFE;
+
+//! dataチャンクのサイズが書かれていないことを表す値
+unsigned long const	kUnknownSize		= 0xFFFFFFFFul;
+
+//! これより大きいfmtチャンクは壊れているとみなす
+unsigned long const	kMaxFmtBytes		= 1024;
+
+unsigned int	read_u16	(byte_t const *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+unsigned long	read_u32	(byte_t const *p)
+{
+	return
+		static_cast<unsigned long>(p[0]) |
+		(static_cast<unsigned long>(p[1]) << 8) |
+		(static_cast<unsigned long>(p[2]) << 16) |
+		(static_cast<unsigned long>(p[3]) << 24);
+}
+
+void	write_u16	(byte_t *p, unsigned int value)
+{
+	p[0] = static_cast<byte_t>(value);
+	p[1] = static_cast<byte_t>(value >> 8);
+}
+
+void	write_u32	(byte_t *p, unsigned long value)
+{
+	for(size_t i = 0; i < 4; ++i) {
+		p[i] = static_cast<byte_t>(value >> (i * 8));
+	}
+}
+
+//! fmtチャンクのフォーマットタグとビット数からサンプルの形式を決める
+//! 対応していなければkNumSampleFormat
+size_t	to_sample_format	(unsigned int tag, unsigned int bits)
+{
+	if(tag == kFormatPcm) {
+		switch(bits) {
+			case 16: return dsp::SampleFormat::Int16;
+			case 24: return dsp::SampleFormat::Int24;
+			case 32: return dsp::SampleFormat::Int32;
+		}
+	} else if(tag == kFormatFloat && bits == 32) {
+		return dsp::SampleFormat::Float32;
+	}
+	return dsp::SampleFormat::kNumSampleFormat;
+}
+
+bool	read_fmt_chunk	(byte_t const *p, size_t size, AudioFormat &format, std::string &error)
+{
+	if(size < 16) {
+		error = "fmt chunk is too short";
+		return false;
+	}
+
+	unsigned int tag				= read_u16(p);
+	unsigned int const channels		= read_u16(p + 2);
+	unsigned long const rate		= read_u32(p + 4);
+	unsigned int const block_align	= read_u16(p + 12);
+	unsigned int const bits			= read_u16(p + 14);
+
+	//! WAVE_FORMAT_EXTENSIBLEでは、SubFormatのGUIDの先頭2バイトがフォーマットタグ
+	if(tag == kFormatExtensible) {
+		if(size < 40) {
+			error = "WAVE_FORMAT_EXTENSIBLE fmt chunk is too short";
+			return false;
+		}
+		tag = read_u16(p + 24);
+	}
+
+	size_t const sample_format = to_sample_format(tag, bits);
+	if(sample_format == dsp::SampleFormat::kNumSampleFormat) {
+		error = "unsupported sample format (16/24/32-bit PCM and 32-bit float are supported)";
+		return false;
+	}
+	if(channels == 0 || rate == 0) {
+		error = "invalid channel count or sampling rate";
+		return false;
+	}
+	if(block_align != channels * dsp::get_sample_size(sample_format)) {
+		error = "unsupported block alignment";
+		return false;
+	}
+
+	format.sample_format_	= sample_format;
+	format.num_channels_	= channels;
+	format.sampling_rate_	= rate;
+	return true;
+}
+
+}	//unnamed namespace
+
+size_t	get_frame_size		(AudioFormat const &format)
+{
+	return format.num_channels_ * dsp::get_sample_size(format.sample_format_);
+}
+
+bool	read_wav_header		(InputStream &in, AudioFormat &format,
+							 unsigned long long &data_bytes, std::string &error)
+{
+	byte_t const *p;
+	if(in.acquire(p, 12) != 12 ||
+		std::memcmp(p, "RIFF", 4) != 0 || std::memcmp(p + 8, "WAVE", 4) != 0)
+	{
+		error = "not a RIFF WAVE file";
+		return false;
+	}
+
+	bool has_fmt = false;
+	for( ; ; ) {
+		if(in.acquire(p, 8) != 8) {
+			error = "data chunk not found";
+			return false;
+		}
+		char id[4];
+		std::memcpy(id, p, 4);
+		unsigned long const size = read_u32(p + 4);
+
+		if(std::memcmp(id, "data", 4) == 0) {
+			if(!has_fmt) {
+				error = "data chunk appears before fmt chunk";
+				return false;
+			}
+			data_bytes = (size == kUnknownSize) ? ~0ull : size;
+			return true;
+		}
+
+		if(std::memcmp(id, "fmt ", 4) == 0) {
+			if(size > kMaxFmtBytes || in.acquire(p, size) != size ||
+				!read_fmt_chunk(p, size, format, error))
+			{
+				if(error.empty()) {
+					error = "truncated fmt chunk";
+				}
+				return false;
+			}
+			has_fmt = true;
+			if(size & 1) {
+				in.skip(1);
+			}
+		} else {
+			//! チャンクのサイズが奇数のときは1バイトのパディングがある
+			unsigned long long const skip = size + (size & 1);
+			if(in.skip(skip) != skip) {
+				error = "truncated chunk";
+				return false;
+			}
+		}
+	}
+}
+
+bool	write_wav_header	(std::FILE *fp, AudioFormat const &format)
+{
+	unsigned int const sample_size = static_cast<unsigned int>(dsp::get_sample_size(format.sample_format_));
+	unsigned int const block_align = static_cast<unsigned int>(get_frame_size(format));
+
+	byte_t h[44];
+	std::memcpy(h, "RIFF", 4);
+	write_u32(h + 4, 36);
+	std::memcpy(h + 8, "WAVE", 4);
+	std::memcpy(h + 12, "fmt ", 4);
+	write_u32(h + 16, 16);
+	write_u16(h + 20, format.sample_format_ == dsp::SampleFormat::Float32 ? kFormatFloat : kFormatPcm);
+	write_u16(h + 22, static_cast<unsigned int>(format.num_channels_));
+	write_u32(h + 24, format.sampling_rate_);
+	write_u32(h + 28, format.sampling_rate_ * block_align);
+	write_u16(h + 32, block_align);
+	write_u16(h + 34, sample_size * 8);
+	std::memcpy(h + 36, "data", 4);
+	write_u32(h + 40, 0);
+
+	return std::fwrite(h, 1, sizeof(h), fp) == sizeof(h);
+}
+
+bool	finish_wav_file		(std::FILE *fp, unsigned long long data_bytes)
+{
+	if(data_bytes > kMaxWavDataBytes) {
+		return false;
+	}
+	if(data_bytes & 1) {
+		if(std::fputc(0, fp) == EOF) {
+			return false;
+		}
+	}
+
+	byte_t riff_size[4];
+	byte_t data_size[4];
+	write_u32(riff_size, static_cast<unsigned long>(36 + data_bytes + (data_bytes & 1)));
+	write_u32(data_size, static_cast<unsigned long>(data_bytes));
+
+	return
+		std::fseek(fp, 4, SEEK_SET) == 0 &&
+		std::fwrite(riff_size, 1, 4, fp) == 4 &&
+		std::fseek(fp, 40, SEEK_SET) == 0 &&
+		std::fwrite(data_size, 1, 4, fp) == 4;
+}
+
+}}	//namespace hwm::render
@@ -0,0 +1,59 @@
+#ifndef	HWM_MINIVSTEFFECT_RENDER_WAVFILE_HPP
+#define	HWM_MINIVSTEFFECT_RENDER_WAVFILE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+namespace hwm { namespace render {
+
+struct InputStream;
+
+//! 入出力するファイルの種類
+struct FileType
+{
+	enum {
+		//! RIFF WAVE
+		Wav,
+		//! ヘッダのないインターリーブされたサンプル列
+		//! サンプルの形式、チャンネル数、サンプリングレートは外から指定する
+		Raw,
+		kNumFileType
+	};
+};
+
+//! オーディオデータの形式
+struct AudioFormat
+{
+	size_t			file_type_;
+	//! dsp::SampleFormatのいずれか
+	size_t			sample_format_;
+	size_t			num_channels_;
+	unsigned long	sampling_rate_;
+};
+
+//! 1フレーム(全チャンネルの1サンプル)のバイト数
+size_t	get_frame_size		(AudioFormat const &format);
+
+//! WAVファイルのヘッダを読み、inをdataチャンクの先頭まで進める
+//! formatのfile_type_以外を設定し、dataチャンクのバイト数をdata_bytesに書く
+//! dataチャンクのサイズが0xFFFFFFFFになっている(ストリーミングで書き出された)ファイルでは、
+//! data_bytesを最大値にして終端まで読ませる
+//! 対応していない形式ならerrorに理由を書いてfalseを返す
+bool	read_wav_header		(InputStream &in, AudioFormat &format,
+							 unsigned long long &data_bytes, std::string &error);
+
+//! ファイルの先頭にWAVファイルのヘッダ(44バイト)を書く
+//! dataチャンクのサイズは0にしておき、finish_wav_fileで書き直す
+bool	write_wav_header	(std::FILE *fp, AudioFormat const &format);
+
+//! dataチャンクをdata_bytesバイト書き終えたファイルの、ヘッダのサイズを書き直す
+//! data_bytesが奇数なら、チャンクの境界を揃える1バイトを追加する
+bool	finish_wav_file		(std::FILE *fp, unsigned long long data_bytes);
+
+//! WAVファイルのdataチャンクに書けるバイト数の上限
+unsigned long long const	kMaxWavDataBytes = 0xFFFFFFFFull - 37;
+
+}}	//namespace hwm::render
+
+#endif	//HWM_MINIVSTEFFECT_RENDER_WAVFILE_HPP
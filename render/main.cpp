@@ -0,0 +1,308 @@
+#include "./Renderer.hpp"
+#include "./ThreadPool.hpp"
+#include "dsp/BiquadCoeffs.hpp"
+#include "dsp/CpuFeatures.hpp"
+#include "dsp/SampleFormat.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace hwm;
+
+struct Name
+{
+	char const *	name_;
+	size_t			value_;
+};
+
+Name const	filter_names[] = {
+	{ "lpf",		dsp::FilterType::LPF },
+	{ "hpf",		dsp::FilterType::HPF },
+	{ "bpf",		dsp::FilterType::BPF },
+	{ "notch",		dsp::FilterType::notch },
+	{ "apf",		dsp::FilterType::APF },
+	{ "peak",		dsp::FilterType::PeakingEQ },
+	{ "lowshelf",	dsp::FilterType::LowShelf },
+	{ "highshelf",	dsp::FilterType::HighShelf },
+};
+
+Name const	format_names[] = {
+	{ "s16",	dsp::SampleFormat::Int16 },
+	{ "s24",	dsp::SampleFormat::Int24 },
+	{ "s32",	dsp::SampleFormat::Int32 },
+	{ "f32",	dsp::SampleFormat::Float32 },
+};
+
+template<size_t N>
+bool	find_name	(Name const (&names)[N], char const *name, size_t &value)
+{
+	for(size_t i = 0; i < N; ++i) {
+		if(std::strcmp(names[i].name_, name) == 0) {
+			value = names[i].value_;
+			return true;
+		}
+	}
+	return false;
+}
+
+//! プリセットは番号、プラグインのプログラム名、フィルタタイプの短い名前のどれでも指定できる
+bool	find_preset	(char const *name, size_t &index)
+{
+	char *end;
+	unsigned long const n = std::strtoul(name, &end, 10);
+	if(*name != '\0' && *end == '\0') {
+		index = n;
+		return n < render::kNumPresets;
+	}
+
+	size_t filter_type;
+	bool const is_type = find_name(filter_names, name, filter_type);
+	for(size_t i = 0; i < render::kNumPresets; ++i) {
+		if(std::strcmp(render::get_preset_name(i), name) == 0 ||
+			(is_type && render::get_preset(i).filter_type_ == filter_type))
+		{
+			index = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool	parse_double	(char const *s, double &value)
+{
+	char *end;
+	value = std::strtod(s, &end);
+	return *s != '\0' && *end == '\0';
+}
+
+bool	parse_size		(char const *s, size_t &value)
+{
+	char *end;
+	unsigned long const n = std::strtoul(s, &end, 10);
+	value = n;
+	return *s != '\0' && *end == '\0';
+}
+
+std::string	get_file_name	(std::string const &path)
+{
+	std::string::size_type const slash = path.find_last_of("/\\");
+	return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+//! 出力のファイル名(入力のファイル名)が同じになる入力の組を探す
+//! 見つかればtrueを返し、その2つの添字をfirst, secondに書く
+bool	find_duplicate_output	(std::vector<std::string> const &inputs, size_t &first, size_t &second)
+{
+	std::map<std::string, size_t> outputs;
+	for(size_t i = 0; i < inputs.size(); ++i) {
+		std::pair<std::map<std::string, size_t>::iterator, bool> const r =
+			outputs.insert(std::make_pair(get_file_name(inputs[i]), i));
+		if(!r.second) {
+			first = r.first->second;
+			second = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void	print_usage	()
+{
+	std::fprintf(stderr,
+		"usage: mve_render [options] -o <output-dir> <input>...\n"
+		"\n"
+		"Applies the MiniVstEffect filter to WAV/RAW files.\n"
+		"Each output file has the same name as its input and is written to <output-dir>;\n"
+		"inputs whose names collide are rejected before anything is rendered.\n"
+		"\n"
+		"filter:\n"
+		"  --preset <name>       plugin preset: index 0-7, program name, or filter type\n"
+		"  --type <type>         lpf, hpf, bpf, notch, apf, peak, lowshelf, highshelf\n"
+		"  --cutoff <Hz>         cutoff frequency (default: the preset's cutoff)\n"
+		"  --gain <dB>           gain for peak, lowshelf and highshelf (default: 0)\n"
+		"  --q <Q>               Q (default: 0.3)\n"
+		"  --direct-form         filter mono files in direct form instead of the faster state-space form\n"
+		"\n"
+		"files:\n"
+		"  -o <dir>              output directory\n"
+		"  --format <fmt>        output sample format: s16, s24, s32, f32 (default: same as input)\n"
+		"  --raw-format <fmt>    sample format of .raw/.pcm inputs (default: f32)\n"
+		"  --raw-channels <n>    channel count of .raw/.pcm inputs (default: 2)\n"
+		"  --raw-rate <Hz>       sampling rate of .raw/.pcm inputs (default: 44100)\n"
+		"  --no-mmap             read inputs through buffered streaming instead of mmap\n"
+		"  --threads <n>         number of worker threads (default: hardware threads)\n"
+		"  --parallel            render one file at a time, splitting each file over all threads\n"
+		"                        (for a few long files; the output matches the sequential render)\n"
+		);
+}
+
+}	//unnamed namespace
+
+//! 使い方はprint_usageを参照
+//! 1つでも失敗したファイルがあれば1を返す
+int main(int argc, char **argv)
+{
+	render::RenderSettings settings;
+	settings.filter_						= render::get_preset(0);
+	settings.preset_cutoff_					= true;
+	settings.output_format_					= dsp::SampleFormat::kNumSampleFormat;
+	settings.use_mmap_						= true;
+	settings.raw_format_.file_type_			= render::FileType::Raw;
+	settings.raw_format_.sample_format_		= dsp::SampleFormat::Float32;
+	settings.raw_format_.num_channels_		= 2;
+	settings.raw_format_.sampling_rate_		= 44100;
+	settings.state_space_					= true;
+
+	std::string output_dir;
+	size_t num_threads = 0;
+	bool parallel = false;
+	std::vector<std::string> inputs;
+
+	//! --presetはフィルタの値をまとめて置き換えるので、他の指定より先に適用する
+	for(int a = 1; a + 1 < argc; ++a) {
+		if(std::strcmp(argv[a], "--preset") == 0) {
+			size_t index;
+			if(!find_preset(argv[a + 1], index)) {
+				std::fprintf(stderr, "unknown preset: %s\n", argv[a + 1]);
+				return 1;
+			}
+			settings.filter_ = render::get_preset(index);
+		}
+	}
+
+	for(int a = 1; a < argc; ++a) {
+		char const *arg = argv[a];
+		if(std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+			print_usage();
+			return 0;
+		}
+		if(std::strcmp(arg, "--no-mmap") == 0) {
+			settings.use_mmap_ = false;
+			continue;
+		}
+		if(std::strcmp(arg, "--parallel") == 0) {
+			parallel = true;
+			continue;
+		}
+		if(std::strcmp(arg, "--direct-form") == 0) {
+			settings.state_space_ = false;
+			continue;
+		}
+		if(arg[0] != '-') {
+			inputs.push_back(arg);
+			continue;
+		}
+		if(a + 1 >= argc) {
+			std::fprintf(stderr, "missing value for %s\n", arg);
+			return 1;
+		}
+
+		char const *value = argv[++a];
+		size_t n;
+		bool ok = true;
+		if(std::strcmp(arg, "--preset") == 0) {
+			//! 適用済み
+		} else if(std::strcmp(arg, "--type") == 0) {
+			ok = find_name(filter_names, value, settings.filter_.filter_type_);
+		} else if(std::strcmp(arg, "--cutoff") == 0) {
+			ok = parse_double(value, settings.filter_.cutoff_);
+			settings.preset_cutoff_ = false;
+		} else if(std::strcmp(arg, "--gain") == 0) {
+			ok = parse_double(value, settings.filter_.db_gain_);
+		} else if(std::strcmp(arg, "--q") == 0) {
+			ok = parse_double(value, settings.filter_.Q_) && settings.filter_.Q_ > 0.0;
+		} else if(std::strcmp(arg, "-o") == 0) {
+			output_dir = value;
+		} else if(std::strcmp(arg, "--format") == 0) {
+			ok = find_name(format_names, value, settings.output_format_);
+		} else if(std::strcmp(arg, "--raw-format") == 0) {
+			ok = find_name(format_names, value, settings.raw_format_.sample_format_);
+		} else if(std::strcmp(arg, "--raw-channels") == 0) {
+			ok = parse_size(value, settings.raw_format_.num_channels_) && settings.raw_format_.num_channels_ > 0;
+		} else if(std::strcmp(arg, "--raw-rate") == 0) {
+			ok = parse_size(value, n) && n > 0;
+			settings.raw_format_.sampling_rate_ = static_cast<unsigned long>(n);
+		} else if(std::strcmp(arg, "--threads") == 0) {
+			ok = parse_size(value, num_threads);
+		} else {
+			std::fprintf(stderr, "unknown option: %s\n", arg);
+			print_usage();
+			return 1;
+		}
+		if(!ok) {
+			std::fprintf(stderr, "invalid value for %s: %s\n", arg, value);
+			return 1;
+		}
+	}
+
+	if(output_dir.empty() || inputs.empty()) {
+		print_usage();
+		return 1;
+	}
+
+	//! 別のディレクトリにある同じ名前の入力は、同じ出力ファイルに書かれてしまう
+	//! 並列に処理すると互いの出力を壊すので、処理を始める前に断る
+	size_t first = 0, second = 0;
+	if(find_duplicate_output(inputs, first, second)) {
+		std::fprintf(stderr, "%s and %s would both be written to %s/%s\n",
+			inputs[first].c_str(), inputs[second].c_str(),
+			output_dir.c_str(), get_file_name(inputs[second]).c_str());
+		return 1;
+	}
+
+	typedef std::chrono::steady_clock clock;
+	clock::time_point const start = clock::now();
+
+	render::ThreadPool pool(num_threads);
+
+	std::mutex print_mutex;
+	size_t num_failed = 0;
+	unsigned long long total_frames = 0;
+
+	auto render_file = [&](render::Renderer &renderer, std::string const &input) {
+		std::string const output = output_dir + "/" + get_file_name(input);
+		std::string error;
+		bool const ok = renderer.render(input, output, settings, error);
+
+		std::lock_guard<std::mutex> lock(print_mutex);
+		if(ok) {
+			total_frames += renderer.get_num_frames();
+		} else {
+			++num_failed;
+			std::fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+		}
+	};
+
+	if(parallel) {
+		//! ファイルを順に、区間に分けて全スレッドで処理する
+		render::Renderer renderer(&pool);
+		for(size_t i = 0; i < inputs.size(); ++i) {
+			render_file(renderer, inputs[i]);
+		}
+	} else {
+		//! ファイルごとに1スレッドで処理する
+		std::vector<std::unique_ptr<render::Renderer>> renderers;
+		for(size_t i = 0; i < pool.get_num_threads(); ++i) {
+			renderers.push_back(std::unique_ptr<render::Renderer>(new render::Renderer()));
+		}
+		pool.run(inputs.size(), [&](size_t job, size_t thread) {
+			render_file(*renderers[thread], inputs[job]);
+		});
+	}
+
+	double const seconds = std::chrono::duration<double>(clock::now() - start).count();
+	std::fprintf(stderr, "%u files (%u failed), %llu frames in %.3f s on %u threads [%s]\n",
+		static_cast<unsigned>(inputs.size()), static_cast<unsigned>(num_failed),
+		total_frames, seconds, static_cast<unsigned>(pool.get_num_threads()),
+		dsp::get_simd_level_string(dsp::get_simd_level()));
+
+	return (num_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+#include "./Hooks.hpp"
+#include <dlfcn.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdarg>
+
+//! glibcの元の確保関数
+//! dlsymは内部でcallocを呼び出すことがあるので、確保関数はdlsymで探さずにこちらを使う
+extern "C" {
+void *	__libc_malloc	(size_t size);
+void *	__libc_calloc	(size_t count, size_t size);
+void *	__libc_realloc	(void *ptr, size_t size);
+void *	__libc_memalign	(size_t alignment, size_t size);
+void	__libc_free		(void *ptr);
+}
+
+namespace hwm { namespace rtcheck {
+
+namespace {
+
+//! 自明な型なので、スレッドローカルにしても初期化や確保は起きない
+thread_local bool		checking;
+thread_local Violations	counts;
+
+typedef int		(*mutex_func)		(pthread_mutex_t *);
+typedef int		(*cond_func)		(pthread_cond_t *);
+typedef long	(*syscall_func)		(long, ...);
+typedef ssize_t	(*write_func)		(int, void const *, size_t);
+typedef int		(*nanosleep_func)	(timespec const *, timespec *);
+typedef int		(*clock_nanosleep_func)	(clockid_t, int, timespec const *, timespec *);
+
+mutex_func				real_mutex_lock;
+mutex_func				real_mutex_trylock;
+cond_func				real_cond_signal;
+cond_func				real_cond_broadcast;
+syscall_func			real_syscall;
+write_func				real_write;
+nanosleep_func			real_nanosleep;
+clock_nanosleep_func	real_clock_nanosleep;
+
+//! 元の関数を探す。init_hooksより前(静的な初期化の間)に呼び出されたときのために、
+//! 見つかっていなければ呼び出しのたびにここで探す
+template<class Func>
+Func	find_real	(Func &func, char const *name)
+{
+	if(!func) {
+		func = reinterpret_cast<Func>(dlsym(RTLD_NEXT, name));
+	}
+	return func;
+}
+
+void	record_allocation	()
+{
+	if(checking) {
+		++counts.allocations_;
+	}
+}
+
+void	record_free	(void *ptr)
+{
+	if(checking && ptr) {
+		++counts.frees_;
+	}
+}
+
+int		lock_mutex	(pthread_mutex_t *mutex, bool try_lock)
+{
+	if(checking) {
+		++counts.locks_;
+	}
+
+	if(try_lock) {
+		return find_real(real_mutex_trylock, "pthread_mutex_trylock")(mutex);
+	}
+	return find_real(real_mutex_lock, "pthread_mutex_lock")(mutex);
+}
+
+void	record_syscall	()
+{
+	if(checking) {
+		++counts.syscalls_;
+	}
+}
+
+}	//unnamed namespace
+
+void	init_hooks	()
+{
+	find_real(real_mutex_lock, "pthread_mutex_lock");
+	find_real(real_mutex_trylock, "pthread_mutex_trylock");
+	find_real(real_cond_signal, "pthread_cond_signal");
+	find_real(real_cond_broadcast, "pthread_cond_broadcast");
+	find_real(real_syscall, "syscall");
+	find_real(real_write, "write");
+	find_real(real_nanosleep, "nanosleep");
+	find_real(real_clock_nanosleep, "clock_nanosleep");
+}
+
+void	begin_check	()
+{
+	Violations const zero = { 0, 0, 0, 0 };
+	counts = zero;
+	checking = true;
+}
+
+Violations
+		end_check	()
+{
+	checking = false;
+	return counts;
+}
+
+}}	//namespace hwm::rtcheck
+
+//! 実行ファイルで定義した関数は、libstdc++やlibcからの呼び出しでも優先される
+extern "C" {
+
+void *	malloc	(size_t size)
+{
+	hwm::rtcheck::record_allocation();
+	return __libc_malloc(size);
+}
+
+void *	calloc	(size_t count, size_t size)
+{
+	hwm::rtcheck::record_allocation();
+	return __libc_calloc(count, size);
+}
+
+void *	realloc	(void *ptr, size_t size)
+{
+	hwm::rtcheck::record_allocation();
+	return __libc_realloc(ptr, size);
+}
+
+void *	memalign	(size_t alignment, size_t size)
+{
+	hwm::rtcheck::record_allocation();
+	return __libc_memalign(alignment, size);
+}
+
+void *	aligned_alloc	(size_t alignment, size_t size)
+{
+	hwm::rtcheck::record_allocation();
+	return __libc_memalign(alignment, size);
+}
+
+int		posix_memalign	(void **ptr, size_t alignment, size_t size)
+{
+	hwm::rtcheck::record_allocation();
+	if(alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+		return EINVAL;
+	}
+
+	void *const p = __libc_memalign(alignment, size);
+	if(!p) {
+		return ENOMEM;
+	}
+	*ptr = p;
+	return 0;
+}
+
+void	free	(void *ptr)
+{
+	hwm::rtcheck::record_free(ptr);
+	__libc_free(ptr);
+}
+
+int		pthread_mutex_lock	(pthread_mutex_t *mutex)
+{
+	return hwm::rtcheck::lock_mutex(mutex, false);
+}
+
+int		pthread_mutex_trylock	(pthread_mutex_t *mutex)
+{
+	return hwm::rtcheck::lock_mutex(mutex, true);
+}
+
+//! 待っているスレッドがなければカーネルに入らないが、あるかどうかはタイミング次第なので
+//! 呼び出しを数える
+int		pthread_cond_signal	(pthread_cond_t *cond)
+{
+	hwm::rtcheck::record_syscall();
+	return hwm::rtcheck::find_real(hwm::rtcheck::real_cond_signal, "pthread_cond_signal")(cond);
+}
+
+int		pthread_cond_broadcast	(pthread_cond_t *cond)
+{
+	hwm::rtcheck::record_syscall();
+	return hwm::rtcheck::find_real(hwm::rtcheck::real_cond_broadcast, "pthread_cond_broadcast")(cond);
+}
+
+//! 引数の数は番号によるので、最大の6個をそのまま渡す
+long	syscall	(long number, ...)
+{
+	hwm::rtcheck::record_syscall();
+
+	va_list args;
+	va_start(args, number);
+	long a[6];
+	for(size_t i = 0; i < 6; ++i) {
+		a[i] = va_arg(args, long);
+	}
+	va_end(args);
+
+	return hwm::rtcheck::find_real(hwm::rtcheck::real_syscall, "syscall")(
+		number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+ssize_t	write	(int fd, void const *buf, size_t count)
+{
+	hwm::rtcheck::record_syscall();
+	return hwm::rtcheck::find_real(hwm::rtcheck::real_write, "write")(fd, buf, count);
+}
+
+int		nanosleep	(timespec const *req, timespec *rem)
+{
+	hwm::rtcheck::record_syscall();
+	return hwm::rtcheck::find_real(hwm::rtcheck::real_nanosleep, "nanosleep")(req, rem);
+}
+
+int		clock_nanosleep	(clockid_t clock, int flags, timespec const *req, timespec *rem)
+{
+	hwm::rtcheck::record_syscall();
+	return hwm::rtcheck::find_real(hwm::rtcheck::real_clock_nanosleep, "clock_nanosleep")(
+		clock, flags, req, rem);
+}
+
+}	//extern "C"
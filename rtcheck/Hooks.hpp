@@ -0,0 +1,38 @@
+#ifndef	HWM_MINIVSTEFFECT_RTCHECK_HOOKS_HPP
+#define	HWM_MINIVSTEFFECT_RTCHECK_HOOKS_HPP
+
+#include <cstddef>
+
+namespace hwm { namespace rtcheck {
+
+//! オーディオスレッドで呼び出してはいけない関数の、チェック中の呼び出し回数
+//! malloc, free, pthread_mutex_lock, システムコールに入る関数などをこの実行ファイルで置き換えて数える
+//! 数えるのはbegin_checkを呼び出したスレッドだけで、ほかのスレッド(線形位相のFIRを設計する
+//! ワーカーなど)の呼び出しは数えない
+struct Violations
+{
+	//! malloc, calloc, realloc, posix_memalign, aligned_alloc, memalign
+	size_t	allocations_;
+	//! 0以外のポインタのfree
+	size_t	frees_;
+	//! pthread_mutex_lock, pthread_mutex_trylock
+	size_t	locks_;
+	//! カーネルに入りうる呼び出し
+	//! pthread_cond_signal, pthread_cond_broadcast(待っているスレッドがあればfutexで起こす)、
+	//! syscall, write, nanosleep, clock_nanosleep
+	size_t	syscalls_;
+};
+
+//! 元のpthread_mutex_lock, pthread_cond_signalなどを探しておく
+//! チェックを始める前に、メインスレッドから1度呼び出す
+void		init_hooks	();
+
+//! このスレッドでの呼び出しを、0から数え始める
+void		begin_check	();
+
+//! 数えるのをやめ、begin_checkからの呼び出し回数を返す
+Violations	end_check	();
+
+}}	//namespace hwm::rtcheck
+
+#endif	//HWM_MINIVSTEFFECT_RTCHECK_HOOKS_HPP
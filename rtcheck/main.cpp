@@ -0,0 +1,240 @@
+#include "./Hooks.hpp"
+#include "MiniVstEffect.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace hwm;
+
+VstIntPtr VSTCALLBACK
+		host_callback	(AEffect *, VstInt32, VstInt32, VstIntPtr, void *, float)
+{
+	return 0;
+}
+
+size_t const kBlockSize = 512;
+size_t const kNumChannels = MiniVstEffect::kNumChannels;
+
+//! 呼び出しの種類ごとの集計
+struct PathResult
+{
+	std::string				name_;
+	size_t					num_calls_;
+	rtcheck::Violations		violations_;
+};
+
+//! 呼び出しをフックの間で実行して、種類ごとに集計する
+struct Checker
+{
+	Checker		()
+		:	num_failures_(0)
+	{}
+
+	//! 1度目の呼び出しも数える
+	//! std::stringの容量が足りなくなるなど、最初の呼び出しでだけ起きる確保もオーディオスレッドでは問題になる
+	template<class Func>
+	void	run		(char const *path, char const *context, Func func)
+	{
+		rtcheck::begin_check();
+		func();
+		rtcheck::Violations const v = rtcheck::end_check();
+
+		PathResult &result = find_path(path);
+		++result.num_calls_;
+		result.violations_.allocations_ += v.allocations_;
+		result.violations_.frees_ += v.frees_;
+		result.violations_.locks_ += v.locks_;
+		result.violations_.syscalls_ += v.syscalls_;
+
+		if(v.allocations_ || v.frees_ || v.locks_ || v.syscalls_) {
+			//! 同じ原因が何度も出るので、最初のいくつかだけ表示する
+			if(num_failures_ < kMaxReportedFailures) {
+				std::printf("  %s(%s): %u alloc, %u free, %u lock, %u syscall\n", path, context,
+					static_cast<unsigned>(v.allocations_), static_cast<unsigned>(v.frees_),
+					static_cast<unsigned>(v.locks_), static_cast<unsigned>(v.syscalls_));
+			}
+			++num_failures_;
+		}
+	}
+
+	PathResult &
+			find_path	(char const *path)
+	{
+		for(size_t i = 0; i < results_.size(); ++i) {
+			if(results_[i].name_ == path) {
+				return results_[i];
+			}
+		}
+
+		PathResult const result = { path, 0, { 0, 0, 0, 0 } };
+		results_.push_back(result);
+		return results_.back();
+	}
+
+	enum {
+		kMaxReportedFailures = 20
+	};
+
+	size_t						num_failures_;
+	std::vector<PathResult>		results_;
+};
+
+//! オーディオスレッドから呼び出されるメソッドを、このスレッドから順に呼び出す
+//! 全プログラムについて、全パラメータを0から1まで動かしながら、1回ごとに処理と表示の取得を行う
+//!
+//! プラグインは最後に処理を呼び出したスレッドをオーディオスレッドとみなすので、
+//! ここからのsetParameterとsetProgramはホストの自動化として扱われる。
+//! 遅延の変わる位相とオーバーサンプリング、プログラムの切り替えは、
+//! 別のスレッド(ホストのGUIスレッドの代わり)からも書き込んで、切り替えた後の処理を調べる
+struct Driver
+{
+	explicit
+	Driver	(MiniVstEffect &effect)
+		:	effect_(effect)
+		,	input_(kNumChannels * kBlockSize)
+		,	output_(kNumChannels * kBlockSize)
+		,	input_double_(kNumChannels * kBlockSize)
+		,	output_double_(kNumChannels * kBlockSize)
+	{
+		//! 無音だとバイパスされてフィルタを通らないので、雑音を入れておく
+		unsigned int seed = 1;
+		for(size_t i = 0; i < input_.size(); ++i) {
+			seed = seed * 1664525u + 1013904223u;
+			input_[i] = (static_cast<float>(seed >> 8) / (1 << 24) - 0.5f) * 0.5f;
+			input_double_[i] = input_[i];
+		}
+
+		for(size_t ch = 0; ch < kNumChannels; ++ch) {
+			inputs_[ch] = &input_[ch * kBlockSize];
+			outputs_[ch] = &output_[ch * kBlockSize];
+			inputs_double_[ch] = &input_double_[ch * kBlockSize];
+			outputs_double_[ch] = &output_double_[ch * kBlockSize];
+		}
+	}
+
+	void	process	(Checker &checker, char const *context)
+	{
+		checker.run("processReplacing", context, [&] {
+			effect_.processReplacing(inputs_, outputs_, static_cast<VstInt32>(kBlockSize));
+		});
+		checker.run("processDoubleReplacing", context, [&] {
+			effect_.processDoubleReplacing(inputs_double_, outputs_double_, static_cast<VstInt32>(kBlockSize));
+		});
+	}
+
+	//! ホストのGUIスレッドからの呼び出し。メモリを確保してよいので数えない
+	template<class Func>
+	static
+	void	on_host_thread	(Func func)
+	{
+		std::thread thread(func);
+		thread.join();
+	}
+
+	void	get_parameter	(Checker &checker, VstInt32 index, char const *context)
+	{
+		checker.run("getParameter", context, [&] { effect_.getParameter(index); });
+		checker.run("getParameterDisplay", context, [&] { effect_.getParameterDisplay(index, text_); });
+		checker.run("getParameterLabel", context, [&] { effect_.getParameterLabel(index, text_); });
+		checker.run("getParameterName", context, [&] { effect_.getParameterName(index, text_); });
+	}
+
+	void	sweep	(Checker &checker)
+	{
+		float const values[] = { 0.0f, 0.35f, 0.7f, 1.0f };
+		char context[64];
+
+		for(VstInt32 program = 0; program < effect_.getNumPrograms(); ++program) {
+			std::snprintf(context, sizeof(context), "program %d", static_cast<int>(program));
+			checker.run("setProgram", context, [&] { effect_.setProgram(program); });
+			process(checker, context);
+			on_host_thread([&] { effect_.setProgram(program); });
+			checker.run("getProgramName", context, [&] { effect_.getProgramName(text_); });
+			checker.run("getProgramNameIndexed", context, [&] {
+				effect_.getProgramNameIndexed(0, program, text_);
+			});
+			//! 短い名前にして、プリセットの長い名前のコピーで確保が起きるかを隠さないようにする
+			checker.run("setProgramName", context, [&] {
+				std::strcpy(text_, "Renamed");
+				effect_.setProgramName(text_);
+			});
+			process(checker, context);
+
+			for(VstInt32 index = 0; index < MiniVstEffect::kNumParams; ++index) {
+				for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+					std::snprintf(context, sizeof(context), "program %d, param %d = %g",
+						static_cast<int>(program), static_cast<int>(index), values[i]);
+					checker.run("setParameter", context, [&] { effect_.setParameter(index, values[i]); });
+					process(checker, context);
+					if(index == MiniVstEffect::kPhase || index == MiniVstEffect::kOversampling) {
+						on_host_thread([&] { effect_.setParameter(index, values[i]); });
+						process(checker, context);
+					}
+					get_parameter(checker, index, context);
+				}
+			}
+		}
+	}
+
+	MiniVstEffect &		effect_;
+	std::vector<float>	input_;
+	std::vector<float>	output_;
+	std::vector<double>	input_double_;
+	std::vector<double>	output_double_;
+	float *				inputs_[kNumChannels];
+	float *				outputs_[kNumChannels];
+	double *			inputs_double_[kNumChannels];
+	double *			outputs_double_[kNumChannels];
+	//! 表示の取得先。VSTでは文字列の長さはkVstMaxProgNameLenなどまで
+	char				text_[256];
+};
+
+}	//unnamed namespace
+
+//! オーディオスレッドから呼び出されるメソッド(processReplacing, setParameterなどの自動化)と
+//! 表示の取得で、メモリの確保・解放、mutexのロック、システムコールが起きていないかを調べる
+//! 1つでも見つかれば1を返す
+int		main	()
+{
+	rtcheck::init_hooks();
+
+	MiniVstEffect effect(&host_callback);
+	effect.setSampleRate(48000.0f);
+	effect.setBlockSize(static_cast<VstInt32>(kBlockSize));
+	effect.resume();
+
+	Checker checker;
+	Driver driver(effect);
+
+	//! 最初のブロックで、このスレッドがオーディオスレッドになる
+	driver.process(checker, "first block");
+
+	//! 2周目は、1周目の最後の状態(線形位相、4倍のオーバーサンプリングなど)からプログラムを切り替える
+	driver.sweep(checker);
+	driver.sweep(checker);
+
+	if(checker.num_failures_ > Checker::kMaxReportedFailures) {
+		std::printf("  ... %u more\n",
+			static_cast<unsigned>(checker.num_failures_ - Checker::kMaxReportedFailures));
+	}
+
+	std::printf("\n%-24s %8s %8s %8s %8s %8s\n", "", "calls", "alloc", "free", "lock", "syscall");
+	for(size_t i = 0; i < checker.results_.size(); ++i) {
+		PathResult const &r = checker.results_[i];
+		std::printf("%-24s %8u %8u %8u %8u %8u\n", r.name_.c_str(),
+			static_cast<unsigned>(r.num_calls_),
+			static_cast<unsigned>(r.violations_.allocations_),
+			static_cast<unsigned>(r.violations_.frees_),
+			static_cast<unsigned>(r.violations_.locks_),
+			static_cast<unsigned>(r.violations_.syscalls_));
+	}
+
+	//! HWM_MINIVSTEFFECT_NO_EDITORでビルドしているので、Editorの経路は確かめていない
+	bool const passed = (checker.num_failures_ == 0);
+	std::printf("\n%s (without the editor)\n", passed ? "PASS" : "FAIL");
+	return passed ? 0 : 1;
+}